@@ -67,6 +67,9 @@ public:
 
 //Max value
   static pop::F32 maxValue();
+// number of calls of the seed functions, and value of the last seed (hash of the array for the array seed)
+  static int seedGeneration();
+  static unsigned long seedValue();
 // 2007-02-11: made the destructor virtual; thanks "float64 more" for pointing this out
   virtual ~MTRand_int32(); // destructor
 protected: // used by derived classes, otherwise not accessible; use the ()-operator
@@ -81,6 +84,8 @@ private:
   static unsigned long state[624]; // state std::vector array
   static int p; // position in state array
   static  bool init; // true if init function is called
+  static int _seed_generation;
+  static unsigned long _seed_value;
 // private functions used to generate the pseudo random numbers
   unsigned long twiddle(unsigned long, unsigned long); // used by gen_state()
   void gen_state(); // generate new state
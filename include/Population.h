@@ -15,10 +15,12 @@
 #include"data/germgrain/GermGrain.h"
 #include"data/notstable/graph/Graph.h"
 #include"data/notstable/Ransac.h"
+#include"data/mat/GEMM.h"
 #include"data/mat/MatN.h"
 #include"data/mat/MatNInOut.h"
 #include"data/mat/MatNDisplay.h"
 #include"data/mat/Mat2x.h"
+#include"data/mat/MatNChunked.h"
 #include"data/notstable/Classifer.h"
 #include"data/notstable/Descriptor.h"
 #include"data/utility/BSPTree.h"
@@ -36,6 +38,8 @@
 #include"data/typeF/TypeTraitsF.h"
 #include"PopulationConfig.h"
 #include"data/utility/BasicUtility.h"
+#include"data/utility/Compression.h"
+#include"data/utility/MemoryMappedFile.h"
 #include"data/utility/Cryptography.h"
 #include"data/utility/XML.h"
 #include"data/vec/VecN.h"
@@ -44,6 +48,7 @@
 #include"3rdparty/VideoVLC.h"
 #include"3rdparty/VideoFFMPEG.h"
 #include"data/neuralnetwork/NeuralNetwork.h"
+#include"data/neuralnetwork/NeuralNetworkQuantized.h"
 #include"algorithm/Analysis.h"
 #include"algorithm/AnalysisAdvanced.h"
 #include"algorithm/Application.h"
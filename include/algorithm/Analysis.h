@@ -544,40 +544,45 @@ struct POP_EXPORTS Analysis
         if(rmax>maxsize/2)
             rmax=maxsize/2;
 
-        Mat2F32 m(max_value+1,1);
+        if(rmax<0)
+            rmax=0;
+        //a single scan of the box of radius rmax-1 where each point is counted in the ring ceil(|x'|), the first radius of the balls containing it,
+        //then the histogram of the ball of radius r is the cumulative sum of the rings 0..r
+        Mat2F32 m(max_value+1,rmax+1);
+        std::fill(m.begin(),m.end(),0.f);
         for(unsigned int i =0;i<m.sizeI();i++)
             m(i,0)=i;
-
-        for( int r =0;r<rmax;r++){
-            m.resizeInformation(m.sizeI(),m.sizeJ()+1);
-            typename MatN<DIM,PixelType>::E R( r*2+1);
+        int r_stop = rmax;
+        if(rmax>0){
+            typename MatN<DIM,PixelType>::E R( (rmax-1)*2+1);
             typename MatN<DIM,PixelType>::IteratorEDomain it(R);
-            bool inside =true;
-            typename MatN<DIM,PixelType>::E add =x- r;
-            while(it.next()&&inside==true){
-                typename MatN<DIM,PixelType>::E xprime = it.x()-r;
-                if(xprime.norm(norm)<=r){
+            typename MatN<DIM,PixelType>::E add =x- (rmax-1);
+            while(it.next()){
+                typename MatN<DIM,PixelType>::E xprime = it.x()-(rmax-1);
+                int ring = static_cast<int>(std::ceil(xprime.norm(norm)));
+                if(ring<r_stop){
                     typename MatN<DIM,PixelType>::E xxprime = it.x()+add;
                     if(f.isValid(xxprime)){
-                        m(f(xxprime),r+1) ++;
+                        m(f(xxprime),ring+1) ++;
                     }else{
-                        inside = false;
+                        r_stop = ring;
                     }
                 }
             }
-            if(inside==true){
-                int count =0;
-                for(unsigned int i =0;i<m.sizeI();i++){
-                    count +=m(i,r+1);
-                }
-                for(unsigned int i =0;i<m.sizeI();i++){
-                    m(i,r+1)/=count;
-                }
-            }else{
-                r=rmax;
-                m.resizeInformation(m.sizeI(),m.sizeJ()-1);
+        }
+        std::vector<F64> cumulative(m.sizeI(),0);
+        F64 count =0;
+        for( int r =0;r<r_stop;r++){
+            for(unsigned int i =0;i<m.sizeI();i++){
+                cumulative[i]+=m(i,r+1);
+                count+=m(i,r+1);
+            }
+            for(unsigned int i =0;i<m.sizeI();i++){
+                m(i,r+1)=static_cast<F32>(cumulative[i]/count);
             }
         }
+        if(r_stop<rmax)
+            m.resizeInformation(m.sizeI(),r_stop+1);
         return m;
 
     }
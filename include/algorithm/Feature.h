@@ -425,6 +425,87 @@ public:
     //@}
     //-------------------------------------
     //
+    //! \name Template matching
+    //@{
+    //-------------------------------------
+
+    /*!
+    * \brief normalized cross-correlation of the matrix with a pattern
+    * \param f input matrix with a scalar pixel type
+    * \param pattern input pattern with a scalar pixel type
+    * \return score in [-1,1] of the pattern placed with its first corner at \f$x-p/2\f$, with \f$p\f$ the domain of the pattern
+    *
+    * The score is \f$\frac{\sum_{x'} (f(x-p/2+x')-\bar f_x)(t(x')-\bar t)}{\sqrt{\sum_{x'} (f(x-p/2+x')-\bar f_x)^2\sum_{x'} (t(x')-\bar t)^2}}\f$
+    * with \f$\bar f_x\f$ the mean of f in the window. The numerator is the convolution with the flipped zero-mean pattern (see Processing::convolution, by FFT
+    * for the large patterns) and the window statistics of the denominator are given in constant time by ProcessingAdvanced::BoxStatistics.
+    * The score is 0 where the window is not included in the domain or where f or the pattern is constant.
+    * \code
+    * Mat2UI8 img;
+    * img.load(POP_PROJECT_SOURCE_DIR+std::string("/image/Lena.bmp"));
+    * Mat2UI8 pattern = img(Vec2I32(200,200),Vec2I32(241,241));
+    * Mat2F32 score = Feature::templateMatchingNCC(img,pattern);
+    * Vec2I32 xmax;
+    * F32 scoremax=-1;
+    * ForEachDomain2D(x,score){
+    *     if(score(x)>scoremax){
+    *         scoremax = score(x);
+    *         xmax=x;
+    *     }
+    * }
+    * std::cout<<xmax-pattern.getDomain()/2<<std::endl;//200 200
+    * \endcode
+    */
+    template<int DIM,typename PixelType1,typename PixelType2>
+    static MatN<DIM,F32> templateMatchingNCC(const MatN<DIM,PixelType1> & f,const MatN<DIM,PixelType2> & pattern)
+    {
+        MatN<DIM,F32> h(f.getDomain());
+        const VecN<DIM,I32> domain_pattern = pattern.getDomain();
+        const int nbr = domain_pattern.multCoordinate();
+        if(nbr==0||h.getDomain().multCoordinate()==0)
+            return h;
+        for(int i=0;i<DIM;i++){
+            if(domain_pattern(i)>f.getDomain()(i))
+                return h;
+        }
+        typename MatN<DIM,PixelType2>::IteratorEDomain itp(pattern.getIteratorEDomain());
+        F64 mean_pattern=0;
+        while(itp.next())
+            mean_pattern+=pattern(itp.x());
+        mean_pattern/=nbr;
+        //the convolution with the flipped pattern is the correlation with the window [x-p/2,x-p/2+p-1]
+        MatN<DIM,F32> kernel(domain_pattern);
+        F64 norm_pattern=0;
+        itp.init();
+        while(itp.next()){
+            F64 v = pattern(itp.x())-mean_pattern;
+            norm_pattern+=v*v;
+            kernel(domain_pattern-1-itp.x())=static_cast<F32>(v);
+        }
+        if(norm_pattern<=0)
+            return h;
+        MatN<DIM,F32> numerator = Processing::convolution(MatN<DIM,F32>(f),kernel,MatNBoundaryConditionBounded());
+        ProcessingAdvanced::BoxStatistics<DIM,PixelType1> stat(f);
+        typename MatN<DIM,F32>::IteratorEDomain it(h.getIteratorEDomain());
+        while(it.next()){
+            VecN<DIM,I32> xmin = it.x()-domain_pattern/2;
+            VecN<DIM,I32> xmax = xmin+domain_pattern-1;
+            bool inside=true;
+            for(int i=0;i<DIM;i++){
+                if(xmin(i)<0||xmax(i)>=f.getDomain()(i))
+                    inside=false;
+            }
+            if(inside==false)
+                continue;
+            F64 sum = static_cast<F64>(stat.sum(xmin,xmax));
+            F64 variance_sum = static_cast<F64>(stat.sumPower2(xmin,xmax))-sum*sum/nbr;
+            if(variance_sum>0)
+                h(it.x())=static_cast<F32>(maximum(-1.,minimum(1.,numerator(it.x())/std::sqrt(variance_sum*norm_pattern))));
+        }
+        return h;
+    }
+    //@}
+    //-------------------------------------
+    //
     //! \name Pyramid facilities
     //@{
     //-------------------------------------
@@ -35,6 +35,8 @@ in the Software.
 #define FUNCTIONPROCEDUREFUNCTORF_HPP
 #include"data/vec/VecN.h"
 #include"data/mat/MatNIteratorE.h"
+#include"3rdparty/tinythread.h"
+#include"data/distribution/Distribution.h"
 namespace pop
 {
 template<typename Function_E_F,typename Generator_F,typename IteratorE>
@@ -90,6 +92,30 @@ typename FunctorAccumulatorF::ReturnType forEachFunctorAccumulator(const Functio
     }
     return func.getValue();
 }
+template<int Dim, typename PixelType>
+class MatN;
+/*!
+ * \brief accumulation on a neighborhood of a matrix
+ *
+ * For a center inside the interior of the domain, the values are read with the precomputed linear offsets of the neighborhood
+ * without boundary condition. Otherwise the neighborhood iteration with the boundary condition is used.
+ */
+template<int DIM,typename PixelType,typename FunctorAccumulatorF,typename BoundaryCondition>
+typename FunctorAccumulatorF::ReturnType forEachFunctorAccumulator(const MatN<DIM,PixelType> & f,  FunctorAccumulatorF & func, MatNIteratorENeighborhood<VecN<DIM,I32>,BoundaryCondition> & it){
+    if(it.isInterior()==false||f.getDomain()!=it.getDomainMatN()||f.stride()!=it.strideMatN()){
+        func.init();
+        while(it.next()){
+            func( f(it.x()));
+        }
+        return func.getValue();
+    }
+    func.init();
+    const PixelType * data = f.data()+it.indexCenter();
+    const std::vector<std::ptrdiff_t> & offset = it.tabOffset();
+    for(unsigned int i=0;i<offset.size();i++)
+        func(data[offset[i]]);
+    return func.getValue();
+}
 template<typename Function1_E_F,typename Function2_E_F,typename FunctorAccumulatorF,typename IteratorEGlobal,typename IteratorELocal>
 void forEachGlobalToLocal(const Function1_E_F & f, Function2_E_F &  h, FunctorAccumulatorF facc,IteratorELocal  it_local, IteratorEGlobal it_global){
     while(it_global.next()){
@@ -102,5 +128,237 @@ void forEachGlobalToLocal(const Function1_E_F & f, Function2_E_F &  h, FunctorAc
     typename Function1_E_F::IteratorEDomain it_global=f.getIteratorEDomain();
     forEachGlobalToLocal( f,  h,  facc, it_local,it_global);
 }
+
+//    \cond HIDDEN_SYMBOLS
+namespace Private{
+inline int & numberThreadParallel(){
+    static int nbr_thread=0;
+    return nbr_thread;
+}
+template<typename FunctorRange>
+struct ForEachRangeWork
+{
+    FunctorRange * _func;
+    int _begin;
+    int _end;
+    UI64 _seed;
+    int _chunk;
+    static void run(void * param){
+        ForEachRangeWork * work = static_cast<ForEachRangeWork *>(param);
+        RandomEngineChunk engine(work->_seed,static_cast<UI64>(work->_chunk));
+        (*work->_func)(work->_begin,work->_end);
+    }
+};
+#if defined(HAVE_THREAD)
+//persistent workers of forEachRangeParallel: the threads are created at the first use and wait for the tasks of the next calls. The pool is
+//never destroyed, the workers staying blocked on the condition variable until the end of the program.
+class ThreadPool
+{
+public:
+    static ThreadPool & instance(){
+        static ThreadPool * pool = new ThreadPool;
+        return *pool;
+    }
+    //start function(param+i*size_param) for 0<=i<nbr_task on the workers, false if the workers are used by another call (nested or concurrent)
+    bool start(void (*function)(void *),char * param,std::size_t size_param,int nbr_task){
+        if(_mutex_call.try_lock()==false)
+            return false;
+        tthread::lock_guard<tthread::mutex> guard(_mutex);
+        while(static_cast<int>(_v_thread.size())<nbr_task)
+            _v_thread.push_back(new tthread::thread(&ThreadPool::loop,this));
+        _function = function;
+        _param = param;
+        _size_param = size_param;
+        _nbr_task = nbr_task;
+        _index_task = 0;
+        _nbr_task_done = 0;
+        _cond_task.notify_all();
+        return true;
+    }
+    //wait for the end of the tasks given by start
+    void wait(){
+        {
+            tthread::lock_guard<tthread::mutex> guard(_mutex);
+            while(_nbr_task_done<_nbr_task)
+                _cond_done.wait(_mutex);
+            _nbr_task = 0;
+            _index_task = 0;
+        }
+        _mutex_call.unlock();
+    }
+private:
+    ThreadPool()
+        :_function(NULL),_param(NULL),_size_param(0),_nbr_task(0),_index_task(0),_nbr_task_done(0){}
+    static void loop(void * param){
+        ThreadPool * pool = static_cast<ThreadPool *>(param);
+        pool->_mutex.lock();
+        while(true){
+            while(pool->_index_task>=pool->_nbr_task)
+                pool->_cond_task.wait(pool->_mutex);
+            void (*function)(void *) = pool->_function;
+            char * param_task = pool->_param+pool->_index_task*pool->_size_param;
+            pool->_index_task++;
+            pool->_mutex.unlock();
+            function(param_task);
+            pool->_mutex.lock();
+            pool->_nbr_task_done++;
+            if(pool->_nbr_task_done==pool->_nbr_task)
+                pool->_cond_done.notify_all();
+        }
+    }
+    //held from start to wait
+    tthread::mutex _mutex_call;
+    tthread::mutex _mutex;
+    tthread::condition_variable _cond_task;
+    tthread::condition_variable _cond_done;
+    std::vector<tthread::thread *> _v_thread;
+    void (*_function)(void *);
+    char * _param;
+    std::size_t _size_param;
+    int _nbr_task;
+    int _index_task;
+    int _nbr_task_done;
+};
+#endif
+template<typename Function1_E_F,typename Function2_E_F,typename FunctorAccumulatorF,typename IteratorELocal>
+struct ForEachGlobalToLocalSlab
+{
+    const Function1_E_F * _f;
+    Function2_E_F * _h;
+    FunctorAccumulatorF _facc;
+    IteratorELocal _it_local;
+    typename Function1_E_F::E _domain;
+    int _coordinate;
+    ForEachGlobalToLocalSlab(const Function1_E_F & f, Function2_E_F &  h, FunctorAccumulatorF facc,IteratorELocal it_local,const typename Function1_E_F::E & domain,int coordinate)
+        :_f(&f),_h(&h),_facc(facc),_it_local(it_local),_domain(domain),_coordinate(coordinate){}
+    void operator()(int begin,int end){
+        typedef typename Function1_E_F::E E;
+        //each slab has its own copy of the local iterator and of the accumulator
+        FunctorAccumulatorF facc(_facc);
+        IteratorELocal it_local(_it_local);
+        E domain_slab(_domain);
+        domain_slab(_coordinate)=end-begin;
+        MatNIteratorEDomain<E> it(domain_slab);
+        E x;
+        while(it.next()){
+            x = it.x();
+            x(_coordinate)+=begin;
+            it_local.init(x);
+            (*_h)(x)=forEachFunctorAccumulator(*_f,facc,it_local);
+        }
+    }
+};
+}
+//\endcond
+
+/*!
+ * \brief set the number of threads of the parallel algorithms
+ * \param nbr_thread number of threads (0 for the number of cores)
+ */
+inline void setNumberThreadParallel(int nbr_thread){
+    Private::numberThreadParallel()=nbr_thread;
+}
+/*!
+ * \brief number of threads of the parallel algorithms
+ * \return the value fixed by setNumberThreadParallel, otherwise the number of cores with OpenMP or the thread library, otherwise 1
+ */
+inline int getNumberThreadParallel(){
+    if(Private::numberThreadParallel()>0)
+        return Private::numberThreadParallel();
+#if defined(HAVE_OPENMP)
+    return omp_get_max_threads();
+#elif defined(HAVE_THREAD)
+    int nbr_thread = static_cast<int>(tthread::thread::hardware_concurrency());
+    return nbr_thread>0?nbr_thread:1;
+#else
+    return 1;
+#endif
+}
+/*!
+ * \brief number of elements below which the parallel algorithms run sequentially
+ *
+ * Below this size, the thread synchronization costs more than the gain.
+ */
+const int PARALLEL_MINIMUM_SIZE = 10000;
+/*!
+ * \brief split the range [begin,end) in contiguous chunks executed in parallel
+ * \param begin first index
+ * \param end last index excluded
+ * \param func functor called by func(begin_chunk,end_chunk) for each chunk
+ *
+ * The chunks are executed with OpenMP if available, otherwise with the thread library, otherwise sequentially. The functor must
+ * be safe to call concurrently on disjoint chunks. With the thread library, the calling thread executes the first chunk and persistent
+ * workers, created at the first call, the other ones. A call inside a chunk, or concurrent to another call, executes its chunks sequentially.
+ *
+ * Each chunk draws its random variables from its own engine (RandomEngineChunk with the seed Distribution::parallelSeed()), even with a
+ * single chunk. So the random variables depend on the seed and on the number of chunks, and the engine of the calling thread is not advanced:
+ * the random variables drawn after the loop do not depend on the number of threads.
+ */
+template<typename FunctorRange>
+void forEachRangeParallel(int begin,int end,FunctorRange & func){
+    if(begin>=end)
+        return;
+    int nbr_chunk = std::max(1,std::min(getNumberThreadParallel(),end-begin));
+    const UI64 seed = Distribution::parallelSeed();
+    if(nbr_chunk==1){
+        RandomEngineChunk engine(seed,0);
+        func(begin,end);
+        return;
+    }
+    int size_chunk = (end-begin)/nbr_chunk;
+    int remainder  = (end-begin)%nbr_chunk;
+    std::vector<Private::ForEachRangeWork<FunctorRange> > works(nbr_chunk);
+    for(int i=0;i<nbr_chunk;i++){
+        works[i]._seed  = seed;
+        works[i]._chunk = i;
+        works[i]._func  = &func;
+        works[i]._begin = begin + i*size_chunk + std::min(i,remainder);
+        works[i]._end   = works[i]._begin+size_chunk+(i<remainder?1:0);
+    }
+#if defined(HAVE_OPENMP)
+#pragma omp parallel for schedule(static,1)
+    for(int i=0;i<nbr_chunk;i++)
+        Private::ForEachRangeWork<FunctorRange>::run(&works[i]);
+#elif defined(HAVE_THREAD)
+    Private::ThreadPool & pool = Private::ThreadPool::instance();
+    if(pool.start(&Private::ForEachRangeWork<FunctorRange>::run,reinterpret_cast<char *>(&works[1]),sizeof(works[0]),nbr_chunk-1)){
+        Private::ForEachRangeWork<FunctorRange>::run(&works[0]);
+        pool.wait();
+    }else{
+        for(int i=0;i<nbr_chunk;i++)
+            Private::ForEachRangeWork<FunctorRange>::run(&works[i]);
+    }
+#else
+    for(int i=0;i<nbr_chunk;i++)
+        Private::ForEachRangeWork<FunctorRange>::run(&works[i]);
+#endif
+}
+/*!
+ * \brief parallel version of forEachGlobalToLocal
+ *
+ * Without a domain iterator as global iterator, the sequential forEachGlobalToLocal is called.
+ */
+template<typename Function1_E_F,typename Function2_E_F,typename FunctorAccumulatorF,typename IteratorEGlobal,typename IteratorELocal>
+void forEachGlobalToLocalParallel(const Function1_E_F & f, Function2_E_F &  h, FunctorAccumulatorF facc,IteratorELocal  it_local, IteratorEGlobal it_global){
+    forEachGlobalToLocal(f,h,facc,it_local,it_global);
+}
+/*!
+ * \brief parallel version of forEachGlobalToLocal for the domain iterator
+ *
+ * The domain is split in slabs along the slowest coordinate in memory (0 in 2d, DIM-1 otherwise). Each thread iterates over its
+ * slab with its own copy of the local iterator and of the accumulator, so the result is the same as the sequential one.
+ * \sa forEachRangeParallel
+ */
+template<typename Function1_E_F,typename Function2_E_F,typename FunctorAccumulatorF,typename IteratorELocal,typename VecN>
+void forEachGlobalToLocalParallel(const Function1_E_F & f, Function2_E_F &  h, FunctorAccumulatorF facc,IteratorELocal  it_local, MatNIteratorEDomain<VecN> it_global){
+    VecN domain = it_global.getDomain();
+    if(getNumberThreadParallel()<=1||domain.multCoordinate()<PARALLEL_MINIMUM_SIZE){
+        forEachGlobalToLocal(f,h,facc,it_local,it_global);
+        return;
+    }
+    int coordinate = (VecN::DIM==2) ? 0 : VecN::DIM-1;
+    Private::ForEachGlobalToLocalSlab<Function1_E_F,Function2_E_F,FunctorAccumulatorF,IteratorELocal> slab(f,h,facc,it_local,domain,coordinate);
+    forEachRangeParallel(0,domain(coordinate),slab);
+}
 }
 #endif // FUNCTIONPROCEDUREFUNCTORF_HPP
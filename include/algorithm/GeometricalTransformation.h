@@ -7,6 +7,10 @@
 #include"data/mat/MatN.h"
 #include"data/mat/Mat2x.h"
 #include"algorithm/ProcessingAdvanced.h"
+#include"data/functor/FunctorMatN.h"
+#if defined(__SSE2__)
+#include<emmintrin.h>
+#endif
 
 namespace pop
 {
@@ -67,26 +71,17 @@ struct POP_EXPORTS GeometricalTransformation
     template<int DIM, typename PixelType>
     static MatN<DIM,PixelType> subResolution(const MatN<DIM,PixelType> &m , int sub_resolution_factor)
     {
-        MatN<DIM,PixelType> m_sub (m.getDomain()/sub_resolution_factor);
-        if(DIM==2){
-            for(unsigned int index_m_i=0,index_m_sub_i=0;index_m_sub_i<m_sub.sizeI();index_m_i+=sub_resolution_factor,index_m_sub_i++){
-                for(unsigned int index_m_j=0,index_m_sub_j=0;index_m_sub_j<m_sub.sizeJ();index_m_j+=sub_resolution_factor,index_m_sub_j++){
-                    m_sub(index_m_sub_i,index_m_sub_j)=m(index_m_i,index_m_j);
-                }
-            }
-        }
-        else if(DIM==3){
-            for(unsigned int index_m_k=0,index_m_sub_k=0;index_m_sub_k<m_sub.sizeK();index_m_k+=sub_resolution_factor,index_m_sub_k++){
-                for(unsigned int index_m_i=0,index_m_sub_i=0;index_m_sub_i<m_sub.sizeI();index_m_i+=sub_resolution_factor,index_m_sub_i++){
-                    for(unsigned int index_m_j=0,index_m_sub_j=0;index_m_sub_j<m_sub.sizeJ();index_m_j+=sub_resolution_factor,index_m_sub_j++){
-                        m_sub(index_m_sub_i,index_m_sub_j,index_m_sub_k)=m(index_m_i,index_m_j,index_m_k);
-                    }
-                }
-            }
-        }else{
-            std::cerr<<"[ERROR][subResolution] only for 2d and 3d image"<<std::endl;
+        VecN<DIM,int> domain(m.getDomain()/sub_resolution_factor);
+        std::vector<ResampleAxis> axis(DIM);
+        for(int a=0;a<DIM;a++){
+            axis[a]._size_out = domain(a);
+            axis[a]._nbr_tap = 1;
+            axis[a]._weight.assign(domain(a),1.f);
+            axis[a]._index.resize(domain(a));
+            for(int i=0;i<domain(a);i++)
+                axis[a]._index[i]=i*sub_resolution_factor;
         }
-        return m_sub;
+        return _resampleNearest(m,axis);
     }
     /*!
      * \brief get a 2d matrix from a 3d matrix (e.g. a slice in a core sample)
@@ -129,47 +124,623 @@ struct POP_EXPORTS GeometricalTransformation
         }
         return line_;
     }
-    template<  typename PixelType,typename Interpolation>
-    static MatN<2,PixelType> _scale(const MatN<2,PixelType> & f,const VecN<2,F32> & scale,Interpolation )
+    //    \cond HIDDEN_SYMBOLS
+    //sampling of a direction: output(i) = sum_k _weight[i*_nbr_tap+k] input(_index[i*_nbr_tap+k])
+    struct ResampleAxis
     {
-        Vec2I32 domain (scale*VecN<2,F32>(f.getDomain()));
-        MatN<2,PixelType> temp(domain);
-        Vec2F32 alpha = Vec2F32(1.f,1.f)/scale;
-        Vec2I32 x (0,0);
-        Vec2F32 x_f (-0.4999f,-0.4999f);
-        for(x(0)=0;x(0)<(int)temp.sizeI();x(0)++,x_f(0)+=alpha(0)){
-            x_f(1)=-0.4999f;
-            for(x(1)=0;x(1)<(int)temp.sizeJ();x(1)++,x_f(1)+=alpha(1)){
-                temp(x)= Interpolation::apply(f,x_f);
+        int _size_out;
+        int _nbr_tap;
+        std::vector<int> _index;
+        std::vector<F32> _weight;
+    };
+    static ResampleAxis _resampleAxis(int size_in,int size_out,F32 alpha,MatNInterpolationType type){
+        ResampleAxis axis;
+        axis._size_out = size_out;
+        if(type==MATN_INTERPOLATION_NEAREST||type==MATN_INTERPOLATION_BILINEAR){
+            //same sampling positions as the former pointwise scale
+            axis._nbr_tap = (type==MATN_INTERPOLATION_NEAREST)?1:2;
+            axis._index.assign(size_out*axis._nbr_tap,0);
+            axis._weight.assign(size_out*axis._nbr_tap,0.f);
+            F32 x_f =-0.4999f;
+            for(int i=0;i<size_out;i++,x_f+=alpha){
+                if(type==MATN_INTERPOLATION_NEAREST){
+                    axis._index[i]=std::min(std::max(static_cast<int>(pop::round(x_f)),0),size_in-1);
+                    axis._weight[i]=1;
+                }else{
+                    int x1 = static_cast<int>(std::floor(x_f));
+                    F32 sum=0;
+                    for(int k=0;k<2;k++){
+                        if(x1+k>=0&&x1+k<size_in){
+                            axis._index[2*i+k] = x1+k;
+                            axis._weight[2*i+k]= (k==0)?1-(x_f-x1):1-(x1+1-x_f);
+                            sum+=axis._weight[2*i+k];
+                        }
+                    }
+                    if((x1<0||x1+1>=size_in)&&sum!=0){
+                        axis._weight[2*i]/=sum;
+                        axis._weight[2*i+1]/=sum;
+                    }
+                }
             }
+            return axis;
         }
-        return temp;
+        //pixel-centred sampling, the kernel is stretched by the downsampling factor to avoid the aliasing
+        F32 filter_scale = std::max(1.f,alpha);
+        F32 support;
+        if(type==MATN_INTERPOLATION_AREA)
+            support = 0.5f*std::max(1.f,alpha)+0.5f;
+        else if(type==MATN_INTERPOLATION_BICUBIC)
+            support = 2*filter_scale;
+        else
+            support = 3*filter_scale;
+        axis._nbr_tap = 2*static_cast<int>(std::ceil(support))+1;
+        axis._index.assign(size_out*axis._nbr_tap,0);
+        axis._weight.assign(size_out*axis._nbr_tap,0.f);
+        for(int i=0;i<size_out;i++){
+            F32 center = (i+0.5f)*alpha-0.5f;
+            int first = static_cast<int>(std::floor(center))-axis._nbr_tap/2;
+            F32 sum=0;
+            for(int k=0;k<axis._nbr_tap;k++){
+                int j = first+k;
+                if(j<0||j>=size_in)
+                    continue;
+                F32 weight;
+                if(type==MATN_INTERPOLATION_AREA){
+                    //overlap of the pixel j with the footprint [i*alpha,(i+1)*alpha) of the output pixel
+                    F32 x_min = std::max(i*alpha,static_cast<F32>(j));
+                    F32 x_max = std::min((i+1)*alpha,static_cast<F32>(j+1));
+                    weight = std::max(0.f,x_max-x_min);
+                }else if(type==MATN_INTERPOLATION_BICUBIC){
+                    weight = MatNInterpolationBicubic::kernel((j-center)/filter_scale);
+                }else{
+                    weight = MatNInterpolationLanczos::kernel((j-center)/filter_scale);
+                }
+                axis._index[i*axis._nbr_tap+k] = j;
+                axis._weight[i*axis._nbr_tap+k]= weight;
+                sum+=weight;
+            }
+            if(sum!=0){
+                for(int k=0;k<axis._nbr_tap;k++)
+                    axis._weight[i*axis._nbr_tap+k]/=sum;
+            }
+        }
+        return axis;
     }
-    template<  typename PixelType,typename Interpolation>
-    static MatN<3,PixelType> _scale(const MatN<3,PixelType> & f,const VecN<3,F32> & scale,Interpolation )
+    template<typename PixelTypeFloat,typename PixelTypeIn>
+    static void _addMultipliedLine(PixelTypeFloat * out,const PixelTypeIn * in,F32 weight,int size){
+        for(int i=0;i<size;i++)
+            out[i]+=PixelTypeFloat(in[i])*weight;
+    }
+    static void _addMultipliedLine(F32 * out,const F32 * in,F32 weight,int size){
+        FunctorMatN::_addMultiplied(out,in,weight,size);
+    }
+    template<typename PixelTypeIn,typename PixelTypeFloat>
+    struct __FunctorResampleAxis
     {
-        Vec3I32 domain (scale*VecN<2,F32>(f.getDomain()));
-        MatN<3,PixelType> temp(domain);
-        Vec3F32 alpha = Vec2F32(1.f,1.f)/scale;
-        Vec3I32 x (0,0,0);
-        Vec3F32 x_f (-0.4999f,-0.4999f,-0.4999f);
-        for(x(0)=0;x(0)<(int)temp.sizeI();x(0)++,x_f(0)+=alpha(0)){
-            x_f(1)=-0.4999f;
-            for(x(1)=0;x(1)<(int)temp.sizeJ();x(1)++,x_f(1)+=alpha(1)){
-                x_f(2)=-0.4999f;
-                for(x(2)=0;x(2)<(int)temp.sizeK();x(2)++,x_f(2)+=alpha(2)){
-                    temp(x)= Interpolation::apply(f,x_f);
+        const PixelTypeIn * _in;
+        PixelTypeFloat * _out;
+        const ResampleAxis * _axis;
+        //the matrix is a sequence of _nbr_block blocks of _size_in hyperplanes contiguous in memory, each hyperplane of _stride elements
+        int _size_in;
+        int _stride;
+        int _nbr_block;
+        //lines begin<=b<end for the contiguous direction, otherwise output hyperplanes
+        void operator()(int begin,int end){
+            const int nbr_tap = _axis->_nbr_tap;
+            const int size_out= _axis->_size_out;
+            const int * index = &_axis->_index[0];
+            const F32 * weight = &_axis->_weight[0];
+            if(_stride==1){
+                for(int b=begin;b<end;b++){
+                    const PixelTypeIn * in = _in+static_cast<std::size_t>(b)*_size_in;
+                    PixelTypeFloat * out = _out+static_cast<std::size_t>(b)*size_out;
+                    for(int i=0;i<size_out;i++){
+                        PixelTypeFloat value(0);
+                        for(int k=0;k<nbr_tap;k++)
+                            value+=PixelTypeFloat(in[index[i*nbr_tap+k]])*weight[i*nbr_tap+k];
+                        out[i]=value;
+                    }
+                }
+            }else{
+                for(int t=begin;t<end;t++){
+                    int b = t/size_out;
+                    int i = t%size_out;
+                    const PixelTypeIn * in = _in+static_cast<std::size_t>(b)*_size_in*_stride;
+                    PixelTypeFloat * out = _out+(static_cast<std::size_t>(b)*size_out+i)*_stride;
+                    std::fill(out,out+_stride,PixelTypeFloat(0));
+                    for(int k=0;k<nbr_tap;k++){
+                        if(weight[i*nbr_tap+k]!=0)
+                            _addMultipliedLine(out,in+static_cast<std::size_t>(index[i*nbr_tap+k])*_stride,weight[i*nbr_tap+k],_stride);
+                    }
                 }
             }
         }
-        return temp;
+    };
+    template<int DIM,typename PixelType>
+    struct __FunctorResampleNearest
+    {
+        const MatN<DIM,PixelType> * _in;
+        MatN<DIM,PixelType> * _out;
+        const std::vector<ResampleAxis> * _axis;
+        //lines of the output along the contiguous direction
+        void operator()(int begin,int end){
+            const int c = (DIM==1)?0:1;
+            const VecN<DIM,int> domain = _out->getDomain();
+            const int size_line = domain(c);
+            const int * index_line = &(*_axis)[c]._index[0];
+            for(int t=begin;t<end;t++){
+                int remainder = t;
+                std::size_t offset = 0;
+                for(int a=0;a<DIM;a++){
+                    if(a==c)
+                        continue;
+                    int x = remainder%domain(a);
+                    remainder/=domain(a);
+                    offset+=static_cast<std::size_t>((*_axis)[a]._index[x])*_in->stride()(a);
+                }
+                const PixelType * in = _in->data()+offset;
+                PixelType * out = _out->data()+static_cast<std::size_t>(t)*size_line;
+                for(int j=0;j<size_line;j++)
+                    out[j]=in[index_line[j]];
+            }
+        }
+    };
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> _resampleNearest(const MatN<DIM,PixelType> & f,const std::vector<ResampleAxis> & axis){
+        VecN<DIM,int> domain;
+        for(int a=0;a<DIM;a++)
+            domain(a)=axis[a]._size_out;
+        MatN<DIM,PixelType> h(domain);
+        if(domain.multCoordinate()<=0||f.getDomain().multCoordinate()<=0)
+            return h;
+        __FunctorResampleNearest<DIM,PixelType> func;
+        func._in = &f;
+        func._out = &h;
+        func._axis = &axis;
+        int nbr_line = domain.multCoordinate()/domain((DIM==1)?0:1);
+        if(domain.multCoordinate()<PARALLEL_MINIMUM_SIZE)
+            func(0,nbr_line);
+        else
+            forEachRangeParallel(0,nbr_line,func);
+        return h;
+    }
+    template<int DIM,typename PixelTypeIn,typename PixelTypeFloat>
+    static void _resamplePass(const PixelTypeIn * in,const VecN<DIM,int> & domain_in,const VecN<DIM,int> & stride_in,int a,const ResampleAxis & axis,MatN<DIM,PixelTypeFloat> & out){
+        VecN<DIM,int> domain_out(domain_in);
+        domain_out(a)=axis._size_out;
+        out.resize(domain_out);
+        __FunctorResampleAxis<PixelTypeIn,PixelTypeFloat> func;
+        func._in = in;
+        func._out = out.data();
+        func._axis = &axis;
+        func._size_in = domain_in(a);
+        func._stride = stride_in(a);
+        func._nbr_block = domain_in.multCoordinate()/(func._size_in*func._stride);
+        int nbr_range = (func._stride==1)?func._nbr_block:func._nbr_block*axis._size_out;
+        if(domain_out.multCoordinate()<PARALLEL_MINIMUM_SIZE)
+            func(0,nbr_range);
+        else
+            forEachRangeParallel(0,nbr_range,func);
     }
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> _resample(const MatN<DIM,PixelType> & f,const std::vector<ResampleAxis> & axis){
+        typedef typename FunctionTypeTraitsSubstituteF<PixelType,F32>::Result PixelTypeFloat;
+        VecN<DIM,int> domain;
+        for(int a=0;a<DIM;a++)
+            domain(a)=axis[a]._size_out;
+        if(domain.multCoordinate()<=0||f.getDomain().multCoordinate()<=0)
+            return MatN<DIM,PixelType>(domain);
+        //the directions that reduce the most are processed first to decrease the size of the next passes
+        std::vector<std::pair<F32,int> > order(DIM);
+        for(int a=0;a<DIM;a++)
+            order[a]=std::make_pair(static_cast<F32>(domain(a))/f.getDomain()(a),a);
+        std::sort(order.begin(),order.end());
+        MatN<DIM,PixelTypeFloat> buffer0,buffer1;
+        MatN<DIM,PixelTypeFloat> * buffer[2]={&buffer0,&buffer1};
+        int current=0;
+        for(int o=0;o<DIM;o++){
+            int a = order[o].second;
+            //the first pass reads the input without conversion
+            if(o==0)
+                _resamplePass(f.data(),f.getDomain(),f.stride(),a,axis[a],*buffer[1-current]);
+            else
+                _resamplePass(buffer[current]->data(),buffer[current]->getDomain(),buffer[current]->stride(),a,axis[a],*buffer[1-current]);
+            current = 1-current;
+        }
+        MatN<DIM,PixelType> h(domain);
+        for(int i=0;i<domain.multCoordinate();i++)
+            h(i)=ArithmeticsSaturation<PixelType,PixelTypeFloat>::Range((*buffer[current])(i));
+        return h;
+    }
+    //warp engine: the output point x=(i,j) maps to the source point y_k=(m(k,0)*(i+o0)+m(k,1)*(j+o1))+m(k,2), divided by y_2 for a
+    //projective matrix, with the same float operations as transformAffine2D/transformHomogeneous2D. The part depending on i is computed
+    //once per row. Each row is clipped to its valid span, then to the inner span where the four bilinear neighbours are in the domain,
+    //so that the inner loop has no bounds test.
+    struct WarpRow
+    {
+        F32 _a0,_a1,_a2;//m(k,0)*(i+o0)
+        F32 _b0,_b1,_b2;//m(k,1)
+        F32 _t0,_t1,_t2;//m(k,2)
+        F32 _o1;
+        bool _projective;
+        inline void point(int j,F32 & y0,F32 & y1)const{
+            const F32 x1 = static_cast<F32>(j)+_o1;
+            y0 = (_a0+_b0*x1)+_t0;
+            y1 = (_a1+_b1*x1)+_t1;
+            if(_projective){
+                const F32 norm = (_a2+_b2*x1)+_t2;
+                y0/=norm;
+                y1/=norm;
+            }
+        }
+    };
+    //restrict [jmin,jmax] to the j such that a+b*j>0
+    static void _clipWarpRow(F64 a,F64 b,F64 & jmin,F64 & jmax){
+        if(b==0){
+            if(a<=0){jmin=1;jmax=0;}
+        }else if(b>0){
+            jmin = (std::max)(jmin,-a/b);
+        }else{
+            jmax = (std::min)(jmax,-a/b);
+        }
+    }
+    template<typename PixelType>
+    struct __FunctorWarp2D
+    {
+        const MatN<2,PixelType> * _f;
+        MatN<2,PixelType> * _g;
+        F32 _m[9];
+        Vec2F32 _offset;
+        bool _projective;
+        bool _bilinear;
+        //true: a source point is valid if its truncation is in the domain (MatN::isValid), false: if 0<=y<domain (bounded boundary condition)
+        bool _truncation;
 
+        inline bool _isValid(F32 y0,F32 y1)const{
+            if(_truncation)
+                return y0>-1&&y1>-1&&y0<_f->getDomain()(0)&&y1<_f->getDomain()(1);
+            else
+                return y0>=0&&y1>=0&&y0<_f->getDomain()(0)&&y1<_f->getDomain()(1);
+        }
+        inline bool _isInner(F32 y0,F32 y1)const{
+            return y0>=0&&y1>=0&&y0<_f->getDomain()(0)-1&&y1<_f->getDomain()(1)-1;
+        }
+        inline bool _test(const WarpRow & row,int j,bool inner)const{
+            F32 y0,y1;
+            row.point(j,y0,y1);
+            return inner ? _isInner(y0,y1) : _isValid(y0,y1);
+        }
+        //span of the row where lower<y<upper (positive denominator), then adjusted with the float predicate
+        void _span(const WarpRow & row,F32 lower,F32 upper0,F32 upper1,bool inner,int & jmin,int & jmax)const{
+            const int w = _g->getDomain()(1);
+            //y_k = (A_k+B_k*j)/(C+E*j)
+            const F64 A0 = F64(row._a0)+F64(row._b0)*row._o1+row._t0,B0=row._b0;
+            const F64 A1 = F64(row._a1)+F64(row._b1)*row._o1+row._t1,B1=row._b1;
+            F64 C=1,E=0;
+            if(_projective){
+                C = F64(row._a2)+F64(row._b2)*row._o1+row._t2;
+                E = row._b2;
+            }
+            F64 jmin_f=0,jmax_f=w-1;
+            _clipWarpRow(A0-lower*C,B0-lower*E,jmin_f,jmax_f);
+            _clipWarpRow(upper0*C-A0,upper0*E-B0,jmin_f,jmax_f);
+            _clipWarpRow(A1-lower*C,B1-lower*E,jmin_f,jmax_f);
+            _clipWarpRow(upper1*C-A1,upper1*E-B1,jmin_f,jmax_f);
+            if(jmin_f>jmax_f){
+                //the float evaluation can be valid one pixel beyond the exact bound
+                jmin = static_cast<int>((std::max)(F64(0),(std::min)(jmin_f,F64(w-1))));
+                jmax = jmin;
+            }else{
+                jmin = static_cast<int>(std::ceil((std::max)(jmin_f,F64(0))));
+                jmax = static_cast<int>(std::floor((std::min)(jmax_f,F64(w-1))));
+            }
+            while(jmin<=jmax&&!_test(row,jmin,inner))jmin++;
+            while(jmax>=jmin&&!_test(row,jmax,inner))jmax--;
+            if(jmin>jmax)
+                return;
+            while(jmin>0&&_test(row,jmin-1,inner))jmin--;
+            while(jmax<w-1&&_test(row,jmax+1,inner))jmax++;
+        }
+        void _border(const WarpRow & row,PixelType * out,int jbegin,int jend){
+            F32 y0,y1;
+            for(int j=jbegin;j<jend;j++){
+                row.point(j,y0,y1);
+                if(_isValid(y0,y1))
+                    out[j]= _bilinear ? _f->interpolationBilinear(Vec2F32(y0,y1)) : (*_f)(static_cast<int>(y0),static_cast<int>(y1));
+            }
+        }
+        void _inner(const WarpRow & row,PixelType * out,int jbegin,int jend,std::vector<int> & v_index,std::vector<F32> & v_y0,std::vector<F32> & v_y1){
+            typedef typename FunctionTypeTraitsSubstituteF<PixelType,F32>::Result PixelTypeFloat;
+            const int w_in = _f->getDomain()(1);
+            const PixelType * in = _f->data();
+            //source points and offsets of the row (positive coordinates, so the truncation is the floor)
+            int j=jbegin;
+            int n=0;
+#if defined(__SSE2__)
+            if(!_projective){
+                const __m128 step = _mm_set_ps(3,2,1,0);
+                const __m128 a0 = _mm_set1_ps(row._a0),a1 = _mm_set1_ps(row._a1);
+                const __m128 b0 = _mm_set1_ps(row._b0),b1 = _mm_set1_ps(row._b1);
+                const __m128 t0 = _mm_set1_ps(row._t0),t1 = _mm_set1_ps(row._t1);
+                const __m128 o1 = _mm_set1_ps(row._o1);
+                int x0[4],x1[4];
+                for(;j+4<=jend;j+=4,n+=4){
+                    __m128 jj = _mm_add_ps(_mm_add_ps(_mm_set1_ps(static_cast<F32>(j)),step),o1);
+                    __m128 y0 = _mm_add_ps(_mm_add_ps(a0,_mm_mul_ps(b0,jj)),t0);
+                    __m128 y1 = _mm_add_ps(_mm_add_ps(a1,_mm_mul_ps(b1,jj)),t1);
+                    _mm_storeu_ps(&v_y0[n],y0);
+                    _mm_storeu_ps(&v_y1[n],y1);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(x0),_mm_cvttps_epi32(y0));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(x1),_mm_cvttps_epi32(y1));
+                    for(int k=0;k<4;k++)
+                        v_index[n+k]=x0[k]*w_in+x1[k];
+                }
+            }
+#endif
+            for(;j<jend;j++,n++){
+                row.point(j,v_y0[n],v_y1[n]);
+                v_index[n]=static_cast<int>(v_y0[n])*w_in+static_cast<int>(v_y1[n]);
+            }
+            n=0;
+            if(_bilinear){
+                //same weights as MatNInterpolationBiliniear
+                for(j=jbegin;j<jend;j++,n++){
+                    const PixelType * p = in+v_index[n];
+                    const F32 y0 = v_y0[n],y1 = v_y1[n];
+                    const F32 x0 = static_cast<F32>(static_cast<int>(y0)),x1 = static_cast<F32>(static_cast<int>(y1));
+                    const F32 u0 = 1-(y0-x0),v0 = 1-((x0+1)-y0);
+                    const F32 u1 = 1-(y1-x1),v1 = 1-((x1+1)-y1);
+                    PixelTypeFloat value(0);
+                    value+=p[0]*(u0*u1);
+                    value+=p[w_in]*(v0*u1);
+                    value+=p[w_in+1]*(v0*v1);
+                    value+=p[1]*(u0*v1);
+                    out[j]=ArithmeticsSaturation<PixelType,PixelTypeFloat>::Range(value);
+                }
+            }else{
+                for(j=jbegin;j<jend;j++,n++)
+                    out[j]=in[v_index[n]];
+            }
+        }
+        //rows begin<=i<end
+        void operator()(int begin,int end){
+            const int w = _g->getDomain()(1);
+            std::vector<int> v_index(w);
+            std::vector<F32> v_y0(w),v_y1(w);
+            const F32 d0 = static_cast<F32>(_f->getDomain()(0)),d1 = static_cast<F32>(_f->getDomain()(1));
+            for(int i=begin;i<end;i++){
+                PixelType * out = _g->data()+static_cast<std::size_t>(i)*w;
+                const F32 x0 = static_cast<F32>(i)+_offset(0);
+                WarpRow row;
+                row._projective = _projective;
+                row._a0 = _m[0]*x0; row._b0 = _m[1]; row._t0 = _m[2];
+                row._a1 = _m[3]*x0; row._b1 = _m[4]; row._t1 = _m[5];
+                row._a2 = _m[6]*x0; row._b2 = _m[7]; row._t2 = _m[8];
+                row._o1 = _offset(1);
+                if(_projective){
+                    const F32 norm_first = (row._a2+row._b2*(0+row._o1))+row._t2;
+                    const F32 norm_last  = (row._a2+row._b2*((w-1)+row._o1))+row._t2;
+                    if(norm_first<0&&norm_last<0){
+                        //same source points with a positive denominator (the negation is exact)
+                        row._a0=-row._a0;row._b0=-row._b0;row._t0=-row._t0;
+                        row._a1=-row._a1;row._b1=-row._b1;row._t1=-row._t1;
+                        row._a2=-row._a2;row._b2=-row._b2;row._t2=-row._t2;
+                    }else if(norm_first<=0||norm_last<=0){
+                        //the horizon line crosses the row
+                        _border(row,out,0,w);
+                        continue;
+                    }
+                }
+                int jmin,jmax;
+                _span(row,_truncation?-1.f:0.f,d0,d1,false,jmin,jmax);
+                if(jmin>jmax)
+                    continue;
+                int kmin=jmin,kmax=jmax;
+                if(_bilinear){
+                    _span(row,0,d0-1,d1-1,true,kmin,kmax);
+                    kmin = (std::max)(kmin,jmin);
+                    kmax = (std::min)(kmax,jmax);
+                }
+                if(kmin>kmax){
+                    _border(row,out,jmin,jmax+1);
+                }else{
+                    _border(row,out,jmin,kmin);
+                    _inner(row,out,kmin,kmax+1,v_index,v_y0,v_y1);
+                    _border(row,out,kmax+1,jmax+1);
+                }
+            }
+        }
+    };
+    //g(x)=f(m*(x+offset)) for the points x of g with a valid source point, the other points of g are unchanged
+    template<typename PixelType>
+    static void _warp2D(const MatN<2,PixelType> & f,MatN<2,PixelType> & g,const Mat2x33F32 & m,const Vec2F32 & offset,bool bilinear,bool truncation){
+        __FunctorWarp2D<PixelType> func;
+        func._f = &f;
+        func._g = &g;
+        for(int k=0;k<9;k++)
+            func._m[k] = m._dat[k];
+        func._offset = offset;
+        func._projective = (m._dat[6]!=0||m._dat[7]!=0||m._dat[8]!=1);
+        func._bilinear = bilinear;
+        func._truncation = truncation;
+        if(g.getDomain().multCoordinate()<PARALLEL_MINIMUM_SIZE)
+            func(0,g.getDomain()(0));
+        else
+            forEachRangeParallel(0,g.getDomain()(0),func);
+    }
+    //3D warp engine: the output point x=(i,j,k) maps to the source point y=m*(x+o). Along a row (i,k fixed), y=A+B*j with A computed
+    //once per row. As in 2D, the row is clipped to the valid span and to the inner span where the eight trilinear neighbours are in the domain.
+    template<typename PixelType>
+    struct __FunctorWarp3D
+    {
+        const MatN<3,PixelType> * _f;
+        MatN<3,PixelType> * _g;
+        //3x4 affine matrix, row major
+        F32 _m[12];
+        Vec3F32 _offset;
+        bool _bilinear;
+
+        //nearest: the translation is shifted by 1/2, so that the valid points are 0<=y<domain and the truncation is the rounding
+        inline bool _isValid(const F32 * y)const{
+            if(_bilinear)
+                return y[0]>-1&&y[1]>-1&&y[2]>-1&&y[0]<_f->getDomain()(0)&&y[1]<_f->getDomain()(1)&&y[2]<_f->getDomain()(2);
+            else
+                return y[0]>=0&&y[1]>=0&&y[2]>=0&&y[0]<_f->getDomain()(0)&&y[1]<_f->getDomain()(1)&&y[2]<_f->getDomain()(2);
+        }
+        inline bool _isInner(const F32 * y)const{
+            return y[0]>=0&&y[1]>=0&&y[2]>=0&&y[0]<_f->getDomain()(0)-1&&y[1]<_f->getDomain()(1)-1&&y[2]<_f->getDomain()(2)-1;
+        }
+        inline void _point(const F32 * a,int j,F32 * y)const{
+            const F32 x1 = static_cast<F32>(j)+_offset(1);
+            y[0] = a[0]+_m[1]*x1;
+            y[1] = a[1]+_m[5]*x1;
+            y[2] = a[2]+_m[9]*x1;
+        }
+        inline bool _test(const F32 * a,int j,bool inner)const{
+            F32 y[3];
+            _point(a,j,y);
+            return inner ? _isInner(y) : _isValid(y);
+        }
+        void _span(const F32 * a,F32 lower,const F32 * upper,bool inner,int & jmin,int & jmax)const{
+            const int w = _g->getDomain()(1);
+            F64 jmin_f=0,jmax_f=w-1;
+            for(int c=0;c<3;c++){
+                const F64 A = F64(a[c])+F64(_m[4*c+1])*_offset(1),B = _m[4*c+1];
+                _clipWarpRow(A-lower,B,jmin_f,jmax_f);
+                _clipWarpRow(upper[c]-A,-B,jmin_f,jmax_f);
+            }
+            if(jmin_f>jmax_f){
+                jmin = static_cast<int>((std::max)(F64(0),(std::min)(jmin_f,F64(w-1))));
+                jmax = jmin;
+            }else{
+                jmin = static_cast<int>(std::ceil((std::max)(jmin_f,F64(0))));
+                jmax = static_cast<int>(std::floor((std::min)(jmax_f,F64(w-1))));
+            }
+            while(jmin<=jmax&&!_test(a,jmin,inner))jmin++;
+            while(jmax>=jmin&&!_test(a,jmax,inner))jmax--;
+            if(jmin>jmax)
+                return;
+            while(jmin>0&&_test(a,jmin-1,inner))jmin--;
+            while(jmax<w-1&&_test(a,jmax+1,inner))jmax++;
+        }
+        void _border(const F32 * a,PixelType * out,int jbegin,int jend){
+            F32 y[3];
+            for(int j=jbegin;j<jend;j++){
+                _point(a,j,y);
+                if(_isValid(y)){
+                    if(_bilinear)
+                        out[j]=_f->interpolationBilinear(Vec3F32(y[0],y[1],y[2]));
+                    else
+                        out[j]=(*_f)(static_cast<int>(y[0]),static_cast<int>(y[1]),static_cast<int>(y[2]));
+                }
+            }
+        }
+        void _inner(const F32 * a,PixelType * out,int jbegin,int jend,std::vector<int> & v_index,std::vector<F32> & v_y){
+            typedef typename FunctionTypeTraitsSubstituteF<PixelType,F32>::Result PixelTypeFloat;
+            const int s0 = _f->getDomain()(1);
+            const int s2 = _f->getDomain()(0)*_f->getDomain()(1);
+            const PixelType * in = _f->data();
+            int j=jbegin;
+            int n=0;
+#if defined(__SSE2__)
+            const __m128 step = _mm_set_ps(3,2,1,0);
+            const __m128 o1 = _mm_set1_ps(_offset(1));
+            const __m128 a0 = _mm_set1_ps(a[0]),a1 = _mm_set1_ps(a[1]),a2 = _mm_set1_ps(a[2]);
+            const __m128 b0 = _mm_set1_ps(_m[1]),b1 = _mm_set1_ps(_m[5]),b2 = _mm_set1_ps(_m[9]);
+            int x0[4],x1[4],x2[4];
+            for(;j+4<=jend;j+=4,n+=4){
+                __m128 jj = _mm_add_ps(_mm_add_ps(_mm_set1_ps(static_cast<F32>(j)),step),o1);
+                __m128 y0 = _mm_add_ps(a0,_mm_mul_ps(b0,jj));
+                __m128 y1 = _mm_add_ps(a1,_mm_mul_ps(b1,jj));
+                __m128 y2 = _mm_add_ps(a2,_mm_mul_ps(b2,jj));
+                __m128i i0 = _mm_cvttps_epi32(y0),i1 = _mm_cvttps_epi32(y1),i2 = _mm_cvttps_epi32(y2);
+                _mm_storeu_ps(&v_y[3*n],_mm_sub_ps(y0,_mm_cvtepi32_ps(i0)));
+                _mm_storeu_ps(&v_y[3*n+4],_mm_sub_ps(y1,_mm_cvtepi32_ps(i1)));
+                _mm_storeu_ps(&v_y[3*n+8],_mm_sub_ps(y2,_mm_cvtepi32_ps(i2)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x0),i0);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x1),i1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(x2),i2);
+                for(int l=0;l<4;l++)
+                    v_index[n+l]=x0[l]*s0+x1[l]+x2[l]*s2;
+            }
+#endif
+            //the fractional parts are stored by packets of 4 points: y0 of the 4 points, then y1, then y2
+            for(;j<jend;j++,n++){
+                F32 y[3];
+                _point(a,j,y);
+                int x0 = static_cast<int>(y[0]),x1 = static_cast<int>(y[1]),x2 = static_cast<int>(y[2]);
+                const int p = (n/4)*12+n%4;
+                v_y[p]=y[0]-x0;
+                v_y[p+4]=y[1]-x1;
+                v_y[p+8]=y[2]-x2;
+                v_index[n]=x0*s0+x1+x2*s2;
+            }
+            n=0;
+            if(_bilinear){
+                for(j=jbegin;j<jend;j++,n++){
+                    const PixelType * p = in+v_index[n];
+                    const int q = (n/4)*12+n%4;
+                    const F32 w0 = v_y[q],w1 = v_y[q+4],w2 = v_y[q+8];
+                    //interpolation along the contiguous axis first
+                    PixelTypeFloat c00 = PixelTypeFloat(p[0])*(1-w1)+PixelTypeFloat(p[1])*w1;
+                    PixelTypeFloat c10 = PixelTypeFloat(p[s0])*(1-w1)+PixelTypeFloat(p[s0+1])*w1;
+                    PixelTypeFloat c01 = PixelTypeFloat(p[s2])*(1-w1)+PixelTypeFloat(p[s2+1])*w1;
+                    PixelTypeFloat c11 = PixelTypeFloat(p[s2+s0])*(1-w1)+PixelTypeFloat(p[s2+s0+1])*w1;
+                    PixelTypeFloat c0 = c00*(1-w0)+c10*w0;
+                    PixelTypeFloat c1 = c01*(1-w0)+c11*w0;
+                    out[j]=ArithmeticsSaturation<PixelType,PixelTypeFloat>::Range(c0*(1-w2)+c1*w2);
+                }
+            }else{
+                for(j=jbegin;j<jend;j++,n++)
+                    out[j]=in[v_index[n]];
+            }
+        }
+        //slices begin<=k<end
+        void operator()(int begin,int end){
+            const int d0 = _g->getDomain()(0),w = _g->getDomain()(1);
+            std::vector<int> v_index(w);
+            std::vector<F32> v_y(3*(w+4));
+            const F32 lower = _bilinear ? -1.f : 0.f;
+            F32 upper[3],upper_inner[3];
+            for(int c=0;c<3;c++){
+                upper[c]=static_cast<F32>(_f->getDomain()(c));
+                upper_inner[c]=upper[c]-1;
+            }
+            for(int k=begin;k<end;k++){
+                const F32 x2 = static_cast<F32>(k)+_offset(2);
+                for(int i=0;i<d0;i++){
+                    const F32 x0 = static_cast<F32>(i)+_offset(0);
+                    PixelType * out = _g->data()+static_cast<std::size_t>(k)*d0*w+static_cast<std::size_t>(i)*w;
+                    F32 a[3];
+                    for(int c=0;c<3;c++)
+                        a[c] = _m[4*c]*x0+_m[4*c+2]*x2+_m[4*c+3];
+                    int jmin,jmax;
+                    _span(a,lower,upper,false,jmin,jmax);
+                    if(jmin>jmax)
+                        continue;
+                    int kmin=jmin,kmax=jmax;
+                    if(_bilinear){
+                        _span(a,0,upper_inner,true,kmin,kmax);
+                        kmin = (std::max)(kmin,jmin);
+                        kmax = (std::min)(kmax,jmax);
+                    }
+                    if(kmin>kmax){
+                        _border(a,out,jmin,jmax+1);
+                    }else{
+                        _border(a,out,jmin,kmin);
+                        _inner(a,out,kmin,kmax+1,v_index,v_y);
+                        _border(a,out,kmax+1,jmax+1);
+                    }
+                }
+            }
+        }
+    };
+    //\endcond
     /*!
      * \brief scale the image
      * \param scale vector of scale factor
      * \param f input matrix
-     * \param interpolation: 0=no, 1=BI-LINEAR
+     * \param interpolation MATN_INTERPOLATION_NEAREST, MATN_INTERPOLATION_BILINEAR, MATN_INTERPOLATION_BICUBIC, MATN_INTERPOLATION_LANCZOS or MATN_INTERPOLATION_AREA
      *
      * scale the matrix with its domain of definition. For instance, in this code:
      * \code
@@ -185,11 +756,14 @@ struct POP_EXPORTS GeometricalTransformation
     */
     template<int DIM,  typename PixelType>
     static MatN<DIM,PixelType> scale(const MatN<DIM,PixelType> & f,const VecN<DIM,F32> & scale,MatNInterpolationType interpolation=MATN_INTERPOLATION_NEAREST ){
-        if(interpolation==MATN_INTERPOLATION_NEAREST){
-            return _scale(f,scale,MatNInterpolationNearest());
-        }else{
-            return _scale(f,scale,MatNInterpolationBiliniear());
-        }
+        VecN<DIM,int> domain(scale*VecN<DIM,F32>(f.getDomain()));
+        std::vector<ResampleAxis> axis(DIM);
+        for(int a=0;a<DIM;a++)
+            axis[a]=_resampleAxis(f.getDomain()(a),domain(a),1.f/scale(a),interpolation);
+        if(interpolation==MATN_INTERPOLATION_NEAREST)
+            return _resampleNearest(f,axis);
+        else
+            return _resample(f,axis);
     }
 
 
@@ -250,11 +824,18 @@ struct POP_EXPORTS GeometricalTransformation
     static MatN<2,PixelType> rotate(const MatN<2,PixelType> & f,F32 angle,MatNBoundaryConditionType boundarycondtion=MATN_BOUNDARY_CONDITION_BOUNDED)
     {
         Mat2x22F32 rot22 = GeometricalTransformation::rotation2D(angle);
-        typename MatN<2,PixelType>::IteratorEDomain it = f.getIteratorEDomain();
-
         MatN<2,PixelType> g(f.getDomain());
         Vec2F32 c(f.getDomain()/2);
-        it.init();
+        if(boundarycondtion==MATN_BOUNDARY_CONDITION_BOUNDED){
+            //y = rot22*(x-c)+c
+            Mat2x33F32 m;
+            m._dat[0]=rot22._dat[0];m._dat[1]=rot22._dat[1];m._dat[2]=c(0);
+            m._dat[3]=rot22._dat[2];m._dat[4]=rot22._dat[3];m._dat[5]=c(1);
+            m._dat[6]=0;m._dat[7]=0;m._dat[8]=1;
+            _warp2D(f,g,m,-c,true,false);
+            return g;
+        }
+        typename MatN<2,PixelType>::IteratorEDomain it = g.getIteratorEDomain();
         MatNBoundaryCondition condition(boundarycondtion);
         while(it.next()){
             Vec2F32 y =Vec2F32(it.x()(0),it.x()(1))-c;
@@ -728,17 +1309,86 @@ struct POP_EXPORTS GeometricalTransformation
             xmax = f.getDomain();
         }
         MatN<2,Type> g(domain);
-        typename MatN<2,Type>::IteratorEDomain it(g.getIteratorEDomain());
         Mat2x33F32 maffine_inverse;
         maffine_inverse = maffine.inverse();//inverse of affine matrix is still affine matrix !
-        while(it.next()){
-            Vec2F32 x(it.x()+xmin);
-            x =  GeometricalTransformation::transformAffine2D(maffine_inverse,x);
-            if(f.isValid(x))
-                g(it.x())=f.interpolationBilinear(x);
+        //as in the point version, the output point is shifted by the integer part of xmin
+        _warp2D(f,g,maffine_inverse,Vec2F32(Vec2I32(xmin)),true,true);
+        return g;
+    }
+    /*!
+     * \brief Affine transformation on a 3D matrix
+     * \param maffine affine transformation matrix in homogeneous coordinates (4x4)
+     * \param f input matrix
+     * \param automaticsize if true, the output domain is the bounding box of the transformed domain, otherwise the domain of f
+     * \param interpolation MATN_INTERPOLATION_NEAREST or MATN_INTERPOLATION_BILINEAR (trilinear)
+     * \return output matrix
+     *
+     * The output voxel x takes the value of f at maffine^{-1}*x, and 0 outside the input domain. The slices are processed in parallel.
+     * For instance, the rotation of a volume about its center:
+     * \code
+     * Mat3UI8 m;
+     * m.loadFromDirectory("/home/vincent/Desktop/WorkSegmentation/sand/","500-","pgm");
+     * Vec3F32 c(m.getDomain()/2);
+     * Mat2F32 maffine = GeometricalTransformation::translation3DHomogeneousCoordinate(c);
+     * maffine = maffine*GeometricalTransformation::rotation3DHomogeneousCoordinate(PI/6,2);
+     * maffine = maffine*GeometricalTransformation::translation3DHomogeneousCoordinate(-c);
+     * m = GeometricalTransformation::transformAffine3D(maffine,m,true,MATN_INTERPOLATION_BILINEAR);
+     * \endcode
+    */
+    template< typename Type>
+    static MatN<3,Type> transformAffine3D(const Mat2F32 & maffine,const MatN<3,Type> & f,bool automaticsize=false,MatNInterpolationType interpolation=MATN_INTERPOLATION_BILINEAR)
+    {
+        POP_DbgAssertMessage(maffine.sizeI()==4&&maffine.sizeJ()==4,"In GeometricalTransformation::transformAffine3D, the matrix must be 4x4 (homogeneous coordinates)");
+        Vec3F32 xmin(0,0,0);
+        Vec3I32 domain(f.getDomain());
+        if(automaticsize==true){
+            Vec3F32 xmax(-NumericLimits<F32>::maximumRange());
+            xmin = NumericLimits<F32>::maximumRange();
+            for(int corner=0;corner<8;corner++){
+                Vec3F32 x;
+                for(int c=0;c<3;c++)
+                    x(c)= (corner&(1<<c)) ? static_cast<F32>(f.getDomain()(c)) : 0.f;
+                x = GeometricalTransformation::transformAffine3D(maffine,x);
+                xmin=minimum(xmin,x); xmax=maximum(xmax,x);
+            }
+            for(int c=0;c<3;c++){
+                xmin(c) = std::floor(xmin(c));
+                domain(c) = (std::max)(1,static_cast<int>(std::ceil(xmax(c)-xmin(c))));
+            }
         }
+        MatN<3,Type> g(domain);
+        Mat2F32 maffine_inverse = maffine.inverse();
+        __FunctorWarp3D<Type> func;
+        func._f = &f;
+        func._g = &g;
+        for(int i=0;i<3;i++)
+            for(int j=0;j<4;j++)
+                func._m[4*i+j] = maffine_inverse(i,j);
+        func._offset = xmin;
+        func._bilinear = (interpolation!=MATN_INTERPOLATION_NEAREST);
+        if(func._bilinear==false){
+            //rounding of the source point
+            for(int i=0;i<3;i++)
+                func._m[4*i+3]+=0.5f;
+        }
+        if(domain.multCoordinate()<PARALLEL_MINIMUM_SIZE)
+            func(0,domain(2));
+        else
+            forEachRangeParallel(0,domain(2),func);
         return g;
     }
+    /*!
+    * \brief Affine transformation on a 3d vector
+    * \param x 3d input vector
+    * \param maffine affine transformation matrix in homogeneous coordinates (4x4)
+    * \return output vector after the affine transformation
+    */
+    static inline Vec3F32 transformAffine3D(const Mat2F32 & maffine,const Vec3F32 & x)
+    {
+        return Vec3F32(maffine(0,0)*x(0) + maffine(0,1)*x(1)+maffine(0,2)*x(2)+maffine(0,3),
+                       maffine(1,0)*x(0) + maffine(1,1)*x(1)+maffine(1,2)*x(2)+maffine(1,3),
+                       maffine(2,0)*x(0) + maffine(2,1)*x(1)+maffine(2,2)*x(2)+maffine(2,3));
+    }
     /*!
      * \brief Projective transformation on matrix
      * \param f input matrix
@@ -774,15 +1424,9 @@ struct POP_EXPORTS GeometricalTransformation
     static MatN<2,Type> transformHomogeneous2D(const pop::Mat2x33F32 & mproj,const MatN<2,Type> & f)
     {
         MatN<2,Type> gtransform(f.getDomain());
-        typename MatN<2,Type>::IteratorEDomain it(gtransform.getIteratorEDomain());
         Mat2x33F32 mproj_inverse;
         mproj_inverse = mproj.inverse();
-        while(it.next()){
-            Vec2F32 x(Vec2F32(it.x()));
-            x =  GeometricalTransformation::transformHomogeneous2D(mproj_inverse,x);
-            if(f.isValid(x))
-                gtransform(it.x())=f.interpolationBilinear(x);
-        }
+        _warp2D(f,gtransform,mproj_inverse,Vec2F32(0,0),true,true);
         return gtransform;
     }
     /*!
@@ -869,15 +1513,9 @@ struct POP_EXPORTS GeometricalTransformation
         trans=minimum(trans,x); xmax=maximum(xmax,x);
 
         MatN<2,Type> panoramic(xmax-trans);
-        ForEachDomain2D(xit,panoramic){
-            Vec2F32 x_trans = Vec2F32(xit)+trans;
-            Vec2F32 xx  =  GeometricalTransformation::transformHomogeneous2D(mhom,x_trans);
-            if(f.isValid(x_trans)==true)
-                panoramic(xit) = f(x_trans);
-            if(g.isValid(xx)==true)
-                panoramic(xit)=g(xx);
-
-        }
+        //f translated, then g transformed on top of it
+        _warp2D(f,panoramic,Mat2x33F32::identity(),trans,false,true);
+        _warp2D(g,panoramic,mhom,trans,false,true);
         return panoramic;
     }
 
@@ -373,7 +373,7 @@ struct POP_EXPORTS LinearAlgebra
      * \brief find beta such that \f$\hat{\boldsymbol{\beta}} = \underset{\boldsymbol{\beta}}{\operatorname{arg\,min}}\, \bigl\|\mathbf y - \mathbf X \boldsymbol \beta \bigr\|^2\f$
      * \param X input matrix
      * \param Y output vector
-     * \return beta
+     * \return beta ((0,0) if X is empty or if Y does not have one element by row of X)
      *
      * See  <a href=http://en.wikipedia.org/wiki/Linear_least_squares_%28mathematics%29>wikipedia </a>
      * \code
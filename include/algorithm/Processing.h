@@ -38,6 +38,7 @@ in the Software.
 #include"algorithm/ProcessingAdvanced.h"
 #include"algorithm/Analysis.h"
 #include"algorithm/Draw.h"
+#include"algorithm/Representation.h"
 #include"data/mat/MatNIteratorE.h"
 namespace pop
 {
@@ -119,9 +120,41 @@ struct POP_EXPORTS Processing
     template<int DIM,typename PixelType>
     static void  randomField(const VecN<DIM,int> & domain ,Distribution &d, MatN<DIM,PixelType> & h){
         h.resize(domain) ;
-        typename MatN<DIM,PixelType>::IteratorEDomain it(h.getIteratorEDomain());
-        h= ProcessingAdvanced::randomField< MatN<DIM,PixelType> >(domain,d,it);
+        __FunctorRandomField<PixelType> func;
+        func._d = &d;
+        func._out = h.data();
+        func._size = static_cast<int>(h.size());
+        //one stream by block, so the field does not depend on the number of threads
+        func._seed = Distribution::engine()();
+        func._seed = (func._seed<<32)|Distribution::engine()();
+        const int nbr_block = (func._size+__FunctorRandomField<PixelType>::BLOCK-1)/__FunctorRandomField<PixelType>::BLOCK;
+        if(func._size<PARALLEL_MINIMUM_SIZE)
+            func(0,nbr_block);
+        else
+            forEachRangeParallel(0,nbr_block,func);
     }
+    //    \cond HIDDEN_SYMBOLS
+    template<typename PixelType>
+    struct __FunctorRandomField
+    {
+        enum{BLOCK=4096};
+        const Distribution * _d;
+        PixelType * _out;
+        int _size;
+        UI64 _seed;
+        void operator()(int begin,int end){
+            std::vector<F32> v(BLOCK);
+            for(int b=begin;b<end;b++){
+                RandomEngine engine(_seed,static_cast<UI64>(b));
+                int n = (std::min)(static_cast<int>(BLOCK),_size-b*BLOCK);
+                _d->randomVariables(n,&v[0],engine);
+                PixelType * out = _out+b*BLOCK;
+                for(int i=0;i<n;i++)
+                    out[i]=v[i];
+            }
+        }
+    };
+    //\endcond
     //@}
     //-------------------------------------
     //
@@ -413,14 +446,29 @@ struct POP_EXPORTS Processing
     static MatN<2,UI8>  thresholdNiblackMethod(const MatN<2,PixelType> & f,F32 k=0.2,int radius=5,F32 offset_value=0  ){
         MatN<2,PixelType> fborder(f);
         Draw::addBorder(fborder,radius,typename MatN<2,PixelType>::F(0),MATN_BOUNDARY_CONDITION_MIRROR);
-        MatN<2,UI32> f_F32(fborder);
-        MatN<2,UI32> integral = Processing::integral(f_F32);
-        MatN<2,UI32> integralpower2 = Processing::integralPower2(f_F32);
-        typename MatN<2,UI32>::IteratorERectangle it(fborder.getIteratorERectangle(Vec2I32(radius),f_F32.getDomain()-1-Vec2I32(radius)));
-
-        F32 area_minus1 = 1.f/((2*radius+1)*(2*radius+1));
-        __FunctorNiblackMethod func(integral,integralpower2,area_minus1,k, radius, offset_value);
-        forEachFunctorBinaryFunctionE(f,fborder,func,it);
+        ProcessingAdvanced::BoxStatistics<2,PixelType> stat(fborder);
+        __FunctorNiblackMethod<PixelType> func(stat,k, radius, offset_value);
+        forEachFunctorBinaryFunctionE(f,fborder,func,Vec2I32(radius),fborder.getDomain()-1-Vec2I32(radius));
+        return fborder( Vec2I32(radius) , fborder.getDomain()-Vec2I32(radius));
+    }
+    /*!
+     * \brief Sauvola threshold (2000), Adaptive document image binarization, Pattern Recognition
+     * \param f input function
+     * \param k multiplicative factor of the normalized standard deviation
+     * \param radius neighbordhood radius
+     * \param dynamic_range dynamic range of the standard deviation (128 for 8 bits)
+     * \param offset_value offset value
+     * \return output function noted h
+     *
+     * pixel = ( pixel >  mean * (1 + k * (standard_deviation/dynamic_range - 1)) - offset_value) ? object : background
+    */
+    template<typename PixelType>
+    static MatN<2,UI8>  thresholdSauvolaMethod(const MatN<2,PixelType> & f,F32 k=0.5,int radius=5,F32 dynamic_range=128,F32 offset_value=0  ){
+        MatN<2,PixelType> fborder(f);
+        Draw::addBorder(fborder,radius,typename MatN<2,PixelType>::F(0),MATN_BOUNDARY_CONDITION_MIRROR);
+        ProcessingAdvanced::BoxStatistics<2,PixelType> stat(fborder);
+        __FunctorSauvolaMethod<PixelType> func(stat,k, radius, dynamic_range,offset_value);
+        forEachFunctorBinaryFunctionE(f,fborder,func,Vec2I32(radius),fborder.getDomain()-1-Vec2I32(radius));
         return fborder( Vec2I32(radius) , fborder.getDomain()-Vec2I32(radius));
     }
     /*!
@@ -436,13 +484,9 @@ struct POP_EXPORTS Processing
     static MatN<2,UI8>  thresholdAdaptativeMean(const MatN<2,PixelType> & f,int radius=5,F32 offset_value=0  ){
         MatN<2,PixelType> fborder(f);
         Draw::addBorder(fborder,radius,typename MatN<2,PixelType>::F(0),MATN_BOUNDARY_CONDITION_MIRROR);
-        MatN<2,UI32> f_F32(fborder);
-        MatN<2,UI32> integral = Processing::integral(f_F32);
-        typename MatN<2,UI32>::IteratorERectangle it(fborder.getIteratorERectangle(Vec2I32(radius),f_F32.getDomain()-1-Vec2I32(radius)));
-
-        F32 area_minus1 = 1.f/((2*radius+1)*(2*radius+1));
-        __FunctorMean func(integral,area_minus1, radius, offset_value);
-        forEachFunctorBinaryFunctionE(f,fborder,func,it);
+        ProcessingAdvanced::BoxStatistics<2,PixelType> stat(fborder,false);
+        __FunctorMean<PixelType> func(stat, radius, offset_value);
+        forEachFunctorBinaryFunctionE(f,fborder,func,Vec2I32(radius),fborder.getDomain()-1-Vec2I32(radius));
         return fborder( Vec2I32(radius) , fborder.getDomain()-Vec2I32(radius));
     }
     /*!
@@ -947,6 +991,7 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * Mat2RGBUI8 erosion =processing.erosion(img,3,2);
      * erosion.display();
      *  \endcode
+     * For a scalar pixel type and the norm 0 (a box), the van Herk/Gil-Werman algorithm is used so the computational time does not depend on the radius.
      */
     template<int DIM,typename PixelType>
     static MatN<DIM,PixelType> erosion(const MatN<DIM,PixelType> & f,F32 radius,int norm=2)
@@ -1009,6 +1054,7 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * Mat2RGBUI8 dilation =processing.dilation(img,3,2);
      * dilation.display();
      *  \endcode
+     * For a scalar pixel type and the norm 0 (a box), the van Herk/Gil-Werman algorithm is used so the computational time does not depend on the radius.
      */
     template<int DIM,typename PixelType>
     static MatN<DIM,PixelType> dilation(const MatN<DIM,PixelType> & f,F32 radius,int norm=2)
@@ -1062,7 +1108,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      *
      *  median of the input matrix:\n
      * \f$\forall x \in E:\quad h(x) =\mbox{median}_{\forall x'\in N(x) }f(x') \f$ where the operator median returns the median value of the list of input values and
-     * \f$N(x)=\{x': \|x'-x\|_n<=r\} \f$. For instance,
+     * \f$N(x)=\{x': \|x'-x\|_n<=r\} \f$. For the 8 and 16 bits pixel types, a sliding histogram is used so the cost grows with the
+     * radius power DIM-1 instead of DIM. For instance,
      * \code
      * Mat2RGBUI8 img;
      * img.load((std::string(POP_PROJECT_SOURCE_DIR)+"/image/Lena.bmp").c_str());
@@ -1123,7 +1170,7 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \return h output function
      *
      *  mean of the input matrix:\n
-     * \f$\forall x \in E:\quad h(x) =\mbox{mean}_{\forall x'\in N(x) }f(x') \f$ where \f$N(x)=\{x': \|x'-x\|_n<=r\} \f$. For instance,
+     * \f$\forall x \in E:\quad h(x) =\mbox{mean}_{\forall x'\in N(x) }f(x') \f$ where \f$N(x)=\{x': \|x'-x\|_n<=r\} \f$. For the norm 0 (box) and a scalar pixel type, the mean is computed in constant time by pixel with the integral of f (see ProcessingAdvanced::BoxStatistics). For instance,
      * \code
      * Mat2RGBUI8 img;
      * img.load((std::string(POP_PROJECT_SOURCE_DIR)+"/image/Lena.bmp").c_str());
@@ -1541,6 +1588,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * In order to compute the convolution in discrete space, the basic idea is the truncation of the infinite support of the filtering function by a finite support,a window of some finite size and shape.
      * Then this windows is scanned across the matrix. The output pixel value is the weighted sum of the input pixels within the window where the weights are the values of the filter assigned
      * to every pixel of the window itself.\n
+     * For the scalar pixel types, the convolution is computed directly or by overlap-save FFT (see Representation::convolutionByFFT), the cheapest
+     * of the two for the sizes of the matrix and of the kernel, so the large kernels as 31x31x31 are computed in a time independent of the kernel size.\n
      * For instance, the convolution with a home-made kernel:
      \code
     F32 d[]=
@@ -1560,10 +1609,34 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
     */
     template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
     static MatN<DIM,PixelType1> convolution(const MatN<DIM,PixelType1> & f, const MatN<DIM,PixelType2> & kernel,BoundaryCondition boundarycondition)
+    {
+        return _convolution(f,kernel,boundarycondition,Int2Type<std::numeric_limits<PixelType1>::is_specialized&&std::numeric_limits<PixelType2>::is_specialized>());
+    }
+    //    \cond HIDDEN_SYMBOLS
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,PixelType1> _convolution(const MatN<DIM,PixelType1> & f, const MatN<DIM,PixelType2> & kernel,BoundaryCondition boundarycondition,Int2Type<false>)
     {
         typename MatN<DIM,PixelType1>::IteratorEDomain itg (f.getIteratorEDomain());
         return FunctorMatN::convolution(f, kernel, itg, boundarycondition);
     }
+    //scalar pixel types: the direct convolution costs kernel.size() iterations by pixel. Measured, an iteration costs about 2/3 of
+    //the unit of Private::FFTConvolutionTiling::cost in 2D and about 2 units in 3D where the iteration is slower.
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,PixelType1> _convolution(const MatN<DIM,PixelType1> & f, const MatN<DIM,PixelType2> & kernel,BoundaryCondition boundarycondition,Int2Type<true>)
+    {
+        Private::FFTConvolutionTiling<DIM> tiling(f.getDomain(),kernel.getDomain(),1<<21);
+        const F64 cost_direct = static_cast<F64>(f.getDomain().multCoordinate())*kernel.getDomain().multCoordinate();
+        if(cost_direct<=tiling.cost()*((DIM<=2)?1.5:0.5)){
+            typename MatN<DIM,PixelType1>::IteratorEDomain itg (f.getIteratorEDomain());
+            return FunctorMatN::convolution(f, kernel, itg, boundarycondition);
+        }
+        MatN<DIM,F32> hF32 = Representation::convolutionByFFT(f,kernel,boundarycondition,1<<21);
+        MatN<DIM,PixelType1> h(f.getDomain());
+        for(unsigned int i=0;i<h.size();i++)
+            h(i)=ArithmeticsSaturation<PixelType1,F32>::Range(hF32(i));
+        return h;
+    }
+    //\endcond
 
     template<int DIM,typename PixelType,typename BoundaryCondition>
     static MatN<DIM,PixelType> convolutionSeperable(const MatN<DIM,PixelType> & f, const Vec<F32> & kernel,int direction,BoundaryCondition condition)
@@ -2384,7 +2457,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \param norm 1 = 4-neighborhood in 2d and 6 in 3d, and  0=8-neighborhood in 2d and 26 in 3d
      * \return  basins of the watershed transformation
      *
-     * Watershed transformation on the topographic surface initialiased by the seeds withoutboundary
+     * Watershed transformation on the topographic surface initialiased by the seeds withoutboundary. The number of pixels/voxels
+     * is limited to 2^31-1 (an error message and an empty matrix above).
      * \code
      * Mat2RGBUI8 img;
      * img.load((std::string(POP_PROJECT_SOURCE_DIR)+"/image/Lena.bmp").c_str());
@@ -2417,7 +2491,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \param norm 1 = 4-neighborhood in 2d and 6 in 3d, and  0=8-neighborhood in 2d and 26 in 3d
      * \return  basins of the watershed transformation
      *
-     * Watershed transformation on the topographic surface initialiased by the seeds restricted by the mask
+     * Watershed transformation on the topographic surface initialiased by the seeds restricted by the mask. The number of pixels/voxels
+     * is limited to 2^31-1 (an error message and an empty matrix above).
      * \code
      * F32 porosity=0.3;
      * DistributionNormal dnormal(10,5);//Poisson generator
@@ -2464,7 +2539,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \param norm 1 = 4-neighborhood in 2d and 6 in 3d, and  0=8-neighborhood in 2d and 26 in 3d
       *\return  basins of the watershed transformation
      *
-     * Watershed transformation on the topographic surface initialiased by the seeds with a boundary region to separate the basins
+     * Watershed transformation on the topographic surface initialiased by the seeds with a boundary region to separate the basins. The number of pixels/voxels
+     * is limited to 2^31-1 (an error message and an empty matrix above).
      * \code
      * Mat2UI8 iex;
      * iex.load("../image/iex.png");
@@ -2505,6 +2581,7 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \return  basins of the watershed transformation
      *
      * Watershed transformation on the topographic surface initialiased by the seeds restricted by the mask with a boundary region to separate the basins. The boundary label is 0 in the output label matrix.
+     * The number of pixels/voxels is limited to 2^31-1 (an error message and an empty matrix above).
     */
 
     template<int DIM,typename PixelType1,typename PixelType2>
@@ -2726,7 +2803,8 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
      * \param seed input seed
      * \return distance function
      *
-     * The distance function based on the seeds \f$ d(x) = \min_{'x\in \cup_{s_i}} d(x' ,x) \f$
+     * The exact euclidean distance function based on the seeds \f$ d(x) = \min_{'x\in \cup_{s_i}} d(x' ,x) \f$ computed by separable passes
+     * in linear time
      * \code
      * Vec3F32 domain(200,200,200);
      * ModelGermGrain3 grain = RandomGeometry::poissonPointProcess(domain,0.00001);
@@ -2745,7 +2823,7 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
     template<int DIM,typename PixelType>
     static MatN<DIM,F32> distanceEuclidean(const MatN<DIM,PixelType> & seed)
     {
-        return ProcessingAdvanced::voronoiTesselationEuclidean(seed).second;
+        return ProcessingAdvanced::distanceEuclidean(seed);
     }
 
     /*!
@@ -2949,32 +3027,22 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
     }
 #endif
     //    \cond HIDDEN_SYMBOLS
+        //the window of radius r centered in x of the matrix with the mirror border
+        template<typename PixelType>
         struct __FunctorNiblackMethod
         {
-            const Mat2UI32* _integral;
-            const Mat2UI32* _integral_power_2;
-            F32 area_minus1;
+            const ProcessingAdvanced::BoxStatistics<2,PixelType>* _stat;
             F32 _k;
             int _radius;
             F32 _offset_value;
-            __FunctorNiblackMethod(const Mat2UI32 & integral,const Mat2UI32& integral_power_2,F32 _area_minus1,F32 k,int radius,F32 offset_value)
-                :_integral(&integral),_integral_power_2(&integral_power_2),area_minus1(_area_minus1),_k(k),_radius(radius),_offset_value(offset_value){
+            __FunctorNiblackMethod(const ProcessingAdvanced::BoxStatistics<2,PixelType> & stat,F32 k,int radius,F32 offset_value)
+                :_stat(&stat),_k(k),_radius(radius),_offset_value(offset_value){
 
             }
-
-            template<typename PixelType>
             UI8 operator()(const MatN<2,PixelType > & f,const  typename MatN<2,PixelType>::E & x){
-                Vec2I32 xadd1=x+Vec2I32(_radius);
-                Vec2I32 xadd2=x+Vec2I32(-_radius);
-                Vec2I32 xsub1=x-Vec2I32(_radius,-_radius);
-                Vec2I32 xsub2=x-Vec2I32(-_radius,_radius);
-                F32 mean =(F32) (*_integral)(xadd1)+(*_integral)(xadd2)-(*_integral)(xsub1)-(*_integral)(xsub2);
-                mean*=area_minus1;
-
-                F32 standartdeviation = static_cast<F32>((*_integral_power_2)(xadd1)+(*_integral_power_2)(xadd2)-(*_integral_power_2)(xsub1)-(*_integral_power_2)(xsub2));
-                standartdeviation*=area_minus1;
-                standartdeviation =standartdeviation-mean*mean;
-
+                F64 mean_window;
+                F32 standartdeviation = static_cast<F32>(_stat->meanVariance(x-_radius,x+_radius,mean_window));
+                F32 mean = static_cast<F32>(mean_window);
                 if(standartdeviation>0)
                     standartdeviation = std::sqrt( standartdeviation);
                 else
@@ -2985,26 +3053,40 @@ without  the application of greylevelRemoveEmptyValue, all grey-level excepted 0
                     return  0;
             }
         };
-        struct __FunctorMean
+        template<typename PixelType>
+        struct __FunctorSauvolaMethod
         {
-            const Mat2UI32* _integral;
-            F32 area_minus1;
+            const ProcessingAdvanced::BoxStatistics<2,PixelType>* _stat;
+            F32 _k;
             int _radius;
+            F32 _dynamic_range;
             F32 _offset_value;
-            __FunctorMean(const Mat2UI32 & integral,F32 _area_minus1,int radius,F32 offset_value)
-                :_integral(&integral),area_minus1(_area_minus1),_radius(radius),_offset_value(offset_value){
+            __FunctorSauvolaMethod(const ProcessingAdvanced::BoxStatistics<2,PixelType> & stat,F32 k,int radius,F32 dynamic_range,F32 offset_value)
+                :_stat(&stat),_k(k),_radius(radius),_dynamic_range(dynamic_range),_offset_value(offset_value){
 
             }
-
-            template<typename PixelType>
             UI8 operator()(const MatN<2,PixelType > & f,const  typename MatN<2,PixelType>::E & x){
-                Vec2I32 xadd1=x+Vec2I32(_radius);
-                Vec2I32 xadd2=x+Vec2I32(-_radius);
-                Vec2I32 xsub1=x-Vec2I32(_radius,-_radius);
-                Vec2I32 xsub2=x-Vec2I32(-_radius,_radius);
-                F32 mean =(F32) (*_integral)(xadd1)+(*_integral)(xadd2)-(*_integral)(xsub1)-(*_integral)(xsub2);
-                mean*=area_minus1;
+                F64 mean_window;
+                F32 standartdeviation = std::sqrt(static_cast<F32>(_stat->meanVariance(x-_radius,x+_radius,mean_window)));
+                F32 mean = static_cast<F32>(mean_window);
+                if(f(x-_radius)>ArithmeticsSaturation<PixelType,F32>::Range( mean*(1+_k*(standartdeviation/_dynamic_range-1)))-_offset_value)
+                    return 255;
+                else
+                    return  0;
+            }
+        };
+        template<typename PixelType>
+        struct __FunctorMean
+        {
+            const ProcessingAdvanced::BoxStatistics<2,PixelType>* _stat;
+            int _radius;
+            F32 _offset_value;
+            __FunctorMean(const ProcessingAdvanced::BoxStatistics<2,PixelType> & stat,int radius,F32 offset_value)
+                :_stat(&stat),_radius(radius),_offset_value(offset_value){
 
+            }
+            UI8 operator()(const MatN<2,PixelType > & f,const  typename MatN<2,PixelType>::E & x){
+                F32 mean = static_cast<F32>(_stat->mean(x-_radius,x+_radius));
                 if(f(x-_radius)>ArithmeticsSaturation<PixelType,F32>::Range( mean)-_offset_value)
                     return 255;
                 else
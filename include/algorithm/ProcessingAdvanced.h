@@ -90,75 +90,218 @@ struct ProcessingAdvanced
         it.init();
         return ProcessingAdvanced::threshold(f,UI8(threshold_max),NumericLimits<PixelType>::maximumRange(),it);
     }
-    template<typename PixelType>
-    static MatN<2,PixelType>  integral(const MatN<2,PixelType> & f)
+    /*!
+     * \brief integral of the matrix http://research.microsoft.com/~viola/Pubs/Detect/violaJones_IJCV.pdf
+     * \param f input matrix
+     * \return output matrix with \f$h(x)=\sum_{0\leq x'\leq x} f(x')\f$ (x' lower or equal than x for each coordinate)
+     *
+     * The cumulative sums are done direction by direction, adding each hyperplane to the next one in the memory order, with the blocks shared between the threads.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType>  integral(const MatN<DIM,PixelType> & f)
     {
-        MatN<2,PixelType> out(f.getDomain());
-
-#if defined(HAVE_OPENMP)
-        MatN<2,PixelType> s (f.getDomain());
-
-#pragma omp parallel for
-        for(int i=0;i<f.getDomain()(0);i++){
-            s(i,0)=f(i,0);
-            for(int j=1;j<f.getDomain()(1);j++){
-                s(i,j)=f(i,j) + s(i,j-1);
-            }
-        }
-#pragma omp parallel for
-        for(int j=0;j<f.getDomain()(1);j++){
-            out(0,j)=s(0,j);
-            for(int i=1;i<f.getDomain()(0);i++){
-                out(i,j)=s(i,j) + out(i-1,j);
-            }
-        }
-#else
-        for(int i=0;i<out.getDomain()(0);i++){
-            for(int j=0;j<out.getDomain()(1);j++){
-                PixelType a = (i>0?out(i-1, j):0);
-                PixelType b = (j>0?out(i, j-1):0);
-                PixelType c = (i>0&&j>0?out(i-1, j-1):0);
-                out(i, j) = f(i, j) + a + b - c;
-            }
+        MatN<DIM,PixelType> out(f);
+        if(out.getDomain().multCoordinate()==0)
+            return out;
+        __FunctorLineCumulativeSum<PixelType> func;
+        func._data = out.data();
+        for(int coordinate=0;coordinate<DIM;coordinate++){
+            //the matrix is a sequence of blocks of _size hyperplanes contiguous in memory, each hyperplane of _stride elements
+            func._size = out.getDomain()(coordinate);
+            func._stride = out.stride()(coordinate);
+            func._nbr_block = out.getDomain().multCoordinate()/(func._size*func._stride);
+            if(func._nbr_block>1)
+                forEachRangeParallel(0,func._nbr_block,func);
+            else
+                forEachRangeParallel(0,func._stride,func);
         }
-#endif
-
         return out;
     }
-    template<typename VoxelType>
-    static MatN<3,VoxelType>  integral(const MatN<3,VoxelType> & f)
-    {
-        MatN<3,VoxelType> s (f.getDomain());
-        MatN<3,VoxelType> integral2d (f.getDomain());
-        MatN<3,VoxelType> out(f.getDomain());
-        for(int i=0;i<f.getDomain()(0);i++){
-            for(int j=0;j<f.getDomain()(1);j++){
-                for(int k=0;k<f.getDomain()(2);k++){
-                    if(k==0){
-                        s(i,j,k)=f(i,j,k);
-                    }
-                    else{
-                        s(i,j,k)=f(i,j,k)+s(i,j,k-1);
-                    }
-                    if(j==0){
-                        integral2d(i,j,k)=s(i,j,k);
-                    }
-                    else{
-                        integral2d(i,j,k)=s(i,j,k)+integral2d(i,j-1,k);
-                    }
-                    if(i==0){
-                        out(i,j,k)=integral2d(i,j,k);
-                    }
-                    else{
-                        out(i,j,k)=integral2d(i,j,k)+out(i-1,j,k);
+    //    \cond HIDDEN_SYMBOLS
+    template<typename AccumulatorType>
+    struct __FunctorLineCumulativeSum
+    {
+        AccumulatorType * _data;
+        int _size;
+        int _stride;
+        int _nbr_block;
+        //blocks begin<=b<end if there are many blocks, otherwise the elements begin<=j<end of the hyperplanes of the single block
+        void operator()(int begin,int end){
+            int b_begin=begin,b_end=end,j_begin=0,j_end=_stride;
+            if(_nbr_block<=1){
+                b_begin=0;b_end=1;j_begin=begin;j_end=end;
+            }
+            for(int b=b_begin;b<b_end;b++){
+                AccumulatorType * p = _data+static_cast<std::size_t>(b)*_size*_stride;
+                for(int k=1;k<_size;k++){
+                    AccumulatorType * current = p+static_cast<std::size_t>(k)*_stride;
+                    const AccumulatorType * previous = current-_stride;
+                    for(int j=j_begin;j<j_end;j++)
+                        current[j]+=previous[j];
+                }
+            }
+        }
+    };
+    template<bool isInteger,typename Dummy=void>
+    struct __BoxStatisticsAccumulator
+    {
+        typedef I64 Result;
+    };
+    template<typename Dummy>
+    struct __BoxStatisticsAccumulator<false,Dummy>
+    {
+        typedef F64 Result;
+    };
+    //\endcond
+    /*!
+     * \class pop::ProcessingAdvanced::BoxStatistics
+     * \brief sum, mean and variance of the matrix in any rectangular window in constant time
+     * \tparam DIM dimension
+     * \tparam PixelType scalar pixel type
+     *
+     * The integrals of f and of \f$f^2\f$ (see integral) are computed once, then the sum in the window \f$[xmin,xmax]\f$ is given by the
+     * \f$2^{DIM}\f$ corners of the window. The accumulators are 64 bits (I64 for the integer pixel types, F64 otherwise), so the sums of the squares
+     * of a large 16 bits volume do not overflow. The window is clipped to the domain.
+     * \code
+     * Mat2UI8 img;
+     * img.load(POP_PROJECT_SOURCE_DIR+std::string("/image/Lena.bmp"));
+     * ProcessingAdvanced::BoxStatistics<2,UI8> stat(img);
+     * std::cout<<stat.mean(Vec2I32(10,10),Vec2I32(20,20))<<" "<<stat.variance(Vec2I32(10,10),Vec2I32(20,20))<<std::endl;
+     * \endcode
+    */
+    template<int DIM,typename PixelType>
+    class BoxStatistics
+    {
+    public:
+        typedef typename __BoxStatisticsAccumulator<std::numeric_limits<PixelType>::is_integer>::Result Accumulator;
+    private:
+        MatN<DIM,Accumulator> _integral;
+        MatN<DIM,Accumulator> _integral_power2;
+        VecN<DIM,I32> _domain;
+        static I32 countClipped(const VecN<DIM,I32> & xmin,const VecN<DIM,I32> & xmax){
+            I32 nbr=1;
+            for(int c=0;c<DIM;c++)
+                nbr*=xmax(c)-xmin(c)+1;
+            return nbr;
+        }
+        bool clip(VecN<DIM,I32> & xmin,VecN<DIM,I32> & xmax)const{
+            for(int c=0;c<DIM;c++){
+                xmin(c)=maximum(xmin(c),0);
+                xmax(c)=minimum(xmax(c),_domain(c)-1);
+                if(xmin(c)>xmax(c))
+                    return false;
+            }
+            return true;
+        }
+        //the 2^DIM corners of the window, xmax(c) or xmin(c)-1 for each coordinate c, the corners outside the domain being null
+        static Accumulator sumCorner(const MatN<DIM,Accumulator> & integral,const VecN<DIM,I32> & xmin,const VecN<DIM,I32> & xmax){
+            Accumulator sum=0;
+            for(int mask=0;mask<(1<<DIM);mask++){
+                int nbr_min=0;
+                int index=0;
+                bool inside=true;
+                for(int c=0;c<DIM&&inside==true;c++){
+                    if(mask&(1<<c)){
+                        index+=xmax(c)*integral.stride()(c);
+                    }else if(xmin(c)>0){
+                        index+=(xmin(c)-1)*integral.stride()(c);
+                        nbr_min++;
+                    }else{
+                        inside=false;
                     }
                 }
+                if(inside==false)
+                    continue;
+                if(nbr_min%2==0)
+                    sum+=integral(index);
+                else
+                    sum-=integral(index);
             }
+            return sum;
         }
-        return out;
-    }
-
-
+    public:
+        /*!
+         * \param f input matrix
+         * \param with_variance compute the integral of \f$f^2\f$ for sumPower2 and variance
+        */
+        BoxStatistics(const MatN<DIM,PixelType> & f,bool with_variance=true)
+            :_domain(f.getDomain())
+        {
+            MatN<DIM,Accumulator> f_accumulator(f.getDomain());
+            std::copy(f.begin(),f.end(),f_accumulator.begin());
+            _integral = ProcessingAdvanced::integral(f_accumulator);
+            if(with_variance){
+                f_accumulator = f_accumulator.multTermByTerm(f_accumulator);
+                _integral_power2 = ProcessingAdvanced::integral(f_accumulator);
+            }
+        }
+        //! \return domain of the input matrix
+        VecN<DIM,I32> getDomain()const{
+            return _domain;
+        }
+        //! \return number of pixels of the window clipped to the domain
+        I32 count(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax)const{
+            if(clip(xmin,xmax)==false)
+                return 0;
+            return countClipped(xmin,xmax);
+        }
+        //! \return sum of f in the window
+        Accumulator sum(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax)const{
+            if(clip(xmin,xmax)==false)
+                return 0;
+            return sumCorner(_integral,xmin,xmax);
+        }
+        //! \return sum of \f$f^2\f$ in the window
+        Accumulator sumPower2(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax)const{
+            if(clip(xmin,xmax)==false)
+                return 0;
+            return sumCorner(_integral_power2,xmin,xmax);
+        }
+        //! \return mean of f in the window (0 for an empty window)
+        F64 mean(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax)const{
+            if(clip(xmin,xmax)==false)
+                return 0;
+            return static_cast<F64>(sumCorner(_integral,xmin,xmax))/countClipped(xmin,xmax);
+        }
+        //! \return variance of f in the window, \f$E[f^2]-E[f]^2\f$ (0 for an empty window)
+        F64 variance(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax)const{
+            F64 m;
+            return meanVariance(xmin,xmax,m);
+        }
+        //! \return variance of f in the window with its mean in m (0 for an empty window)
+        F64 meanVariance(VecN<DIM,I32> xmin,VecN<DIM,I32> xmax,F64 & m)const{
+            m=0;
+            if(clip(xmin,xmax)==false)
+                return 0;
+            F64 nbr = countClipped(xmin,xmax);
+            m = static_cast<F64>(sumCorner(_integral,xmin,xmax))/nbr;
+            return maximum(static_cast<F64>(sumCorner(_integral_power2,xmin,xmax))/nbr-m*m,0.);
+        }
+    };
+
+    //    \cond HIDDEN_SYMBOLS
+    template<int DIM,typename PixelType>
+    struct __FunctorMeanBox
+    {
+        const BoxStatistics<DIM,PixelType> * _stat;
+        MatN<DIM,PixelType> * _h;
+        VecN<DIM,I32> _xmin;
+        VecN<DIM,I32> _xmax;
+        int _coordinate_split;
+        //pixels of the slab begin<=x(coordinate_split)<end, the 64 bits sum divided in F64 to keep its precision
+        void operator()(int begin,int end){
+            VecN<DIM,I32> domain = _h->getDomain();
+            domain(_coordinate_split)=end-begin;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain);
+            VecN<DIM,I32> x;
+            while(it.next()){
+                x = it.x();
+                x(_coordinate_split)+=begin;
+                (*_h)(x)=static_cast<PixelType>(static_cast<F64>(_stat->sum(x+_xmin,x+_xmax))/_stat->count(x+_xmin,x+_xmax));
+            }
+        }
+    };
+    //\endcond
 
     template<int DIM,typename PixelType>
     static MatN<DIM,UI8>  nonMaximumSuppression(const MatN<DIM,PixelType> & img,const MatN<DIM,VecN<DIM,F32> >& grad,const MatN<DIM,F32> &gradnorm)
@@ -517,7 +660,7 @@ struct ProcessingAdvanced
         Function h(f.getDomain());
         typedef FunctorF::FunctorAccumulatorMin<typename Function::F > FunctorAccumulator;
         FunctorAccumulator funcAccumulator;
-        forEachGlobalToLocal(f, h, funcAccumulator, itlocal, itglobal);
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
         return h;
     }
     /*! \fn Function dilation(const Function & f,IteratorGlobal & itglobal, IteratorLocal & itlocal )
@@ -537,7 +680,7 @@ struct ProcessingAdvanced
         Function h(f.getDomain());
         typedef FunctorF::FunctorAccumulatorMax<typename Function::F > FunctorAccumulator;
         FunctorAccumulator funcAccumulator;
-        forEachGlobalToLocal(f, h, funcAccumulator, itlocal, itglobal);
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
         return h;
     }
     /*! \fn Function closing(const Function & f,IteratorGlobal & itglobal, IteratorLocal & itlocal )
@@ -600,9 +743,246 @@ struct ProcessingAdvanced
         Function h(f.getDomain());
         typedef FunctorF::FunctorAccumulatorMedian<typename Function::F> FunctorAccumulator;
         FunctorAccumulator funcAccumulator;
-        forEachGlobalToLocal(f, h, funcAccumulator, itlocal, itglobal);
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
+        return h;
+    }
+
+    /*!
+     *  \brief Median filter of the 8 bits matrix with a sliding histogram
+     * \param f input matrix
+     * \param itglobal domain iterator of f
+     * \param itlocal neighborhood iterator of f
+     * \return h output matrix
+     *
+     * Same result as the generic median. The neighborhood histogram slides along the lines (Huang): moving to the next pixel, only the values
+     * of the front and back faces of the neighborhood are added and removed, and the median is tracked in a two-level histogram (Perreault and Hebert).
+     * The cost per pixel is proportional to the size of a face of the neighborhood instead of its volume. The lines are shared between the threads.
+    */
+    template<int DIM>
+    static MatN<DIM,UI8> median(const MatN<DIM,UI8> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        return _medianHistogram(f,itglobal,itlocal);
+    }
+    /*!
+     *  \brief Median filter of the 16 bits matrix with a sliding histogram
+     * \param f input matrix
+     * \param itglobal domain iterator of f
+     * \param itlocal neighborhood iterator of f
+     * \return h output matrix
+     *
+     * Same algorithm as the 8 bits case with a histogram of 65536 bins.
+    */
+    template<int DIM>
+    static MatN<DIM,UI16> median(const MatN<DIM,UI16> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        return _medianHistogram(f,itglobal,itlocal);
+    }
+    //    \cond HIDDEN_SYMBOLS
+    //histogram of the unsigned integer values (8 or 16 bits) with a coarse level of sqrt(NBR_BIN) bins
+    template<typename PixelType>
+    struct __HistogramMedian
+    {
+        enum{
+            NBR_BIN = 1<<(8*sizeof(PixelType)),
+            SHIFT   = 4*sizeof(PixelType)
+        };
+        std::vector<I32> _fine;
+        std::vector<I32> _coarse;
+        I32 _count;
+        //median value and number of values lower than the median value
+        I32 _median;
+        I32 _nbr_below;
+        __HistogramMedian()
+            :_fine(NBR_BIN,0),_coarse(NBR_BIN>>SHIFT,0),_count(0),_median(0),_nbr_below(0)
+        {}
+        //empty histogram from a histogram containing only the given values (the other bins are not read, 65536 for 16 bits)
+        template<typename Iterator>
+        void clear(Iterator begin,Iterator end){
+            for(;begin!=end;++begin){
+                _fine[*begin]=0;
+                _coarse[*begin>>SHIFT]=0;
+            }
+            _count=0;
+            _median=0;
+            _nbr_below=0;
+        }
+        void add(PixelType value){
+            _fine[value]++;
+            _coarse[value>>SHIFT]++;
+            _count++;
+            if(value<_median)
+                _nbr_below++;
+        }
+        void remove(PixelType value){
+            _fine[value]--;
+            _coarse[value>>SHIFT]--;
+            _count--;
+            if(value<_median)
+                _nbr_below--;
+        }
+        //the value of rank count/2 in the sorted list, as FunctorAccumulatorMedian
+        PixelType getValue(){
+            if(_count==0)
+                return 0;
+            const I32 k = _count/2;
+            const I32 block = 1<<SHIFT;
+            while(_nbr_below+_fine[_median]<=k){
+                _nbr_below+=_fine[_median];
+                _median++;
+                while((_median&(block-1))==0&&_nbr_below+_coarse[_median>>SHIFT]<=k){
+                    _nbr_below+=_coarse[_median>>SHIFT];
+                    _median+=block;
+                }
+            }
+            while(_nbr_below>k){
+                _median--;
+                _nbr_below-=_fine[_median];
+                while((_median&(block-1))==0&&_median>=block&&_nbr_below-_coarse[(_median>>SHIFT)-1]>k){
+                    _median-=block;
+                    _nbr_below-=_coarse[_median>>SHIFT];
+                }
+            }
+            return static_cast<PixelType>(_median);
+        }
+    };
+    template<int DIM,typename PixelType>
+    struct __FunctorLineMedian
+    {
+        const MatN<DIM,PixelType> * _f;
+        MatN<DIM,PixelType> * _h;
+        int _coordinate;
+        int _coordinate_split;
+        //the neighborhood, the translations added and removed when the center moves of one pixel along the line (relatively to the new center)
+        std::vector<VecN<DIM,I32> > _v_neigh;
+        std::vector<VecN<DIM,I32> > _v_add;
+        std::vector<VecN<DIM,I32> > _v_remove;
+        VecN<DIM,I32> _tab_min;
+        VecN<DIM,I32> _tab_max;
+
+        bool isInside(const VecN<DIM,I32> & x)const{
+            for(int c=0;c<DIM;c++){
+                if(x(c)<0||x(c)>=_f->getDomain()(c))
+                    return false;
+            }
+            return true;
+        }
+        static void offset(const std::vector<VecN<DIM,I32> > & v,const VecN<DIM,I32> & stride,std::vector<int> & v_offset){
+            v_offset.resize(v.size());
+            for(unsigned int i=0;i<v.size();i++)
+                v_offset[i]=VecNIndice<DIM>::VecN2Indice(stride,v[i]);
+        }
+        //lines of the slab begin<=x(coordinate_split)<end
+        void operator()(int begin,int end){
+            const VecN<DIM,I32> domain = _f->getDomain();
+            const int n = domain(_coordinate);
+            const int stride_f = _f->stride()(_coordinate);
+            const int stride_h = _h->stride()(_coordinate);
+            std::vector<int> v_offset_neigh,v_offset_add,v_offset_remove;
+            offset(_v_neigh,_f->stride(),v_offset_neigh);
+            offset(_v_add,_f->stride(),v_offset_add);
+            offset(_v_remove,_f->stride(),v_offset_remove);
+            __HistogramMedian<PixelType> hist;
+            std::vector<PixelType> v_value;
+            VecN<DIM,I32> domain_lines = domain;
+            domain_lines(_coordinate)=1;
+            if(_coordinate_split!=_coordinate)
+                domain_lines(_coordinate_split)=end-begin;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain_lines);
+            const PixelType * dataf = _f->data();
+            PixelType * datah = _h->data();
+            VecN<DIM,I32> x;
+            while(it.next()){
+                x = it.x();
+                if(_coordinate_split!=_coordinate)
+                    x(_coordinate_split)+=begin;
+                //the translated pixels are inside the domain for the other coordinates
+                bool line_interior=true;
+                for(int c=0;c<DIM;c++){
+                    if(c!=_coordinate&&(x(c)+_tab_min(c)<0||x(c)+_tab_max(c)>=domain(c)))
+                        line_interior=false;
+                }
+                const int index_f = VecNIndice<DIM>::VecN2Indice(_f->stride(),x);
+                const int index_h = VecNIndice<DIM>::VecN2Indice(_h->stride(),x);
+                for(unsigned int i=0;i<_v_neigh.size();i++){
+                    if(line_interior ? (_v_neigh[i](_coordinate)>=0&&_v_neigh[i](_coordinate)<n) : isInside(x+_v_neigh[i]))
+                        hist.add(dataf[index_f+v_offset_neigh[i]]);
+                }
+                datah[index_h]=hist.getValue();
+                for(int xl=1;xl<n;xl++){
+                    x(_coordinate)=xl;
+                    const int indexl_f = index_f+xl*stride_f;
+                    for(unsigned int i=0;i<_v_remove.size();i++){
+                        if(line_interior ? (xl+_v_remove[i](_coordinate)>=0&&xl+_v_remove[i](_coordinate)<n) : isInside(x+_v_remove[i]))
+                            hist.remove(dataf[indexl_f+v_offset_remove[i]]);
+                    }
+                    for(unsigned int i=0;i<_v_add.size();i++){
+                        if(line_interior ? (xl+_v_add[i](_coordinate)>=0&&xl+_v_add[i](_coordinate)<n) : isInside(x+_v_add[i]))
+                            hist.add(dataf[indexl_f+v_offset_add[i]]);
+                    }
+                    datah[index_h+xl*stride_h]=hist.getValue();
+                }
+                //the histogram contains the neighborhood of the last pixel of the line, only these bins are set to zero
+                x(_coordinate)=n-1;
+                const int indexlast_f = index_f+(n-1)*stride_f;
+                v_value.clear();
+                for(unsigned int i=0;i<_v_neigh.size();i++){
+                    if(line_interior ? (n-1+_v_neigh[i](_coordinate)>=0&&n-1+_v_neigh[i](_coordinate)<n) : isInside(x+_v_neigh[i]))
+                        v_value.push_back(dataf[indexlast_f+v_offset_neigh[i]]);
+                }
+                hist.clear(v_value.begin(),v_value.end());
+            }
+        }
+    };
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> _medianHistogram(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        typedef MatNIteratorEDomain<VecN<DIM,I32> > IteratorGlobal;
+        typedef MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> IteratorLocal;
+        if(!(itglobal.getDomain()==f.getDomain())||!(itlocal.getDomain().first==f.getDomain())||itlocal.getDomain().second.size()==0||f.getDomain().multCoordinate()==0)
+            return median<MatN<DIM,PixelType>,IteratorGlobal,IteratorLocal>(f,itglobal,itlocal);
+        MatN<DIM,PixelType> h(f.getDomain());
+        __FunctorLineMedian<DIM,PixelType> func;
+        func._f = &f;
+        func._h = &h;
+        //the lines along the fastest coordinate in memory, shared between the threads by slabs along the slowest one
+        func._coordinate = (DIM==1) ? 0 : 1;
+        func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+        const Vec<VecN<DIM,I32> > tab = itlocal.getDomain().second;
+        func._v_neigh.assign(tab.begin(),tab.end());
+        //membership of the translations in the bounding box of the neighborhood enlarged of one pixel along the line
+        VecN<DIM,I32> xmin = tab[0],xmax = tab[0];
+        for(unsigned int i=1;i<tab.size();i++){
+            for(int c=0;c<DIM;c++){
+                xmin(c) = std::min(xmin(c),tab[i](c));
+                xmax(c) = std::max(xmax(c),tab[i](c));
+            }
+        }
+        func._tab_min = xmin;
+        func._tab_max = xmax;
+        xmin(func._coordinate)--;
+        xmax(func._coordinate)++;
+        MatN<DIM,UI8> box(xmax-xmin+1);
+        for(unsigned int i=0;i<tab.size();i++){
+            //a translation counted twice is not handled by the sliding
+            if(box(tab[i]-xmin)!=0)
+                return median<MatN<DIM,PixelType>,IteratorGlobal,IteratorLocal>(f,itglobal,itlocal);
+            box(tab[i]-xmin)=1;
+        }
+        VecN<DIM,I32> e(0);
+        e(func._coordinate)=1;
+        for(unsigned int i=0;i<tab.size();i++){
+            if(box(tab[i]+e-xmin)==0)
+                func._v_add.push_back(tab[i]);
+            if(box(tab[i]-e-xmin)==0)
+                func._v_remove.push_back(tab[i]-e);
+        }
+        if(DIM==1)
+            func(0,1);
+        else
+            forEachRangeParallel(0,f.getDomain()(func._coordinate_split),func);
         return h;
     }
+    //\endcond
 
     /*! \fn Function mean(const Function & f,IteratorGlobal & itglobal, IteratorLocal & itlocal)
      *  \brief Median filter of the input matrix
@@ -622,9 +1002,379 @@ struct ProcessingAdvanced
         Function h(f.getDomain());
         typedef FunctorF::FunctorAccumulatorMean<typename Function::F> FunctorAccumulator;
         FunctorAccumulator funcAccumulator;
-        forEachGlobalToLocal(f, h, funcAccumulator, itlocal, itglobal);
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
         return h;
     }
+    /*!
+     *  \brief Mean filter of the input matrix
+     * \param f input matrix
+     * \param itglobal domain iterator of f
+     * \param itlocal neighborhood iterator of f
+     * \return h output matrix
+     *
+     * Same result as the generic mean up to the rounding. When the pixel type is scalar and the neighborhood is a box (ball with the norm 0, rectangular
+     * structural element), the sum in the window is given in constant time by BoxStatistics and divided in F64, so a mean just below an integer
+     * is not rounded up as with the F32 accumulator of the generic mean. Otherwise, the generic neighborhood scan is applied.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> mean(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        return mean(f,itglobal,itlocal,Int2Type<isVectoriel<PixelType>::value>());
+    }
+    //    \cond HIDDEN_SYMBOLS
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> mean(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal,Int2Type<true>)
+    {
+        return mean<MatN<DIM,PixelType>,MatNIteratorEDomain<VecN<DIM,I32> >,MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> >(f,itglobal,itlocal);
+    }
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> mean(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal,Int2Type<false>)
+    {
+        VecN<DIM,I32> xmin,xmax;
+        if(!(itglobal.getDomain()==f.getDomain())||!(itlocal.getDomain().first==f.getDomain())||isNeighborhoodBox(itlocal,xmin,xmax)==false)
+            return mean<MatN<DIM,PixelType>,MatNIteratorEDomain<VecN<DIM,I32> >,MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> >(f,itglobal,itlocal);
+        MatN<DIM,PixelType> h(f.getDomain());
+        if(f.getDomain().multCoordinate()==0)
+            return h;
+        BoxStatistics<DIM,PixelType> stat(f,false);
+        __FunctorMeanBox<DIM,PixelType> func;
+        func._stat = &stat;
+        func._h = &h;
+        func._xmin = xmin;
+        func._xmax = xmax;
+        func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+        forEachRangeParallel(0,f.getDomain()(func._coordinate_split),func);
+        return h;
+    }
+    //\endcond
+
+    /*!
+     *  \brief Erosion of the input matrix by a rectangular neighborhood
+     * \param f input matrix
+     * \param itglobal domain iterator of f
+     * \param itlocal neighborhood iterator of f
+     * \return h output matrix
+     *
+     * Same result as the generic erosion. When the pixel type is scalar, the structural element is decomposed in line segments:
+     *   - a box (ball with the norm 0, rectangular structural element, line segment along an axis) is the product of segments along
+     *     the axes, eroded with the van Herk/Gil-Werman algorithm with a cost independent of the neighborhood size (see erosionBox),
+     *   - a box dilated by a diamond of radius r (cross for the balls of radius 1, diamond, octagon) is the erosion by the box followed
+     *     by r erosions by the unit cross, a cross being the union of the segments of width 3 along the axes (see isNeighborhoodBoxDiamond).
+     *
+     * Otherwise (for instance the balls with the norm 2 and a radius larger than 1), the generic neighborhood scan is applied.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> erosion(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        VecN<DIM,I32> xmin,xmax;
+        int radius;
+        if(isVectoriel<PixelType>::value==false&&itglobal.getDomain()==f.getDomain()&&itlocal.getDomain().first==f.getDomain()&&isNeighborhoodBoxDiamond(itlocal,xmin,xmax,radius)){
+            MatN<DIM,PixelType> h = erosionBox(f,xmin,xmax);
+            for(int i=0;i<radius;i++)
+                _morphologyCross(h,__FunctorMinVanHerk());
+            return h;
+        }
+        MatN<DIM,PixelType> h(f.getDomain());
+        FunctorF::FunctorAccumulatorMin<PixelType> funcAccumulator;
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
+        return h;
+    }
+    /*!
+     *  \brief Dilation of the input matrix by a rectangular neighborhood
+     * \param f input matrix
+     * \param itglobal domain iterator of f
+     * \param itlocal neighborhood iterator of f
+     * \return h output matrix
+     *
+     * Same result as the generic dilation. When the pixel type is scalar and the neighborhood is a box dilated by a diamond,
+     * the line segment decomposition of the erosion is used (see dilationBox). Otherwise, the generic neighborhood scan is applied.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> dilation(const MatN<DIM,PixelType> & f,MatNIteratorEDomain<VecN<DIM,I32> > & itglobal, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> & itlocal)
+    {
+        VecN<DIM,I32> xmin,xmax;
+        int radius;
+        if(isVectoriel<PixelType>::value==false&&itglobal.getDomain()==f.getDomain()&&itlocal.getDomain().first==f.getDomain()&&isNeighborhoodBoxDiamond(itlocal,xmin,xmax,radius)){
+            MatN<DIM,PixelType> h = dilationBox(f,xmin,xmax);
+            for(int i=0;i<radius;i++)
+                _morphologyCross(h,__FunctorMaxVanHerk());
+            return h;
+        }
+        MatN<DIM,PixelType> h(f.getDomain());
+        FunctorF::FunctorAccumulatorMax<PixelType> funcAccumulator;
+        forEachGlobalToLocalParallel(f, h, funcAccumulator, itlocal, itglobal);
+        return h;
+    }
+
+    /*!
+     *  \brief test if the neighborhood is a box
+     * \param itlocal neighborhood iterator
+     * \param xmin lower corner of the box (output)
+     * \param xmax upper corner of the box included (output)
+     * \return true if the set of translations of the neighborhood is equal to \f$[xmin(0),xmax(0)]\times\ldots\times[xmin(DIM-1),xmax(DIM-1)]\f$
+     *
+     * The ball of radius r with the norm 0 is the box \f$[-r,r]^{DIM}\f$ and a line segment along an axis is a box of width 1 in the other directions.
+    */
+    template<int DIM,typename BoundaryCondition>
+    static bool isNeighborhoodBox(const MatNIteratorENeighborhood<VecN<DIM,I32>,BoundaryCondition> & itlocal,VecN<DIM,I32> & xmin,VecN<DIM,I32> & xmax)
+    {
+        int radius;
+        return isNeighborhoodBoxDiamond(itlocal,xmin,xmax,radius)&&radius==0;
+    }
+    /*!
+     *  \brief test if the neighborhood is a box dilated by a diamond
+     * \param itlocal neighborhood iterator
+     * \param xmin lower corner of the box (output)
+     * \param xmax upper corner of the box included (output)
+     * \param radius radius of the diamond (output)
+     * \return true if the set of translations of the neighborhood is \f$\{b+d: b\in[xmin(0),xmax(0)]\times\ldots\times[xmin(DIM-1),xmax(DIM-1)], |d|_1\leq radius\}\f$
+     *
+     * The radius is 0 for a box, and the box is the origin for a diamond (the balls of radius 1 with the norm 1 or 2 are the unit cross).
+     * A box dilated by a diamond is an octagon in 2d. When the radius is not 0, the box must contain the origin so that the erosion by the
+     * box followed by the erosions by the unit cross gives the erosion restricted to the domain.
+    */
+    template<int DIM,typename BoundaryCondition>
+    static bool isNeighborhoodBoxDiamond(const MatNIteratorENeighborhood<VecN<DIM,I32>,BoundaryCondition> & itlocal,VecN<DIM,I32> & xmin,VecN<DIM,I32> & xmax,int & radius)
+    {
+        const Vec<VecN<DIM,I32> > tab = itlocal.getDomain().second;
+        if(tab.size()==0)
+            return false;
+        VecN<DIM,I32> bmin = tab[0],bmax = tab[0];
+        for(unsigned int i=1;i<tab.size();i++){
+            for(int j=0;j<DIM;j++){
+                bmin(j) = std::min(bmin(j),tab[i](j));
+                bmax(j) = std::max(bmax(j),tab[i](j));
+            }
+        }
+        VecN<DIM,I32> size = bmax-bmin+1;
+        F64 volume = 1,factorial = 1;
+        for(int i=0;i<DIM;i++){
+            volume*=size(i);
+            factorial*=i+1;
+        }
+        //a diamond fills 1/DIM! of its bounding box
+        if(volume>factorial*tab.size())
+            return false;
+        //the translations can be duplicated, so we mark the distinct ones in the bounding box
+        VecN<DIM,I32> stride;
+        stride(0)=1;
+        for(int i=1;i<DIM;i++)
+            stride(i)=stride(i-1)*size(i-1);
+        std::vector<bool> hit(static_cast<unsigned int>(volume),false);
+        for(unsigned int i=0;i<tab.size();i++)
+            hit[VecNIndice<DIM>::VecN2Indice(stride,tab[i]-bmin)]=true;
+        //the face x(0)=bmin(0) is the box without the diamond, so its width along the coordinate 1 gives the radius
+        radius = 0;
+        if(DIM>1){
+            int face_min=size(1),face_max=-1;
+            VecN<DIM,I32> size_face = size;
+            size_face(0)=1;
+            MatNIteratorEDomain<VecN<DIM,I32> > it_face(size_face);
+            while(it_face.next()){
+                if(hit[VecNIndice<DIM>::VecN2Indice(stride,it_face.x())]){
+                    face_min = std::min(face_min,it_face.x()(1));
+                    face_max = std::max(face_max,it_face.x()(1));
+                }
+            }
+            if(face_max<0||(size(1)-1-(face_max-face_min))%2!=0)
+                return false;
+            radius = (size(1)-1-(face_max-face_min))/2;
+        }
+        xmin = bmin+radius;
+        xmax = bmax-radius;
+        for(int i=0;i<DIM;i++){
+            if(xmin(i)>xmax(i)||(radius>0&&(xmin(i)>0||xmax(i)<0)))
+                return false;
+        }
+        //each point of the bounding box is in the neighborhood iff its norm 1 distance to the box is lower than the radius
+        MatNIteratorEDomain<VecN<DIM,I32> > it(size);
+        while(it.next()){
+            VecN<DIM,I32> x = it.x()+bmin;
+            int distance=0;
+            for(int i=0;i<DIM;i++)
+                distance+=std::max(0,std::max(xmin(i)-x(i),x(i)-xmax(i)));
+            if((distance<=radius)!=hit[VecNIndice<DIM>::VecN2Indice(stride,it.x())])
+                return false;
+        }
+        return true;
+    }
+
+    /*!
+     *  \brief Erosion by a box with the van Herk/Gil-Werman algorithm
+     * \param f input matrix
+     * \param xmin lower corner of the box
+     * \param xmax upper corner of the box included
+     * \return h output matrix
+     *
+     * \f$\forall x \in E:\quad h(x) =\min_{\forall x'\in (x+B)\cap E }f(x') \f$ with \f$B=[xmin(0),xmax(0)]\times\ldots\times[xmin(DIM-1),xmax(DIM-1)]\f$.\n
+     * The box is separable so the erosion is done line by line in each direction. In a line, the van Herk/Gil-Werman algorithm computes
+     * the minimum in a sliding window of width w with about 3 comparisons by pixel whatever w. The outside of the domain is ignored like
+     * in the generic erosion with the bounded boundary condition.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> erosionBox(const MatN<DIM,PixelType> & f,const VecN<DIM,I32> & xmin,const VecN<DIM,I32> & xmax)
+    {
+        MatN<DIM,PixelType> h(f);
+        for(int i=0;i<DIM;i++)
+            _morphologyLineVanHerk(h,i,xmin(i),xmax(i),__FunctorMinVanHerk(),NumericLimits<PixelType>::maximumRange());
+        return h;
+    }
+    /*!
+     *  \brief Dilation by a box with the van Herk/Gil-Werman algorithm
+     * \param f input matrix
+     * \param xmin lower corner of the box
+     * \param xmax upper corner of the box included
+     * \return h output matrix
+     *
+     * \f$\forall x \in E:\quad h(x) =\max_{\forall x'\in (x+B)\cap E }f(x') \f$ with \f$B=[xmin(0),xmax(0)]\times\ldots\times[xmin(DIM-1),xmax(DIM-1)]\f$.
+     * \sa erosionBox
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,PixelType> dilationBox(const MatN<DIM,PixelType> & f,const VecN<DIM,I32> & xmin,const VecN<DIM,I32> & xmax)
+    {
+        MatN<DIM,PixelType> h(f);
+        for(int i=0;i<DIM;i++)
+            _morphologyLineVanHerk(h,i,xmin(i),xmax(i),__FunctorMaxVanHerk(),NumericLimits<PixelType>::minimumRange());
+        return h;
+    }
+    //    \cond HIDDEN_SYMBOLS
+    struct __FunctorMinVanHerk
+    {
+        template<typename PixelType>
+        PixelType operator()(PixelType a,PixelType b)const{
+            return pop::minimum(a,b);
+        }
+    };
+    struct __FunctorMaxVanHerk
+    {
+        template<typename PixelType>
+        PixelType operator()(PixelType a,PixelType b)const{
+            return pop::maximum(a,b);
+        }
+    };
+    //h(x)=op(f(x),f(x-e_i),f(x+e_i)) for the neighbors in the domain, for the pixels of the slab begin<=x(coordinate_split)<end
+    template<int DIM,typename PixelType,typename FunctorOp>
+    struct __FunctorCross
+    {
+        const MatN<DIM,PixelType> * _f;
+        MatN<DIM,PixelType> * _h;
+        int _coordinate_split;
+        FunctorOp _op;
+        void operator()(int begin,int end){
+            const VecN<DIM,I32> domain_f = _f->getDomain();
+            VecN<DIM,I32> domain = domain_f;
+            domain(_coordinate_split)=end-begin;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain);
+            const PixelType * in = _f->data();
+            PixelType * out = _h->data();
+            VecN<DIM,I32> x;
+            while(it.next()){
+                x = it.x();
+                x(_coordinate_split)+=begin;
+                const int index = VecNIndice<DIM>::VecN2Indice(_f->stride(),x);
+                PixelType value = in[index];
+                for(int i=0;i<DIM;i++){
+                    if(x(i)>0)
+                        value = _op(value,in[index-_f->stride()(i)]);
+                    if(x(i)<domain_f(i)-1)
+                        value = _op(value,in[index+_f->stride()(i)]);
+                }
+                out[index]=value;
+            }
+        }
+    };
+    //erosion or dilation of h by the unit cross
+    template<int DIM,typename PixelType,typename FunctorOp>
+    static void _morphologyCross(MatN<DIM,PixelType> & h,FunctorOp op)
+    {
+        if(h.getDomain().multCoordinate()==0)
+            return;
+        const MatN<DIM,PixelType> f(h);
+        __FunctorCross<DIM,PixelType,FunctorOp> func;
+        func._f = &f;
+        func._h = &h;
+        func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+        func._op = op;
+        forEachRangeParallel(0,h.getDomain()(func._coordinate_split),func);
+    }
+    //in place h(x)=op_{x+lo<=x'<=x+hi} h(x') along the direction coordinate, with neutral the neutral element of op
+    template<int DIM,typename PixelType,typename FunctorOp>
+    struct __FunctorLineVanHerk
+    {
+        MatN<DIM,PixelType> * _h;
+        int _coordinate;
+        int _coordinate_split;
+        int _lo;
+        int _hi;
+        FunctorOp _op;
+        PixelType _neutral;
+        //lines of the slab begin<=x(coordinate_split)<end
+        void operator()(int begin,int end){
+            const int n = _h->getDomain()(_coordinate);
+            const int stride = _h->stride()(_coordinate);
+            const int w = _hi-_lo+1;
+            const int m = n+w-1;
+            std::vector<PixelType> line(m),g(m),b(m);
+            VecN<DIM,I32> domain_lines = _h->getDomain();
+            domain_lines(_coordinate)=1;
+            if(_coordinate_split!=_coordinate)
+                domain_lines(_coordinate_split)=end-begin;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain_lines);
+            PixelType * data = _h->data();
+            VecN<DIM,I32> x;
+            while(it.next()){
+                x = it.x();
+                if(_coordinate_split!=_coordinate)
+                    x(_coordinate_split)+=begin;
+                PixelType * p = data+VecNIndice<DIM>::VecN2Indice(_h->stride(),x);
+                for(int k=0;k<m;k++){
+                    int index = k+_lo;
+                    line[k]= (index>=0&&index<n) ? p[index*stride] : _neutral;
+                }
+                //forward accumulation in each block of size w
+                for(int k=0;k<m;k++){
+                    if(k%w==0)
+                        g[k]=line[k];
+                    else
+                        g[k]=_op(g[k-1],line[k]);
+                }
+                //backward accumulation in each block of size w
+                for(int k=m-1;k>=0;k--){
+                    if(k==m-1||k%w==w-1)
+                        b[k]=line[k];
+                    else
+                        b[k]=_op(b[k+1],line[k]);
+                }
+                for(int k=0;k<n;k++){
+                    p[k*stride]=_op(b[k],g[k+w-1]);
+                }
+            }
+        }
+    };
+    template<int DIM,typename PixelType,typename FunctorOp>
+    static void _morphologyLineVanHerk(MatN<DIM,PixelType> & h,int coordinate,int lo,int hi,FunctorOp op,PixelType neutral)
+    {
+        if((lo==0&&hi==0)||h.getDomain().multCoordinate()==0)
+            return;
+        __FunctorLineVanHerk<DIM,PixelType,FunctorOp> func;
+        func._h = &h;
+        func._coordinate = coordinate;
+        //the lines are shared between the threads by slabs along the slowest coordinate in memory different of the line direction
+        func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+        if(func._coordinate_split==coordinate)
+            func._coordinate_split = (DIM==2) ? 1 : DIM-2;
+        if(DIM==1)
+            func._coordinate_split = coordinate;
+        func._lo = lo;
+        func._hi = hi;
+        func._op = op;
+        func._neutral = neutral;
+        if(func._coordinate_split==coordinate)
+            func(0,1);
+        else
+            forEachRangeParallel(0,h.getDomain()(func._coordinate_split),func);
+    }
+    //\endcond
 
 
     /*! \fn Function alternateSequentialCOStructuralElement(const Function & f,IteratorGlobal & itglobal,IteratorLocal & itlocal, int maxradius)
@@ -762,9 +1512,9 @@ struct ProcessingAdvanced
             it.init();
 
             if(i==direction)
-                fout = FunctorMatN::convolutionSeperable(fout,der,direction,it,MatNBoundaryConditionMirror());
+                fout = FunctorMatN::convolutionSeperable(fout,der,i,it,MatNBoundaryConditionMirror());
             else
-                fout = FunctorMatN::convolutionSeperable(fout,smooth,direction,it,MatNBoundaryConditionMirror());
+                fout = FunctorMatN::convolutionSeperable(fout,smooth,i,it,MatNBoundaryConditionMirror());
         }
         return fout;
     }
@@ -1003,6 +1753,47 @@ struct ProcessingAdvanced
         return hole;
     }
 
+    /*! \fn MatN<DIM,UI8> holeFilling( const MatN<DIM,UI8>& bin,MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh)
+     * \param bin input binary matrix
+     * \param itneigh domain of the neighborhood iterator
+     * \return hole output matrix
+     *
+     *  hole filling of the input binary matrix: the clusters of the background are labelled with the union-find algorithm of clusterToLabel
+     *  and the ones touching the border of the domain are kept
+    */
+    template<int DIM>
+    static MatN<DIM,UI8> holeFilling( const MatN<DIM,UI8>& bin,MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh)
+    {
+        MatN<DIM,UI8> hole(bin.getDomain());
+        if(bin.stride()!=hole.stride())
+            return holeFilling<MatN<DIM,UI8> >(bin,itneigh);
+        const int size = bin.getDomain().multCoordinate();
+        if(size==0)
+            return hole;
+        const UI8 * databin = bin.data();
+        UI8 * datahole = hole.data();
+        for(int i=0;i<size;i++)
+            datahole[i] = (databin[i]==0) ? 1 : 0;
+        MatN<DIM,UI32> label(bin.getDomain());
+        UI32 nbr_label = _clusterToLabelUnionFind(hole,itneigh,label,false);
+        std::vector<bool> v_border(nbr_label+1,false);
+        for(int c=0;c<DIM;c++){
+            VecN<DIM,I32> domain_face = bin.getDomain();
+            domain_face(c)=1;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain_face);
+            while(it.next()){
+                VecN<DIM,I32> x = it.x();
+                v_border[label(x)]=true;
+                x(c)=bin.getDomain()(c)-1;
+                v_border[label(x)]=true;
+            }
+        }
+        const UI32 * datalabel = label.data();
+        for(int i=0;i<size;i++)
+            datahole[i] = (datalabel[i]!=0&&v_border[datalabel[i]]) ? 0 : 255;
+        return hole;
+    }
+
     /*! \fn FunctionLabel regionGrowingAdamsBischofMeanOverStandardDeviation(const FunctionLabel & seed,const FunctionTopo & topo, typename FunctionTopo::IteratorENeighborhood  itneigh )
      * \param seed input seeds
      * \param topo topographic surface
@@ -1242,42 +2033,298 @@ struct ProcessingAdvanced
         }
         return map;
     }
-    //fast implementation for 2d case with radius=1
-    static inline Mat2UI32 clusterToLabel2D(const Mat2UI8 & f,int norm=0)
+    /*! \fn MatN<DIM,UI32> clusterToLabel(const MatN<DIM,UI8> & f, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded>  itneigh,MatNIteratorEDomain<VecN<DIM,I32> > it_order)
+     * \param f input binary matrix
+     * \param itneigh neighborhood IteratorE
+     * \param it_order domain IteratorE
+     * \return  label output label matrix
+     *
+     *  Two-pass union-find labeling. The first pass scans each slab along the slowest coordinate in memory on its own thread and merges each pixel
+     *  with its already scanned neighbors, skipping the neighbors already connected to a merged one (decision tree). The slabs are merged along their
+     *  boundaries, then the labels are numbered in the order of the domain IteratorE, so the output is the same as the region growing.
+    */
+    template<int DIM>
+    static MatN<DIM,UI32> clusterToLabel(const MatN<DIM,UI8> & f, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded>  itneigh,MatNIteratorEDomain<VecN<DIM,I32> > it_order)
     {
-        Mat2UI32 map(f.getDomain());
-        int cluster=0;
-        std::vector<int > v_list_i;
-        std::vector<int > v_list_j;
-        for(unsigned int j =0;j<f.sizeJ();j++){
-            for(unsigned int i =0;i<f.sizeI();i++){
-
-
-                if(f(i,j)>0&&map(i,j)==0){
-                    cluster++;
-                    v_list_i.push_back(i);v_list_j.push_back(j);
-                    while(v_list_i.empty()==false){
-                        unsigned int i_next = *(v_list_i.rbegin());
-                        v_list_i.pop_back();
-                        unsigned int j_next = *(v_list_j.rbegin());
-                        v_list_j.pop_back();
-                        if(map(i_next,j_next)==0){
-                            map(i_next,j_next)=cluster;
-                            if(i_next>0          &&f(i_next-1,j_next)>0){v_list_i.push_back(i_next-1);v_list_j.push_back(j_next);}
-                            if(i_next+1<f.sizeI()&&f(i_next+1,j_next)>0){v_list_i.push_back(i_next+1);v_list_j.push_back(j_next);}
-                            if(j_next>0          &&f(i_next,j_next-1)>0){v_list_i.push_back(i_next);v_list_j.push_back(j_next-1);}
-                            if(j_next+1<f.sizeJ()&&f(i_next,j_next+1)>0){v_list_i.push_back(i_next);v_list_j.push_back(j_next+1);}
-                            if(norm==0){
-                                if(i_next>0          &&j_next>0          &&f(i_next-1,j_next-1)>0){v_list_i.push_back(i_next-1);v_list_j.push_back(j_next-1);}
-                                if(i_next+1<f.sizeI()&&j_next>0          &&f(i_next+1,j_next-1)>0){v_list_i.push_back(i_next+1);v_list_j.push_back(j_next-1);}
-                                if(i_next>0          &&j_next+1<f.sizeJ()&&f(i_next-1,j_next+1)>0){v_list_i.push_back(i_next-1);v_list_j.push_back(j_next+1);}
-                                if(i_next+1<f.sizeI()&&j_next+1<f.sizeJ()&&f(i_next+1,j_next+1)>0){v_list_i.push_back(i_next+1);v_list_j.push_back(j_next+1);}
+        MatN<DIM,UI32> label(f.getDomain());
+        if(f.stride()!=label.stride())
+            return clusterToLabel<DIM,MatNIteratorEDomain<VecN<DIM,I32> > >(f,itneigh,it_order);
+        _clusterToLabelUnionFind(f,itneigh,label,true);
+        return label;
+    }
+    //    \cond HIDDEN_SYMBOLS
+    //union-find on the pixel indexes stored in the label matrix, parent[i]=j+1 with j the parent of i and j<=i, parent[i]=i+1 for a root
+    static inline UI32 _unionFindRoot(UI32 * parent,UI32 i){
+        UI32 root = i;
+        while(parent[root]!=root+1)
+            root = parent[root]-1;
+        while(parent[i]!=root+1){
+            UI32 next = parent[i]-1;
+            parent[i]=root+1;
+            i=next;
+        }
+        return root;
+    }
+    static inline void _unionFindMerge(UI32 * parent,UI32 i,UI32 j){
+        i = _unionFindRoot(parent,i);
+        j = _unionFindRoot(parent,j);
+        if(i<j)
+            parent[j]=i+1;
+        else if(j<i)
+            parent[i]=j+1;
+    }
+    template<int DIM>
+    struct __FunctorClusterToLabelSlab
+    {
+        const UI8 * _data;
+        UI32 * _parent;
+        VecN<DIM,I32> _domain;
+        VecN<DIM,I32> _stride;
+        int _coordinate_split;
+        int _nbr_slab;
+        //causal neighbors (already scanned) with their linear offsets and, for each one, the set of the causal neighbors adjacent to it
+        std::vector<VecN<DIM,I32> > _v_causal;
+        std::vector<int> _v_offset;
+        std::vector<UI32> _v_covered;
+        bool _use_covered;
+        VecN<DIM,I32> _tab_min;
+        VecN<DIM,I32> _tab_max;
+
+        //the fastest coordinate in memory
+        static int coordinateLine(){
+            return (DIM==1) ? 0 : 1;
+        }
+        int slabBegin(int slab)const{
+            return static_cast<int>((static_cast<F64>(_domain(_coordinate_split))*slab)/_nbr_slab);
+        }
+        //next line in memory order (x(coordinateLine())=0)
+        void nextLine(VecN<DIM,I32> & x)const{
+            for(int c=0;c<DIM;c++){
+                if(c==coordinateLine())
+                    continue;
+                if(++x(c)<_domain(c))
+                    return;
+                x(c)=0;
+            }
+        }
+        bool isInside(const VecN<DIM,I32> & x)const{
+            for(int c=0;c<DIM;c++){
+                if(x(c)<0||x(c)>=_domain(c))
+                    return false;
+            }
+            return true;
+        }
+        //first pass in the slabs begin<=slab<end, the neighbors in the previous slabs are ignored
+        void operator()(int begin,int end){
+            const int cl = coordinateLine();
+            const int n = _domain(cl);
+            const unsigned int nbr_causal = static_cast<unsigned int>(_v_offset.size());
+            const UI8 * data = _data;
+            UI32 * parent = _parent;
+            for(int slab=begin;slab<end;slab++){
+                int row_begin = (DIM==1) ? 0 : slabBegin(slab);
+                int row_end   = (DIM==1) ? 1 : slabBegin(slab+1);
+                if(row_begin==row_end)
+                    continue;
+                VecN<DIM,I32> x(0);
+                if(DIM>1)
+                    x(_coordinate_split)=row_begin;
+                const UI32 index_min = static_cast<UI32>(row_begin*_stride(_coordinate_split));
+                const UI32 index_max = (DIM==1) ? n : static_cast<UI32>(row_end*_stride(_coordinate_split));
+                for(UI32 line=index_min;line<index_max;line+=n,nextLine(x)){
+                    //the neighbors of the pixels of the line are inside the slab for line_begin<=x(cl)<line_end
+                    bool line_interior=true;
+                    for(int c=0;c<DIM;c++){
+                        if(c!=cl&&(x(c)+_tab_min(c)<(c==_coordinate_split ? row_begin : 0)||x(c)+_tab_max(c)>=_domain(c)))
+                            line_interior=false;
+                    }
+                    const int line_begin = line_interior ? -_tab_min(cl) : n;
+                    const int line_end   = n-_tab_max(cl);
+                    for(int xl=0;xl<n;xl++){
+                        const UI32 i = line+xl;
+                        if(data[i]==0){
+                            parent[i]=0;
+                            continue;
+                        }
+                        parent[i]=i+1;
+                        const bool interior = xl>=line_begin&&xl<line_end;
+                        if(interior==false)
+                            x(cl)=xl;
+                        UI32 covered=0;
+                        bool first=true;
+                        for(unsigned int k=0;k<nbr_causal;k++){
+                            if(_use_covered&&((covered>>k)&1))
+                                continue;
+                            if(interior==false){
+                                if(isInside(x+_v_causal[k])==false||static_cast<int>(i)+_v_offset[k]<static_cast<int>(index_min))
+                                    continue;
                             }
+                            UI32 j = i+_v_offset[k];
+                            if(data[j]==0)
+                                continue;
+                            if(first){
+                                parent[i]=parent[j];
+                                first=false;
+                            }else if(parent[j]!=parent[i]){
+                                _unionFindMerge(parent,i,j);
+                            }
+                            if(_use_covered)
+                                covered|=_v_covered[k];
                         }
                     }
+                    x(cl)=0;
+                }
+            }
+        }
+        //merge the pixels at the beginning of the slab with their neighbors in the previous slabs
+        void mergeBoundary(int slab){
+            const int cl = coordinateLine();
+            const int n = _domain(cl);
+            int row_begin = slabBegin(slab);
+            int reach = 0;
+            for(unsigned int k=0;k<_v_causal.size();k++)
+                reach = maximum(reach,-_v_causal[k](_coordinate_split));
+            int row_end = minimum(row_begin+reach,_domain(_coordinate_split));
+            VecN<DIM,I32> x(0);
+            x(_coordinate_split)=row_begin;
+            const UI32 index_min = static_cast<UI32>(row_begin*_stride(_coordinate_split));
+            const UI32 index_max = static_cast<UI32>(row_end*_stride(_coordinate_split));
+            for(UI32 line=index_min;line<index_max;line+=n,nextLine(x)){
+                for(int xl=0;xl<n;xl++){
+                    const UI32 i = line+xl;
+                    if(_data[i]==0)
+                        continue;
+                    x(cl)=xl;
+                    for(unsigned int k=0;k<_v_offset.size();k++){
+                        if(x(_coordinate_split)+_v_causal[k](_coordinate_split)>=row_begin||isInside(x+_v_causal[k])==false)
+                            continue;
+                        UI32 j = i+_v_offset[k];
+                        if(_data[j]!=0)
+                            _unionFindMerge(_parent,i,j);
+                    }
+                }
+                x(cl)=0;
+            }
+        }
+    };
+    //label the clusters of f (value!=0) in label and return the number of labels, numbered in the domain order if domain_order is true, in the memory order otherwise
+    template<int DIM>
+    static UI32 _clusterToLabelUnionFind(const MatN<DIM,UI8> & f, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh,MatN<DIM,UI32> & label,bool domain_order)
+    {
+        typedef VecN<DIM,I32> E;
+        const int size = f.getDomain().multCoordinate();
+        if(size==0)
+            return 0;
+        __FunctorClusterToLabelSlab<DIM> func;
+        func._data = f.data();
+        func._parent = label.data();
+        func._domain = f.getDomain();
+        func._stride = label.stride();
+        func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+        //the causal neighbors of the symmetrized neighborhood
+        std::vector<E> v_neigh;
+        for(unsigned int k=0;k<itneigh.tab().size();k++){
+            for(int sign=-1;sign<=1;sign+=2){
+                E v = itneigh.tab()[k]*sign;
+                if(VecNIndice<DIM>::VecN2Indice(func._stride,v)<0&&std::find(v_neigh.begin(),v_neigh.end(),v)==v_neigh.end())
+                    v_neigh.push_back(v);
+            }
+        }
+        std::vector<UI32> v_nbr_covered(v_neigh.size(),0);
+        for(unsigned int k=0;k<v_neigh.size();k++){
+            for(unsigned int l=0;l<v_neigh.size();l++){
+                E diff = v_neigh[l]-v_neigh[k];
+                if(l!=k&&(std::find(v_neigh.begin(),v_neigh.end(),diff)!=v_neigh.end()||std::find(v_neigh.begin(),v_neigh.end(),-diff)!=v_neigh.end()))
+                    v_nbr_covered[k]++;
+            }
+        }
+        //the neighbors adjacent to most of the others first, as the decision tree of Wu
+        for(unsigned int k=0;k<v_neigh.size();k++){
+            for(unsigned int l=k+1;l<v_neigh.size();l++){
+                if(v_nbr_covered[l]>v_nbr_covered[k]){
+                    std::swap(v_nbr_covered[l],v_nbr_covered[k]);
+                    std::swap(v_neigh[l],v_neigh[k]);
                 }
             }
         }
+        func._v_causal = v_neigh;
+        func._use_covered = v_neigh.size()<=32;
+        func._tab_min = 0;
+        func._tab_max = 0;
+        for(unsigned int k=0;k<v_neigh.size();k++){
+            func._v_offset.push_back(VecNIndice<DIM>::VecN2Indice(func._stride,v_neigh[k]));
+            UI32 covered=0;
+            for(unsigned int l=0;l<v_neigh.size()&&func._use_covered;l++){
+                E diff = v_neigh[l]-v_neigh[k];
+                if(l!=k&&(std::find(v_neigh.begin(),v_neigh.end(),diff)!=v_neigh.end()||std::find(v_neigh.begin(),v_neigh.end(),-diff)!=v_neigh.end()))
+                    covered|=(1u<<l);
+            }
+            func._v_covered.push_back(covered);
+            for(int c=0;c<DIM;c++){
+                func._tab_min(c)=minimum(func._tab_min(c),v_neigh[k](c));
+                func._tab_max(c)=maximum(func._tab_max(c),v_neigh[k](c));
+            }
+        }
+        func._nbr_slab = (size<PARALLEL_MINIMUM_SIZE||DIM==1) ? 1 : minimum(getNumberThreadParallel(),func._domain(func._coordinate_split));
+        forEachRangeParallel(0,func._nbr_slab,func);
+        for(int slab=1;slab<func._nbr_slab;slab++)
+            func.mergeBoundary(slab);
+
+        //the parent is before the pixel, so the roots are numbered in one pass in memory order
+        UI32 * data = label.data();
+        UI32 nbr_label=0;
+        for(int i=0;i<size;i++){
+            if(data[i]==0)
+                continue;
+            if(data[i]==static_cast<UI32>(i)+1)
+                data[i]=++nbr_label;
+            else
+                data[i]=data[data[i]-1];
+        }
+        if(domain_order==false||DIM==1)
+            return nbr_label;
+        //renumbering in the domain order (first coordinate first): key of the first pixel of each label in this order
+        const int cl = __FunctorClusterToLabelSlab<DIM>::coordinateLine();
+        const int n = func._domain(cl);
+        E stride_domain;
+        stride_domain(0)=1;
+        for(int c=1;c<DIM;c++)
+            stride_domain(c)=stride_domain(c-1)*func._domain(c-1);
+        std::vector<UI32> v_first(nbr_label+1,NumericLimits<UI32>::maximumRange());
+        E x(0);
+        for(int line=0;line<size;line+=n,func.nextLine(x)){
+            UI32 key = static_cast<UI32>(VecNIndice<DIM>::VecN2Indice(stride_domain,x));
+            for(int xl=0;xl<n;xl++,key+=stride_domain(cl)){
+                UI32 l = data[line+xl];
+                if(l!=0&&key<v_first[l])
+                    v_first[l]=key;
+            }
+        }
+        std::vector<bool> v_isfirst(size,false);
+        for(UI32 l=1;l<=nbr_label;l++)
+            v_isfirst[v_first[l]]=true;
+        std::vector<UI32> v_map(nbr_label+1,0);
+        UI32 nbr_label_domain=0;
+        for(int key=0;key<size;key++){
+            if(v_isfirst[key]){
+                int index=0;
+                for(int c=0;c<DIM;c++)
+                    index+=((key/stride_domain(c))%func._domain(c))*func._stride(c);
+                v_map[data[index]]=++nbr_label_domain;
+            }
+        }
+        for(int i=0;i<size;i++)
+            data[i]=v_map[data[i]];
+        return nbr_label;
+    }
+    //\endcond
+    //fast implementation for 2d case with radius=1
+    static inline Mat2UI32 clusterToLabel2D(const Mat2UI8 & f,int norm=0)
+    {
+        Mat2UI32 map(f.getDomain());
+        if(f.stride()!=map.stride())
+            return clusterToLabel<2,Mat2UI8::IteratorEDomain>(f,f.getIteratorENeighborhood(1,norm),f.getIteratorEDomain());
+        _clusterToLabelUnionFind(f,f.getIteratorENeighborhood(1,norm),map,true);
         return map;
     }
 
@@ -1326,6 +2373,40 @@ struct ProcessingAdvanced
         return clustermax;
     }
 
+    /*! \fn MatN<DIM,UI8> clusterMax(const MatN<DIM,UI8> & bin, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded>  itneigh)
+     * \param bin input binary matrix
+     * \param itneigh neighborhood IteratorE domain
+      *\return  max cluster
+     *
+     *  The ouput matrix is the max cluster of the input binary matrix, labelled with the union-find algorithm of clusterToLabel
+    */
+    template<int DIM>
+    static MatN<DIM,UI8> clusterMax(const MatN<DIM,UI8> & bin, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded>  itneigh)
+    {
+        MatN<DIM,UI32> label(bin.getDomain());
+        if(bin.stride()!=label.stride())
+            return clusterMax<MatN<DIM,UI8> >(bin,itneigh);
+        UI32 nbr_label = _clusterToLabelUnionFind(bin,itneigh,label,true);
+        const int size = bin.getDomain().multCoordinate();
+        const UI32 * datalabel = label.data();
+        std::vector<UI32> occurence(nbr_label+1,0);
+        for(int i=0;i<size;i++)
+            occurence[datalabel[i]]++;
+        UI32 maxoccurence=0;
+        UI32 maxlabel=0;
+        for(UI32 i=1;i<=nbr_label;i++){
+            if(maxoccurence<occurence[i]){
+                maxlabel=i;
+                maxoccurence=occurence[i];
+            }
+        }
+        MatN<DIM,UI8> clustermax(bin.getDomain());
+        UI8 * datamax = clustermax.data();
+        for(int i=0;i<size;i++)
+            datamax[i] = (datalabel[i]==maxlabel) ? NumericLimits<UI8>::maximumRange() : 0;
+        return clustermax;
+    }
+
     /*! \fn void FunctionProcedureMinimaRegional(const FunctionTopo & topo, typename FunctionTopo::IteratorENeighborhood  itneigh , FunctionLabel & minima)
      * \param topo input topographic surface
      * \param itneigh neighborhood IteratorE domain
@@ -1575,6 +2656,346 @@ struct ProcessingAdvanced
         }
         return pop.getRegion();
     }
+
+    /*!
+      * \param seed input seed
+     * \param topo input topographic surface
+     * \param itneigh neighborhood IteratorE domain
+      *\return  basins of the watershed transformation
+     *
+     *  Same result as the generic watershed with the flat hierarchical queue of _watershedHierarchicalQueue.
+     *  The number of pixels is limited to 2^31-1: above, an error message is printed (assertion in debug) and an empty matrix is returned.
+    */
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    static MatN<DIM,PixelTypeLabel> watershed(const MatN<DIM,PixelTypeLabel> & seed, const MatN<DIM,PixelTypeTopo> & topo, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh )
+    {
+        return _watershedHierarchicalQueue(seed,topo,static_cast<const MatN<DIM,UI8> *>(NULL),itneigh,false);
+    }
+    /*!
+      * \param seed input seed
+     * \param topo input topographic surface
+     * \param mask mask restricted the region growing
+     * \param itneigh neighborhood IteratorE domain
+      *\return  basins of the watershed transformation
+     *
+     *  Same result as the generic watershed with the flat hierarchical queue of _watershedHierarchicalQueue.
+     *  The number of pixels is limited to 2^31-1: above, an error message is printed (assertion in debug) and an empty matrix is returned.
+    */
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    static MatN<DIM,PixelTypeLabel> watershed(const MatN<DIM,PixelTypeLabel> & seed, const MatN<DIM,PixelTypeTopo> & topo, const MatN<DIM,UI8> & mask, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh )
+    {
+        return _watershedHierarchicalQueue(seed,topo,&mask,itneigh,false);
+    }
+    /*!
+      * \param seed input seed
+     * \param topo input topographic surface
+     * \param itneigh neighborhood IteratorE domain
+      *\return  basins of the watershed transformation with the boundary label 0
+     *
+     *  Same result as the generic watershedBoundary with the flat hierarchical queue of _watershedHierarchicalQueue.
+     *  The number of pixels is limited to 2^31-1: above, an error message is printed (assertion in debug) and an empty matrix is returned.
+    */
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    static MatN<DIM,PixelTypeLabel> watershedBoundary(const MatN<DIM,PixelTypeLabel> & seed, const MatN<DIM,PixelTypeTopo> & topo, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh )
+    {
+        return _watershedHierarchicalQueue(seed,topo,static_cast<const MatN<DIM,UI8> *>(NULL),itneigh,true);
+    }
+    /*!
+      * \param seed input seed
+     * \param topo input topographic surface
+     * \param mask mask restricted the region growing
+     * \param itneigh neighborhood IteratorE domain
+      *\return  basins of the watershed transformation labelled by seed+1 with the boundary label 1 and the outside of the mask 0
+     *
+     *  Same result as the generic watershedBoundary with the flat hierarchical queue of _watershedHierarchicalQueue.
+     *  The number of pixels is limited to 2^31-1: above, an error message is printed (assertion in debug) and an empty matrix is returned.
+    */
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    static MatN<DIM,PixelTypeLabel> watershedBoundary(const MatN<DIM,PixelTypeLabel> & seed, const MatN<DIM,PixelTypeTopo> & topo, const MatN<DIM,UI8> & mask, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh )
+    {
+        return _watershedHierarchicalQueue(seed,topo,&mask,itneigh,true);
+    }
+    //    \cond HIDDEN_SYMBOLS
+    //queue of the flooding on the linear indices: the pixels above the current level sorted by level, the ones at the current level in a FIFO
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    struct __WatershedHierarchicalQueue
+    {
+        typedef VecN<DIM,I32> E;
+        PixelTypeLabel * _dataregion;
+        const PixelTypeTopo * _datatopo;
+        std::vector<bool> * _done;
+        PixelTypeLabel _noregion;
+        I32 _current_level;
+        std::vector<UI32> _bucket;
+        std::vector<UI32> _bucket_end;
+        std::vector<UI32> _fifo;
+        E _stride;
+        E _domain;
+
+        E x(UI32 index)const{
+            E x;
+            for(int i=0;i<DIM;i++)
+                x(i)=(index/_stride(i))%_domain(i);
+            return x;
+        }
+        //a pixel not labelled and not already in the queue is labelled by label and pushed
+        void push(PixelTypeLabel label,UI32 index){
+            if((*_done)[index]==false&&_dataregion[index]==_noregion){
+                _dataregion[index]=label;
+                I32 level = maximum(_datatopo[index],static_cast<PixelTypeTopo>(_current_level));
+                if(level>_current_level){
+                    _bucket[_bucket_end[level]]=index;
+                    _bucket_end[level]++;
+                }else{
+                    _fifo.push_back(index);
+                }
+            }
+        }
+        //linear indices of the neighbors of x in the order of the neighborhood iterator
+        void neighbor(MatNIteratorENeighborhood<E,MatNBoundaryConditionBounded> & itneigh,const E & x,std::vector<UI32> & v_neigh)const{
+            v_neigh.clear();
+            itneigh.init(x);
+            if(itneigh.isInterior()){
+                const std::vector<std::ptrdiff_t> & offset = itneigh.tabOffset();
+                for(unsigned int i=0;i<offset.size();i++)
+                    v_neigh.push_back(static_cast<UI32>(itneigh.indexCenter()+offset[i]));
+            }else{
+                while(itneigh.next())
+                    v_neigh.push_back(static_cast<UI32>(VecNIndice<DIM>::VecN2Indice(_stride,itneigh.x())));
+            }
+        }
+    };
+    //neighbors not done of a layer of the FIFO, collected by chunks in parallel
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    struct __FunctorWatershedLayer
+    {
+        //candidate marking a pixel of the layer with a neighbor done before the layer with an other label
+        static const UI32 HIT = 0xFFFFFFFF;
+        const __WatershedHierarchicalQueue<DIM,PixelTypeLabel,PixelTypeTopo> * _queue;
+        const std::vector<UI32> * _source;
+        UI32 _begin;
+        UI32 _size_chunk;
+        UI32 _end;
+        bool _withboundary;
+        MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> _itgrowth;
+        //for each chunk, the candidates (position in the source, neighbor) in the FIFO order
+        std::vector<std::vector<std::pair<UI32,UI32> > > _candidate;
+        void operator()(int chunk_begin,int chunk_end){
+            MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itgrowth(_itgrowth);
+            std::vector<UI32> v_neigh;
+            for(int chunk=chunk_begin;chunk<chunk_end;chunk++){
+                std::vector<std::pair<UI32,UI32> > & candidate = _candidate[chunk];
+                candidate.clear();
+                UI32 read_end = std::min(_end,_begin+(chunk+1)*_size_chunk);
+                for(UI32 read=_begin+chunk*_size_chunk;read<read_end;read++){
+                    UI32 index = (*_source)[read];
+                    PixelTypeLabel label = _queue->_dataregion[index];
+                    _queue->neighbor(itgrowth,_queue->x(index),v_neigh);
+                    bool hit=false;
+                    for(unsigned int j=0;j<v_neigh.size();j++){
+                        if((*_queue->_done)[v_neigh[j]]==true){
+                            if(_queue->_dataregion[v_neigh[j]]!=label)
+                                hit=true;
+                        }
+                        //with boundary, the neighbors labelled but not done can be the pixels of the layer popped before
+                        else if(_withboundary==true||_queue->_dataregion[v_neigh[j]]==_queue->_noregion)
+                            candidate.push_back(std::make_pair(read,v_neigh[j]));
+                    }
+                    if(_withboundary==true&&hit==true)
+                        candidate.push_back(std::make_pair(read,HIT));
+                }
+            }
+        }
+    };
+    /*
+     * Watershed by flooding with a hierarchical queue on the linear indices of the pixels.
+     *
+     * The flooding order is the one of Population<...,RestrictedSetWithoutALL,SQFIFO,Growth> with FunctorTopography: a FIFO by
+     * level, a pixel pushed at the level max(topo(x),current level), the neighbors in the order of the neighborhood iterator.
+     * Since the current level never decreases, the first push of a pixel is always the first popped, so each pixel is pushed
+     * once with its label stored in the output matrix until it is popped (the bit set done marks the final labels).
+     * The pixels above the current level are stored in a single array sorted by level (counting sort with the histogram of
+     * the topography), and the ones at the current level in a FIFO vector reused for all the levels. So the memory is bounded by
+     * two UI32 by pixel, whatever the number of grey-levels.
+     *
+     * Parallel mode: the FIFO of a level is processed by layers, the pixels pushed by the pixels of a layer being the next layer.
+     * The neighbors of a large layer are computed by the threads on contiguous chunks, then the pops are applied sequentially in
+     * the FIFO order (position in the layer, then order in the neighborhood). With boundary, a pixel of the layer is a boundary
+     * pixel if a neighbor done before the layer (found by the threads) or a pixel of the layer popped before it (checked in the
+     * sequential pass) has an other label. The tie-breaking rule is so the one of the sequential flooding: a pixel is labelled
+     * by the first pixel popped in its neighborhood, the plateaus being flooded in the FIFO order. The result does not depend
+     * on the number of threads.
+     *
+     * A decomposition in sub-blocks flooded independently is not used: the label of a pixel on a plateau depends on the FIFO
+     * order of the whole level (the pixels pushed at a lower level anywhere in the domain come first), so the seams between the
+     * sub-blocks cannot be reconciled to the sequential result without flooding again the plateaus crossing them.
+     */
+    template<int DIM,typename PixelTypeLabel,typename PixelTypeTopo>
+    static MatN<DIM,PixelTypeLabel> _watershedHierarchicalQueue(const MatN<DIM,PixelTypeLabel> & seed, const MatN<DIM,PixelTypeTopo> & topo, const MatN<DIM,UI8> * mask, MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itneigh,bool withboundary )
+    {
+        typedef VecN<DIM,I32> E;
+        //the queue stores the linear indices in UI32, and the neighbors are computed with the int indexing of MatN
+        UI64 size_domain = 1;
+        for(int i=0;i<DIM;i++)
+            size_domain*=static_cast<UI64>(topo.getDomain()(i));
+        POP_DbgAssertMessage(size_domain<=static_cast<UI64>(NumericLimits<I32>::maximumRange()),"the number of pixels must be less than 2^31");
+        if(size_domain>static_cast<UI64>(NumericLimits<I32>::maximumRange())){
+            std::cerr<<"In ProcessingAdvanced::watershed, the number of pixels "<<size_domain<<" exceeds 2^31-1, the int index range of MatN, return an empty matrix"<<std::endl;
+            return MatN<DIM,PixelTypeLabel>();
+        }
+        const PixelTypeLabel noregion = RestrictedSetWithoutALL<PixelTypeLabel>::NoRegion;
+        //with mask and boundary, the labels are shifted by one and the boundary label is 1
+        const int shift = (mask!=NULL&&withboundary) ? 1 : 0;
+        const PixelTypeLabel labelboundary = static_cast<PixelTypeLabel>(shift);
+        FunctorTopography<MatN<DIM,PixelTypeTopo> > functortopo(topo);
+        const I32 nbrlevel = functortopo.nbrLevel();
+
+        MatN<DIM,PixelTypeLabel> region(topo.getDomain(),noregion);
+        const UI32 size = static_cast<UI32>(size_domain);
+        std::vector<bool> done(size,false);
+        __WatershedHierarchicalQueue<DIM,PixelTypeLabel,PixelTypeTopo> queue;
+        queue._dataregion = region.data();
+        queue._datatopo = topo.data();
+        queue._done = &done;
+        queue._noregion = noregion;
+        queue._current_level = 0;
+        queue._stride = region.stride();
+        queue._domain = region.getDomain();
+
+        //counting sort of the pixels by level
+        std::vector<UI32> bucket_begin(nbrlevel+1,0);
+        for(UI32 i=0;i<size;i++){
+            I32 level = maximum(queue._datatopo[i],static_cast<PixelTypeTopo>(0));
+            bucket_begin[level+1]++;
+        }
+        for(I32 level=0;level<nbrlevel;level++)
+            bucket_begin[level+1]+=bucket_begin[level];
+        queue._bucket_end.assign(bucket_begin.begin(),bucket_begin.end()-1);
+        queue._bucket.resize(size);
+
+        MatNIteratorENeighborhood<E,MatNBoundaryConditionBounded> itgrowth(itneigh);
+        itgrowth.removeCenter();
+
+        //initialisation of the seeds
+        typename MatN<DIM,PixelTypeTopo>::IteratorEDomain it(topo.getDomain());
+        while(it.next()){
+            UI32 index = static_cast<UI32>(VecNIndice<DIM>::VecN2Indice(queue._stride,it.x()));
+            if(mask!=NULL&&(*mask)(it.x())==0){
+                queue._dataregion[index]=0;
+                done[index]=true;
+            }
+            else if(seed(it.x())!=0){
+                PixelTypeLabel label = static_cast<PixelTypeLabel>(seed(it.x())+shift);
+                queue._dataregion[index]= (label==noregion) ? label-1 : label;
+                done[index]=true;
+            }
+        }
+        it.init();
+        std::vector<UI32> v_neigh;
+        while(it.next()){
+            if(seed(it.x())!=0&&(mask==NULL||(*mask)(it.x())!=0)){
+                UI32 index = static_cast<UI32>(VecNIndice<DIM>::VecN2Indice(queue._stride,it.x()));
+                queue.neighbor(itgrowth,it.x(),v_neigh);
+                for(unsigned int j=0;j<v_neigh.size();j++)
+                    queue.push(queue._dataregion[index],v_neigh[j]);
+            }
+        }
+
+        const int nbr_thread = getNumberThreadParallel();
+        __FunctorWatershedLayer<DIM,PixelTypeLabel,PixelTypeTopo> layer;
+        layer._queue = &queue;
+        layer._withboundary = withboundary;
+        layer._itgrowth = itgrowth;
+        layer._candidate.resize(4*nbr_thread);
+
+        //flooding level by level
+        for(queue._current_level=0;queue._current_level<nbrlevel;queue._current_level++){
+            //first the pixels pushed at the lower levels, then the ones pushed at this level layer by layer
+            const std::vector<UI32> * source = &queue._bucket;
+            UI32 begin = bucket_begin[queue._current_level];
+            UI32 end   = queue._bucket_end[queue._current_level];
+            while(true){
+                if(nbr_thread>1&&end-begin>=static_cast<UI32>(PARALLEL_MINIMUM_SIZE)){
+                    layer._source = source;
+                    layer._begin = begin;
+                    layer._end = end;
+                    layer._size_chunk = (end-begin+layer._candidate.size()-1)/layer._candidate.size();
+                    forEachRangeParallel(0,static_cast<int>(layer._candidate.size()),layer);
+                    for(unsigned int chunk=0;chunk<layer._candidate.size();chunk++){
+                        const std::vector<std::pair<UI32,UI32> > & candidate = layer._candidate[chunk];
+                        unsigned int j=0;
+                        UI32 read_end = std::min(end,begin+(chunk+1)*layer._size_chunk);
+                        for(UI32 read=begin+chunk*layer._size_chunk;read<read_end;read++){
+                            UI32 index = (*source)[read];
+                            PixelTypeLabel label = queue._dataregion[index];
+                            unsigned int j_end=j;
+                            while(j_end<candidate.size()&&candidate[j_end].first==read)
+                                j_end++;
+                            if(withboundary){
+                                bool hit=false;
+                                for(unsigned int k=j;k<j_end;k++){
+                                    UI32 v = candidate[k].second;
+                                    if(v==layer.HIT||(done[v]==true&&queue._dataregion[v]!=label))
+                                        hit=true;
+                                }
+                                if(hit==true){
+                                    queue._dataregion[index]=labelboundary;
+                                    done[index]=true;
+                                    j=j_end;
+                                    continue;
+                                }
+                            }
+                            done[index]=true;
+                            for(;j<j_end;j++)
+                                queue.push(label,candidate[j].second);
+                        }
+                    }
+                }else{
+                    for(UI32 read=begin;read<end;read++){
+                        UI32 index = (*source)[read];
+                        PixelTypeLabel label = queue._dataregion[index];
+                        E x = queue.x(index);
+                        if(withboundary){
+                            queue.neighbor(itneigh,x,v_neigh);
+                            bool hit=false;
+                            for(unsigned int j=0;j<v_neigh.size();j++){
+                                if(done[v_neigh[j]]==true&&queue._dataregion[v_neigh[j]]!=label)
+                                    hit=true;
+                            }
+                            if(hit==true){
+                                queue._dataregion[index]=labelboundary;
+                                done[index]=true;
+                                continue;
+                            }
+                        }
+                        done[index]=true;
+                        queue.neighbor(itgrowth,x,v_neigh);
+                        for(unsigned int j=0;j<v_neigh.size();j++)
+                            queue.push(label,v_neigh[j]);
+                    }
+                }
+                //the next layer
+                if(source==&queue._bucket){
+                    source = &queue._fifo;
+                    begin = 0;
+                }else{
+                    begin = end;
+                }
+                end = static_cast<UI32>(queue._fifo.size());
+                if(begin==end)
+                    break;
+            }
+            queue._fifo.clear();
+        }
+        if(mask!=NULL&&withboundary==false){
+            for(UI32 i=0;i<size;i++){
+                if(queue._dataregion[i]==noregion)
+                    queue._dataregion[i]=0;
+            }
+        }
+        return region;
+    }
+    //\endcond
     /*! \fn Function1 geodesicReconstruction(const Function1 & f,const Function2 & g, typename Function1::IteratorENeighborhood  itneigh)
       * \param f input matrix
      * \param g input matrix
@@ -1872,6 +3293,152 @@ struct ProcessingAdvanced
         }
         return std::make_pair(region,dist);
     }
+    /*! \fn std::pair<MatN<DIM,PixelType>,MatN<DIM,F32> >  voronoiTesselationEuclidean(const MatN<DIM,PixelType> & seed)
+      * \param seed input seed
+      * \return the first element of the pair contain the voronoi tesselation and the second the distance function
+      *
+      *  Exact voronoi tesselation based on the seeds \f$ region_i(x) = \{y :  d(y ,s_i) \leq d(y , s_j), j\neq i\}\f$ calculated with the euclidean norm.\n
+      * The squared distance is separable, so it is computed by successive 1d passes along each coordinate (lower envelope of parabolas,
+      * Felzenszwalb and Huttenlocher) with a linear complexity. The label of the nearest seed follows each pass. In each pass, the lines are shared
+      * between the threads. The squared distances are accumulated in F64, so they are exact for any domain.
+    */
+    template<int DIM,typename PixelType>
+    static std::pair<MatN<DIM,PixelType>,MatN<DIM,F32> >  voronoiTesselationEuclidean(const MatN<DIM,PixelType> & seed)
+    {
+        MatN<DIM,F32> dist(seed.getDomain());
+        MatN<DIM,PixelType> region(seed.getDomain());
+        _distanceEuclideanSeparable(seed,dist,&region);
+        return std::make_pair(region,dist);
+    }
+    /*! \fn MatN<DIM,F32> distanceEuclidean(const MatN<DIM,PixelType> & seed)
+      * \param seed input seed
+      * \return the euclidean distance function
+      *
+      *  Exact euclidean distance function to the seeds \f$ d(x) = \min_{'x\in \cup_{s_i}} |x' -x|_2 \f$ calculated with the separable algorithm
+      * of voronoiTesselationEuclidean without the label propagation. Without seed, the distance is 0 everywhere.
+    */
+    template<int DIM,typename PixelType>
+    static MatN<DIM,F32>  distanceEuclidean(const MatN<DIM,PixelType> & seed)
+    {
+        MatN<DIM,F32> dist(seed.getDomain());
+        _distanceEuclideanSeparable(seed,dist,static_cast<MatN<DIM,PixelType> *>(NULL));
+        return dist;
+    }
+    //    \cond HIDDEN_SYMBOLS
+    //in place squared distance along the direction coordinate, d(q)=min_p (q-p)^2+d(p), by the lower envelope of the parabolas of the finite sites
+    template<int DIM,typename PixelType>
+    struct __FunctorLineDistanceEuclidean
+    {
+        MatN<DIM,F64> * _dist;
+        MatN<DIM,PixelType> * _label;
+        int _coordinate;
+        int _coordinate_split;
+        //lines of the slab begin<=x(coordinate_split)<end
+        void operator()(int begin,int end){
+            const int n = _dist->getDomain()(_coordinate);
+            const int stride = _dist->stride()(_coordinate);
+            const F64 infinity = NumericLimits<F64>::maximumRange();
+            std::vector<F64> f(n),z(n+1);
+            std::vector<int> v(n);
+            std::vector<PixelType> label(_label!=NULL ? n : 0);
+            VecN<DIM,I32> domain_lines = _dist->getDomain();
+            domain_lines(_coordinate)=1;
+            if(_coordinate_split!=_coordinate)
+                domain_lines(_coordinate_split)=end-begin;
+            MatNIteratorEDomain<VecN<DIM,I32> > it(domain_lines);
+            VecN<DIM,I32> x;
+            while(it.next()){
+                x = it.x();
+                if(_coordinate_split!=_coordinate)
+                    x(_coordinate_split)+=begin;
+                int index = VecNIndice<DIM>::VecN2Indice(_dist->stride(),x);
+                F64 * pdist = _dist->data()+index;
+                PixelType * plabel = (_label!=NULL) ? _label->data()+index : NULL;
+                //lower envelope: v the sites, [z(k),z(k+1)] the interval where the parabola of v(k) is minimal
+                int k=-1;
+                for(int q=0;q<n;q++){
+                    f[q]=pdist[q*stride];
+                    if(plabel!=NULL)
+                        label[q]=plabel[q*stride];
+                    if(pdist[q*stride]>=infinity)
+                        continue;
+                    F64 s=-NumericLimits<F64>::maximumRange();
+                    while(k>=0){
+                        s = ((f[q]+static_cast<F64>(q)*q)-(f[v[k]]+static_cast<F64>(v[k])*v[k]))/(2.*(q-v[k]));
+                        if(s<=z[k])
+                            k--;
+                        else
+                            break;
+                    }
+                    if(k<0)
+                        s=-NumericLimits<F64>::maximumRange();
+                    k++;
+                    v[k]=q;
+                    z[k]=s;
+                    z[k+1]=NumericLimits<F64>::maximumRange();
+                }
+                //no site, the line stays at infinity
+                if(k<0)
+                    continue;
+                k=0;
+                for(int q=0;q<n;q++){
+                    while(z[k+1]<q)
+                        k++;
+                    F64 d = q-v[k];
+                    pdist[q*stride]=d*d+f[v[k]];
+                    if(plabel!=NULL)
+                        plabel[q*stride]=label[v[k]];
+                }
+            }
+        }
+    };
+    template<int DIM,typename PixelType>
+    static void _distanceEuclideanSeparable(const MatN<DIM,PixelType> & seed,MatN<DIM,F32> & dist,MatN<DIM,PixelType> * label)
+    {
+        const F64 infinity = NumericLimits<F64>::maximumRange();
+        const int size = dist.getDomain().multCoordinate();
+        if(size==0)
+            return;
+        //the squared distances are integers, exact in F64 (not in F32 above 2^24)
+        MatN<DIM,F64> distpower2(dist.getDomain());
+        if(seed.stride()==distpower2.stride()){
+            const PixelType * dataseed = seed.data();
+            F64 * datadist = distpower2.data();
+            for(int i=0;i<size;i++)
+                datadist[i]= (dataseed[i]!=0) ? 0 : infinity;
+            if(label!=NULL)
+                std::copy(dataseed,dataseed+size,label->data());
+        }else{
+            typename MatN<DIM,PixelType>::IteratorEDomain it(seed.getDomain());
+            while(it.next()){
+                distpower2(it.x())= (seed(it.x())!=0) ? 0 : infinity;
+                if(label!=NULL)
+                    (*label)(it.x())=seed(it.x());
+            }
+        }
+        __FunctorLineDistanceEuclidean<DIM,PixelType> func;
+        func._dist = &distpower2;
+        func._label = label;
+        for(int coordinate=0;coordinate<DIM;coordinate++){
+            func._coordinate = coordinate;
+            //the lines are shared between the threads by slabs along the slowest coordinate in memory different of the line direction
+            func._coordinate_split = (DIM==2) ? 0 : DIM-1;
+            if(func._coordinate_split==coordinate)
+                func._coordinate_split = (DIM==2) ? 1 : DIM-2;
+            if(DIM==1)
+                func._coordinate_split = coordinate;
+            if(func._coordinate_split==coordinate)
+                func(0,1);
+            else
+                forEachRangeParallel(0,dist.getDomain()(func._coordinate_split),func);
+        }
+        const F64 * datapower2 = distpower2.data();
+        F32 * data = dist.data();
+        for(int i=0;i<size;i++){
+            data[i] = (datapower2[i]>=infinity) ? 0 : static_cast<F32>(std::sqrt(datapower2[i]));
+        }
+    }
+    //\endcond
 
     /*! \fn static Function  erosionRegionGrowing(const Function & f,F32 radius, int norm=1)
           * \param bin input binary matrix
@@ -37,6 +37,7 @@ in the Software.
 #include"algorithm/ForEachFunctor.h"
 #include"algorithm/Visualization.h"
 #include"algorithm/GeometricalTransformation.h"
+#include<map>
 namespace pop
 {
 
@@ -81,173 +82,483 @@ enum FFT_WAY{
     FFT_BACKWARD=-1,
 };
 namespace Private{
-template<typename T>
-struct FFTAbtract{
-    virtual void apply(T*  data,FFT_WAY way=FFT_FORWARD)=0;
-};
-
-template<unsigned N, typename T=F32>
-struct FFTDanielsonLanczos :public FFTAbtract<T>{
-    void apply(T* data,FFT_WAY way=FFT_FORWARD) {
-        _sift(data);
-        _exec(data, way);
-    }
-    FFTDanielsonLanczos<N/2,T> _scale_two;
-    void _sift(T* data){
-        int m;
-        int n = N<<1;
-        int j=1;
-        for (int i=1; i<n; i+=2) {
-            if (j>i) {
-                std::swap(data[j-1], data[i-1]);
-                std::swap(data[j], data[i]);
+/*!
+ * \brief one-dimensional FFT of any size
+ *
+ * The size is factorized in radices 4, 2, 3, 5 and 7 for a mixed-radix decimation in time (Cooley-Tukey) with the twiddle factors
+ * computed once in double precision. A size with a prime factor greater than 7 is computed with the Bluestein algorithm as a
+ * circular convolution of size a power of 2. The plan is constant after its construction so it can be shared between threads,
+ * each thread with its own scratch buffer of size sizeScratch().
+ */
+class FFTPlan
+{
+public:
+    explicit FFTPlan(int n)
+        :_n(n),_plan_bluestein(NULL),_m(0)
+    {
+        int remainder = n;
+        int p = 4;
+        while(remainder>1){
+            while(remainder%p!=0){
+                switch(p){
+                case 4: p=2; break;
+                case 2: p=3; break;
+                default: p+=2;
+                }
+                if(p>7)
+                    break;
+            }
+            if(p>7)
+                break;
+            remainder/=p;
+            _factors.push_back(p);
+            _factors.push_back(remainder);
+        }
+        if(remainder>1){
+            //Bluestein: X_k = c_k sum_j (x_j c_j) conj(c_{k-j}) with the chirp c_k = exp(-i pi k^2/n)
+            _factors.clear();
+            _m=1;
+            while(_m<2*n-1)
+                _m*=2;
+            _plan_bluestein = new FFTPlan(_m);
+            _chirp.resize(n);
+            for(int k=0;k<n;k++){
+                long long k2 = (static_cast<long long>(k)*k)%(2*static_cast<long long>(n));
+                F64 angle = -pop::PI*k2/n;
+                _chirp[k]=ComplexF32(static_cast<F32>(std::cos(angle)),static_cast<F32>(std::sin(angle)));
             }
-            m = N;
-            while (m>=2 && j>m) {
-                j -= m;
-                m >>= 1;
+            std::vector<ComplexF32> v_filter(_m+_plan_bluestein->sizeScratch());
+            v_filter[0]=_chirp[0].conjugate();
+            for(int k=1;k<n;k++){
+                v_filter[k]=_chirp[k].conjugate();
+                v_filter[_m-k]=_chirp[k].conjugate();
             }
-            j += m;
-        };
+            _plan_bluestein->apply(&v_filter[0],&v_filter[_m],FFT_FORWARD);
+            _filter.resize(_m);
+            for(int k=0;k<_m;k++)
+                _filter[k]=v_filter[k]/static_cast<F32>(_m);
+        }else{
+            _twiddle_forward.resize(n);
+            _twiddle_backward.resize(n);
+            for(int k=0;k<n;k++){
+                F64 angle = -2*pop::PI*k/n;
+                _twiddle_forward[k]=ComplexF32(static_cast<F32>(std::cos(angle)),static_cast<F32>(std::sin(angle)));
+                _twiddle_backward[k]=_twiddle_forward[k].conjugate();
+            }
+        }
     }
-    void _exec(T* data,FFT_WAY way){
-        _scale_two._exec(data,way);
-        _scale_two._exec(data+N,way);
-
-        T wtemp,tempr,tempi,wr,wi,wpr,wpi;
-        wtemp = sin(pop::PI/N);
-        wpr = -2.f*wtemp*wtemp;
-        wpi = -way*sin(2*pop::PI/N);
-
-        wr = 1.f;
-        wi = 0.f;
-        for (unsigned i=0; i<N; i+=2) {
-            tempr = data[i+N]*wr - data[i+N+1]*wi;
-            tempi = data[i+N]*wi + data[i+N+1]*wr;
-            data[i+N] = data[i]-tempr;
-            data[i+N+1] = data[i+1]-tempi;
-            data[i] += tempr;
-            data[i+1] += tempi;
-
-            wtemp = wr;
-            wr += wr*wpr - wi*wpi;
-            wi += wi*wpr + wtemp*wpi;
+    ~FFTPlan(){
+        if(_plan_bluestein!=NULL)
+            delete _plan_bluestein;
+    }
+    int size()const{
+        return _n;
+    }
+    //! \return size of the scratch buffer of apply
+    int sizeScratch()const{
+        if(_plan_bluestein!=NULL)
+            return _m+_plan_bluestein->sizeScratch();
+        else
+            return _n;
+    }
+    /*!
+     * \param data n complex numbers transformed in place
+     * \param scratch buffer of sizeScratch() complex numbers
+     * \param way FFT_FORWARD for \f$X_k=\sum_j x_j e^{-2i\pi jk/n}\f$, FFT_BACKWARD for the conjugate exponent (without normalization)
+    */
+    void apply(ComplexF32 * data,ComplexF32 * scratch,FFT_WAY way)const{
+        if(_n<=1)
+            return;
+        if(_plan_bluestein!=NULL){
+            _applyBluestein(data,scratch,way);
+        }else{
+            _work(scratch,data,1,&_factors[0],(way==FFT_FORWARD)?&_twiddle_forward[0]:&_twiddle_backward[0],way);
+            std::copy(scratch,scratch+_n,data);
         }
-
     }
-};
-
-template<typename T>
-class FFTDanielsonLanczos<4,T>:public FFTAbtract<T>  {
-public:
-    void apply(T* data,FFT_WAY way =FFT_FORWARD){
-        std::swap(data[2],data[4]);
-        std::swap(data[3],data[5]);
-        _exec(data,way);
-    }
-    void _exec(T* data,FFT_WAY way=FFT_FORWARD) {
-        T tr = data[2];
-        T ti = data[3];
-        data[2] = data[0]-tr;
-        data[3] = data[1]-ti;
-        data[0] += tr;
-        data[1] += ti;
-        tr = data[6];
-        ti = data[7];
-        if(way==FFT_FORWARD){
-            data[6] = data[5]-ti;
-            data[7] = tr-data[4];
+private:
+    FFTPlan(const FFTPlan&);
+    FFTPlan& operator=(const FFTPlan&);
+    void _applyBluestein(ComplexF32 * data,ComplexF32 * scratch,FFT_WAY way)const{
+        //the backward transform is the conjugate of the forward transform of the conjugate
+        ComplexF32 * a = scratch;
+        for(int k=0;k<_n;k++)
+            a[k]= _multiply((way==FFT_FORWARD) ? data[k] : data[k].conjugate(),_chirp[k]);
+        std::fill(a+_n,a+_m,ComplexF32(0));
+        _plan_bluestein->apply(a,scratch+_m,FFT_FORWARD);
+        for(int k=0;k<_m;k++)
+            a[k]=_multiply(a[k],_filter[k]);
+        _plan_bluestein->apply(a,scratch+_m,FFT_BACKWARD);
+        for(int k=0;k<_n;k++){
+            data[k]= _multiply(a[k],_chirp[k]);
+            if(way==FFT_BACKWARD)
+                data[k]=data[k].conjugate();
+        }
+    }
+    //out = FFT of the n/fstride elements in[0], in[fstride], ... with the factors (p,m) of this size
+    void _work(ComplexF32 * out,const ComplexF32 * in,int fstride,const int * factors,const ComplexF32 * twiddle,FFT_WAY way)const{
+        const int p = factors[0];
+        const int m = factors[1];
+        if(m==1){
+            for(int j=0;j<p;j++)
+                out[j]=in[j*fstride];
         }else{
-            data[6] = -(data[5]-ti);
-            data[7] = -(tr-data[4]);
-        }
-        data[4] += tr;
-        data[5] += ti;
-
-        tr = data[4];
-        ti = data[5];
-        data[4] = data[0]-tr;
-        data[5] = data[1]-ti;
-        data[0] += tr;
-        data[1] += ti;
-        tr = data[6];
-        ti = data[7];
-        data[6] = data[2]-tr;
-        data[7] = data[3]-ti;
-        data[2] += tr;
-        data[3] += ti;
-
+            for(int j=0;j<p;j++)
+                _work(out+j*m,in+j*fstride,fstride*p,factors+2,twiddle,way);
+        }
+        switch(p){
+        case 2: _butterfly2(out,fstride,m,twiddle); break;
+        case 3: _butterfly3(out,fstride,m,twiddle); break;
+        case 4: _butterfly4(out,fstride,m,twiddle,way); break;
+        case 5: _butterfly5(out,fstride,m,twiddle); break;
+        default: _butterflyGeneric(out,fstride,m,p,twiddle);
+        }
     }
-};
-
-template<typename T>
-struct FFTDanielsonLanczos<1,T>:public FFTAbtract<T> {
-    void apply(T* ,FFT_WAY =FFT_FORWARD){}
-    void _exec(T* ,FFT_WAY ) {}
-};
-
-
-template<int POW>
-struct Pow2{
-    enum{value=2*Pow2<POW-1>::value};
-};
-template<>
-struct Pow2<0>{
-    enum{value=1};
-};
-template<int SCALE,int SCALE2>
-struct _InitFFT{
-    static void init(Vec<FFTAbtract<F32> *>&fft_op,Vec<int>& fft_size ){
-        fft_op.push_back(new FFTDanielsonLanczos<Pow2<SCALE>::value >);
-        fft_size.push_back(Pow2<SCALE>::value);
-        _InitFFT<SCALE+1,SCALE2>::init(fft_op,fft_size);
+    static ComplexF32 _multiply(const ComplexF32 & a,const ComplexF32 & b){
+        return ComplexF32(a.real()*b.real()-a.img()*b.img(),a.real()*b.img()+a.img()*b.real());
     }
-};
-template<int SCALE>
-struct _InitFFT<SCALE,SCALE>{
-    static void init(Vec<FFTAbtract<F32> *>&fft_op,Vec<int>& fft_size ){
-        fft_op.push_back(new FFTDanielsonLanczos<Pow2<SCALE>::value >);
-        fft_size.push_back(Pow2<SCALE>::value);
+    static void _butterfly2(ComplexF32 * out,int fstride,int m,const ComplexF32 * twiddle){
+        for(int k=0;k<m;k++){
+            ComplexF32 t = _multiply(out[k+m],twiddle[k*fstride]);
+            out[k+m]=out[k]-t;
+            out[k]+=t;
+        }
     }
-};
-
-
-
-template<int SCALE1=2,int SCALE2=12>
-struct FFTConcrete{
-    Vec<FFTAbtract<F32> *> _fft_op;
-    Vec<int> _fft_size;
-    int _select;
-    FFTConcrete():_select(-1){
-        _InitFFT<SCALE1,SCALE2>::init(_fft_op,_fft_size);
+    //the twiddle at n/3 (resp. n/5, 2n/5) is the cube (resp. fifth) root of unity of the way
+    static void _butterfly3(ComplexF32 * out,int fstride,int m,const ComplexF32 * twiddle){
+        const F32 epi3 = twiddle[fstride*m].img();
+        for(int k=0;k<m;k++){
+            ComplexF32 s1 = _multiply(out[k+m],twiddle[k*fstride]);
+            ComplexF32 s2 = _multiply(out[k+2*m],twiddle[2*k*fstride]);
+            ComplexF32 s3 = s1+s2;
+            ComplexF32 s0 = s1-s2;
+            ComplexF32 half = ComplexF32(out[k].real()-0.5f*s3.real(),out[k].img()-0.5f*s3.img());
+            out[k]+=s3;
+            s0 = ComplexF32(s0.real()*epi3,s0.img()*epi3);
+            out[k+2*m]=ComplexF32(half.real()+s0.img(),half.img()-s0.real());
+            out[k+m]  =ComplexF32(half.real()-s0.img(),half.img()+s0.real());
+        }
     }
-    void select(int nbr_element){
-        for(unsigned int i=0;i<=_fft_size.size();i++){
-            if(_fft_size[i]==nbr_element){
-                _select =i;
+    static void _butterfly5(ComplexF32 * out,int fstride,int m,const ComplexF32 * twiddle){
+        const ComplexF32 ya = twiddle[fstride*m];
+        const ComplexF32 yb = twiddle[2*fstride*m];
+        for(int k=0;k<m;k++){
+            ComplexF32 s0 = out[k];
+            ComplexF32 s1 = _multiply(out[k+m],twiddle[k*fstride]);
+            ComplexF32 s2 = _multiply(out[k+2*m],twiddle[2*k*fstride]);
+            ComplexF32 s3 = _multiply(out[k+3*m],twiddle[3*k*fstride]);
+            ComplexF32 s4 = _multiply(out[k+4*m],twiddle[4*k*fstride]);
+            ComplexF32 s7 = s1+s4;
+            ComplexF32 s10 = s1-s4;
+            ComplexF32 s8 = s2+s3;
+            ComplexF32 s9 = s2-s3;
+            out[k]=s0+s7+s8;
+            ComplexF32 s5(s0.real()+s7.real()*ya.real()+s8.real()*yb.real(),s0.img()+s7.img()*ya.real()+s8.img()*yb.real());
+            ComplexF32 s6(s10.img()*ya.img()+s9.img()*yb.img(),-s10.real()*ya.img()-s9.real()*yb.img());
+            out[k+m]  =s5-s6;
+            out[k+4*m]=s5+s6;
+            ComplexF32 s11(s0.real()+s7.real()*yb.real()+s8.real()*ya.real(),s0.img()+s7.img()*yb.real()+s8.img()*ya.real());
+            ComplexF32 s12(-s10.img()*yb.img()+s9.img()*ya.img(),s10.real()*yb.img()-s9.real()*ya.img());
+            out[k+2*m]=s11+s12;
+            out[k+3*m]=s11-s12;
+        }
+    }
+    static void _butterfly4(ComplexF32 * out,int fstride,int m,const ComplexF32 * twiddle,FFT_WAY way){
+        for(int k=0;k<m;k++){
+            ComplexF32 s0 = _multiply(out[k+m],twiddle[k*fstride]);
+            ComplexF32 s1 = _multiply(out[k+2*m],twiddle[2*k*fstride]);
+            ComplexF32 s2 = _multiply(out[k+3*m],twiddle[3*k*fstride]);
+            ComplexF32 s5 = out[k]-s1;
+            out[k]+=s1;
+            ComplexF32 s3 = s0+s2;
+            ComplexF32 s4 = s0-s2;
+            out[k+2*m]=out[k]-s3;
+            out[k]+=s3;
+            //multiplication of s4 by -i (forward) or i (backward)
+            if(way==FFT_FORWARD){
+                out[k+m]  =ComplexF32(s5.real()+s4.img(),s5.img()-s4.real());
+                out[k+3*m]=ComplexF32(s5.real()-s4.img(),s5.img()+s4.real());
+            }else{
+                out[k+m]  =ComplexF32(s5.real()-s4.img(),s5.img()+s4.real());
+                out[k+3*m]=ComplexF32(s5.real()+s4.img(),s5.img()-s4.real());
             }
-            if(i==_fft_size.size()){
-                std::cerr<<"Cannot find the FFT for this size"<<std::endl;
+        }
+    }
+    void _butterflyGeneric(ComplexF32 * out,int fstride,int m,int p,const ComplexF32 * twiddle)const{
+        ComplexF32 scratch[7];
+        for(int u=0;u<m;u++){
+            for(int q=0;q<p;q++)
+                scratch[q]=out[u+q*m];
+            for(int q1=0;q1<p;q1++){
+                int k=u+q1*m;
+                int index_twiddle=0;
+                ComplexF32 sum = scratch[0];
+                for(int q=1;q<p;q++){
+                    index_twiddle+=fstride*k;
+                    if(index_twiddle>=_n)
+                        index_twiddle%=_n;
+                    sum+=_multiply(scratch[q],twiddle[index_twiddle]);
+                }
+                out[k]=sum;
             }
         }
     }
-
-    void apply(F32 *  data,int nbr_element,FFT_WAY way=FFT_FORWARD){
-        if(_select>=0)
-            _fft_op(_select)->apply(data,way);
-        else{
-            for(unsigned int i=0;i<=_fft_size.size();i++){
-                if(_fft_size[i]==nbr_element){
-                    _fft_op(i)->apply(data,way);
-                    break;
+    int _n;
+    std::vector<int> _factors;
+    std::vector<ComplexF32> _twiddle_forward;
+    std::vector<ComplexF32> _twiddle_backward;
+    FFTPlan * _plan_bluestein;
+    int _m;
+    std::vector<ComplexF32> _chirp;
+    std::vector<ComplexF32> _filter;
+};
+/*!
+ * \brief plans cached by size for the process lifetime
+ */
+class FFTPlanCache
+{
+public:
+    static const FFTPlan & getPlan(int n){
+        FFTPlanCache & cache = instance();
+        const FFTPlan * plan;
+#if defined(HAVE_THREAD)
+        tthread::lock_guard<tthread::mutex> guard(cache._mutex);
+#endif
+#if defined(HAVE_OPENMP)
+#pragma omp critical(pop_fft_plan_cache)
+#endif
+        {
+            std::map<int,FFTPlan *>::iterator it = cache._plans.find(n);
+            if(it==cache._plans.end())
+                it = cache._plans.insert(std::make_pair(n,new FFTPlan(n))).first;
+            plan = it->second;
+        }
+        return *plan;
+    }
+    ~FFTPlanCache(){
+        for(std::map<int,FFTPlan *>::iterator it=_plans.begin();it!=_plans.end();it++)
+            delete it->second;
+    }
+private:
+    static FFTPlanCache & instance(){
+        static FFTPlanCache cache;
+        return cache;
+    }
+    std::map<int,FFTPlan *> _plans;
+#if defined(HAVE_THREAD)
+    tthread::mutex _mutex;
+#endif
+};
+//    \cond HIDDEN_SYMBOLS
+//FFT of the lines along a direction: the matrix is a sequence of _nbr_block blocks of _size hyperplanes contiguous in memory,
+//each hyperplane of _stride elements. For a non-contiguous direction, the lines are gathered by batches of adjacent lines.
+struct __FunctorFFTLines
+{
+    enum{BATCH=8};
+    ComplexF32 * _data;
+    const FFTPlan * _plan;
+    int _size;
+    int _stride;
+    int _nbr_block;
+    int _nbr_batch;
+    FFT_WAY _way;
+    int nbrRange()const{
+        return (_stride==1) ? _nbr_block : _nbr_block*_nbr_batch;
+    }
+    void operator()(int begin,int end){
+        std::vector<ComplexF32> v_scratch(_plan->sizeScratch());
+        if(_stride==1){
+            for(int b=begin;b<end;b++)
+                _plan->apply(_data+static_cast<std::size_t>(b)*_size,&v_scratch[0],_way);
+            return;
+        }
+        std::vector<ComplexF32> v_lines(static_cast<std::size_t>(BATCH)*_size);
+        for(int u=begin;u<end;u++){
+            int b = u/_nbr_batch;
+            int j = (u%_nbr_batch)*BATCH;
+            int width = std::min(static_cast<int>(BATCH),_stride-j);
+            ComplexF32 * p = _data+static_cast<std::size_t>(b)*_size*_stride+j;
+            for(int i=0;i<_size;i++)
+                for(int w=0;w<width;w++)
+                    v_lines[w*_size+i]=p[static_cast<std::size_t>(i)*_stride+w];
+            for(int w=0;w<width;w++)
+                _plan->apply(&v_lines[w*_size],&v_scratch[0],_way);
+            for(int i=0;i<_size;i++)
+                for(int w=0;w<width;w++)
+                    p[static_cast<std::size_t>(i)*_stride+w]=v_lines[w*_size+i];
+        }
+    }
+};
+//FFT of the pairs of real lines (2l,2l+1) packed in the contiguous lines 2l (real part) and 2l+1 (imaginary part) for l in [begin,end).
+//Forward: the packed lines are z=a+ib and the output lines are the FFT of a and b.
+//Backward: the input lines are the hermitian A and B, and the output line 2l is the backward FFT of A+iB, equal to a+ib.
+struct __FunctorFFTRealLines
+{
+    ComplexF32 * _data;
+    const FFTPlan * _plan;
+    int _size;
+    int _nbr_line;
+    FFT_WAY _way;
+    void operator()(int begin,int end){
+        std::vector<ComplexF32> v_scratch(_plan->sizeScratch());
+        std::vector<ComplexF32> v_z(_size);
+        const int n = _size;
+        for(int l=begin;l<end;l++){
+            ComplexF32 * line_a = _data+static_cast<std::size_t>(2*l)*n;
+            ComplexF32 * line_b = (2*l+1<_nbr_line) ? line_a+n : NULL;
+            if(_way==FFT_FORWARD){
+                _plan->apply(line_a,&v_scratch[0],FFT_FORWARD);
+                std::copy(line_a,line_a+n,v_z.begin());
+                for(int k=0;k<n;k++){
+                    ComplexF32 z_k = v_z[k];
+                    ComplexF32 z_minus_k = v_z[(n-k)%n].conjugate();
+                    line_a[k]=(z_k+z_minus_k)*0.5f;
+                    if(line_b!=NULL){
+                        ComplexF32 d = z_k-z_minus_k;
+                        line_b[k]=ComplexF32(d.img()*0.5f,-d.real()*0.5f);
+                    }
                 }
-                if(i==_fft_size.size()){
-                    std::cerr<<"Cannot find the FFT for this size"<<std::endl;
+            }else{
+                for(int k=0;k<n;k++){
+                    if(line_b!=NULL)
+                        v_z[k]=ComplexF32(line_a[k].real()-line_b[k].img(),line_a[k].img()+line_b[k].real());
+                    else
+                        v_z[k]=line_a[k];
                 }
+                _plan->apply(&v_z[0],&v_scratch[0],FFT_BACKWARD);
+                std::copy(v_z.begin(),v_z.end(),line_a);
             }
         }
     }
 };
+//\endcond
+/*!
+ * \brief FFT of the matrix in place along the given direction, the lines shared between the threads
+ */
+template<int DIM>
+void FFTDirection(MatN<DIM,ComplexF32> & data,int direction,FFT_WAY way){
+    if(data.getDomain().multCoordinate()==0||data.getDomain()(direction)<=1)
+        return;
+    __FunctorFFTLines func;
+    func._data = data.data();
+    func._plan = &FFTPlanCache::getPlan(data.getDomain()(direction));
+    func._size = data.getDomain()(direction);
+    func._stride = data.stride()(direction);
+    func._nbr_block = data.getDomain().multCoordinate()/(func._size*func._stride);
+    func._nbr_batch = (func._stride+__FunctorFFTLines::BATCH-1)/__FunctorFFTLines::BATCH;
+    func._way = way;
+    if(data.getDomain().multCoordinate()<PARALLEL_MINIMUM_SIZE)
+        func(0,func.nbrRange());
+    else
+        forEachRangeParallel(0,func.nbrRange(),func);
+}
+/*!
+ * \brief smallest size greater or equal to n with the prime factors 2, 3 and 5 (the sizes of FFTPlan with a specialized butterfly)
+ */
+inline int FFTFastSize(int n){
+    for(int m=maximum(n,1);;m++){
+        int remainder = m;
+        for(int p=2;p<=5;p++){
+            while(remainder%p==0)
+                remainder/=p;
+        }
+        if(remainder==1)
+            return m;
+    }
+}
+/*!
+ * \brief tiles of the overlap-save convolution
+ *
+ * The output is computed by tiles of size tile(). Each tile is the valid part of the circular convolution of an input block of fast size
+ * block()=tile()+kernel-1 (see FFTFastSize). The number of tiles by direction is chosen to minimize cost() with at most size_block_max
+ * elements by block, so the memory is bounded for the large volumes.
+ */
+template<int DIM>
+class FFTConvolutionTiling
+{
+public:
+    FFTConvolutionTiling(const VecN<DIM,I32> & domain,const VecN<DIM,I32> & domain_kernel,int size_block_max)
+        :_domain(domain),_domain_kernel(domain_kernel),_cost(-1)
+    {
+        //candidate blocks by direction for 1, 2, 3,... tiles, the number of tiles growing geometrically
+        std::vector<int> v_block[DIM];
+        for(int i=0;i<DIM;i++){
+            int nbr_tile=1;
+            while(true){
+                int tile = (domain(i)+nbr_tile-1)/nbr_tile;
+                int block = FFTFastSize(tile+domain_kernel(i)-1);
+                if(v_block[i].empty()||block<v_block[i].back())
+                    v_block[i].push_back(block);
+                if(tile<=1)
+                    break;
+                nbr_tile = minimum(maximum(nbr_tile+1,nbr_tile*5/4),domain(i));
+            }
+        }
+        VecN<DIM,I32> block;
+        _search(0,v_block,block,size_block_max);
+        if(_cost<0){
+            //the kernel is too large for size_block_max: the smallest blocks
+            for(int i=0;i<DIM;i++)
+                block(i)=v_block[i].back();
+            _set(block);
+        }
+    }
+    //! \return size of the output tile
+    const VecN<DIM,I32> & tile()const{
+        return _tile;
+    }
+    //! \return size of the input block transformed by FFT
+    const VecN<DIM,I32> & block()const{
+        return _block;
+    }
+    //! \return number of tiles to cover the domain
+    VecN<DIM,I32> nbrTile()const{
+        VecN<DIM,I32> nbr;
+        for(int i=0;i<DIM;i++)
+            nbr(i)=(_domain(i)+_tile(i)-1)/_tile(i);
+        return nbr;
+    }
+    //! \return \f$n\log_2(n)\f$ summed over the tiles with n the number of elements of the block, proportional to the cost of the FFT convolution
+    F64 cost()const{
+        return _cost;
+    }
+private:
+    F64 _costBlock(const VecN<DIM,I32> & block)const{
+        F64 size_block=1;
+        F64 nbr_tile=1;
+        for(int i=0;i<DIM;i++){
+            size_block*=block(i);
+            nbr_tile*=(_domain(i)+block(i)-_domain_kernel(i))/(block(i)-_domain_kernel(i)+1);
+        }
+        return nbr_tile*size_block*std::log(size_block)/std::log(2.);
+    }
+    void _set(const VecN<DIM,I32> & block){
+        _block = block;
+        _tile = block-_domain_kernel+1;
+        _cost = _costBlock(block);
+    }
+    void _search(int i,const std::vector<int> * v_block,VecN<DIM,I32> & block,F64 size_block_max){
+        if(i==DIM){
+            F64 cost = _costBlock(block);
+            if(_cost<0||cost<_cost)
+                _set(block);
+            return;
+        }
+        F64 size_block=1;
+        for(int j=0;j<i;j++)
+            size_block*=block(j);
+        for(unsigned int k=0;k<v_block[i].size();k++){
+            block(i)=v_block[i][k];
+            if(size_block*block(i)<=size_block_max)
+                _search(i+1,v_block,block,size_block_max);
+        }
+    }
+    VecN<DIM,I32> _domain;
+    VecN<DIM,I32> _domain_kernel;
+    VecN<DIM,I32> _tile;
+    VecN<DIM,I32> _block;
+    F64 _cost;
+};
 }
 
 struct POP_EXPORTS Representation
@@ -278,85 +589,124 @@ struct POP_EXPORTS Representation
         * \brief Apply the FFT on the input matrix
 
          *
+         * The FFT is computed at the full resolution for any domain: the sizes with the prime factors 2, 3, 5 and 7 are computed directly (2, 3 and 5 are the fastest), the others
+         * use the Bluestein algorithm. The plans of the line FFTs are cached between the calls and the lines are shared between the threads.
+         * The inverse FFT is not normalized (see scale).
         */
     static inline Mat2ComplexF32  FFT(const Mat2ComplexF32 & f ,FFT_WAY way=FFT_FORWARD)
     {
-        Mat2ComplexF32  data;
-        truncatePower2(f,data);
-        Private::FFTConcrete<> fft;
-        for(unsigned int i=0;i<data.sizeI();i++){
-            ComplexF32 *line = data.data()+i*data.sizeJ();
-            fft.apply(line->data(),data.sizeJ(),way);
-        }
-        ComplexF32* t = new ComplexF32[data.sizeI()];
-        for(unsigned int j=0;j<data.sizeJ();j++){
-            unsigned int position =j;
-            for(unsigned int i=0;i<data.sizeI();i++){
-                t[i]=data(position);
-                position+=data.sizeJ();
-            }
-            fft.apply(t[0].data(),data.sizeI(),way);
-            position =j;
-            for(unsigned int i=0;i<data.sizeI();i++){
-                data(position)=t[i];
-                position+=data.sizeJ();
-            }
-        }
-		delete[] t;
-        return data;
+        return FFTMultiDimension(f,way);
     }
     static inline Mat3ComplexF32 FFT(const Mat3ComplexF32 & f,FFT_WAY way=FFT_FORWARD) {
-        Mat3ComplexF32  data;
-        truncatePower2(f,data);
-        Private::FFTConcrete<> fft;
-        for(unsigned int i=0;i<data.sizeI();i++){
-            for(unsigned int k=0;k<data.sizeK();k++){
-                ComplexF32 *line = data.data()+i*data.sizeJ()+k*data.sizeJ()*data.sizeI();
-                fft.apply(line->data(),data.sizeJ(),way);
-            }
+        return FFTMultiDimension(f,way);
+    }
+    static inline MatN<1,ComplexF32> FFT(const MatN<1,ComplexF32> & f ,FFT_WAY way=FFT_FORWARD)
+    {
+        return FFTMultiDimension(f,way);
+    }
+    /*!
+     * \param f input matrix with ComplexF32 as pixel/voxel type
+     * \param way for direct  FFT FFT_FORWARD , for  inverse FFT FFT_BACKWARD
+     * \return the fft
+     * \brief FFT in any dimension, direction by direction
+    */
+    template<int DIM>
+    static MatN<DIM,ComplexF32> FFTMultiDimension(const MatN<DIM,ComplexF32> & f,FFT_WAY way=FFT_FORWARD)
+    {
+        MatN<DIM,ComplexF32> data(f);
+        for(int i=0;i<DIM;i++)
+            Private::FFTDirection(data,i,way);
+        return data;
+    }
+    /*!
+     * \param f input real matrix
+     * \return the fft of f (all the frequencies, with \f$\hat f(-k)=\hat f(k)^*\f$)
+     * \brief forward FFT of a real matrix
+     *
+     * Two real lines are transformed by a single complex FFT in the contiguous direction, so the first pass costs half of the complex FFT.
+     * \code
+     * Mat2UI8 img;
+     * img.load(POP_PROJECT_SOURCE_DIR+std::string("/image/Lena.bmp"));
+     * Mat2ComplexF32 fft = Representation::FFTRealToComplex(Mat2F32(img));
+     * Mat2F32 imgf = Representation::FFTComplexToReal(fft)/static_cast<F32>(img.size());
+     * \endcode
+    */
+    template<int DIM>
+    static MatN<DIM,ComplexF32> FFTRealToComplex(const MatN<DIM,F32> & f)
+    {
+        MatN<DIM,ComplexF32> data(f.getDomain());
+        const int direction = (DIM==1) ? 0 : 1;
+        const int n = f.getDomain()(direction);
+        const int nbr_line = (n==0) ? 0 : f.getDomain().multCoordinate()/n;
+        MatN<DIM,F32> fcontiguous(f);
+        //the pair of lines (a,b) is packed in z=a+ib, then A_k=(Z_k+Z^*_{n-k})/2 and B_k=(Z_k-Z^*_{n-k})/(2i)
+        for(int l=0;l<nbr_line;l+=2){
+            const F32 * a = fcontiguous.data()+static_cast<std::size_t>(l)*n;
+            const F32 * b = (l+1<nbr_line) ? a+n : NULL;
+            ComplexF32 * z = data.data()+static_cast<std::size_t>(l)*n;
+            for(int k=0;k<n;k++)
+                z[k]=ComplexF32(a[k],(b!=NULL)?b[k]:0);
         }
-		ComplexF32* t = new ComplexF32[data.sizeI()];
-        for(unsigned int j=0;j<data.sizeJ();j++){
-            for(unsigned int k=0;k<data.sizeK();k++){
-                unsigned int position =j+k*data.sizeJ()*data.sizeI();
-                for(unsigned int i=0;i<data.sizeI();i++){
-                    t[i]=data(position);
-                    position+=data.sizeJ();
-                }
-                fft.apply(t[0].data(),data.sizeI(),way);
-                position =j+k*data.sizeJ()*data.sizeI();
-                for(unsigned int i=0;i<data.sizeI();i++){
-                    data(position)=t[i];
-                    position+=data.sizeJ();
-                }
-            }
+        if(n>1){
+            Private::__FunctorFFTRealLines func;
+            func._data = data.data();
+            func._plan = &Private::FFTPlanCache::getPlan(n);
+            func._size = n;
+            func._nbr_line = nbr_line;
+            func._way = FFT_FORWARD;
+            if(data.getDomain().multCoordinate()<PARALLEL_MINIMUM_SIZE)
+                func(0,(nbr_line+1)/2);
+            else
+                forEachRangeParallel(0,(nbr_line+1)/2,func);
         }
-		delete[] t;
-		ComplexF32* t2 = new ComplexF32[data.sizeI()];
-        for(unsigned int i=0;i<data.sizeI();i++){
-            for(unsigned int j=0;j<data.sizeJ();j++){
-                unsigned int position =j+i*data.sizeI();
-                for(unsigned int k=0;k<data.sizeK();k++){
-                    t2[k]=data(position);
-                    position+=data.sizeJ()*data.sizeI();
-                }
-                fft.apply(t2[0].data(),data.sizeK(),way);
-                position =j+i*data.sizeI();
-                for(unsigned int k=0;k<data.sizeK();k++){
-                    data(position)=t2[k];
-                    position+=data.sizeJ()*data.sizeI();
-                }
-            }
+        for(int i=0;i<DIM;i++){
+            if(i!=direction)
+                Private::FFTDirection(data,i,FFT_FORWARD);
         }
-		delete[] t2;
         return data;
     }
-    static inline MatN<1,ComplexF32> FFT(MatN<1,ComplexF32> & f ,FFT_WAY way=FFT_FORWARD)
+    /*!
+     * \param f input fourier matrix of a real matrix (\f$f(-k)=f(k)^*\f$)
+     * \return the real part of the backward FFT of f (not normalized as FFT)
+     * \brief backward FFT to a real matrix
+     *
+     * The backward FFT is applied in all the directions except the contiguous one, then two hermitian lines are transformed by a single complex FFT.
+    */
+    template<int DIM>
+    static MatN<DIM,F32> FFTComplexToReal(const MatN<DIM,ComplexF32> & f)
     {
-        MatN<1,ComplexF32> data(f);
-        Private::FFTConcrete<> fft;
-        fft.apply(data.data()->data(),data.sizeI(),way);
-        return data;
+        MatN<DIM,ComplexF32> data(f);
+        const int direction = (DIM==1) ? 0 : 1;
+        for(int i=0;i<DIM;i++){
+            if(i!=direction)
+                Private::FFTDirection(data,i,FFT_BACKWARD);
+        }
+        const int n = f.getDomain()(direction);
+        const int nbr_line = (n==0) ? 0 : f.getDomain().multCoordinate()/n;
+        MatN<DIM,F32> out(f.getDomain());
+        if(n>1){
+            Private::__FunctorFFTRealLines func;
+            func._data = data.data();
+            func._plan = &Private::FFTPlanCache::getPlan(n);
+            func._size = n;
+            func._nbr_line = nbr_line;
+            func._way = FFT_BACKWARD;
+            if(data.getDomain().multCoordinate()<PARALLEL_MINIMUM_SIZE)
+                func(0,(nbr_line+1)/2);
+            else
+                forEachRangeParallel(0,(nbr_line+1)/2,func);
+        }
+        //the pair of lines (a,b) is in z=a+ib
+        for(int l=0;l<nbr_line;l+=2){
+            const ComplexF32 * z = data.data()+static_cast<std::size_t>(l)*n;
+            F32 * a = out.data()+static_cast<std::size_t>(l)*n;
+            for(int k=0;k<n;k++){
+                a[k]=z[k].real();
+                if(l+1<nbr_line)
+                    a[k+n]=z[k].img();
+            }
+        }
+        return out;
     }
 
     /*! \brief visualization of the fourrier matrix in log scale h(x) = log( ||f(x)||+1)
@@ -467,29 +817,95 @@ struct POP_EXPORTS Representation
     template<int DIM,typename PixelType>
     static MatN<DIM,F32> correlationDirectionByFFT(const MatN<DIM,PixelType> & f){
 
-        MatN<DIM,PixelType> bint;
-        pop::Representation::truncatePower2(f,bint);
-        MatN<DIM,F32> binfloat(bint);
-        typename MatN<DIM,PixelType>::IteratorEDomain it (binfloat.getIteratorEDomain());
+        MatN<DIM,F32> binfloat(f);
+        typename MatN<DIM,F32>::IteratorEDomain it (binfloat.getIteratorEDomain());
         binfloat = pop::ProcessingAdvanced::greylevelRange(binfloat,it,0,1);
+        MatN<DIM,ComplexF32>  fft = pop::Representation::FFTRealToComplex(binfloat);
+        for(unsigned int i=0;i<fft.size();i++){
+            fft(i).real() = fft(i).real()*fft(i).real()+fft(i).img()*fft(i).img();
+            fft(i).img() =0;
+        }
+        MatN<DIM,F32>  fout = pop::Representation::FFTComplexToReal(fft);
+        return  fout;
 
+    }
+    //@}
 
-        MatN<DIM,ComplexF32>  bin_complex(bint.getDomain());
-        Convertor::fromRealImaginary(binfloat,bin_complex);
-        MatN<DIM,ComplexF32>  fft = pop::Representation::FFT(bin_complex,FFT_FORWARD);
-
-        it.init();
-        while(it.next()){
-            ComplexF32 c = fft(it.x());
-            ComplexF32 c1 = fft(it.x());
-            fft(it.x()).real() = (c*c1.conjugate()).real();
-            fft(it.x()).img() =0;
-        }
-        fft  = pop::Representation::FFT(fft,FFT_BACKWARD);
-        MatN<DIM,F32>  fout(bint.getDomain());
-        Convertor::toRealImaginary(fft,fout);
-        return  fout;
+    //-------------------------------------
+    //
+    //! \name Convolution in Fourier space
+    //@{
+    //-------------------------------------
 
+    /*!
+     * \param f input matrix with a scalar pixel type
+     * \param kernel input kernel with a scalar pixel type
+     * \param size_block_max maximum number of elements of the blocks transformed by FFT
+     * \return \f$(f\ast k)(x)=\sum_{x'} f(x-x'+c) k(x')\f$ with \f$c\f$ the center (kernel.getDomain()-1)/2, as Processing::convolution
+     * \brief convolution by overlap-save FFT
+     *
+     * The output is computed by tiles (see Private::FFTConvolutionTiling). For each tile, the input block, extended beyond the domain
+     * with the boundary condition, is multiplied in the Fourier space by the FFT of the kernel, computed once, and the part of the
+     * circular convolution without wrap-around is the tile. The cost does not depend on the kernel size, so it is the fast path
+     * for the large kernels as the 31x31x31 ones of the template matching.
+     * \code
+     * Mat2UI8 img;
+     * img.load(POP_PROJECT_SOURCE_DIR+std::string("/image/Lena.bmp"));
+     * Mat2F32 kernel = FunctorMatN::createGaussianKernelMultiDimension<2>(10,30);
+     * Mat2F32 smooth = Representation::convolutionByFFT(img,kernel,MatNBoundaryConditionMirror());
+     * \endcode
+    */
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,F32> convolutionByFFT(const MatN<DIM,PixelType1> & f, const MatN<DIM,PixelType2> & kernel,BoundaryCondition,int size_block_max=1<<21)
+    {
+        MatN<DIM,F32> h(f.getDomain());
+        if(h.getDomain().multCoordinate()==0||kernel.getDomain().multCoordinate()==0)
+            return h;
+        Private::FFTConvolutionTiling<DIM> tiling(f.getDomain(),kernel.getDomain(),size_block_max);
+        const VecN<DIM,I32> block = tiling.block();
+        const VecN<DIM,I32> tile = tiling.tile();
+        const F32 scale_value = 1.f/block.multCoordinate();
+        //the block of the tile at x0 starts at x0-shift, so the circular convolution at y>=kernel-1 is the convolution at x0+y-(kernel-1)
+        const VecN<DIM,I32> shift = kernel.getDomain()-1-(kernel.getDomain()-1)/2;
+
+        MatN<DIM,F32> kernel_block(block);
+        typename MatN<DIM,PixelType2>::IteratorEDomain itk(kernel.getIteratorEDomain());
+        while(itk.next())
+            kernel_block(itk.x())=static_cast<F32>(kernel(itk.x()));
+        MatN<DIM,ComplexF32> kernel_fft = FFTRealToComplex(kernel_block);
+        for(unsigned int i=0;i<kernel_fft.size();i++)
+            kernel_fft(i)=kernel_fft(i)*scale_value;
+
+        MatN<DIM,F32> f_block(block);
+        typename MatN<DIM,F32>::IteratorEDomain itb(f_block.getIteratorEDomain());
+        MatNIteratorEDomain<VecN<DIM,I32> > ittile(tiling.nbrTile());
+        while(ittile.next()){
+            VecN<DIM,I32> x0 = ittile.x()*tile;
+            itb.init();
+            while(itb.next()){
+                VecN<DIM,I32> x = x0+itb.x()-shift;
+                if(BoundaryCondition::isValid(f.getDomain(),x)){
+                    BoundaryCondition::apply(f.getDomain(),x);
+                    f_block(itb.x())=static_cast<F32>(f(x));
+                }else{
+                    f_block(itb.x())=0;
+                }
+            }
+            MatN<DIM,ComplexF32> fft = FFTRealToComplex(f_block);
+            for(unsigned int i=0;i<fft.size();i++){
+                const ComplexF32 a = fft(i);
+                const ComplexF32 & b = kernel_fft(i);
+                fft(i)=ComplexF32(a.real()*b.real()-a.img()*b.img(),a.real()*b.img()+a.img()*b.real());
+            }
+            MatN<DIM,F32> conv = FFTComplexToReal(fft);
+            VecN<DIM,I32> size_tile;
+            for(int i=0;i<DIM;i++)
+                size_tile(i)=minimum(tile(i),f.getDomain()(i)-x0(i));
+            MatNIteratorEDomain<VecN<DIM,I32> > itout(size_tile);
+            while(itout.next())
+                h(x0+itout.x())=conv(itout.x()+kernel.getDomain()-1);
+        }
+        return h;
     }
     //@}
 
@@ -60,6 +60,76 @@ namespace pop
 //* \defgroup Distribution  Distribution
 //* \brief mapping from the real number to the real number
 //*/
+/*!
+    \class pop::RandomEngine
+    \brief small and fast pseudo-random generator (xoshiro128**, period 2^128-1)
+    \author Tariel Vincent
+  *
+  * Unlike the Mersenne twister of Distribution::irand(), whose state is shared by the whole program, the state of this engine is 16 bytes
+  * owned by the object, so each thread can sample with its own engine without lock. The pair (seed,stream) defines the sequence: the streams of
+  * a seed are independent sequences, so a parallel loop can attach a stream to each work item (row, slice, block) and get the same result for any
+  * number of threads.
+  * \code
+  * DistributionNormal d(0,1);
+  * std::vector<F32> v(1000);
+  * RandomEngine engine(1234,0);//seed 1234, first stream
+  * d.randomVariables(static_cast<int>(v.size()),&v[0],engine);
+  * \endcode
+  * \sa Distribution::engine()
+*/
+class POP_EXPORTS RandomEngine
+{
+public:
+    /*!
+     * engine of the seed 0, first stream
+     */
+    RandomEngine();
+    /*!
+     * \param seed seed
+     * \param stream index of the sequence for this seed
+     */
+    RandomEngine(UI64 seed,UI64 stream=0);
+    /*!
+     * \param seed seed
+     * \param stream index of the sequence for this seed
+     *
+     * restart the engine at the beginning of the sequence (seed,stream)
+     */
+    void seed(UI64 seed,UI64 stream=0);
+    /*!
+     * \return 32 random bits
+     */
+    inline UI32 operator()(){
+        const UI32 result = _rotl(_s[1]*5,7)*9;
+        const UI32 t = _s[1]<<9;
+        _s[2]^=_s[0];
+        _s[3]^=_s[1];
+        _s[1]^=_s[2];
+        _s[0]^=_s[3];
+        _s[2]^=t;
+        _s[3]=_rotl(_s[3],11);
+        return result;
+    }
+    /*!
+     * \return random integer in [0,n) (generator of std::random_shuffle)
+     */
+    inline UI32 operator()(UI32 n){
+        return static_cast<UI32>((static_cast<UI64>(this->operator()())*n)>>32);
+    }
+    /*!
+     * \return random real in [0,1)
+     */
+    inline F32 randomReal(){
+        return static_cast<F32>(this->operator()()>>8)*(1.f/16777216.f);
+    }
+    static UI32 maxValue();
+private:
+    static inline UI32 _rotl(UI32 x,int k){
+        return (x<<k)|(x>>(32-k));
+    }
+    UI32 _s[4];
+};
+
 class POP_EXPORTS Distribution
 {
     /*!
@@ -107,7 +177,37 @@ private:
     static unsigned long _length;
     static MTRand_int32 _irand;
 public:
+    /*!
+    * \return the Mersenne twister shared by the whole program
+    *
+    * The state is shared by all threads, so do not call it concurrently. To sample in parallel, use engine() or a RandomEngine by work item.
+    * The distributions do not draw from it, but its seed functions reseed the engines of the distributions as setSeed does, so
+    * Distribution::irand().seed(s) still makes the random variables reproducible.
+    */
     static MTRand_int32 &irand();
+    /*!
+    * \return the random engine of the calling thread
+    *
+    * All the random variables of the distributions are drawn from this engine. Each thread has its own engine, so the distributions can be
+    * sampled concurrently. It is seeded with the global seed (see setSeed) and the stream 0, or the OpenMP thread number with OpenMP. Inside
+    * a chunk of forEachRangeParallel, it is the engine of the chunk (see RandomEngineChunk). Inside randomVariables(n,out,engine), it is the
+    * engine given in argument.
+    */
+    static RandomEngine & engine();
+    /*!
+    * \param seed global seed
+    *
+    * restart the engines of all threads with this seed (the default seed depends on the time). Call it outside the parallel regions.
+    */
+    static void setSeed(UI64 seed);
+    /*!
+    * \return the seed of the next parallel loop of the calling thread
+    *
+    * Hash of the seed of the calling thread (the global seed, or the seed of the chunk inside a chunk of forEachRangeParallel) and of the
+    * number of calls since this seed. The engine of the calling thread is not advanced, so the random variables drawn after a parallel loop
+    * do not depend on the number of threads. forEachRangeParallel calls it once by loop.
+    */
+    static UI64 parallelSeed();
 
     /*!
     \fn virtual ~Distribution();
@@ -158,12 +258,81 @@ public:
     */
     virtual F32 randomVariable()const=0;
     /*!
+    * \param n number of random variables
+    * \param out output buffer of size n
+    *
+    *  Generate n random variables following the probability distribution in the buffer, with the engine of the calling thread.
+    */
+    void randomVariables(int n,F32 * out)const;
+    /*!
+    * \param n number of random variables
+    * \param out output buffer of size n
+    * \param engine random engine
+    *
+    *  Generate n random variables following the probability distribution in the buffer, with the given engine. With an engine by work item,
+    *  a parallel sampling is reproducible:
+    \code
+    struct FunctorNoise{
+        const Distribution * _d;
+        Mat2F32 * _m;
+        UI64 _seed;
+        void operator()(int begin,int end){
+            for(int i=begin;i<end;i++){
+                RandomEngine engine(_seed,i);//one stream by row
+                _d->randomVariables(_m->sizeJ(),_m->data()+i*_m->sizeJ(),engine);
+            }
+        }
+    };
+    \endcode
+    */
+    void randomVariables(int n,F32 * out,RandomEngine & engine)const;
+    /*!
     * \return  VecNer distribution
     *
     *  clone pattern
     */
     virtual Distribution * clone()const=0 ;
     void display(F32 xmin=0,F32 xmax=255)const;
+protected:
+    /*!
+    *  batch generation, the default implementation calls randomVariable() with the engine as engine of the calling thread
+    */
+    virtual void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
+    /*!
+    * \return the previous engine of the calling thread
+    *
+    * set the engine of the calling thread (NULL: the own engine of the thread)
+    */
+    static RandomEngine * _setEngine(RandomEngine * engine);
+    friend class RandomEngineChunk;
+};
+/*!
+    \class pop::RandomEngineChunk
+    \brief engine of the calling thread for a chunk of a parallel loop
+    \author Tariel Vincent
+  *
+  * During its lifetime, Distribution::engine() of the calling thread is the stream chunk of the seed, and Distribution::parallelSeed() restarts
+  * from this pair, so a nested loop is reproducible too. The previous engine is restored by the destructor. forEachRangeParallel creates one
+  * by chunk with the seed given by Distribution::parallelSeed(), so a parallel sampling depends on the seed and on the number of chunks, not on
+  * the scheduling of the threads.
+*/
+class POP_EXPORTS RandomEngineChunk
+{
+public:
+    /*!
+     * \param seed seed of the parallel loop
+     * \param chunk index of the chunk
+     */
+    RandomEngineChunk(UI64 seed,UI64 chunk);
+    ~RandomEngineChunk();
+private:
+    RandomEngineChunk(const RandomEngineChunk &);
+    RandomEngineChunk & operator=(const RandomEngineChunk &);
+    RandomEngine _engine;
+    RandomEngine * _engine_previous;
+    UI64 _seed_previous;
+    UI64 _counter_previous;
+    bool _chunk_previous;
 };
 
 
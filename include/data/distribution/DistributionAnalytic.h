@@ -90,6 +90,8 @@ public:
     virtual DistributionSign * clone()const ;
     F32 operator()(F32 value)const ;
     F32 randomVariable()const ;
+protected:
+    void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
 
 };
 
@@ -134,6 +136,8 @@ public:
     virtual DistributionUniformReal * clone()const ;
     F32 operator()(F32 value)const ;
     virtual F32 randomVariable()const ;
+protected:
+    void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
 };
 class POP_EXPORTS DistributionUniformInt:public Distribution, public DistributionDiscrete
 {
@@ -165,6 +169,8 @@ public:
     F32 randomVariable()const ;
     DistributionUniformInt * clone()const ;
     F32 operator()(F32 value)const ;
+protected:
+    void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
 
 
 };
@@ -200,6 +206,8 @@ public:
     F32 randomVariable()const ;
     DistributionNormal * clone()const ;
     F32 operator()(F32 value)const ;
+protected:
+    void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
 
 };
 class POP_EXPORTS DistributionBinomial:public Distribution, public DistributionDiscrete
@@ -263,6 +271,8 @@ public:
     F32 randomVariable()const ;
     DistributionExponential * clone()const ;
     F32 operator()(F32 value)const  ;
+protected:
+    void _randomVariables(int n,F32 * out,RandomEngine & engine)const;
 };
 
 
@@ -39,6 +39,12 @@ in the Software.
 #include"data/vec/VecN.h"
 #include"data/mat/MatN.h"
 #include"algorithm/Convertor.h"
+#include"algorithm/ForEachFunctor.h"
+#if defined(__AVX__)
+#include<immintrin.h>
+#elif defined(__SSE__)
+#include<xmmintrin.h>
+#endif
 namespace pop
 {
 /// @cond DEV
@@ -88,63 +94,164 @@ struct POP_EXPORTS FunctorMatN
         }
         return h;
     }
-    template<typename PixelType1,typename PixelType2,typename BoundaryCondition>
-    static MatN<2,PixelType1> convolutionSeperable(const MatN<2,PixelType1> & f, const Vec<PixelType2> & kernel,int direction,MatNIteratorEDomain<Vec2I32> ,BoundaryCondition)
+    /*!
+     * \brief separable convolution on the whole domain
+     *
+     * For the scalar pixel types (as UI8, UI16 or F32), each line of the direction is convolved with a F32 accumulator line:
+     * the boundary condition is applied once to build the padded line (or the table of the source hyperplanes when the direction
+     * is not contiguous in memory), then each kernel coefficient adds a shifted contiguous line (SSE/AVX if enabled at the compilation).
+     * The taps are added in the same order as the generic algorithm so the result is identical. The lines are shared between the threads.
+    */
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,PixelType1> convolutionSeperable(const MatN<DIM,PixelType1> & f, const Vec<PixelType2> & kernel,int direction,MatNIteratorEDomain<VecN<DIM,I32> > itglobal,BoundaryCondition condition)
     {
-
-        MatN<2,PixelType1> h(f.getDomain());
-        typedef typename FunctionTypeTraitsSubstituteF<PixelType1,F32>::Result Type_F32;
-        typedef typename FunctionTypeTraitsSubstituteF<PixelType2,F32>::Result Type2_F32;
-
-        int radius = static_cast<int>((kernel.size()-1)/2);
-        Vec2I32 x;
-        for(x(0)=0;x(0)<static_cast<int>(f.sizeI());x(0)++){
-            for(x(1)=0;x(1)<static_cast<int>(f.sizeJ());x(1)++){
-                int dir = x(direction);
-                Type_F32 value=0;
-                int temp = x(direction);
-                for(unsigned k=0;k<kernel.size();k++){
-                    x(direction)= dir+(radius-k);
-                    if(BoundaryCondition::isValid(f.getDomain(),x,direction)){
-                        BoundaryCondition::apply(f.getDomain(),x,direction);
-                        value+=Type_F32(f(x))*Type2_F32(kernel(k));
-                    }
-                }
-                x(direction)=temp;
-                h(x)=ArithmeticsSaturation<PixelType1,Type_F32>::Range (value);
+        return _convolutionSeperable(f,kernel,direction,itglobal,condition,Int2Type<std::numeric_limits<PixelType1>::is_specialized&&std::numeric_limits<PixelType2>::is_specialized>());
+    }
+    //    \cond HIDDEN_SYMBOLS
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,PixelType1> _convolutionSeperable(const MatN<DIM,PixelType1> & f, const Vec<PixelType2> & kernel,int direction,MatNIteratorEDomain<VecN<DIM,I32> > itglobal,BoundaryCondition condition,Int2Type<false>)
+    {
+        return convolutionSeperable<DIM,PixelType1,PixelType2,MatNIteratorEDomain<VecN<DIM,I32> >,BoundaryCondition>(f,kernel,direction,itglobal,condition);
+    }
+    template<int DIM,typename PixelType1,typename PixelType2,typename BoundaryCondition>
+    static MatN<DIM,PixelType1> _convolutionSeperable(const MatN<DIM,PixelType1> & f, const Vec<PixelType2> & kernel,int direction,MatNIteratorEDomain<VecN<DIM,I32> > ,BoundaryCondition,Int2Type<true>)
+    {
+        MatN<DIM,PixelType1> h(f.getDomain());
+        if(h.getDomain().multCoordinate()==0||kernel.size()==0)
+            return h;
+        MatN<DIM,F32> fF32;
+        const F32 * data = _dataF32(f,fF32,h.stride());
+        const int size = f.getDomain()(direction);
+        Vec<F32> kernelF32(kernel.size());
+        for(unsigned int k=0;k<kernel.size();k++)
+            kernelF32(k)=static_cast<F32>(kernel(k));
+        //value(x) = sum_k f(x+ (radius-k) e_direction) kernel(k), with the shift radius-k in [radius+1-kernel.size(),radius]
+        const int radius = static_cast<int>((kernel.size()-1)/2);
+        const int shift_min = radius+1-static_cast<int>(kernel.size());
+        std::vector<int> v_map(size+radius-shift_min);
+        VecN<DIM,I32> x(0);
+        for(int i=0;i<static_cast<int>(v_map.size());i++){
+            x(direction)=i+shift_min;
+            v_map[i]=-1;
+            if(BoundaryCondition::isValid(f.getDomain(),x,direction)){
+                BoundaryCondition::apply(f.getDomain(),x,direction);
+                if(x(direction)>=0&&x(direction)<size)
+                    v_map[i]=x(direction);
             }
         }
+        __FunctorConvolutionSeperable<DIM,PixelType1> func;
+        func._data = data;
+        func._h = &h;
+        func._kernel = &kernelF32;
+        func._radius = radius;
+        func._shift_min = shift_min;
+        func._map = &v_map;
+        func._size = size;
+        func._stride = h.stride()(direction);
+        func._nbr_block = h.getDomain().multCoordinate()/(size*func._stride);
+        int nbr_range = (func._nbr_block>1||func._stride==1) ? func._nbr_block : func._stride;
+        if(h.getDomain().multCoordinate()<PARALLEL_MINIMUM_SIZE)
+            func(0,nbr_range);
+        else
+            forEachRangeParallel(0,nbr_range,func);
         return h;
     }
-    template<typename PixelType1,typename PixelType2,typename BoundaryCondition>
-    static MatN<3,PixelType1> convolutionSeperable(const MatN<3,PixelType1> & f, const Vec<PixelType2> & kernel,int direction,MatNIteratorEDomain<Vec3I32> ,BoundaryCondition)
+    template<int DIM,typename PixelType>
+    static const F32 * _dataF32(const MatN<DIM,PixelType> & f,MatN<DIM,F32> & fF32,const VecN<DIM,I32> & stride){
+        fF32.resize(f.getDomain());
+        if(f.stride()==stride){
+            for(int i=0;i<f.getDomain().multCoordinate();i++)
+                fF32(i)=static_cast<F32>(f(i));
+        }else{
+            typename MatN<DIM,PixelType>::IteratorEDomain it(f.getIteratorEDomain());
+            while(it.next())
+                fF32(it.x())=static_cast<F32>(f(it.x()));
+        }
+        return fF32.data();
+    }
+    template<int DIM>
+    static const F32 * _dataF32(const MatN<DIM,F32> & f,MatN<DIM,F32> & fF32,const VecN<DIM,I32> & stride){
+        if(f.stride()==stride)
+            return f.data();
+        fF32.resize(f.getDomain());
+        typename MatN<DIM,F32>::IteratorEDomain it(f.getIteratorEDomain());
+        while(it.next())
+            fF32(it.x())=f(it.x());
+        return fF32.data();
+    }
+    //out(i)+=weight*in(i) for 0<=i<size
+    static void _addMultiplied(F32 * out,const F32 * in,F32 weight,int size){
+        int i=0;
+#if defined(__AVX__)
+        __m256 weight8 = _mm256_set1_ps(weight);
+        for(;i+8<=size;i+=8)
+            _mm256_storeu_ps(out+i,_mm256_add_ps(_mm256_loadu_ps(out+i),_mm256_mul_ps(_mm256_loadu_ps(in+i),weight8)));
+#endif
+#if defined(__SSE__)
+        __m128 weight4 = _mm_set1_ps(weight);
+        for(;i+4<=size;i+=4)
+            _mm_storeu_ps(out+i,_mm_add_ps(_mm_loadu_ps(out+i),_mm_mul_ps(_mm_loadu_ps(in+i),weight4)));
+#endif
+        for(;i<size;i++)
+            out[i]+=in[i]*weight;
+    }
+    template<int DIM,typename PixelType>
+    struct __FunctorConvolutionSeperable
     {
-
-        MatN<3,PixelType1> h(f.getDomain());
-        typedef typename FunctionTypeTraitsSubstituteF<PixelType1,F32>::Result Type_F32;
-        typedef typename FunctionTypeTraitsSubstituteF<PixelType2,F32>::Result Type2_F32;
-        int radius = static_cast<int>((kernel.size()-1)/2);
-        Vec3I32 x;
-        for(x(0)=0;x(0)<static_cast<int>(f.sizeI());x(0)++){
-            for(x(1)=0;x(1)<static_cast<int>(f.sizeJ());x(1)++){
-                for(x(2)=0;x(2)<static_cast<int>(f.sizeK());x(2)++){
-                    int dir = x(direction);
-                    Type_F32 value=0;
-                    int temp = x(direction);
-                    for(unsigned k=0;k<kernel.size();k++){
-                        x(direction)= dir+(radius-k);
-                        if(BoundaryCondition::isValid(f.getDomain(),x,direction)){
-                            BoundaryCondition::apply(f.getDomain(),x,direction);
-                            value+=Type_F32(f(x))*Type2_F32(kernel(k));
+        const F32 * _data;
+        MatN<DIM,PixelType> * _h;
+        const Vec<F32> * _kernel;
+        int _radius;
+        int _shift_min;
+        const std::vector<int> * _map;
+        //the matrix is a sequence of _nbr_block blocks of _size hyperplanes contiguous in memory, each hyperplane of _stride elements
+        int _size;
+        int _stride;
+        int _nbr_block;
+        //blocks begin<=b<end, or the elements begin<=j<end of the hyperplanes for a single block with a non-contiguous direction
+        void operator()(int begin,int end){
+            const int kernel_size = static_cast<int>(_kernel->size());
+            if(_stride==1){
+                //contiguous direction: padded line
+                std::vector<F32> v_line(_map->size());
+                std::vector<F32> v_value(_size);
+                for(int b=begin;b<end;b++){
+                    const F32 * in = _data+static_cast<std::size_t>(b)*_size;
+                    for(unsigned int i=0;i<v_line.size();i++)
+                        v_line[i] = ((*_map)[i]>=0) ? in[(*_map)[i]] : 0;
+                    std::fill(v_value.begin(),v_value.end(),0.f);
+                    for(int k=0;k<kernel_size;k++)
+                        _addMultiplied(&v_value[0],&v_line[_radius-k-_shift_min],(*_kernel)(k),_size);
+                    PixelType * out = _h->data()+static_cast<std::size_t>(b)*_size;
+                    for(int i=0;i<_size;i++)
+                        out[i]=ArithmeticsSaturation<PixelType,F32>::Range(v_value[i]);
+                }
+            }else{
+                //non-contiguous direction: each hyperplane of the output is a weighted sum of the source hyperplanes
+                int b_begin=begin,b_end=end,j_begin=0,j_end=_stride;
+                if(_nbr_block<=1){
+                    b_begin=0;b_end=1;j_begin=begin;j_end=end;
+                }
+                std::vector<F32> v_value(j_end-j_begin);
+                for(int b=b_begin;b<b_end;b++){
+                    const F32 * in = _data+static_cast<std::size_t>(b)*_size*_stride+j_begin;
+                    PixelType * out = _h->data()+static_cast<std::size_t>(b)*_size*_stride+j_begin;
+                    for(int i=0;i<_size;i++){
+                        std::fill(v_value.begin(),v_value.end(),0.f);
+                        for(int k=0;k<kernel_size;k++){
+                            int i_source = (*_map)[i+_radius-k-_shift_min];
+                            if(i_source>=0)
+                                _addMultiplied(&v_value[0],in+static_cast<std::size_t>(i_source)*_stride,(*_kernel)(k),j_end-j_begin);
                         }
+                        PixelType * out_i = out+static_cast<std::size_t>(i)*_stride;
+                        for(int j=0;j<j_end-j_begin;j++)
+                            out_i[j]=ArithmeticsSaturation<PixelType,F32>::Range(v_value[j]);
                     }
-                     x(direction)=temp;
-                    h(x)=ArithmeticsSaturation<PixelType1,Type_F32>::Range (value);
                 }
             }
         }
-        return h;
-    }
+    };
+    //\endcond
     template<int DIM,typename PixelType1,typename PixelType2,typename IteratorE,typename BoundaryCondition>
     static MatN<DIM,PixelType1> convolution(const MatN<DIM,PixelType1> & f, const MatN<DIM,PixelType2> & kernel,IteratorE itglobal,BoundaryCondition)
     {
@@ -0,0 +1,105 @@
+/******************************************************************************\
+|*                   Population library for C++ X.X.X                         *|
+|*----------------------------------------------------------------------------*|
+The Population License is similar to the MIT license in adding this clause:
+for any writing public or private that has resulted from the use of the
+software population, the reference of this book "Population library, 2012,
+Vincent Tariel" shall be included in it.
+
+So, the terms of the Population License are:
+
+Copyright © 2012-2015, Tariel Vincent
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software and for any writing
+public or private that has resulted from the use of the software population,
+the reference of this book "Population library, 2012, Vincent Tariel" shall
+be included in it.
+
+The Software is provided "as is", without warranty of any kind, express or
+implied, including but not limited to the warranties of merchantability,
+fitness for a particular purpose and noninfringement. In no event shall the
+authors or copyright holders be liable for any claim, damages or other
+liability, whether in an action of contract, tort or otherwise, arising
+from, out of or in connection with the software or the use or other dealings
+in the Software.
+\***************************************************************************/
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include"PopulationConfig.h"
+#include"data/typeF/TypeTraitsF.h"
+
+namespace pop
+{
+/*!
+    \class pop::GEMM
+    \brief built-in general matrix-matrix and matrix-vector products (no external BLAS)
+    \author Tariel Vincent
+    \ingroup Matrix
+  *
+  * The matrices are row-major, as MatN, so the leading dimension is the distance between two rows (and not two columns as in the Fortran BLAS).
+  * The product follows the Goto scheme: op(B) is packed in panels of NR columns staying in L1, op(A) in slivers of MR rows staying in L2, and a
+  * register-blocked MR*NR micro-kernel accumulates the rank-KC updates. The micro-kernel is AVX with FMA if the processor has it (detected at
+  * run time with GCC and Clang on x86), otherwise SSE or scalar. op(B) is packed once (k*n elements), then the row blocks are distributed on
+  * the threads in a single parallel loop. No message is written on the standard output.
+  * \code
+  * Mat2F32 A(500,300),B(300,400),C(500,400);
+  * //C = A*B
+  * GEMM::sgemm('N','N',500,400,300,1,A.data(),300,B.data(),400,0,C.data(),400);
+  * \endcode
+*/
+class POP_EXPORTS GEMM
+{
+public:
+    /*!
+    * \param transA 'N' for op(A)=A, 'T' for op(A)=A^t
+    * \param transB 'N' for op(B)=B, 'T' for op(B)=B^t
+    * \param m number of rows of op(A) and C
+    * \param n number of columns of op(B) and C
+    * \param k number of columns of op(A) and rows of op(B)
+    * \param alpha scalar
+    * \param A matrix data
+    * \param lda leading dimension of A
+    * \param B matrix data
+    * \param ldb leading dimension of B
+    * \param beta scalar (for beta=0, C is not read)
+    * \param C output matrix data
+    * \param ldc leading dimension of C
+    *
+    * C = alpha*op(A)*op(B) + beta*C
+    */
+    static void sgemm(char transA,char transB,int m,int n,int k,F32 alpha,const F32 * A,int lda,const F32 * B,int ldb,F32 beta,F32 * C,int ldc);
+    /*!
+    * double precision version of sgemm
+    */
+    static void dgemm(char transA,char transB,int m,int n,int k,F64 alpha,const F64 * A,int lda,const F64 * B,int ldb,F64 beta,F64 * C,int ldc);
+    /*!
+    * \param transA 'N' for op(A)=A, 'T' for op(A)=A^t
+    * \param m number of rows of A
+    * \param n number of columns of A
+    * \param alpha scalar
+    * \param A matrix data
+    * \param lda leading dimension of A
+    * \param x input vector (n elements for 'N', m for 'T')
+    * \param beta scalar (for beta=0, y is not read)
+    * \param y output vector (m elements for 'N', n for 'T')
+    *
+    * y = alpha*op(A)*x + beta*y
+    */
+    static void sgemv(char transA,int m,int n,F32 alpha,const F32 * A,int lda,const F32 * x,F32 beta,F32 * y);
+    /*!
+    * double precision version of sgemv
+    */
+    static void dgemv(char transA,int m,int n,F64 alpha,const F64 * A,int lda,const F64 * x,F64 beta,F64 * y);
+};
+}
+#endif // GEMM_H
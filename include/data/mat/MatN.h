@@ -51,6 +51,8 @@ in the Software.
 #include"data/functor/FunctorF.h"
 #include"algorithm/ForEachFunctor.h"
 #include"data/utility/BasicUtility.h"
+#include"data/utility/MemoryMappedFile.h"
+#include"data/mat/GEMM.h"
 
 namespace pop
 {
@@ -271,6 +273,7 @@ public:
 protected:
     PixelType * _data;
     bool _is_owner_data;
+    MemoryMappedFile * _mapped;
     VecN<Dim,int> _domain;
     VecN<Dim,int> _stride;
 public:
@@ -898,6 +901,7 @@ public:
     *
     * The loadFromDirectory attempts to load all files as 2d slices of the  3D matrix in the  directory pathdir. If the extension is set,
     * we filter all filter all files with the extension. It is the same for basename.\n
+    * The slices are decoded in parallel (see setNumberThreadParallel) directly in their z-plane, each thread holding a single decoded slice.\n
     * For instance, this code produces:
     \code
     Mat3UI8 img;
@@ -913,7 +917,8 @@ public:
     * \return true in case of success
     *
     * The loader attempts to read the matrix using the specified format. Natively, this library support the pgm, png, jpg, bmp formats. However thanks to the CImg library, this library can
-    read various matrix formats http://cimg.sourceforge.net/reference/group__cimg__files__io.html if you install Image Magick http://www.imagemagick.org/script/binary-releases.php.
+    read various matrix formats http://cimg.sourceforge.net/reference/group__cimg__files__io.html if you install Image Magick http://www.imagemagick.org/script/binary-releases.php.\n
+    The native pop format (extension .pop) stores any dimension and pixel type with a compressed payload (see save).
     */
     bool load(const char * file);
     /*!
@@ -940,6 +945,35 @@ public:
     */
     bool loadRaw(const char * file,const Domain & d);
     /*!
+    * \param file input raw file
+    * \param d  domain of definition of the image
+    * \param read_only true for a read-only mapping, false to write the modifications in the file
+    * \param offset position in bytes of the first voxel in the file (to skip a header or to open a slab of a larger volume)
+    * \return true in case of success
+    *
+    * The data of the matrix is the file mapped in memory (see MemoryMappedFile) without copy: the voxels are read by the operating
+    * system on the first access, so the opening is immediate and the volume can be larger than the RAM. The mapped matrix is used as
+    * any matrix by the algorithms. The copy of a mapped matrix is an usual matrix in memory. The assignment of a matrix of the same domain to
+    * a writable mapped matrix writes in the file, the other resizing releases the mapping. A read-only mapped matrix must not be modified.\n
+    * The number of voxels is limited to the index range of MatN (\f$2^{31}-1\f$), a larger volume is opened by slabs with the offset.
+    * \code
+    * Mat3UI8 menisque;
+    * Vec3I32 d(1300,1500,401);
+    * menisque.openMapped("/home/vincent/Downloads/top_cap_1300_1500_401_1b.raw",d);
+    * Mat3UI8 threshold = Processing::threshold(menisque,125);
+    * \endcode
+    * \sa loadRaw
+    */
+    bool openMapped(const char * file,const Domain & d,bool read_only=true,std::size_t offset=0);
+    /*!
+    * \param file input binary pgm file (as saved by MatN::save for more than 20 pixels)
+    * \param read_only true for a read-only mapping, false to write the modifications in the file
+    * \return true in case of success
+    *
+    * Map the pixel section of the pgm file, the domain is given by the header (see openMapped(const char * file,const Domain & d,bool read_only,std::size_t offset) ).
+    */
+    bool openMapped(const char * file,bool read_only=true);
+    /*!
     * \param pathdir directory path
     * \param basefilename filename base by default "toto"
     * \param extension by default ".pgm"
@@ -949,7 +983,8 @@ public:
     * "/home/vincent/Project/ENPC/ROCK/Seg/seg0000.bmp", \n
     * "/home/vincent/Project/ENPC/ROCK/Seg/seg0001.bmp",\n
     * "/home/vincent/Project/ENPC/ROCK/Seg/seg0002.bmp"\n
-    *  "and so one.
+    *  "and so one.\n
+    * The slices are encoded in parallel (see setNumberThreadParallel).
     */
     void saveFromDirectory(const char * pathdir,const char * basefilename="toto",const char * extension=".pgm")const ;
 
@@ -957,7 +992,10 @@ public:
     * \param file input file
     *
     * The saver attempts to write the matrix using the specified format.  Natively, this library support the pgm, png, jpg, bmp format. However thanks to the CImg library, this library can
-    save various matrix formats http://cimg.sourceforge.net/reference/group__cimg__files__io.html .
+    save various matrix formats http://cimg.sourceforge.net/reference/group__cimg__files__io.html .\n
+    With the extension .pop, the matrix is saved in the native format: a typed header (dimension, pixel type, domain, spacing) followed by blocks of 1 MB
+    compressed in parallel with the codec of the class Compression, after a byte-plane filter (with delta for the integer types). Label
+    images compress by a factor 20-100 at a speed close to the one of the raw format.
     */
     void save(const char * file)const ;
 
@@ -1511,43 +1549,43 @@ public:
 
 #ifdef HAVE_SWIG
     MatN(const MatN<Dim,UI8> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,UI8>::Range);
     }
     MatN(const MatN<Dim,UI16> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,UI16>::Range);
     }
     MatN(const MatN<Dim,UI32> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,UI32>::Range);
     }
     MatN(const MatN<Dim,F32> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,F32>::Range);
     }
     MatN(const MatN<Dim,RGBUI8> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,RGBUI8>::Range);
     }
     MatN(const MatN<Dim,RGBF32> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,RGBF32>::Range);
     }
     MatN(const MatN<Dim,ComplexF32> &img)
-        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+        :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
     {
         _initStride();
         std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,ComplexF32>::Range);
@@ -1583,6 +1621,10 @@ public:
     bool isOwnerData()const{
         return _is_owner_data;
     }
+    //! \return true if the data is mapped from a file (see openMapped)
+    bool isMapped()const{
+        return _mapped!=NULL;
+    }
     MatN selectColumn(int index_column){
         MatN m(VecN<Dim,int>(_domain(0),1),this->data()+_stride[1]*index_column);
         m._stride(0)=this->_stride(0);
@@ -1604,7 +1646,21 @@ public:
     }
 
 private:
+    void _deallocate(){
+        if(_mapped!=NULL){
+            delete _mapped;
+            _mapped = NULL;
+            _data = NULL;
+        }else if(_is_owner_data==true&&_data!=NULL){
+            delete[] _data;
+            _data = NULL;
+        }
+    }
     void _initStride(){
+        if(DIM==1){
+            _stride[0]=1;
+            return;
+        }
         _stride[1]=1;
         _stride[0]=_domain[1];
         for(unsigned int i=2;i<DIM;i++){
@@ -1641,7 +1697,7 @@ typedef MatN<3,VecN<3,F32> >  Mat3Vec3F32;
 
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN()
-    :_data(NULL),_is_owner_data(true)
+    :_data(NULL),_is_owner_data(true),_mapped(NULL)
 {
     _domain=0;
     _initStride();
@@ -1649,12 +1705,11 @@ MatN<Dim,PixelType>::MatN()
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::~MatN()
 {
-    if(_is_owner_data==true&& _data!=NULL)
-        delete[] _data;
+    _deallocate();
 }
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(const VecN<Dim,int>& domain,PixelType v)
-    :_data(new PixelType[domain.multCoordinate()]),_is_owner_data(true),_domain(domain)
+    :_data(new PixelType[domain.multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(domain)
 {
     std::fill(this->begin(), this->end(), v);
     _initStride();
@@ -1663,7 +1718,7 @@ MatN<Dim,PixelType>::MatN(const VecN<Dim,int>& domain,PixelType v)
 
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(unsigned int sizei,unsigned int sizej)
-    :_data(new PixelType[sizei*sizej]),_is_owner_data(true),_domain(sizei,sizej)
+    :_data(new PixelType[sizei*sizej]),_is_owner_data(true),_mapped(NULL),_domain(sizei,sizej)
 {
     std::fill(this->begin(), this->end(), PixelType(0));
     _initStride();
@@ -1672,7 +1727,7 @@ MatN<Dim,PixelType>::MatN(unsigned int sizei,unsigned int sizej)
 }
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(unsigned int sizei, unsigned int sizej,unsigned int sizek)
-    :_data(new PixelType[sizei*sizej*sizek]),_is_owner_data(true),_domain(sizei,sizej,sizek)
+    :_data(new PixelType[sizei*sizej*sizek]),_is_owner_data(true),_mapped(NULL),_domain(sizei,sizej,sizek)
 {
     std::fill(this->begin(), this->end(), PixelType(0));
     _initStride();
@@ -1680,7 +1735,7 @@ MatN<Dim,PixelType>::MatN(unsigned int sizei, unsigned int sizej,unsigned int si
 }
 //template<int Dim, typename PixelType>
 //MatN<Dim,PixelType>::MatN(const VecN<Dim,int> & x,const Vec<PixelType>& data_values )
-//    :_data(new PixelType[x.multCoordinate()]),_is_owner_data(true),_domain(x)
+//    :_data(new PixelType[x.multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(x)
 //{
 //    _initStride();
 //    POP_DbgAssertMessage((int)data_values.size()==_domain.multCoordinate(),"In MatN::MatN(const VecN<Dim,int> & x,const Vec<PixelType>& data ), the size of input Vec data must be equal to the number of pixel/voxel");
@@ -1688,7 +1743,7 @@ MatN<Dim,PixelType>::MatN(unsigned int sizei, unsigned int sizej,unsigned int si
 
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(const VecN<Dim,int> & domain, PixelType* v_value )
-    :_data(v_value),_is_owner_data(false),_domain(domain)
+    :_data(v_value),_is_owner_data(false),_mapped(NULL),_domain(domain)
 {
     _initStride();
 }
@@ -1696,7 +1751,7 @@ MatN<Dim,PixelType>::MatN(const VecN<Dim,int> & domain, PixelType* v_value )
 template<int Dim, typename PixelType>
 template<typename T1>
 MatN<Dim,PixelType>::MatN(const MatN<Dim, T1> & img )
-    :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_domain(img.getDomain())
+    :_data(new PixelType[img.getDomain().multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(img.getDomain())
 {
     _initStride();
     std::transform(img.begin(),img.end(),this->begin(),ArithmeticsSaturation<PixelType,T1>::Range);
@@ -1706,6 +1761,7 @@ MatN<Dim,PixelType>::MatN(const MatN<Dim, T1> & img )
 #ifndef HAVE_SWIG
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(const MatN<Dim,PixelType> & img )
+    :_mapped(NULL)
 {
     if(img._is_owner_data==false){
         this->_is_owner_data = img._is_owner_data;
@@ -1725,7 +1781,7 @@ MatN<Dim,PixelType>::MatN(const MatN<Dim,PixelType> & img )
 
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(const char * filepath )
-    :_data( NULL),_is_owner_data(true),_domain(0)
+    :_data( NULL),_is_owner_data(true),_mapped(NULL),_domain(0)
 {
     if(filepath!=0)
         load(filepath);
@@ -1733,7 +1789,7 @@ MatN<Dim,PixelType>::MatN(const char * filepath )
 }
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>::MatN(const MatN<Dim,PixelType> & img, const VecN<Dim,int>& xmin, const VecN<Dim,int> & xmax  )
-    :_data( new PixelType[(xmax-xmin).multCoordinate()]),_is_owner_data(true),_domain(xmax-xmin)
+    :_data( new PixelType[(xmax-xmin).multCoordinate()]),_is_owner_data(true),_mapped(NULL),_domain(xmax-xmin)
 {
     POP_DbgAssertMessage(xmin.allSuperiorEqual(0),"xmin must be superior or equal to 0");
     POP_DbgAssertMessage(xmax.allSuperior(xmin),"xmax must be superior to xmin");
@@ -1872,9 +1928,12 @@ void MatN<Dim,PixelType>::resize(unsigned int sizei,unsigned int sizej,unsigned
 template<int Dim, typename PixelType>
 void MatN<Dim,PixelType>::resize(const VecN<Dim,int> & d){
 
+    if(_mapped!=NULL&&_mapped->isReadOnly()==false&&d==_domain){
+        //a writable mapped matrix keeps its file for the same domain, so the assignment writes in the file
+        return;
+    }
     if(_is_owner_data==true){
-        if(_data!=NULL)
-            delete[] _data;
+        _deallocate();
         _domain=d;
         _initStride();
         _data = new PixelType[_domain.multCoordinate()];
@@ -1883,6 +1942,27 @@ void MatN<Dim,PixelType>::resize(const VecN<Dim,int> & d){
     }
 }
 template<int Dim, typename PixelType>
+bool MatN<Dim,PixelType>::openMapped(const char * file,const Domain & d,bool read_only,std::size_t offset){
+    F64 nbr_voxel=1;
+    for(int i=0;i<Dim;i++)
+        nbr_voxel*=d(i);
+    if(nbr_voxel>NumericLimits<int>::maximumRange()){
+        std::cerr<<"In MatN::openMapped, the number of voxels exceeds the index range, open the volume by slabs with the offset"<<std::endl;
+        return false;
+    }
+    MemoryMappedFile * map = MemoryMappedFile::open(file,offset,sizeof(PixelType)*static_cast<std::size_t>(d.multCoordinate()),read_only);
+    if(map==NULL)
+        return false;
+    if(_is_owner_data==true)
+        _deallocate();
+    _mapped = map;
+    _data = static_cast<PixelType *>(map->data());
+    _is_owner_data = true;
+    _domain = d;
+    _initStride();
+    return true;
+}
+template<int Dim, typename PixelType>
 void MatN<Dim,PixelType>::resizeInformation(unsigned int sizei,unsigned int sizej){
     Domain d;
     d(0)=sizei;
@@ -1903,8 +1983,7 @@ void MatN<Dim,PixelType>::resizeInformation(const VecN<Dim,int>& d){
         MatN<Dim,PixelType> temp(*this);
         _domain=d;
         _initStride();
-        if(_data!=NULL)
-            delete[] _data;
+        _deallocate();
         _data = new PixelType[_domain.multCoordinate()];
         IteratorEDomain it(this->getIteratorEDomain());
         while(it.next()){
@@ -1929,8 +2008,7 @@ template<int Dim, typename PixelType>
 void MatN<Dim,PixelType>::clear(){
     _domain=0;
     if(_is_owner_data==true){
-        if(_data!=NULL)
-            delete[] _data;
+        _deallocate();
         _data = NULL;
     }
 }
@@ -2098,8 +2176,7 @@ MatN<Dim,PixelType> & MatN<Dim,PixelType>::operator =(const MatN<Dim, T1> & img
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType> & MatN<Dim,PixelType>::operator =(const MatN<Dim,PixelType> & img ){
     if(img.isOwnerData()==false){
-        if(this->_is_owner_data ==true&&_data!=NULL)
-            delete[] _data;
+        _deallocate();
         this->_is_owner_data = img.isOwnerData();
         this->_data  = const_cast<PixelType*>(img.data());
         this->_domain  = img.getDomain();
@@ -2213,12 +2290,55 @@ MatN<Dim, PixelType>  MatN<Dim,PixelType>::operator-(PixelType value)const{
     return h;
 }
 
+namespace Private {
+//the products of F32 and F64 matrices large enough to amortize the packing go through GEMM, the others (and the small ones, as the 3*3 homogeneous matrices) through the loop
+template<typename PixelType>
+struct MatrixProduct
+{
+    static bool gemm(int ,int ,int ,const PixelType * ,const PixelType * ,PixelType * ){return false;}
+    static bool gemv(int ,int ,const PixelType * ,const PixelType * ,PixelType * ){return false;}
+};
+template<>
+struct MatrixProduct<F32>
+{
+    static bool gemm(int m,int n,int k,const F32 * a,const F32 * b,F32 * c){
+        if(static_cast<F64>(m)*n*k<32.*32*32)
+            return false;
+        GEMM::sgemm('N','N',m,n,k,1,a,k,b,n,0,c,n);
+        return true;
+    }
+    static bool gemv(int m,int n,const F32 * a,const F32 * x,F32 * y){
+        if(static_cast<F64>(m)*n<64.*64)
+            return false;
+        GEMM::sgemv('N',m,n,1,a,n,x,0,y);
+        return true;
+    }
+};
+template<>
+struct MatrixProduct<F64>
+{
+    static bool gemm(int m,int n,int k,const F64 * a,const F64 * b,F64 * c){
+        if(static_cast<F64>(m)*n*k<32.*32*32)
+            return false;
+        GEMM::dgemm('N','N',m,n,k,1,a,k,b,n,0,c,n);
+        return true;
+    }
+    static bool gemv(int m,int n,const F64 * a,const F64 * x,F64 * y){
+        if(static_cast<F64>(m)*n<64.*64)
+            return false;
+        GEMM::dgemv('N',m,n,1,a,n,x,0,y);
+        return true;
+    }
+};
+}
 template<int Dim, typename PixelType>
 MatN<Dim,PixelType>  MatN<Dim,PixelType>::operator*(const MatN<Dim,PixelType> &m)const
 {
     POP_DbgAssertMessage(DIM==2&&this->sizeJ()==m.sizeI() ,"In Matrix::operator*, Not compatible size for the operator * of the class Matrix (A_{n,k}*B_{k,p})");
-    MatN<Dim,PixelType> mtrans = m.transpose();
     MatN<Dim,PixelType> mout(this->sizeI(),m.sizeJ());
+    if(Private::MatrixProduct<PixelType>::gemm(this->sizeI(),m.sizeJ(),this->sizeJ(),this->data(),m.data(),mout.data()))
+        return mout;
+    MatN<Dim,PixelType> mtrans = m.transpose();
     for( int i=0;i<static_cast<int>(this->sizeI());i++){
         for(unsigned  j=0;j<(m.sizeJ());j++){
             PixelType sum = 0;
@@ -2244,6 +2364,8 @@ template<int Dim, typename PixelType>
 Vec<PixelType>  MatN<Dim,PixelType>::operator*(const Vec<PixelType> & v)const{
     POP_DbgAssertMessage(DIM==2&&this->sizeJ()==v.size() ,"In Matrix::operator*, Not compatible size for the operator *=(Vec) of the class Matrix (A_{n,k}*v_{k})");
     Vec<PixelType> temp(this->sizeI());
+    if(this->sizeI()>0&&Private::MatrixProduct<PixelType>::gemv(this->sizeI(),this->sizeJ(),this->data(),&v[0],&temp[0]))
+        return temp;
     for(unsigned int i=0;i<this->sizeI();i++){
         PixelType sum = 0;
         typename MatN::const_iterator this_it  = this->begin() +  i*this->sizeJ();
@@ -2967,6 +3089,17 @@ void forEachFunctorBinaryFunctionE(const MatN<2,Type1> & f, MatN<2,Type2> &  h,
         }
     }
 }
+//the rectangle xmin<=x<=xmax, the last row and column included
+template<typename Type1,typename Type2,typename FunctorBinaryFunctionE>
+void forEachFunctorBinaryFunctionE(const MatN<2,Type1> & f, MatN<2,Type2> &  h,  FunctorBinaryFunctionE func, const Vec2I32 & xmin, const Vec2I32 & xmax)
+{
+    Vec2I32 x;
+    for(x(0)=xmin(0);x(0)<=xmax(0);x(0)++){
+        for(x(1)=xmin(1);x(1)<=xmax(1);x(1)++){
+            h(x)=func( f, x);
+        }
+    }
+}
 
 
 template<typename Type1,typename Type2,typename FunctorBinaryFunctionE>
@@ -206,9 +206,16 @@ private:
     MatNBoundaryConditionType _condition;
 };
 
+/*!
+ * Interpolation of a matrix at a real position. The pointwise interpolations (MatNInterpolation) implement the nearest, the bilinear, the bicubic and the lanczos ones.
+ * The area interpolation averages the pixels covered by an output pixel, so it is only defined for the resampling of GeometricalTransformation::scale.
+ */
 enum  MatNInterpolationType{
     MATN_INTERPOLATION_NEAREST = 0,
-    MATN_INTERPOLATION_BILINEAR= 1
+    MATN_INTERPOLATION_BILINEAR= 1,
+    MATN_INTERPOLATION_BICUBIC = 2,
+    MATN_INTERPOLATION_LANCZOS = 3,
+    MATN_INTERPOLATION_AREA    = 4
 };
 
 
@@ -435,11 +442,94 @@ private:
 
 };
 
+//    \cond HIDDEN_SYMBOLS
+//separable interpolation with the kernel Kernel::kernel of support [-Kernel::RADIUS,Kernel::RADIUS], the taps outside the domain are removed and the weights normalized
+struct POP_EXPORTS MatNInterpolationSeparable{
+    template<typename Kernel,typename MatN,typename FloatType>
+    static  typename MatN::F apply(const MatN & m, const VecN<MatN::DIM,FloatType> & x){
+        const int nbr_tap = 2*Kernel::RADIUS;
+        int index[MatN::DIM][2*Kernel::RADIUS];
+        F32 weight[MatN::DIM][2*Kernel::RADIUS];
+        for(int i=0;i<MatN::DIM;i++){
+            int first = static_cast<int>(std::floor(x(i)))-Kernel::RADIUS+1;
+            F32 sum=0;
+            for(int k=0;k<nbr_tap;k++){
+                index[i][k]=first+k;
+                if(first+k>=0&&first+k<m.getDomain()(i))
+                    weight[i][k]=Kernel::kernel(static_cast<F32>(first+k-x(i)));
+                else
+                    weight[i][k]=0;
+                sum+=weight[i][k];
+            }
+            if(sum!=0){
+                for(int k=0;k<nbr_tap;k++)
+                    weight[i][k]/=sum;
+            }
+        }
+        typedef typename FunctionTypeTraitsSubstituteF<typename MatN::F,F32>::Result  PixelTypeFloat;
+        PixelTypeFloat value(0);
+        VecN<MatN::DIM,I32> y;
+        int nbr_neighbor = 1;
+        for(int i=0;i<MatN::DIM;i++)
+            nbr_neighbor*=nbr_tap;
+        for(int n=0;n<nbr_neighbor;n++){
+            int r=n;
+            F32 w=1;
+            for(int i=0;i<MatN::DIM;i++){
+                y(i)=index[i][r%nbr_tap];
+                w*=weight[i][r%nbr_tap];
+                r/=nbr_tap;
+            }
+            //a null weight includes the taps outside the domain
+            if(w!=0)
+                value+=PixelTypeFloat(m(y))*w;
+        }
+        return ArithmeticsSaturation<typename MatN::F,PixelTypeFloat>::Range(value);
+    }
+};
+//\endcond
+struct POP_EXPORTS MatNInterpolationBicubic{
+    enum{RADIUS=2};
+    //Keys kernel with a=-0.5
+    static F32 kernel(F32 x){
+        const F32 a=-0.5f;
+        x = std::abs(x);
+        if(x<1)
+            return ((a+2)*x-(a+3))*x*x+1;
+        else if(x<2)
+            return ((a*x-5*a)*x+8*a)*x-4*a;
+        return 0;
+    }
+    template<typename MatN,typename FloatType>
+    static  typename MatN::F apply(const MatN & m, const VecN<MatN::DIM,FloatType> & x){
+        return MatNInterpolationSeparable::apply<MatNInterpolationBicubic>(m,x);
+    }
+};
+struct POP_EXPORTS MatNInterpolationLanczos{
+    enum{RADIUS=3};
+    static F32 kernel(F32 x){
+        x = std::abs(x);
+        if(x<1e-6f)
+            return 1;
+        else if(x>=RADIUS)
+            return 0;
+        F32 pix = PI*x;
+        return RADIUS*std::sin(pix)*std::sin(pix/RADIUS)/(pix*pix);
+    }
+    template<typename MatN,typename FloatType>
+    static  typename MatN::F apply(const MatN & m, const VecN<MatN::DIM,FloatType> & x){
+        return MatNInterpolationSeparable::apply<MatNInterpolationLanczos>(m,x);
+    }
+};
+
 struct POP_EXPORTS MatNInterpolation
 {
     MatNInterpolationType _type;
     MatNInterpolation(MatNInterpolationType type = MATN_INTERPOLATION_NEAREST)
-        :_type(type){}
+        :_type(type){
+        if(_type==MATN_INTERPOLATION_AREA)
+            std::cerr<<"In MatNInterpolation::MatNInterpolation, the area interpolation is only defined for the resampling (GeometricalTransformation::scale), the pointwise interpolation uses the nearest one"<<std::endl;
+    }
 
     template<int DIM,typename FloatType>
     static bool isValid(const VecN<DIM,I32> & domain,const VecN<DIM,FloatType> & x){
@@ -447,10 +537,15 @@ struct POP_EXPORTS MatNInterpolation
     }
     template< typename MatN,typename FloatType>
     typename MatN::F apply(const MatN & m, const VecN<MatN::DIM,FloatType> & x){
-        if(_type==MATN_INTERPOLATION_NEAREST)
-            return MatNInterpolationNearest::apply(m,x);
-        else {
+        switch(_type){
+        case MATN_INTERPOLATION_BILINEAR:
             return MatNInterpolationBiliniear::apply(m,x);
+        case MATN_INTERPOLATION_BICUBIC:
+            return MatNInterpolationBicubic::apply(m,x);
+        case MATN_INTERPOLATION_LANCZOS:
+            return MatNInterpolationLanczos::apply(m,x);
+        default:
+            return MatNInterpolationNearest::apply(m,x);
         }
     }
 };
@@ -0,0 +1,736 @@
+/******************************************************************************\
+|*                   Population library for C++ X.X.X                         *|
+|*----------------------------------------------------------------------------*|
+The Population License is similar to the MIT license in adding this clause:
+for any writing public or private that has resulted from the use of the
+software population, the reference of this book "Population library, 2012,
+Vincent Tariel" shall be included in it.
+
+So, the terms of the Population License are:
+
+Copyright © 2012-2015, Tariel Vincent
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software and for any writing
+public or private that has resulted from the use of the software population,
+the reference of this book "Population library, 2012, Vincent Tariel" shall
+be included in it.
+
+The Software is provided "as is", without warranty of any kind, express or
+implied, including but not limited to the warranties of merchantability,
+fitness for a particular purpose and noninfringement. In no event shall the
+authors or copyright holders be liable for any claim, damages or other
+liability, whether in an action of contract, tort or otherwise, arising
+from, out of or in connection with the software or the use or other dealings
+in the Software.
+\***************************************************************************/
+
+#ifndef MATNCHUNKED_H
+#define MATNCHUNKED_H
+
+#include<fstream>
+#include<vector>
+#include<cstring>
+#include<limits>
+#include<iostream>
+#include"PopulationConfig.h"
+#include"data/typeF/TypeF.h"
+#include"data/typeF/TypeTraitsF.h"
+#include"data/vec/VecN.h"
+#include"data/mat/MatN.h"
+#include"data/mat/MatNInOut.h"
+#include"data/utility/Compression.h"
+#include"3rdparty/lodepng.h"
+
+namespace pop
+{
+
+/*! \ingroup Matrix
+* \defgroup MatNChunked MatNChunked
+* \brief n-dimensional matrices stored on disk by bricks for out-of-core processing
+*/
+
+enum MatNChunkedCompression{
+    MATN_CHUNKED_RAW     = 0,
+    MATN_CHUNKED_DEFLATE = 1,
+    MATN_CHUNKED_LZ      = 2
+};
+
+//    \cond HIDDEN_SYMBOLS
+namespace Private{
+template<int DIM,typename PixelType>
+void copyBox(const MatN<DIM,PixelType> & src,const VecN<DIM,int> & src_x0,MatN<DIM,PixelType> & dst,const VecN<DIM,int> & dst_x0,const VecN<DIM,int> & size){
+    const int axis = (DIM==1)?0:1;//contiguous direction
+    for(int i=0;i<DIM;i++)
+        if(size(i)<=0)
+            return;
+    VecN<DIM,int> p(0);
+    while(true){
+        const PixelType * s = src.begin()+VecNIndice<DIM>::VecN2Indice(src.stride(),src_x0+p);
+        PixelType * d = dst.begin()+VecNIndice<DIM>::VecN2Indice(dst.stride(),dst_x0+p);
+        std::copy(s,s+size(axis),d);
+        int i=0;
+        for(;i<DIM;i++){
+            if(i==axis)
+                continue;
+            p(i)++;
+            if(p(i)<size(i))
+                break;
+            p(i)=0;
+        }
+        if(i==DIM)
+            return;
+    }
+}
+//visit the box [bmin,bmax) in the storage order of MatN (direction 1, then 0, then 2,...)
+template<int DIM>
+bool nextStorageOrder(VecN<DIM,int> & b,const VecN<DIM,int> & bmin,const VecN<DIM,int> & bmax){
+    for(int k=0;k<DIM;k++){
+        int i = (DIM==1)?0:(k==0?1:(k==1?0:k));
+        b(i)++;
+        if(b(i)<bmax(i))
+            return true;
+        b(i)=bmin(i);
+    }
+    return false;
+}
+}
+//\endcond
+
+/*!
+    \class pop::MatNChunked
+    \ingroup MatNChunked
+    \brief matrix stored in a file by fixed-size bricks to process volumes larger than the RAM
+    \author Tariel Vincent
+    \tparam DIM Space dimension
+    \tparam PixelType Pixel/Voxel type
+
+    The domain is cut in bricks of fixed size. Each brick is stored in the file as a contiguous MatN, possibly compressed (with deflate for the size, or with the fast codec of the class Compression after a byte-plane filter for the speed), and an index
+    in the header gives its position. Only a bounded number of bricks are kept in memory (least recently used cache), so any region of the matrix
+    can be read or written whatever the size of the file.
+
+    The file format (native endianness) is:
+    - the magic "POPCHNK1", then DIM, sizeof(PixelType), the scalar kind (bit 0 integer, bit 1 signed) and the compression as 4-bytes integers,
+    - the domain and the brick domain as DIM 4-bytes integers,
+    - for each brick in the storage order of MatN, its offset, its size and its capacity in bytes as 8-bytes integers (size 0 for an empty brick filled by 0),
+    - the brick data.
+
+    The class MatNChunkedIteratorTile streams the matrix by tiles with a halo, and MatNChunked::forEachTile applies a MatN algorithm tile by tile:
+    \code
+    struct Erosion{
+        Mat3UI8 operator()(const Mat3UI8 & f)const{return Processing::erosion(f,2);}
+    };
+    MatNChunked<3,UI8> in;
+    in.open("ct.chk");
+    MatNChunked<3,UI8> out;
+    out.create("ct_erosion.chk",in.getDomain(),in.getBrickDomain());
+    MatNChunked<3,UI8>::forEachTile(in,out,Erosion(),2);//halo equal to the radius
+    out.close();
+    \endcode
+    \sa MatNChunkedIteratorTile
+*/
+template<int DIM,typename PixelType>
+class POP_EXPORTS MatNChunked
+{
+public:
+    /*!
+    \typedef E
+    * Coordinate type VecN<DIM,int>
+    */
+    typedef VecN<DIM,int> E;
+    /*!
+    \typedef Domain
+    * Domain type VecN<DIM,int>
+    */
+    typedef VecN<DIM,int> Domain;
+    /*!
+    \typedef F
+    * Pixel/voxel type
+    */
+    typedef PixelType F;
+
+    MatNChunked()
+        :_read_only(true),_is_open(false),_compression(MATN_CHUNKED_RAW),_index_dirty(false),_end(0),_stamp(0),_cache_size(0)
+    {
+    }
+    ~MatNChunked(){
+        close();
+    }
+
+    /*!
+    * \param file file path
+    * \param domain domain of the matrix
+    * \param brick brick domain
+    * \param compression compression of the bricks
+    * \return false if the file cannot be created
+    *
+    * create a file where all bricks are empty (filled by 0)
+    */
+    bool create(const char * file,const Domain & domain,const Domain & brick=Domain(64),MatNChunkedCompression compression=MATN_CHUNKED_RAW){
+        close();
+        for(int i=0;i<DIM;i++){
+            if(domain(i)<=0||brick(i)<=0){
+                std::cerr<<"In MatNChunked::create, the domain and the brick domain must be strictly positive"<<std::endl;
+                return false;
+            }
+        }
+        _domain = domain;
+        _brick  = brick;
+        _compression = compression;
+        _initIndex();
+        std::ofstream out(file,std::ios::out|std::ios::binary|std::ios::trunc);
+        if(!out.is_open()){
+            std::cerr<<"In MatNChunked::create, cannot create the file "<<file<<std::endl;
+            return false;
+        }
+        _writeHeader(out);
+        out.close();
+        _file.open(file,std::ios::in|std::ios::out|std::ios::binary);
+        if(!_file.is_open()){
+            std::cerr<<"In MatNChunked::create, cannot open the file "<<file<<std::endl;
+            return false;
+        }
+        _end = _headerSize();
+        _read_only = false;
+        _is_open = true;
+        setCacheSize(_defaultCacheSize());
+        return true;
+    }
+    /*!
+    * \param file file path
+    * \param read_only true to forbid the writing
+    * \return false if the file cannot be opened or if its dimension/pixel type does not match the template parameters
+    */
+    bool open(const char * file,bool read_only=true){
+        close();
+        if(read_only)
+            _file.open(file,std::ios::in|std::ios::binary);
+        else
+            _file.open(file,std::ios::in|std::ios::out|std::ios::binary);
+        if(!_file.is_open()){
+            std::cerr<<"In MatNChunked::open, cannot open the file "<<file<<std::endl;
+            return false;
+        }
+        char magic[8];
+        I32 info[4];
+        _file.read(magic,8);
+        _file.read(reinterpret_cast<char *>(info),sizeof(info));
+        if(!_file||std::memcmp(magic,"POPCHNK1",8)!=0){
+            std::cerr<<"In MatNChunked::open, the file "<<file<<" is not a chunked matrix"<<std::endl;
+            _file.close();
+            return false;
+        }
+        if(info[0]!=DIM||info[1]!=static_cast<I32>(sizeof(PixelType))||info[2]!=Private::scalarKind<PixelType>()){
+            std::cerr<<"In MatNChunked::open, the dimension or the pixel type of the file "<<file<<" does not match"<<std::endl;
+            _file.close();
+            return false;
+        }
+        _compression = static_cast<MatNChunkedCompression>(info[3]);
+        I32 v[2*DIM];
+        _file.read(reinterpret_cast<char *>(v),sizeof(v));
+        for(int i=0;i<DIM;i++){
+            _domain(i)=v[i];
+            _brick(i) =v[DIM+i];
+        }
+        _initIndex();
+        if(_index.empty()==false)
+            _file.read(reinterpret_cast<char *>(&_index[0]),_index.size()*sizeof(BrickEntry));
+        if(!_file){
+            std::cerr<<"In MatNChunked::open, the header of the file "<<file<<" is truncated"<<std::endl;
+            _file.close();
+            return false;
+        }
+        _file.seekg(0,std::ios::end);
+        _end = static_cast<UI64>(_file.tellg());
+        _read_only = read_only;
+        _is_open = true;
+        setCacheSize(_defaultCacheSize());
+        return true;
+    }
+    /*!
+    * \return false if the writing fails
+    *
+    * write the modified bricks and the index in the file (nothing to write for a file opened in read-only mode)
+    */
+    bool flush(){
+        if(_is_open==false||_read_only==true)
+            return true;
+        for(unsigned int i=0;i<_cache.size();i++){
+            if(_cache[i].index>=0&&_cache[i].dirty){
+                _writeBrick(_cache[i].index,_cache[i].brick);
+                _cache[i].dirty=false;
+            }
+        }
+        if(_index_dirty){
+            _file.seekp(_headerSize()-_index.size()*sizeof(BrickEntry));
+            _file.write(reinterpret_cast<const char *>(&_index[0]),_index.size()*sizeof(BrickEntry));
+            _index_dirty = false;
+        }
+        _file.flush();
+        return static_cast<bool>(_file);
+    }
+    /*!
+    * flush and close the file
+    */
+    void close(){
+        if(_is_open==false)
+            return;
+        flush();
+        _file.close();
+        _cache.clear();
+        _brick_slot.clear();
+        _index.clear();
+        _is_open = false;
+    }
+    //! \return true if a file is opened
+    bool isOpen()const{
+        return _is_open;
+    }
+    //! \return domain of the matrix
+    Domain getDomain()const{
+        return _domain;
+    }
+    //! \return domain of a brick
+    Domain getBrickDomain()const{
+        return _brick;
+    }
+    //! \return number of bricks in each direction
+    Domain getNbrBrick()const{
+        return _nbr_brick;
+    }
+    //! \return compression of the bricks
+    MatNChunkedCompression getCompression()const{
+        return _compression;
+    }
+    /*!
+    * \param nbr_brick maximum number of bricks kept in memory
+    *
+    * The memory used by the cache is bounded by nbr_brick*getBrickDomain().multCoordinate()*sizeof(PixelType). By default, the cache holds 256 MB
+    * and at least 3^DIM bricks.
+    */
+    void setCacheSize(int nbr_brick){
+        flush();
+        _cache.clear();
+        _cache_size = std::max(1,nbr_brick);
+        _cache.reserve(_cache_size);
+        std::fill(_brick_slot.begin(),_brick_slot.end(),-1);
+    }
+    //! \return maximum number of bricks kept in memory
+    int getCacheSize()const{
+        return _cache_size;
+    }
+
+    /*!
+    * \param xmin first corner of the region (included)
+    * \param xmax last corner of the region (excluded)
+    * \return the values in the region [xmin,xmax) that must be included in the domain
+    */
+    MatN<DIM,PixelType> read(const E & xmin,const E & xmax){
+        POP_DbgAssertMessage(xmin.allSuperiorEqual(E(0))&&_domain.allSuperiorEqual(xmax)&&xmax.allSuperior(xmin),"In MatNChunked::read, the region must be included in the domain");
+        MatN<DIM,PixelType> f(xmax-xmin);
+        E bmin,bmax;
+        _brickRange(xmin,xmax,bmin,bmax);
+        E b(bmin);
+        do{
+            E origin = b*_brick;
+            E x0 = maximum(origin,xmin);
+            E x1 = minimum(origin+_brick,xmax);
+            const MatN<DIM,PixelType> & brick = _getBrick(_brickIndex(b),true).brick;
+            Private::copyBox(brick,x0-origin,f,x0-xmin,x1-x0);
+        }while(Private::nextStorageOrder(b,bmin,bmax));
+        return f;
+    }
+    /*!
+    * \param f values
+    * \param xmin position of f(0) in the matrix
+    * \return false if the file is not opened or opened in read-only mode, in this case nothing is written
+    *
+    * write the values of f in the region [xmin,xmin+f.getDomain()) that must be included in the domain
+    */
+    bool write(const MatN<DIM,PixelType> & f,const E & xmin){
+        E xmax = xmin+f.getDomain();
+        if(_is_open==false||_read_only==true){
+            std::cerr<<"In MatNChunked::write, the file is not opened or opened in read-only mode, nothing is written"<<std::endl;
+            return false;
+        }
+        POP_DbgAssertMessage(xmin.allSuperiorEqual(E(0))&&_domain.allSuperiorEqual(xmax),"In MatNChunked::write, the region must be included in the domain");
+        E bmin,bmax;
+        _brickRange(xmin,xmax,bmin,bmax);
+        E b(bmin);
+        do{
+            E origin = b*_brick;
+            E x0 = maximum(origin,xmin);
+            E x1 = minimum(origin+_brick,xmax);
+            //a brick entirely covered does not need to be read
+            bool covered = (x0==origin&&x1==minimum(origin+_brick,_domain));
+            BrickCache & cache = _getBrick(_brickIndex(b),!covered);
+            Private::copyBox(f,x0-xmin,cache.brick,x0-origin,x1-x0);
+            cache.dirty = true;
+        }while(Private::nextStorageOrder(b,bmin,bmax));
+        return true;
+    }
+    /*!
+    * \return the whole matrix in memory
+    */
+    MatN<DIM,PixelType> load(){
+        return read(E(0),_domain);
+    }
+    /*!
+    * \param file file path
+    * \param f input matrix
+    * \param brick brick domain
+    * \param compression compression of the bricks
+    * \return false if the file cannot be created
+    *
+    * save the matrix f as a chunked file
+    */
+    static bool save(const char * file,const MatN<DIM,PixelType> & f,const Domain & brick=Domain(64),MatNChunkedCompression compression=MATN_CHUNKED_RAW){
+        MatNChunked<DIM,PixelType> chunked;
+        if(chunked.create(file,f.getDomain(),brick,compression)==false)
+            return false;
+        bool ok = chunked.write(f,E(0));
+        ok = chunked.flush()&&ok;
+        chunked.close();
+        return ok;
+    }
+    /*!
+    * \param in input chunked matrix
+    * \param out output chunked matrix with the same domain
+    * \param func functor MatN<DIM,PixelType> -> MatN<DIM,PixelTypeOut> applied on each tile
+    * \param halo number of voxels added around each tile (at least the radius of the neighborhood used by func)
+    * \return false if out cannot be written (for instance opened in read-only mode)
+    *
+    * The tiles are the bricks of out, extended by the halo and cropped by the domain, such that the result is the same as func applied on the whole matrix
+    * for point-wise and fixed-radius neighborhood operators. Only the bricks of the caches and one tile are in memory.
+    */
+    template<typename PixelTypeOut,typename Functor>
+    static bool forEachTile(MatNChunked<DIM,PixelType> & in,MatNChunked<DIM,PixelTypeOut> & out,Functor func,int halo=0);
+
+private:
+    //    \cond HIDDEN_SYMBOLS
+    struct BrickEntry{
+        UI64 offset;
+        UI64 size;
+        UI64 capacity;
+    };
+    struct BrickCache{
+        int index;
+        bool dirty;
+        UI64 stamp;
+        MatN<DIM,PixelType> brick;
+    };
+    MatNChunked(const MatNChunked &);
+    MatNChunked & operator=(const MatNChunked &);
+
+    static bool _delta(){
+        return std::numeric_limits<typename TypeTraitsTypeScalar<PixelType>::Result>::is_integer;
+    }
+    UI64 _brickBytes()const{
+        return static_cast<UI64>(_brick.multCoordinate())*sizeof(PixelType);
+    }
+    UI64 _headerSize()const{
+        return 8+4*sizeof(I32)+2*DIM*sizeof(I32)+_index.size()*sizeof(BrickEntry);
+    }
+    int _defaultCacheSize()const{
+        int nbr = 1;
+        for(int i=0;i<DIM;i++)
+            nbr*=3;
+        UI64 memory = 256*1024*1024;
+        int nbr_memory = static_cast<int>(std::min<UI64>(memory/std::max<UI64>(1,_brickBytes()),std::numeric_limits<int>::max()));
+        return std::max(1,std::min(static_cast<int>(_index.size()),std::max(nbr,nbr_memory)));
+    }
+    void _initIndex(){
+        for(int i=0;i<DIM;i++)
+            _nbr_brick(i)=(_domain(i)+_brick(i)-1)/_brick(i);
+        _brick_stride = _strideOf(_nbr_brick);
+        BrickEntry empty;
+        empty.offset=0;
+        empty.size=0;
+        empty.capacity=0;
+        _index.assign(_nbr_brick.multCoordinate(),empty);
+        _brick_slot.assign(_index.size(),-1);
+        _index_dirty = false;
+        _cache.clear();
+    }
+    static E _strideOf(const E & domain){
+        E stride;
+        if(DIM==1){
+            stride(0)=1;
+            return stride;
+        }
+        //the recurrence of MatN::_initStride
+        stride(1)=1;
+        stride(0)=domain(1);
+        for(int i=2;i<DIM;i++){
+            if(i==2)
+                stride(2)=domain(1)*domain(0);
+            else
+                stride(i)=domain(i-1)*stride(i-1);
+        }
+        return stride;
+    }
+    int _brickIndex(const E & b)const{
+        return VecNIndice<DIM>::VecN2Indice(_brick_stride,b);
+    }
+    void _brickRange(const E & xmin,const E & xmax,E & bmin,E & bmax)const{
+        for(int i=0;i<DIM;i++){
+            bmin(i)=xmin(i)/_brick(i);
+            bmax(i)=(xmax(i)-1)/_brick(i)+1;
+        }
+    }
+    BrickCache & _getBrick(int index,bool load){
+        _stamp++;
+        int slot = _brick_slot[index];
+        if(slot>=0){
+            _cache[slot].stamp = _stamp;
+            return _cache[slot];
+        }
+        if(static_cast<int>(_cache.size())<_cache_size){
+            slot = static_cast<int>(_cache.size());
+            _cache.push_back(BrickCache());
+            _cache[slot].brick.resize(_brick);
+        }else{
+            slot = 0;
+            for(unsigned int i=1;i<_cache.size();i++){
+                if(_cache[i].stamp<_cache[slot].stamp)
+                    slot = i;
+            }
+            if(_cache[slot].dirty)
+                _writeBrick(_cache[slot].index,_cache[slot].brick);
+            _brick_slot[_cache[slot].index]=-1;
+        }
+        BrickCache & cache = _cache[slot];
+        cache.index = index;
+        cache.dirty = false;
+        cache.stamp = _stamp;
+        _brick_slot[index]=slot;
+        if(load)
+            _readBrick(index,cache.brick);
+        else
+            cache.brick = PixelType(0);
+        return cache;
+    }
+    void _readBrick(int index,MatN<DIM,PixelType> & brick){
+        const BrickEntry & entry = _index[index];
+        if(entry.size==0){
+            brick = PixelType(0);
+            return;
+        }
+        _file.clear();
+        _file.seekg(entry.offset);
+        //a brick that does not compress is stored raw
+        if(entry.size==_brickBytes()){
+            _file.read(reinterpret_cast<char *>(brick.begin()),_brickBytes());
+        }else{
+            _buffer.resize(entry.size);
+            _file.read(reinterpret_cast<char *>(&_buffer[0]),entry.size);
+            bool ok;
+            if(_compression==MATN_CHUNKED_DEFLATE){
+                _decoded.clear();
+                ok = (lodepng::decompress(_decoded,&_buffer[0],_buffer.size())==0&&_decoded.size()==_brickBytes());
+                if(ok)
+                    std::memcpy(brick.begin(),&_decoded[0],_decoded.size());
+            }else{
+                _decoded.resize(_brickBytes());
+                ok = Compression::decompressLZ(&_buffer[0],_buffer.size(),&_decoded[0],_decoded.size());
+                if(ok)
+                    Compression::unfilterShuffle(&_decoded[0],_decoded.size(),sizeof(PixelType),_delta(),reinterpret_cast<unsigned char *>(brick.begin()));
+            }
+            if(ok==false){
+                std::cerr<<"In MatNChunked::read, corrupted brick "<<index<<std::endl;
+                brick = PixelType(0);
+                return;
+            }
+        }
+        if(!_file){
+            std::cerr<<"In MatNChunked::read, cannot read the brick "<<index<<std::endl;
+            _file.clear();
+        }
+    }
+    void _writeBrick(int index,const MatN<DIM,PixelType> & brick){
+        const char * data = reinterpret_cast<const char *>(brick.begin());
+        UI64 size = _brickBytes();
+        if(_compression==MATN_CHUNKED_DEFLATE){
+            _buffer.clear();
+            lodepng::compress(_buffer,reinterpret_cast<const unsigned char *>(data),size);
+        }else if(_compression==MATN_CHUNKED_LZ){
+            _decoded.resize(size);
+            Compression::filterShuffle(reinterpret_cast<const unsigned char *>(data),size,sizeof(PixelType),_delta(),&_decoded[0]);
+            _buffer.resize(Compression::boundLZ(size));
+            _buffer.resize(Compression::compressLZ(&_decoded[0],size,&_buffer[0]));
+        }
+        if(_compression!=MATN_CHUNKED_RAW&&_buffer.size()<size){
+            data = reinterpret_cast<const char *>(&_buffer[0]);
+            size = _buffer.size();
+        }
+        BrickEntry & entry = _index[index];
+        if(entry.capacity<size){
+            entry.offset   = _end;
+            entry.capacity = size;
+            _end += size;
+        }
+        entry.size = size;
+        _index_dirty = true;
+        _file.clear();
+        _file.seekp(entry.offset);
+        _file.write(data,size);
+    }
+    void _writeHeader(std::ostream & out)const{
+        I32 info[4]={DIM,static_cast<I32>(sizeof(PixelType)),Private::scalarKind<PixelType>(),static_cast<I32>(_compression)};
+        I32 v[2*DIM];
+        for(int i=0;i<DIM;i++){
+            v[i]    =_domain(i);
+            v[DIM+i]=_brick(i);
+        }
+        out.write("POPCHNK1",8);
+        out.write(reinterpret_cast<const char *>(info),sizeof(info));
+        out.write(reinterpret_cast<const char *>(v),sizeof(v));
+        out.write(reinterpret_cast<const char *>(&_index[0]),_index.size()*sizeof(BrickEntry));
+    }
+
+    std::fstream _file;
+    bool _read_only;
+    bool _is_open;
+    Domain _domain;
+    Domain _brick;
+    Domain _nbr_brick;
+    E _brick_stride;
+    MatNChunkedCompression _compression;
+    std::vector<BrickEntry> _index;
+    bool _index_dirty;
+    UI64 _end;
+    std::vector<BrickCache> _cache;
+    std::vector<int> _brick_slot;
+    UI64 _stamp;
+    int _cache_size;
+    std::vector<unsigned char> _buffer;
+    std::vector<unsigned char> _decoded;
+    //\endcond
+};
+
+/*!
+    \class pop::MatNChunkedIteratorTile
+    \ingroup MatNChunked
+    \brief stream a chunked matrix by tiles extended by a halo
+    \author Tariel Vincent
+
+    The tiles are visited in the storage order of the bricks. For each tile, the core region [xmin(),xmax()) is extended by the halo in each direction and
+    cropped by the domain, and the values of this extended region are loaded in tile(). Since the extended region is cropped by the domain, an algorithm
+    applied on tile() sees the same boundary as on the whole matrix, so its result restricted to the core is identical when the halo is larger than the
+    radius of its neighborhood.
+    \code
+    MatNChunked<3,UI8> in;
+    in.open("ct.chk");
+    MatNChunkedIteratorTile<3,UI8> it(in,1);
+    int nbr=0;
+    while(it.next()){
+        Mat3UI8 tile = it.core(Processing::threshold(it.tile(),100));
+        nbr+=std::count(tile.begin(),tile.end(),255);
+    }
+    std::cout<<nbr<<std::endl;
+    \endcode
+*/
+template<int DIM,typename PixelType>
+class POP_EXPORTS MatNChunkedIteratorTile
+{
+public:
+    typedef VecN<DIM,int> E;
+    /*!
+    * \param volume chunked matrix
+    * \param halo number of voxels added around each tile
+    * \param tile tile domain (by default the brick domain)
+    */
+    MatNChunkedIteratorTile(MatNChunked<DIM,PixelType> & volume,int halo=0,const E & tile=E(0))
+        :_volume(&volume),_halo(halo),_tile_size(tile)
+    {
+        if(_tile_size.allSuperior(E(0))==false)
+            _tile_size = volume.getBrickDomain();
+        for(int i=0;i<DIM;i++)
+            _nbr_tile(i)=(volume.getDomain()(i)+_tile_size(i)-1)/_tile_size(i);
+        init();
+    }
+    //! restart the iteration
+    void init(){
+        _first = true;
+        _index = E(0);
+    }
+    /*!
+    * \return false when all tiles have been visited, otherwise load the next tile
+    */
+    bool next(){
+        if(_first){
+            _first = false;
+        }else{
+            if(Private::nextStorageOrder(_index,E(0),_nbr_tile)==false)
+                return false;
+        }
+        E domain = _volume->getDomain();
+        _xmin  = _index*_tile_size;
+        _xmax  = minimum(_xmin+_tile_size,domain);
+        _origin= maximum(_xmin-E(_halo),E(0));
+        _tile  = _volume->read(_origin,minimum(_xmax+E(_halo),domain));
+        return true;
+    }
+    //! \return tile extended by the halo
+    const MatN<DIM,PixelType> & tile()const{
+        return _tile;
+    }
+    //! \return first corner of the core (included)
+    const E & xmin()const{
+        return _xmin;
+    }
+    //! \return last corner of the core (excluded)
+    const E & xmax()const{
+        return _xmax;
+    }
+    //! \return position of tile()(0) in the chunked matrix
+    const E & origin()const{
+        return _origin;
+    }
+    /*!
+    * \param f matrix with the domain of tile()
+    * \return the values of f in the core region
+    */
+    template<typename PixelType2>
+    MatN<DIM,PixelType2> core(const MatN<DIM,PixelType2> & f)const{
+        MatN<DIM,PixelType2> h(_xmax-_xmin);
+        Private::copyBox(f,_xmin-_origin,h,E(0),_xmax-_xmin);
+        return h;
+    }
+    //! \return number of tiles
+    int nbrTile()const{
+        return _nbr_tile.multCoordinate();
+    }
+private:
+    MatNChunked<DIM,PixelType> * _volume;
+    int _halo;
+    E _tile_size;
+    E _nbr_tile;
+    E _index;
+    bool _first;
+    E _xmin;
+    E _xmax;
+    E _origin;
+    MatN<DIM,PixelType> _tile;
+};
+
+template<int DIM,typename PixelType>
+template<typename PixelTypeOut,typename Functor>
+bool MatNChunked<DIM,PixelType>::forEachTile(MatNChunked<DIM,PixelType> & in,MatNChunked<DIM,PixelTypeOut> & out,Functor func,int halo){
+    POP_DbgAssertMessage(in.getDomain()==out.getDomain(),"In MatNChunked::forEachTile, the input and output matrices must have the same domain");
+    MatNChunkedIteratorTile<DIM,PixelType> it(in,halo,out.getBrickDomain());
+    while(it.next()){
+        if(out.write(it.core(func(it.tile())),it.xmin())==false)
+            return false;
+    }
+    return out.flush();
+}
+}
+#endif // MATNCHUNKED_H
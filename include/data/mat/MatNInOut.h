@@ -52,9 +52,12 @@ in the Software.
 #include <cmath>
 #include <string>
 #include <algorithm>
+#include <limits>
 #include "data/typeF/TypeF.h"
 #include "data/typeF/RGB.h"
 #include "data/mat/MatN.h"
+#include "algorithm/ForEachFunctor.h"
+#include "data/utility/Compression.h"
 namespace pop
 {
 class POP_EXPORTS MatNInOutPgm
@@ -73,6 +76,8 @@ public:
     template<I32 D,typename T>
     static bool read(MatN<D,T> &in,std::istream &File );
     template<I32 D,typename T>
+    static bool readHeader(Type2Type<MatN<D,T> >,std::istream &File,typename MatN<D,T>::E & domain,bool & ascii);
+    template<I32 D,typename T>
     static void writeAscii(const MatN<D,T>&in,std::ostream & out );
     template<I32 D,typename T>
     static void writeRaw(const MatN<D,T> &in,std::ostream & out );
@@ -149,6 +154,11 @@ private:
     static void  _saveJPG(const MatN<2, RGBUI8 > &img, const char * filename);
 
 
+    template<I32 D,typename T>
+    static void _savePop(const MatN<D,T> &in,const char * file);
+    template<I32 D,typename T>
+    static bool _loadPop(MatN<D,T> &in,const char * file);
+
 public:
     template<I32 D,typename T>
     static void save(const MatN<D,T> &in,const char * file );
@@ -158,6 +168,8 @@ public:
     static bool load(MatN<DIM,Result> &in,const char * file  );
     template<I32 DIM,typename Result>
     static bool loadRaw(MatN<DIM,Result> &in,const char * file  );
+    template<I32 DIM,typename Result>
+    static bool openMapped(MatN<DIM,Result> &in,const char * file,bool read_only);
 
     template<int DIM,typename PixelType>
     static bool loadFromDirectory(MatN<DIM,PixelType> & in1cast,const char * pathdir, const char * basefilename, const char * extension);
@@ -165,6 +177,124 @@ public:
     static void saveFromDirectory(const MatN<DIM,Result> & in1cast,const char * pathdir, const char * basefilename, const char * extension);
 };
 
+//    \cond HIDDEN_SYMBOLS
+namespace Private{
+template<typename PixelType>
+I32 scalarKind(){
+    typedef typename TypeTraitsTypeScalar<PixelType>::Result Scalar;
+    return (std::numeric_limits<Scalar>::is_integer?1:0)+(std::numeric_limits<Scalar>::is_signed?2:0);
+}
+enum PopFilter{
+    POP_FILTER_NONE          = 0,
+    POP_FILTER_SHUFFLE       = 1,
+    POP_FILTER_SHUFFLE_DELTA = 2
+};
+//block b of the pop format: filter then compress, stored raw if the compression does not reduce the size
+struct PopEncodeBlock
+{
+    const unsigned char * _data;
+    UI64 _size;
+    UI64 _size_block;
+    int _element_size;
+    int _filter;
+    std::vector<std::vector<unsigned char> > * _blocks;
+    void operator()(int begin,int end){
+        std::vector<unsigned char> filtered;
+        for(int b=begin;b<end;b++){
+            const unsigned char * in = _data+b*_size_block;
+            std::size_t size = static_cast<std::size_t>(std::min(_size_block,_size-b*_size_block));
+            std::vector<unsigned char> & out = (*_blocks)[b];
+            if(_filter!=POP_FILTER_NONE){
+                filtered.resize(size);
+                Compression::filterShuffle(in,size,_element_size,_filter==POP_FILTER_SHUFFLE_DELTA,&filtered[0]);
+                in = &filtered[0];
+            }
+            out.resize(Compression::boundLZ(size));
+            out.resize(Compression::compressLZ(in,size,&out[0]));
+            if(out.size()>=size)
+                out.assign(_data+b*_size_block,_data+b*_size_block+size);
+        }
+    }
+};
+struct PopDecodeBlock
+{
+    const unsigned char * _payload;
+    const std::vector<UI64> * _sizes;
+    const std::vector<UI64> * _offsets;
+    unsigned char * _data;
+    UI64 _size;
+    UI64 _size_block;
+    int _element_size;
+    int _filter;
+    std::vector<int> * _status;
+    void operator()(int begin,int end){
+        std::vector<unsigned char> filtered;
+        for(int b=begin;b<end;b++){
+            const unsigned char * in = _payload+(*_offsets)[b];
+            unsigned char * out = _data+b*_size_block;
+            std::size_t size = static_cast<std::size_t>(std::min(_size_block,_size-b*_size_block));
+            std::size_t size_in = static_cast<std::size_t>((*_sizes)[b]);
+            if(size_in==size){
+                std::copy(in,in+size,out);
+            }else if(_filter==POP_FILTER_NONE){
+                if(Compression::decompressLZ(in,size_in,out,size)==false)
+                    (*_status)[b]=1;
+            }else{
+                filtered.resize(size);
+                if(Compression::decompressLZ(in,size_in,&filtered[0],size)==false)
+                    (*_status)[b]=1;
+                else
+                    Compression::unfilterShuffle(&filtered[0],size,_element_size,_filter==POP_FILTER_SHUFFLE_DELTA,out);
+            }
+        }
+    }
+};
+//the z-plane i of a 3d matrix has the memory layout of a 2d matrix, so the slices are copied with a single block copy
+template<int DIM,typename PixelType>
+struct LoadSliceRange
+{
+    enum{
+        SUCCESS     = 0,
+        FAIL_LOAD   = 1,
+        FAIL_DOMAIN = 2
+    };
+    const std::vector<std::string> * _files;
+    MatN<DIM,PixelType> * _volume;
+    std::vector<int> * _status;
+    LoadSliceRange(const std::vector<std::string> & files,MatN<DIM,PixelType> & volume,std::vector<int> & status)
+        :_files(&files),_volume(&volume),_status(&status){}
+    void operator()(int begin,int end){
+        VecN<2,int> d(_volume->getDomain()(0),_volume->getDomain()(1));
+        int size_plane = d.multCoordinate();
+        MatN<2,PixelType> img;
+        for(int i=begin;i<end;i++){
+            if(MatNInOut::load(img,(*_files)[i].c_str())==false)
+                (*_status)[i]=FAIL_LOAD;
+            else if(img.getDomain()!=d)
+                (*_status)[i]=FAIL_DOMAIN;
+            else
+                std::copy(img.begin(),img.end(),_volume->begin()+i*size_plane);
+        }
+    }
+};
+template<int DIM,typename PixelType>
+struct SaveSliceRange
+{
+    const std::vector<std::string> * _files;
+    const MatN<DIM,PixelType> * _volume;
+    SaveSliceRange(const std::vector<std::string> & files,const MatN<DIM,PixelType> & volume)
+        :_files(&files),_volume(&volume){}
+    void operator()(int begin,int end){
+        MatN<2,PixelType> plane(VecN<2,int>(_volume->getDomain()(0),_volume->getDomain()(1)));
+        int size_plane = plane.getDomain().multCoordinate();
+        for(int i=begin;i<end;i++){
+            std::copy(_volume->begin()+i*size_plane,_volume->begin()+(i+1)*size_plane,plane.begin());
+            MatNInOut::save(plane,(*_files)[i].c_str());
+        }
+    }
+};
+}
+//\endcond
 namespace Private{
 inline void  headerPNG(std::ostream & out,Type2Type<pop::UI8>){
     out<<"255"<<std::endl;
@@ -213,6 +343,11 @@ bool MatN<Dim,PixelType>::loadRaw(const char * file,const Domain & d)
     return MatNInOut::loadRaw(*this,file);
 }
 template<int Dim, typename PixelType>
+bool MatN<Dim,PixelType>::openMapped(const char * file,bool read_only)
+{
+    return MatNInOut::openMapped(*this,file,read_only);
+}
+template<int Dim, typename PixelType>
 void MatN<Dim,PixelType>::saveFromDirectory(const char * pathdir,const char * basefilename,const char * extension)const
 {
     MatNInOut::saveFromDirectory(*this,pathdir,basefilename,extension);
@@ -240,7 +375,7 @@ void MatN<Dim,PixelType>::saveAscii(const char * file,std::string header)const
     }
 }
 template<I32 D,typename T>
-bool MatNInOutPgm::read(MatN<D,T> &in,std::istream &File )
+bool MatNInOutPgm::readHeader(Type2Type<MatN<D,T> >,std::istream &File,typename MatN<D,T>::E & domain,bool & ascii)
 {
     if (File.fail()){
         std::cerr<<"In MatN::read, cannot open the file";
@@ -250,12 +385,11 @@ bool MatNInOutPgm::read(MatN<D,T> &in,std::istream &File )
     std::string idascii = type.first;
     std::string buffer ;
     std::getline( File, buffer, '\n');
-    bool _ascii;
     if(idascii[1]==buffer[1]){
-        _ascii = true;
+        ascii = true;
     }
     else{
-        _ascii = false;
+        ascii = false;
     }
     std::string str;
     bool firsttime=true;
@@ -287,6 +421,16 @@ bool MatNInOutPgm::read(MatN<D,T> &in,std::istream &File )
 
     std::getline( File, mot, '\n' );
     std::swap(x(0),x(1));
+    domain = x;
+    return true;
+}
+template<I32 D,typename T>
+bool MatNInOutPgm::read(MatN<D,T> &in,std::istream &File )
+{
+    typename MatN<D,T>::E  x;
+    bool _ascii;
+    if(readHeader(Type2Type<MatN<D,T> >(),File,x,_ascii)==false)
+        return false;
     in.resize(x);
     if(_ascii==true){
         return readAscii(in,File);
@@ -464,7 +608,7 @@ void  MatNInOut::_saveJPG(const MatN<DIM, PixelType > &, const char * )
 }
 template<I32 D,typename T>
 void MatNInOut::saveRaw(const MatN<D,T> &in ,const char * file){
-    std::ofstream  out(file);
+    std::ofstream  out(file,std::ios::binary);
     if (out.fail())
         std::cerr<<"In MatN::save, cannot open file: "+std::string(file) << std::endl;
     else
@@ -495,6 +639,8 @@ void MatNInOut::save(const MatN<D,T> &in ,const char * file){
             }
             out.close();
         }
+    }else if(ext==".pop"){
+        _savePop(in,file);
     }else if(ext==".png"||ext==".PNG"){
         _savePNG(in,file);
     }
@@ -508,6 +654,118 @@ void MatNInOut::save(const MatN<D,T> &in ,const char * file){
         _save(in,file);
     }
 }
+template<I32 D,typename T>
+void MatNInOut::_savePop(const MatN<D,T> &in,const char * file){
+    std::ofstream  out(file,std::ios::binary);
+    if (out.fail()){
+        std::cerr<<"In MatN::save, cannot open file: "+std::string(file) << std::endl;
+        return;
+    }
+    const int size_block_max = 1<<20;
+    Private::PopEncodeBlock func;
+    func._data = reinterpret_cast<const unsigned char *>(in.begin());
+    func._size = static_cast<UI64>(in.getDomain().multCoordinate())*sizeof(T);
+    func._size_block = (size_block_max/sizeof(T))*sizeof(T);
+    func._element_size = sizeof(T);
+    if(std::numeric_limits<typename TypeTraitsTypeScalar<T>::Result>::is_integer)
+        func._filter = Private::POP_FILTER_SHUFFLE_DELTA;
+    else
+        func._filter = (sizeof(T)>1)?Private::POP_FILTER_SHUFFLE:Private::POP_FILTER_NONE;
+    UI64 nbr_block = (func._size+func._size_block-1)/func._size_block;
+    std::vector<std::vector<unsigned char> > blocks(static_cast<std::size_t>(nbr_block));
+    func._blocks = &blocks;
+    forEachRangeParallel(0,static_cast<int>(nbr_block),func);
+
+    I32 info[6]={D,static_cast<I32>(sizeof(T)),Private::scalarKind<T>(),1,func._filter,static_cast<I32>(func._size_block)};
+    I32 domain[D];
+    F32 spacing[D];
+    for(int i=0;i<D;i++){
+        domain[i] = in.getDomain()(i);
+        spacing[i]= 1;
+    }
+    std::vector<UI64> sizes(blocks.size());
+    for(unsigned int b=0;b<blocks.size();b++)
+        sizes[b]=blocks[b].size();
+    out.write("POPMATN1",8);
+    out.write(reinterpret_cast<const char *>(info),sizeof(info));
+    out.write(reinterpret_cast<const char *>(domain),sizeof(domain));
+    out.write(reinterpret_cast<const char *>(spacing),sizeof(spacing));
+    out.write(reinterpret_cast<const char *>(&nbr_block),sizeof(nbr_block));
+    if(sizes.empty()==false)
+        out.write(reinterpret_cast<const char *>(&sizes[0]),sizes.size()*sizeof(UI64));
+    for(unsigned int b=0;b<blocks.size();b++){
+        if(blocks[b].empty()==false)
+            out.write(reinterpret_cast<const char *>(&blocks[b][0]),blocks[b].size());
+    }
+    if(out.fail())
+        std::cerr<<"In MatN::save, cannot write file: "+std::string(file) << std::endl;
+}
+template<I32 D,typename T>
+bool MatNInOut::_loadPop(MatN<D,T> &in,const char * file){
+    std::ifstream  is(file,std::ios::binary);
+    char magic[8];
+    I32 info[6];
+    is.read(magic,8);
+    is.read(reinterpret_cast<char *>(info),sizeof(info));
+    if(!is||std::memcmp(magic,"POPMATN1",8)!=0){
+        std::cerr<<"In MatN::load, the file is not in the pop format: "+std::string(file) << std::endl;
+        return false;
+    }
+    if(info[0]!=D||info[1]!=static_cast<I32>(sizeof(T))||info[2]!=Private::scalarKind<T>()){
+        std::cerr<<"In MatN::load, the dimension or the pixel type of the pop file does not match the matrix: "+std::string(file) << std::endl;
+        return false;
+    }
+    if((info[3]!=0&&info[3]!=1)||info[4]<Private::POP_FILTER_NONE||info[4]>Private::POP_FILTER_SHUFFLE_DELTA||info[5]<=0){
+        std::cerr<<"In MatN::load, unknown codec in the pop file: "+std::string(file) << std::endl;
+        return false;
+    }
+    I32 domain[D];
+    F32 spacing[D];
+    UI64 nbr_block;
+    is.read(reinterpret_cast<char *>(domain),sizeof(domain));
+    is.read(reinterpret_cast<char *>(spacing),sizeof(spacing));
+    is.read(reinterpret_cast<char *>(&nbr_block),sizeof(nbr_block));
+    typename MatN<D,T>::Domain d;
+    for(int i=0;i<D;i++)
+        d(i)=domain[i];
+    Private::PopDecodeBlock func;
+    func._size = static_cast<UI64>(d.multCoordinate())*sizeof(T);
+    func._size_block = info[5];
+    func._element_size = sizeof(T);
+    func._filter = info[4];
+    if(!is||nbr_block!=(func._size+func._size_block-1)/func._size_block){
+        std::cerr<<"In MatN::load, corrupted header in the pop file: "+std::string(file) << std::endl;
+        return false;
+    }
+    std::vector<UI64> sizes(static_cast<std::size_t>(nbr_block)),offsets(static_cast<std::size_t>(nbr_block));
+    if(sizes.empty()==false)
+        is.read(reinterpret_cast<char *>(&sizes[0]),sizes.size()*sizeof(UI64));
+    UI64 size_payload = 0;
+    for(unsigned int b=0;b<sizes.size();b++){
+        offsets[b]=size_payload;
+        size_payload+=sizes[b];
+    }
+    std::vector<unsigned char> payload(static_cast<std::size_t>(size_payload));
+    if(payload.empty()==false)
+        is.read(reinterpret_cast<char *>(&payload[0]),payload.size());
+    if(!is){
+        std::cerr<<"In MatN::load, truncated pop file: "+std::string(file) << std::endl;
+        return false;
+    }
+    in.resize(d);
+    std::vector<int> status(sizes.size(),0);
+    func._payload = payload.empty()?NULL:&payload[0];
+    func._sizes = &sizes;
+    func._offsets = &offsets;
+    func._data = reinterpret_cast<unsigned char *>(in.begin());
+    func._status = &status;
+    forEachRangeParallel(0,static_cast<int>(nbr_block),func);
+    if(std::find(status.begin(),status.end(),1)!=status.end()){
+        std::cerr<<"In MatN::load, corrupted block in the pop file: "+std::string(file) << std::endl;
+        return false;
+    }
+    return true;
+}
 template<I32 DIM,typename Result>
 bool MatNInOut::loadRaw(MatN<DIM,Result> &in, const char * file  ){
 
@@ -518,9 +776,9 @@ bool MatNInOut::loadRaw(MatN<DIM,Result> &in, const char * file  ){
     }
     else{
         is.seekg (0, is.end);
-        unsigned int length = (unsigned int)is.tellg();
+        std::streamoff length = is.tellg();
         is.seekg (0, is.beg);
-        if(length>=sizeof(Result)*in.getDomain().multCoordinate()) {
+        if(length>=static_cast<std::streamoff>(sizeof(Result))*in.getDomain().multCoordinate()) {
             return MatNInOutPgm::readRaw(in,is);
         }
         else{
@@ -530,6 +788,26 @@ bool MatNInOut::loadRaw(MatN<DIM,Result> &in, const char * file  ){
     }
 }
 
+template<I32 DIM,typename Result>
+bool MatNInOut::openMapped(MatN<DIM,Result> &in,const char * file,bool read_only){
+    std::ifstream  is(file,std::iostream::binary);
+    if (is.fail()){
+        std::cerr<<"In MatN::openMapped, Cannot open file: "+std::string(file) << std::endl;
+        return false;
+    }
+    typename MatN<DIM,Result>::E domain;
+    bool ascii;
+    if(MatNInOutPgm::readHeader(Type2Type<MatN<DIM,Result> >(),is,domain,ascii)==false)
+        return false;
+    if(ascii==true){
+        std::cerr<<"In MatN::openMapped, only the binary pgm file can be mapped: "+std::string(file) << std::endl;
+        return false;
+    }
+    //the pixels follow the header
+    std::streamoff offset = is.tellg();
+    is.close();
+    return in.openMapped(file,domain,read_only,static_cast<std::size_t>(offset));
+}
 template<I32 DIM,typename Result>
 bool MatNInOut::load(MatN<DIM,Result> &in,const char * file  )
 {
@@ -554,6 +832,8 @@ bool MatNInOut::load(MatN<DIM,Result> &in,const char * file  )
         {
             return MatNInOutPgm::read(in,is);
         }
+    }else if(ext==".pop"){
+        return _loadPop(in,file);
     }else if(ext==".png"||ext==".PNG"){
         return _loadPNG(in,file);
     }else if(ext==".bmp"||ext==".BMP"){
@@ -602,16 +882,20 @@ bool MatNInOut::loadFromDirectory(MatN<DIM,PixelType> & in1cast,const char * pat
     d(1)=img.getDomain()(1);
     d(2)=vec.size();
     in1cast.resize(d);
+    std::copy(img.begin(),img.end(),in1cast.begin());
+    img.clear();
+    //the slices are decoded concurrently, each thread holding a single decoded slice
+    std::vector<int> status(vec.size(),0);
+    Private::LoadSliceRange<DIM,PixelType> func(vec,in1cast,status);
+    forEachRangeParallel(1,(int)vec.size(),func);
     for(int i = 0;i<(int)vec.size();i++){
-        if(i!=0)
-            MatNInOut::load(img,vec[i].c_str());
-        if(img.sizeI()!=in1cast.sizeI()||img.sizeJ()!=in1cast.sizeJ()){
+        if(status[i]==Private::LoadSliceRange<DIM,PixelType>::FAIL_LOAD){
+            std::cerr<<"In MatN::loadFromDirectory, cannot load the file "+vec[i];
+            return false;
+        }else if(status[i]==Private::LoadSliceRange<DIM,PixelType>::FAIL_DOMAIN){
             std::cerr<<std::string("In MatN::loadFromDirectory, all matrix must have the same domain");
             return false;
         }
-        typename MatN<2,PixelType>::IteratorEDomain it(img.getIteratorEDomain());
-        while(it.next())
-            in1cast.operator ()(it.x()(0),it.x()(1),i)=img(it.x()(0),it.x()(1));;
     }
     return true;
 }
@@ -624,29 +908,11 @@ void MatNInOut::saveFromDirectory(const MatN<DIM,Result> & in1cast,const char *
     std::string file =basefilename;
     std::string ext = extension;
     path = path+"/";
-    Vec2I32 d;
-    d(0)=in1cast.getDomain()(0);
-    d(1)=in1cast.getDomain()(1);
-    MatN<2, Result> plane(d);
-
-    typename MatN<2, Result>::IteratorEDomain it(plane.getIteratorEDomain());
-
-
-    int slice =in1cast.getDomain()(2);
-    for(int i=0;i<slice;i++)
-    {
-        VecN<3,int> x;
-        x(2)=i;
-        it.init();
-        while(it.next()){
-            x(0) = it.x()(0);
-            x(1) = it.x()(1);
-            plane(it.x())=(in1cast )(x(0),x(1),x(2));
-        }
-        std::string str = BasicUtility::IntFixedDigit2String(i,4);
-        std::string fileout = path+"/"+file+str+ext;
-        MatNInOut::save(plane,fileout.c_str());
-    }
+    std::vector<std::string> files(in1cast.getDomain()(2));
+    for(int i=0;i<(int)files.size();i++)
+        files[i] = path+"/"+file+BasicUtility::IntFixedDigit2String(i,4)+ext;
+    Private::SaveSliceRange<DIM,Result> func(files,in1cast);
+    forEachRangeParallel(0,(int)files.size(),func);
 }
 
 }
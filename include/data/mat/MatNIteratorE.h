@@ -213,7 +213,42 @@ protected:
     VecN _x;
     VecN _xprime;
     bool _init;
-
+    //bounding box of the translations and their linear offsets in the domain
+    VecN _tab_min;
+    VecN _tab_max;
+    VecN _stride;
+    std::vector<std::ptrdiff_t> _tab_offset;
+    bool _interior;
+    std::ptrdiff_t _index;
+
+    void initOffset(){
+        _stride(0)=1;
+        if(VecN::DIM>1){
+            _stride(1)=1;
+            _stride(0)=_domain(1);
+            for(int i=2;i<VecN::DIM;i++){
+                if(i==2)
+                    _stride(2)=_domain(1)*_domain(0);
+                else
+                    _stride(i)=_domain(i-1)*_stride(i-1);
+            }
+        }
+        _tab_offset.resize(_tab.size());
+        _tab_min=0;
+        _tab_max=0;
+        for(unsigned int i=0;i<_tab.size();i++){
+            std::ptrdiff_t offset=0;
+            for(int j=0;j<VecN::DIM;j++){
+                offset+=static_cast<std::ptrdiff_t>(_stride(j))*_tab[i](j);
+                if(i==0||_tab[i](j)<_tab_min(j))
+                    _tab_min(j)=_tab[i](j);
+                if(i==0||_tab[i](j)>_tab_max(j))
+                    _tab_max(j)=_tab[i](j);
+            }
+            _tab_offset[i]=offset;
+        }
+        _interior=false;
+    }
 
     void initBall(){
         _tab.clear();
@@ -230,6 +265,7 @@ protected:
                 _tab.push_back(translate);
             }
         }
+        initOffset();
     }
 
 public:
@@ -238,12 +274,13 @@ public:
     int _norm;
     typedef std::pair<VecN,Vec<VecN> > Domain;
 
-    MatNIteratorENeighborhood(){
+    MatNIteratorENeighborhood()
+        :_interior(false){
 
     }
 
     MatNIteratorENeighborhood(const MatNIteratorENeighborhood& it)
-        :_domain(it._domain),_tab(it._tab),_init(true),_isball(it._isball),_radius(it._radius),_norm(it._norm)
+        :_domain(it._domain),_tab(it._tab),_init(true),_tab_min(it._tab_min),_tab_max(it._tab_max),_stride(it._stride),_tab_offset(it._tab_offset),_interior(false),_isball(it._isball),_radius(it._radius),_norm(it._norm)
     {
         _it=_tab.begin();
         _init=true;
@@ -251,11 +288,15 @@ public:
     template<typename IteratorENeighborhood>
     MatNIteratorENeighborhood(const IteratorENeighborhood& it)
         :_domain(it.getDomain().first),_tab(it.getDomain().second),_init(true),_isball(it._isball),_radius(it._radius),_norm(it._norm)
-    {}
+    {
+        initOffset();
+    }
 
 
     MatNIteratorENeighborhood(const VecN &domain,Vec<VecN> v_neighborhood)
-        :_domain(domain),_tab(v_neighborhood),_init(true),_isball(false){}
+        :_domain(domain),_tab(v_neighborhood),_init(true),_isball(false){
+        initOffset();
+    }
 
     MatNIteratorENeighborhood(const VecN &domain,  F32 radius , int norm)
         :_domain(domain),_init(true),_isball(true),_radius(radius),_norm(norm){
@@ -263,7 +304,9 @@ public:
     }
 
     MatNIteratorENeighborhood(const Domain &domain)
-        :  _domain(domain.first),_tab(domain.second),_init(true),_isball(false){}
+        :  _domain(domain.first),_tab(domain.second),_init(true),_isball(false){
+        initOffset();
+    }
 
     Domain getDomain()const
     {
@@ -289,6 +332,7 @@ public:
                 }
             }
             _tab=v_tab;
+            initOffset();
         }else{
             _radius=v_it._radius;
             initBall();
@@ -310,12 +354,21 @@ public:
                 break;
             }
         }
+        initOffset();
     }
     void init(const VecN& x_init)
     {
         _x = x_init;
         _it=_tab.begin();
         _init=true;
+        //when the translated bounding box is inside the domain, the boundary condition is not checked
+        _interior=true;
+        _index=0;
+        for(int i=0;i<VecN::DIM;i++){
+            if(_x(i)+_tab_min(i)<0||_x(i)+_tab_max(i)>=_domain(i))
+                _interior=false;
+            _index+=static_cast<std::ptrdiff_t>(_stride(i))*_x(i);
+        }
     }
     bool next()
     {
@@ -327,6 +380,8 @@ public:
         else
         {
             _xprime= (*_it)+_x;//translation
+            if(_interior==true)
+                return true;
             if(BoundaryCondition::isValid(_domain,_xprime)==true)
             {
                BoundaryCondition::apply(_domain,_xprime);
@@ -354,6 +409,34 @@ public:
     }
     void setDomainMatN(const VecN & domain){
         _domain =domain;
+        initOffset();
+    }
+    const VecN & getDomainMatN()const{
+        return _domain;
+    }
+    /*!
+    \return true if all the translations of the current center (set by init) are inside the domain
+    */
+    bool isInterior()const{
+        return _interior;
+    }
+    /*!
+    \return linear index of the current center (set by init) for the domain stride
+    */
+    std::ptrdiff_t indexCenter()const{
+        return _index;
+    }
+    /*!
+    \return linear offsets of the translations for the domain stride (same order as tab())
+    */
+    const std::vector<std::ptrdiff_t> & tabOffset()const{
+        return _tab_offset;
+    }
+    /*!
+    \return stride of the domain used by the linear offsets
+    */
+    const VecN & strideMatN()const{
+        return _stride;
     }
 
 };
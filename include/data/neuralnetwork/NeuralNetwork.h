@@ -92,12 +92,23 @@ public:
     virtual void forwardCPU(const NeuralLayer& layer_previous) = 0;
     /** @brief Using the CPU device, compute the error of the output values of the layer prrevious. */
     virtual void backwardCPU(NeuralLayer& layer_previous) = 0;
+    /** @brief Using the CPU device, compute the output values of a batch of samples (one sample per row of X_batch). */
+    virtual void forwardBatchCPU(NeuralLayer& layer_previous) = 0;
+    /** @brief Using the CPU device, compute the error of the output values of the layer previous for a batch of samples and accumulate the weight errors over the batch. */
+    virtual void backwardBatchCPU(NeuralLayer& layer_previous) = 0;
+    /** @brief allocate the batch buffers for nbr_sample samples (reused until the batch size changes) */
+    virtual void setBatchSize(unsigned int nbr_sample)=0;
     virtual void learn()=0;
     /** @brief get output value */
     virtual const VecF32& X()const=0;
     virtual VecF32& X()=0;
     /** @brief get the error output value */
     virtual VecF32& d_E_X()=0;
+    /** @brief get output values of the batch (one sample per row) */
+    virtual const Mat2F32& X_batch()const=0;
+    virtual Mat2F32& X_batch()=0;
+    /** @brief get the error output values of the batch (empty if the layer does not back-propagate the batch error) */
+    virtual Mat2F32& d_E_X_batch()=0;
     /** @brief set the layer to be trainable */
     virtual void setTrainable(bool istrainable)=0;
     void setLearnableParameter(F32 mu);
@@ -117,6 +128,7 @@ struct NeuronSigmoid
 
 struct Softmax {
     void softmax(Vec<F32>& x);
+    void softmax(F32* x,unsigned int size);
 };
 
 struct NeuralLayerLinear : public NeuralLayer
@@ -127,12 +139,24 @@ struct NeuralLayerLinear : public NeuralLayer
     VecF32& X();
     const VecF32& X()const;
     VecF32& d_E_X();
+    const Mat2F32& X_batch()const;
+    Mat2F32& X_batch();
+    Mat2F32& d_E_X_batch();
     virtual void setTrainable(bool istrainable);
+    virtual void setBatchSize(unsigned int nbr_sample);
+    /** @brief default batch propagation: the samples go one by one through forwardCPU, the previous layer buffers being used as scratch */
+    virtual void forwardBatchCPU(NeuralLayer& layer_previous);
+    /** @brief default batch back-propagation: the samples go one by one through backwardCPU after restoring their forward state */
+    virtual void backwardBatchCPU(NeuralLayer& layer_previous);
     virtual void print();
     VecF32 __Y;
     VecF32 __X;
     VecF32 _d_E_Y;
     VecF32 _d_E_X;
+    Mat2F32 _Y_batch;
+    Mat2F32 _X_batch;
+    Mat2F32 _d_E_Y_batch;
+    Mat2F32 _d_E_X_batch;
 };
 
 class NeuralLayerMatrix : public NeuralLayerLinear
@@ -162,6 +186,9 @@ public:
     NeuralLayerLinearInput(unsigned int nbr_neurons);
     void forwardCPU(const NeuralLayer& );
     void backwardCPU(NeuralLayer& ) ;
+    void forwardBatchCPU(NeuralLayer& ) ;
+    void backwardBatchCPU(NeuralLayer& ) ;
+    void setBatchSize(unsigned int nbr_sample);
     void learn();
     void setTrainable(bool istrainable);
     virtual NeuralLayer * clone();
@@ -176,6 +203,9 @@ public:
     NeuralLayerMatrixInput(unsigned int sizei,unsigned int sizej,unsigned int nbr_map);
     void forwardCPU(const NeuralLayer& ) ;
     void backwardCPU(NeuralLayer& ) ;
+    void forwardBatchCPU(NeuralLayer& ) ;
+    void backwardBatchCPU(NeuralLayer& ) ;
+    void setBatchSize(unsigned int nbr_sample);
     void learn();
     void setTrainable(bool istrainable);
     virtual NeuralLayer * clone();
@@ -186,10 +216,14 @@ public:
 class NeuralLayerLinearFullyConnected : public NeuronSigmoid,public NeuralLayerLinear
 {
 public:
-    NeuralLayerLinearFullyConnected(unsigned int nbr_neurons_previous,unsigned int nbr_neurons);
+    NeuralLayerLinearFullyConnected(unsigned int nbr_neurons_previous,unsigned int nbr_neurons,bool random_weight=true);
     void setTrainable(bool istrainable);
     virtual void forwardCPU(const NeuralLayer& layer_previous);
     virtual void backwardCPU(NeuralLayer& layer_previous);
+    /** @brief one GEMM per batch: Y_batch = X_batch_previous * W^t + biais */
+    virtual void forwardBatchCPU(NeuralLayer& layer_previous);
+    /** @brief two GEMMs per batch, the weight error being the sum of the sample errors */
+    virtual void backwardBatchCPU(NeuralLayer& layer_previous);
     void learn();
     virtual NeuralLayer * clone();
     virtual void print();
@@ -197,14 +231,21 @@ public:
     Mat2F32 _W;
     VecF32 _X_biais;
     Mat2F32 _d_E_W;
+protected:
+    void _forwardLinear(const NeuralLayer& layer_previous);
+    void _forwardBatchLinear(const NeuralLayer& layer_previous);
+    void _backwardBatchLinear(NeuralLayer& layer_previous);
 };
 
 class NeuralLayerLinearFullyConnectedSoftmax : public NeuralLayerLinearFullyConnected
 {
 public:
-    NeuralLayerLinearFullyConnectedSoftmax(unsigned int nbr_neurons_previous,unsigned int nbr_neurons);
+    NeuralLayerLinearFullyConnectedSoftmax(unsigned int nbr_neurons_previous,unsigned int nbr_neurons,bool random_weight=true);
     virtual void forwardCPU(const NeuralLayer &layer_previous);
     virtual void backwardCPU(NeuralLayer& layer_previous);
+    virtual void forwardBatchCPU(NeuralLayer& layer_previous);
+    virtual void backwardBatchCPU(NeuralLayer& layer_previous);
+    virtual NeuralLayer * clone();
     virtual void print();
     virtual void save(XMLNode& nodechild);
     Softmax _sm;
@@ -216,8 +257,12 @@ public:
     NeuralLayerMatrixConvolutionSubScaling(unsigned int nbr_map,unsigned int sub_scaling_factor,unsigned int radius_kernel,unsigned int sizei_map_previous,unsigned int sizej_map_previous,unsigned int nbr_map_previous);
     void setTrainable(bool istrainable);
 
+    /** @brief convolution lowered to im2col plus a matrix-matrix product */
     virtual void forwardCPU(const NeuralLayer& layer_previous);
+    /** @brief kernel error as d_E_Y * im2col^t and previous error as col2im(W^t * d_E_Y) */
     virtual void backwardCPU(NeuralLayer& layer_previous);
+    virtual void forwardBatchCPU(NeuralLayer& layer_previous);
+    virtual void backwardBatchCPU(NeuralLayer& layer_previous);
     void learn();
     virtual NeuralLayer * clone();
     virtual void print();
@@ -228,6 +273,34 @@ public:
     Vec<F32> _d_E_W_biais;
     unsigned int _sub_resolution_factor;
     unsigned int _radius_kernel;
+    /*!
+     * \brief geometry of the convolution lowered to a matrix product
+     *
+     * The im2col matrix has one row k=(map_previous*size_kernel+i_kernel)*size_kernel+j_kernel per kernel tap and one column p=i*sizej+j
+     * per neuron of a map, col(k,p)=X_previous(map_previous)(i*sub+i_kernel,j*sub+j_kernel) being stored at k*stride_k+p*stride_p.
+     */
+    struct Geometry
+    {
+        int _nbr_map_previous,_sizei_previous,_sizej_previous;
+        int _sizei,_sizej;
+        int _size_kernel,_sub;
+        int sizeP()const{return _sizei*_sizej;}
+        int sizeK()const{return _nbr_map_previous*_size_kernel*_size_kernel;}
+        int sizePrevious()const{return _sizei_previous*_sizej_previous;}
+        void im2col(const F32 * X_previous,F32 * col,int stride_k,int stride_p)const;
+        /*! scatter-add of the im2col matrix (stride_k=sizeP(), stride_p=1) in the maps [map_begin,map_end) of X_previous, set to 0 before */
+        void col2im(const F32 * col,F32 * X_previous,int map_begin,int map_end)const;
+    };
+protected:
+    void _initGeometry(const NeuralLayerMatrix & layer_previous);
+    void _forwardIm2Col(const F32 * X_previous,F32 * Y,F32 * X);
+    void _backwardIm2Col(const F32 * X_previous,const F32 * X,const F32 * d_E_X,F32 * d_E_Y,F32 * d_E_X_previous);
+    void _beginAccumulationError();
+    void _endAccumulationError();
+    Geometry _geometry;
+    Mat2F32 _W_matrix;
+    Mat2F32 _d_E_W_matrix;
+    Mat2F32 _im2col;
 };
 class NeuralLayerMatrixMaxPool : public NeuronSigmoid,public NeuralLayerMatrix
 {
@@ -398,6 +471,31 @@ public:
      *
      */
     void backwardCPU(const VecF32 &X_expected);
+    /*!
+     * \brief propagate front a batch of samples
+     * \param  X_batch input values, one sample per row
+     * \param  Y_batch output values, one sample per row
+     *
+     * Same as forwardCPU(const VecF32&,VecF32&) for nbr_sample=X_batch.sizeI() samples at once. The fully connected layers compute
+     * the batch with one matrix-matrix product instead of one matrix-vector product per sample. The per-layer batch buffers are allocated
+     * at the first call and reused as long as the batch size does not change.
+     * \code
+     * Mat2F32 X_batch(nbr_sample,nbr_input),Y_batch;
+     * //fill X_batch
+     * n.forwardCPU(X_batch,Y_batch);
+     * n.backwardCPU(Y_expected_batch);
+     * n.learn();
+     * \endcode
+     */
+    void forwardCPU(const Mat2F32& X_batch,Mat2F32 & Y_batch);
+    /*!
+     * \brief back propagate the error of a batch of samples
+     * \param  X_expected_batch desired output values, one sample per row
+     *
+     * The weight errors are summed over the samples of the batch propagated by the last call of forwardCPU(const Mat2F32&,Mat2F32&) so
+     * one call of learn updates the weights once per batch (divide the learnable parameter by the batch size to get the mean error).
+     */
+    void backwardCPU(const Mat2F32 &X_expected_batch);
     /*!
      * \brief learn after the accumumation of the error for the weight
      *
@@ -425,7 +523,7 @@ public:
     * \brief load xml file
     * \param file input file
     *
-    * The loader attempts to read the neural network in the given file.
+    * The loader attempts to read the neural network in the given file (xml, or binary saved by saveBinary).
     */
     void load(const char * file);
     /*!
@@ -442,6 +540,35 @@ public:
     *
     */
     void save(const char * file)const;
+    /*!
+    * \brief save binary file
+    * \param file output file
+    * \return false if the file cannot be written
+    *
+    * Compact little-endian format: a header (labels, normalization, layer descriptors) followed by the F32 weights of each layer in
+    * blocks starting at a multiple of 64 bytes. The xml format stays the export format.
+    * \sa loadBinary
+    */
+    bool saveBinary(const char * file)const;
+    /*!
+    * \brief load binary file
+    * \param file input file
+    * \return false if the file is not a binary neural network
+    *
+    * The weight matrices of the fully connected layers are the blocks of the file mapped in memory (see MatN::openMapped): no parsing and
+    * no copy, the pages being read by the operating system on the first access, so the loading of a large model is immediate. The mapping
+    * is read-only, setTrainable(true) copies the weights in memory before the learning. The file must not be modified while the network uses it.
+    * load(const char *) recognizes a binary file and calls this method. The network is unchanged if the header is not the one of a binary
+    * neural network, and empty with the default normalization if the file is truncated or corrupted.
+    * \code
+    * NeuralNet net;
+    * net.load("neuralnetwork.xml");
+    * net.saveBinary("neuralnetwork.popnn");
+    * NeuralNet net_mapped;
+    * net_mapped.loadBinary("neuralnetwork.popnn");
+    * \endcode
+    */
+    bool loadBinary(const char * file);
 
     /*!
     * \brief save xml file
@@ -0,0 +1,142 @@
+#ifndef NEURALNETWORKQUANTIZED_H
+#define NEURALNETWORKQUANTIZED_H
+
+#include <vector>
+#include "data/vec/Vec.h"
+#include "data/neuralnetwork/NeuralNetwork.h"
+
+namespace pop {
+
+class POP_EXPORTS NeuralNetQuantized
+{
+public:
+    /*!
+     * \class pop::NeuralNetQuantized
+     * \ingroup NeuralNetwork
+     * \brief int8 inference copy of a trained NeuralNet
+     * \author Tariel Vincent
+     *
+     * Post-training quantization of a NeuralNet for the inference only:
+     *  - the weights of the fully connected and convolutionnal layers are stored in int8 with one scale per output neuron (fully connected) or per map (convolutionnal),
+     *  - the neuron values between two layers are stored in uint8 (int8 value plus 128) with one scale per layer, calibrated with the maximum absolute value reached on a set of samples,
+     *  - the weighted sums are integer dot products accumulated in int32 (VNNI, AVX2 or SSE2 multiply-add chosen at compilation), the biais staying in float,
+     *  - the sigmoid and the softmax use rational and polynomial approximations instead of tanh and exp.
+     *
+     * The max pool layers compare directly the uint8 values. The output values of the last layer are in float.
+     * \code
+     * NeuralNet net;
+     * net.load("neuralnetwork.xml");
+     * Vec<VecF32> v_calibration;//a few hundred representative inputs
+     * ...
+     * NeuralNetQuantized net_quantized(net,v_calibration);
+     * net_quantized.save("neuralnetwork.q8");
+     * VecF32 vout;
+     * net_quantized.forwardCPU(vin,vout);
+     * \endcode
+     * The saved file keeps the geometry of the layers and a checksum of the float weights, checked against a network by isQuantizationOf.
+     * The checksum is bit exact and the xml file rounds the weights, so quantize the network loaded from the xml file, as above.
+     * The working buffers are members so an object must not be shared by threads (as NeuralNet).
+     */
+
+    /*!
+     * default constructor (empty network)
+     */
+    NeuralNetQuantized();
+    /*!
+     * \brief quantize the network
+     * \param net trained network
+     * \param v_calibration input values of the calibration samples
+     * \sa quantize
+     */
+    NeuralNetQuantized(NeuralNet & net,const Vec<VecF32> & v_calibration);
+    /*!
+     * \brief quantize the network
+     * \param net trained network
+     * \param v_calibration input values of the calibration samples
+     *
+     * The calibration samples are propagated in net to measure the range of the neuron values of each layer (only the neuron values of net are modified).
+     * Without calibration samples, the range of the neuron values of the sigmoid is used.
+     */
+    void quantize(NeuralNet & net,const Vec<VecF32> & v_calibration);
+    /*!
+     * \brief propagate front
+     * \param  X_in input values
+     * \param  X_out output values
+     */
+    void forwardCPU(const VecF32& X_in,VecF32 & X_out);
+    /*!
+     * \param net float network
+     * \return true if the layers have the geometry of the layers of net and the float weights have the checksum of the weights of net
+     */
+    bool isQuantizationOf(const NeuralNet & net)const;
+    /*!
+     * \param net float network
+     * \return FNV-1a hash of the float weights of the fully connected and convolutionnal layers
+     */
+    static UI32 checksum(const NeuralNet & net);
+    /*!
+     * \return true if no network has been quantized or loaded
+     */
+    bool empty()const;
+    /*!
+     * \brief clear the network
+     */
+    void clear();
+    /*!
+    * \brief save the binary file (little-endian)
+    * \param file output file
+    * \return false if the file cannot be written
+    */
+    bool save(const char * file)const;
+    /*!
+    * \brief load the binary file saved by save
+    * \param file input file
+    * \return false if the file cannot be read or is not a quantized network
+    */
+    bool load(const char * file);
+    /*!
+    * \brief print the network structure on the standart output
+    */
+    void print()const;
+
+    enum LayerType{
+        LINEAR_INPUT=0,
+        MATRIX_INPUT=1,
+        FULLY_CONNECTED=2,
+        FULLY_CONNECTED_SOFTMAX=3,
+        MATRIX_CONVOLUTION=4,
+        MATRIX_MAX_POOL=5
+    };
+    struct Layer
+    {
+        I32 _type;
+        //output neurons: nbr_map maps of size sizei*sizej (nbr_map=1, sizei=1 for the linear layers)
+        I32 _nbr_map,_sizei,_sizej;
+        I32 _size_kernel,_sub;
+        //one weight row per output neuron (fully connected) or per map (convolutionnal), padded to a multiple of 16 with zeros
+        I32 _nbr_row,_size_row;
+        //neuron value = scale_X*(code-128)
+        F32 _scale_X;
+        std::vector<I8> _W;
+        std::vector<F32> _scale_W;
+        std::vector<F32> _biais;
+        std::vector<I32> _sum_W;
+        unsigned int sizeX()const{return static_cast<unsigned int>(_nbr_map*_sizei*_sizej);}
+    };
+    const std::vector<Layer> & layers()const;
+private:
+    void _initSumWeight(Layer & layer);
+    static bool _checkLayer(const Layer & layer,const Layer & layer_previous);
+    static void _rowGroup(const Layer & layer,int index_row,const I8 ** w);
+    void _forwardFullyConnected(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,F32 * Y);
+    void _forwardConvolution(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,F32 * Y);
+    void _forwardMaxPool(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,UI8 * code);
+    //checksum of the float weights of the quantized network
+    UI32 _checksum;
+    std::vector<Layer> _v_layer;
+    std::vector<std::vector<UI8> > _v_code;
+    std::vector<UI8> _im2col;
+    std::vector<F32> _Y;
+};
+}
+#endif // NEURALNETWORKQUANTIZED_H
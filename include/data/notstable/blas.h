@@ -63,7 +63,6 @@ struct blas {
 #ifdef HAVE_ACML
     template < int DIM >
     static void scal(float alpha, pop::MatN<DIM, pop::F32>& matY) {
-        std::cout << "use BLAS scal" << std::endl;
         int size = matY.getDomain().multCoordinate();
         scal_(&size, &alpha, &matY[0], &otherMatN::getStrideVector(matY));
     } 
@@ -78,7 +77,6 @@ struct blas {
 #ifdef HAVE_ACML
     template < int DIM >
     static void axpy(float alpha, pop::MatN<DIM, pop::F32> &matX, pop::MatN<DIM, pop::F32> &matY) {
-        std::cout << "use BLAS axpy" << std::endl;
         POP_DbgAssertMessage(matY.rows() == matX.rows() && matY.columns() == matX.columns(), "[ERROR] blas::axpy, matX and matY donot have the same size");
         int length = matY.getDomain().multCoordinate();
         axpy_(&length, &alpha, &matX[0], &otherMatN::getStrideVector(matY), &matY[0], &otherMatN::getStrideVector(matY));
@@ -113,6 +111,11 @@ struct blas {
 
 #ifdef HAVE_ACML
     static void gemv(float alpha, pop::MatN<2, pop::F32> &matA, pop::MatN<2, pop::F32> &vecX, float beta, pop::MatN<2, pop::F32> &vecY);
+#else
+    static void gemv(float alpha, const pop::MatN<2, pop::F32>& matA, const pop::MatN<2, pop::F32>& vecX, float beta, pop::MatN<2, pop::F32>& vecY) {
+        POP_DbgAssertMessage((vecX.sizeI() == 1 || vecX.sizeJ() == 1) && (vecY.sizeI() == 1 || vecY.sizeJ() == 1) && (matA.sizeI() == vecY.size()) && (matA.sizeJ() == vecX.size()), "[ERROR] blas::gemv, vector and matrix sizes are not compatible");
+        pop::GEMM::sgemv('N', matA.sizeI(), matA.sizeJ(), alpha, matA.data(), matA.sizeJ(), vecX.data(), beta, vecY.data());
+    }
 #endif
 
     template<typename PixelType>
@@ -127,6 +130,11 @@ struct blas {
 
 #ifdef HAVE_ACML
     static void gemv(float alpha, pop::MatN<2, pop::F32> &matA, char transA, pop::MatN<2, pop::F32> &vecX, float beta, pop::MatN<2, pop::F32> &vecY);
+#else
+    static void gemv(float alpha, const pop::MatN<2, pop::F32>& matA, char transA, const pop::MatN<2, pop::F32>& vecX, float beta, pop::MatN<2, pop::F32>& vecY) {
+        POP_DbgAssertMessage((vecX.sizeI() == 1 || vecX.sizeJ() == 1) && (vecY.sizeI() == 1 || vecY.sizeJ() == 1), "[ERROR] blas::gemv, vector and matrix sizes are not compatible");
+        pop::GEMM::sgemv(transA, matA.sizeI(), matA.sizeJ(), alpha, matA.data(), matA.sizeJ(), vecX.data(), beta, vecY.data());
+    }
 #endif
 
     // C = aAB + bC
@@ -139,6 +147,12 @@ struct blas {
 
 #ifdef HAVE_ACML
     static void gemm(float alpha, pop::MatN<2, pop::F32> &matA, pop::MatN<2, pop::F32> &matB, float beta, pop::MatN<2, pop::F32> &matC);
+#else
+    // built-in packed kernel when no external BLAS is configured
+    static void gemm(float alpha, const pop::MatN<2, pop::F32>& matA, const pop::MatN<2, pop::F32>& matB, float beta, pop::MatN<2, pop::F32>& matC) {
+        POP_DbgAssertMessage((matA.sizeI() == matC.sizeI()) && (matA.sizeJ() == matB.sizeI()) && (matB.sizeJ() == matC.sizeJ()), "[ERROR] blas::gemm, matrix sizes are not compatible");
+        pop::GEMM::sgemm('N', 'N', matC.sizeI(), matC.sizeJ(), matA.sizeJ(), alpha, matA.data(), matA.sizeJ(), matB.data(), matB.sizeJ(), beta, matC.data(), matC.sizeJ());
+    }
 #endif
 
     template < typename PixelType >
@@ -156,6 +170,12 @@ struct blas {
 
 #ifdef HAVE_ACML
     static void gemm(float alpha, pop::MatN<2, pop::F32> &matA, char transA, pop::MatN<2, pop::F32> &matB, char transB, float beta, pop::MatN<2, pop::F32> &matC);
+#else
+    static void gemm(float alpha, const pop::MatN<2, pop::F32>& matA, char transA, const pop::MatN<2, pop::F32>& matB, char transB, float beta, pop::MatN<2, pop::F32>& matC) {
+        int k = (transA == 'T') ? matA.sizeI() : matA.sizeJ();
+        POP_DbgAssertMessage(k == static_cast<int>((transB == 'T') ? matB.sizeJ() : matB.sizeI()), "[ERROR] blas::gemm, matrix sizes are not compatible");
+        pop::GEMM::sgemm(transA, transB, matC.sizeI(), matC.sizeJ(), k, alpha, matA.data(), matA.sizeJ(), matB.data(), matB.sizeJ(), beta, matC.data(), matC.sizeJ());
+    }
 #endif
 
     // v = x * y
@@ -173,7 +193,6 @@ struct blas {
 #ifdef HAVE_ACML
     template<int DIM >
     static pop::F32 dot(pop::MatN<DIM, pop::F32> &matX, pop::MatN<DIM, pop::F32> &matY) {
-        std::cout << "use BLAS dot" << std::endl;
         int size = matY.getDomain().multCoordinate();
         return dot_(&size, &matY[0], &otherMatN::getStrideVector(matY), &matX[0], &otherMatN::getStrideVector(matX));
     }
@@ -210,6 +229,8 @@ struct testBlas {
     static void test_gemv();
     static void test_gemm();
     static void test_dot();
+    // compare the built-in gemm with the naive triple loop
+    static void bench_gemm();
 };
 
 }
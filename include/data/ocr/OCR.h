@@ -3,6 +3,7 @@
 #include<string>
 #include"data/mat/MatN.h"
 #include"data/neuralnetwork/NeuralNetwork.h"
+#include"data/neuralnetwork/NeuralNetworkQuantized.h"
 namespace pop
 {
 /*! \ingroup Other
@@ -42,6 +43,7 @@ class POP_EXPORTS OCRNeuralNetwork : public OCR
 private:
 
     NeuralNet _n;
+    NeuralNetQuantized _n_quantized;
     int _confidence;
     bool _isrecognized;
 public:
@@ -54,6 +56,25 @@ public:
     int characterConfidence();
     bool setDictionnary(std::string path_dic);
     bool setDictionnaryByteArray(const char * byte_array);
+    /*!
+    \brief quantize the neural network in int8 for the recognition
+    \param v_calibration binary matrices of representative characters
+    *
+    * Once quantized, parseMatrix uses the int8 network. The quantized network is saved next to the xml file with
+    * \code
+    * ocr.setDictionnary("neuralnetwork.xml");
+    * ocr.quantize(v_calibration);
+    * ocr.neuralNetworkQuantized().save(OCRNeuralNetwork::quantizedFile("neuralnetwork.xml").c_str());
+    * \endcode
+    * and loaded by setDictionnary when this file exists and matches the xml file (geometry of the layers and checksum of the weights, see NeuralNetQuantized::isQuantizationOf).
+    !*/
+    void quantize(const Vec<Mat2UI8> & v_calibration);
+    NeuralNetQuantized &   neuralNetworkQuantized();
+    const NeuralNetQuantized &   neuralNetworkQuantized()const;
+    /*!
+    \return file of the quantized network associated to the xml file (extension replaced by .q8)
+    !*/
+    static std::string quantizedFile(std::string xmlfile);
 
 };
 /*!
@@ -95,6 +95,19 @@ typedef unsigned int UI32;
  *
  */
 typedef int I32;
+/*! \typedef UI64
+ * \brief Unsigned Integers of 64 bits (0,1,...,18446744073709551615)
+ * \ingroup BasicType
+ *
+ * * UI64's are mostly used as accumulator, for instance in the integral of a large matrix
+ */
+typedef unsigned long long UI64;
+/*! \typedef I64
+ * \brief Signed Integers of 64 bits (-9223372036854775808,...,9223372036854775807)
+ * \ingroup BasicType
+ *
+ */
+typedef long long I64;
 /*! \typedef F32
  * \brief float type 32 bits
  * \ingroup BasicType
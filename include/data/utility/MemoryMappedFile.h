@@ -0,0 +1,96 @@
+/******************************************************************************\
+|*                   Population library for C++ X.X.X                         *|
+|*----------------------------------------------------------------------------*|
+The Population License is similar to the MIT license in adding this clause:
+for any writing public or private that has resulted from the use of the
+software population, the reference of this book "Population library, 2012,
+Vincent Tariel" shall be included in it.
+
+So, the terms of the Population License are:
+
+Copyright © 2012-2015, Tariel Vincent
+Copyright © 2015, Aublin Pierre Louis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to
+deal in the Software without restriction, including without limitation the
+rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software and for any writing
+public or private that has resulted from the use of the software population,
+the reference of this book "Population library, 2012, Vincent Tariel" shall
+be included in it.
+
+The Software is provided "as is", without warranty of any kind, express or
+implied, including but not limited to the warranties of merchantability,
+fitness for a particular purpose and noninfringement. In no event shall the
+authors or copyright holders be liable for any claim, damages or other
+liability, whether in an action of contract, tort or otherwise, arising
+from, out of or in connection with the software or the use or other dealings
+in the Software.
+\***************************************************************************/
+
+#ifndef MEMORYMAPPEDFILE_H
+#define MEMORYMAPPEDFILE_H
+
+#include<cstddef>
+#include"PopulationConfig.h"
+
+namespace pop
+{
+/*!
+    \class pop::MemoryMappedFile
+    \brief a region of a file mapped in the address space of the process (mmap on Unix, MapViewOfFile on Windows)
+    \author Tariel Vincent
+    \ingroup BasicUtility
+  *
+  * The pages are read by the operating system on the first access, so a region larger than the RAM can be mapped. For a writable mapping,
+  * the modifications are written in the file by the operating system. The region is unmapped by the destructor.
+  * \code
+  * MemoryMappedFile * map = MemoryMappedFile::open("volume.raw",0,1000*1000*1000,true);
+  * if(map!=NULL){
+  *     const unsigned char * data = static_cast<const unsigned char *>(map->data());
+  *     std::cout<<(int)data[0]<<std::endl;
+  *     delete map;
+  * }
+  * \endcode
+*/
+class POP_EXPORTS MemoryMappedFile
+{
+public:
+    /*!
+    * \param file file path
+    * \param offset first byte of the region in the file (any value, the alignment on the pages is done here)
+    * \param length number of bytes of the region
+    * \param read_only true for a read-only mapping, false for a shared writable mapping
+    * \return the mapped region, NULL in case of failure (the file is too small or cannot be opened)
+    */
+    static MemoryMappedFile * open(const char * file,std::size_t offset,std::size_t length,bool read_only);
+    ~MemoryMappedFile();
+    //! \return first byte of the region
+    void * data()const;
+    //! \return number of bytes of the region
+    std::size_t size()const;
+    //! \return true for a read-only mapping
+    bool isReadOnly()const;
+    //! write the modified pages in the file
+    bool flush();
+private:
+    MemoryMappedFile();
+    MemoryMappedFile(const MemoryMappedFile &);
+    MemoryMappedFile & operator=(const MemoryMappedFile &);
+    void * _base;
+    std::size_t _length_base;
+    char * _data;
+    std::size_t _length;
+    bool _read_only;
+#if Pop_OS==2
+    void * _handle_file;
+    void * _handle_mapping;
+#endif
+};
+}
+#endif // MEMORYMAPPEDFILE_H
@@ -42,13 +42,25 @@ struct PopTest
    std::string _name_operator;
    bool _bool_write;
    clock_t _start_time, _end_time;
+   int _nbr_error,_nbr_error_start;
    PopTest(){
        _bool_write =false;
+       _nbr_error =0;
+       _nbr_error_start =0;
    }
    inline void start(std::string name_operator, std::string param=std::string()){
        _name_operator = name_operator;
+       _nbr_error_start = _nbr_error;
        _start_time = clock();
    }
+   //check a condition of the current operator (comparison with a reference or round trip)
+   inline bool check(bool condition, std::string message=std::string()){
+       if(condition==false){
+           std::cout<<"[ERROR]["+ _name_operator +"] "+message<<std::endl;
+           _nbr_error++;
+       }
+       return condition;
+   }
   template<int DIM,typename Type>
    void end(MatN<DIM,Type> out){
        MatN<DIM,Type> out_algo;
@@ -74,6 +86,8 @@ struct PopTest
    }
    inline void end(){
        _end_time = clock();
+       if(_nbr_error!=_nbr_error_start)
+           return;
       std::cout<<"[GOOD]["+ _name_operator +"]  execute in " << (double) (_end_time - _start_time) / CLOCKS_PER_SEC<<std::endl;
    }
 };
@@ -13,6 +13,1827 @@ using namespace pop;
 
 
 
+//matrix filled with a linear congruential generator (the same values on every platform)
+template<int DIM,typename PixelType>
+MatN<DIM,PixelType> testRandomMatrix(const typename MatN<DIM,PixelType>::Domain & domain,int range,unsigned int seed=1){
+    MatN<DIM,PixelType> f(domain);
+    for(unsigned int i=0;i<f.size();i++){
+        seed = seed*1103515245u+12345u;
+        f(i)=static_cast<PixelType>((seed>>8)%range);
+    }
+    return f;
+}
+template<int DIM,typename PixelType>
+F64 testMaxDifference(const MatN<DIM,PixelType> & f,const MatN<DIM,PixelType> & g){
+    if(!(f.getDomain()==g.getDomain()))
+        return NumericLimits<F64>::maximumRange();
+    F64 diff=0;
+    for(unsigned int i=0;i<f.size();i++)
+        diff = std::max(diff,std::abs(static_cast<F64>(f(i))-static_cast<F64>(g(i))));
+    return diff;
+}
+//erosion (minimum) or dilation (maximum) by a direct scan of the neighborhood
+template<int DIM,typename PixelType>
+MatN<DIM,PixelType> testMorphologyReference(const MatN<DIM,PixelType> & f,F32 radius,int norm,bool erosion){
+    MatN<DIM,PixelType> h(f.getDomain());
+    typename MatN<DIM,PixelType>::IteratorEDomain itg(f.getIteratorEDomain());
+    typename MatN<DIM,PixelType>::IteratorENeighborhood itn(f.getIteratorENeighborhood(radius,norm));
+    while(itg.next()){
+        itn.init(itg.x());
+        PixelType value = erosion?NumericLimits<PixelType>::maximumRange():NumericLimits<PixelType>::minimumRange();
+        while(itn.next())
+            value = erosion?std::min(value,f(itn.x())):std::max(value,f(itn.x()));
+        h(itg.x())=value;
+    }
+    return h;
+}
+
+void testMorphologyBox(){
+    pop::PopTest test;
+    test.start("erosionBox");
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(67,45),256);
+    for(int radius=1;radius<=7;radius+=3){
+        test.check(testMaxDifference(Processing::erosion(f2,radius,0),testMorphologyReference(f2,radius,0,true))==0,"2d erosion radius "+BasicUtility::Any2String(radius));
+        test.check(testMaxDifference(Processing::dilation(f2,radius,0),testMorphologyReference(f2,radius,0,false))==0,"2d dilation radius "+BasicUtility::Any2String(radius));
+    }
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(13,17,11),1000);
+    test.check(testMaxDifference(Processing::erosion(f3,2,0),testMorphologyReference(f3,2,0,true))==0,"3d erosion");
+    test.check(testMaxDifference(Processing::dilation(f3,2,0),testMorphologyReference(f3,2,0,false))==0,"3d dilation");
+    //radius larger than the domain
+    test.check(testMaxDifference(Processing::erosion(f2,50,0),testMorphologyReference(f2,50,0,true))==0,"radius larger than the domain");
+    test.end();
+}
+
+//count the calls of each index
+struct TestRangeCount
+{
+    std::vector<int> _count;
+    void operator()(int begin,int end){
+        for(int i=begin;i<end;i++)
+            _count[i]++;
+    }
+};
+//parallel loop inside the chunks of a parallel loop
+struct TestRangeNested
+{
+    std::vector<TestRangeCount> _range;
+    void operator()(int begin,int end){
+        for(int i=begin;i<end;i++)
+            forEachRangeParallel(0,static_cast<int>(_range[i]._count.size()),_range[i]);
+    }
+};
+void testParallelGlobalToLocal(){
+    pop::PopTest test;
+    test.start("forEachGlobalToLocalParallel");
+    TestRangeCount range;
+    range._count.resize(1003,0);
+    setNumberThreadParallel(4);
+    forEachRangeParallel(0,1003,range);
+    test.check(std::count(range._count.begin(),range._count.end(),1)==1003,"each index of the range exactly once");
+    //the workers are reused by the next calls, whatever their number of threads
+    for(int i=0;i<200;i++){
+        setNumberThreadParallel(2+i%7);
+        forEachRangeParallel(0,1003,range);
+    }
+    test.check(std::count(range._count.begin(),range._count.end(),201)==1003,"repeated calls");
+    TestRangeNested nested;
+    nested._range.resize(13);
+    for(unsigned int i=0;i<nested._range.size();i++)
+        nested._range[i]._count.resize(100+i,0);
+    setNumberThreadParallel(4);
+    forEachRangeParallel(0,13,nested);
+    bool nested_once=true;
+    for(unsigned int i=0;i<nested._range.size();i++)
+        nested_once = nested_once&&std::count(nested._range[i]._count.begin(),nested._range[i]._count.end(),1)==static_cast<int>(nested._range[i]._count.size());
+    test.check(nested_once,"nested calls");
+    Mat2F32 f2 = testRandomMatrix<2,F32>(Vec2I32(211,157),1000);
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(31,27,23),1000);
+    setNumberThreadParallel(1);
+    Mat2F32 median_seq = Processing::median(f2,2,2);
+    Mat2F32 mean_seq = Processing::mean(f2,3,2);
+    Mat3F32 erosion_seq = Processing::erosion(f3,2,2);
+    setNumberThreadParallel(4);
+    test.check(testMaxDifference(median_seq,Processing::median(f2,2,2))==0,"2d median");
+    test.check(testMaxDifference(mean_seq,Processing::mean(f2,3,2))==0,"2d mean");
+    test.check(testMaxDifference(erosion_seq,Processing::erosion(f3,2,2))==0,"3d erosion");
+    test.check(testMaxDifference(erosion_seq,testMorphologyReference(f3,2,2,true))==0,"3d erosion reference");
+    setNumberThreadParallel(0);
+    test.end();
+}
+
+//the linear offsets of the interior neighborhoods address the same pixels as the translations
+template<int DIM>
+bool testNeighborhoodOffset(const MatN<DIM,F32> & f,MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> itn){
+    typename MatN<DIM,F32>::IteratorEDomain itg(f.getIteratorEDomain());
+    int nbr_interior=0;
+    while(itg.next()){
+        itn.init(itg.x());
+        unsigned int nbr_inside=0;
+        for(unsigned int i=0;i<itn.tab().size();i++)
+            if(f.isValid(itg.x()+itn.tab()(i)))
+                nbr_inside++;
+        unsigned int nbr_visit=0;
+        while(itn.next()){
+            if(!f.isValid(itn.x())||!(itn.x()==itg.x()+itn.xWithoutTranslation()))
+                return false;
+            nbr_visit++;
+        }
+        if(nbr_visit!=nbr_inside||(itn.isInterior()&&nbr_inside!=itn.tab().size()))
+            return false;
+        if(itn.isInterior()){
+            nbr_interior++;
+            for(unsigned int i=0;i<itn.tab().size();i++)
+                if(f.data()[itn.indexCenter()+itn.tabOffset()[i]]!=f(itg.x()+itn.tab()(i)))
+                    return false;
+        }
+    }
+    return nbr_interior>0;
+}
+void testNeighborhoodIterator(){
+    pop::PopTest test;
+    test.start("MatNIteratorENeighborhood");
+    Mat2F32 f2 = testRandomMatrix<2,F32>(Vec2I32(23,17),1000);
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(9,11,7),1000);
+    MatN<4,F32> f4 = testRandomMatrix<4,F32>(VecN<4,I32>(5,6,7,4),1000);
+    test.check(testNeighborhoodOffset(f2,f2.getIteratorENeighborhood(2,2)),"2d ball");
+    test.check(testNeighborhoodOffset(f3,f3.getIteratorENeighborhood(1,1)),"3d ball");
+    test.check(testNeighborhoodOffset(f4,f4.getIteratorENeighborhood(1,0)),"4d box");
+    Mat2F32::IteratorENeighborhood itn(f2.getIteratorENeighborhood(1,1));
+    itn.removeCenter();
+    test.check(testNeighborhoodOffset(f2,itn),"without center");
+    Mat2F32 structural(3,3);
+    structural(0,0)=1;structural(1,2)=1;structural(2,1)=1;
+    itn = f2.getIteratorENeighborhood(structural,1);
+    Mat2F32::IteratorENeighborhood itn_line(f2.getIteratorENeighborhood(1,1));
+    itn.dilate(itn_line);
+    test.check(testNeighborhoodOffset(f2,itn),"dilated structural element");
+    //mean with the offsets (interior) against the mean with the boundary condition
+    Mat2F32 mean = Processing::mean(f2,2,1);
+    Mat2F32 mean_reference(f2.getDomain());
+    Mat2F32::IteratorEDomain itg(f2.getIteratorEDomain());
+    Mat2F32::IteratorENeighborhood itm(f2.getIteratorENeighborhood(2,1));
+    while(itg.next()){
+        itm.init(itg.x());
+        F64 sum=0;int nbr=0;
+        while(itm.next()){sum+=f2(itm.x());nbr++;}
+        mean_reference(itg.x())=static_cast<F32>(sum/nbr);
+    }
+    test.check(testMaxDifference(mean,mean_reference)<1e-3,"mean");
+    test.end();
+}
+
+void testWatershed(){
+    pop::PopTest test;
+    test.start("watershedHierarchicalQueue");
+    //topography with plateaus (few grey-levels) to test the tie-breaking rule
+    Mat2UI8 topo = Processing::smoothGaussian(testRandomMatrix<2,UI8>(Vec2I32(97,83),256),2);
+    topo = topo/20;
+    Mat2UI32 seed = Processing::minimaRegional(topo,0);
+    Mat2UI8 mask(topo.getDomain());
+    for(unsigned int i=0;i<mask.size();i++)
+        mask(i)=(i%97<80)?255:0;
+    Mat2UI8::IteratorENeighborhood itn(topo.getIteratorENeighborhood(1,1));
+    test.check(testMaxDifference(ProcessingAdvanced::watershed(seed,topo,itn),ProcessingAdvanced::watershed<Mat2UI32,Mat2UI8>(seed,topo,itn))==0,"watershed");
+    test.check(testMaxDifference(ProcessingAdvanced::watershed(seed,topo,mask,itn),ProcessingAdvanced::watershed<Mat2UI32,Mat2UI8,Mat2UI8>(seed,topo,mask,itn))==0,"watershed with mask");
+    test.check(testMaxDifference(ProcessingAdvanced::watershedBoundary(seed,topo,itn),ProcessingAdvanced::watershedBoundary<Mat2UI8,Mat2UI32>(seed,topo,itn))==0,"watershed with boundary");
+    test.check(testMaxDifference(ProcessingAdvanced::watershedBoundary(seed,topo,mask,itn),ProcessingAdvanced::watershedBoundary<Mat2UI8,Mat2UI32,Mat2UI8>(seed,topo,mask,itn))==0,"watershed with boundary and mask");
+    Mat3UI8 topo3 = testRandomMatrix<3,UI8>(Vec3I32(21,19,17),8);
+    Mat3UI32 seed3 = Processing::minimaRegional(topo3,0);
+    Mat3UI8::IteratorENeighborhood itn3(topo3.getIteratorENeighborhood(1,0));
+    test.check(testMaxDifference(ProcessingAdvanced::watershed(seed3,topo3,itn3),ProcessingAdvanced::watershed<Mat3UI32,Mat3UI8>(seed3,topo3,itn3))==0,"3d watershed");
+    //the parallel flooding of the large layers gives the sequential result
+    //checkerboard: the pixels of level 1 are all pushed at the level 0, so the first layer of the level 1 is half of the domain
+    Mat2UI8 topo_large(Vec2I32(400,300));
+    for(unsigned int i=0;i<topo_large.size();i++)
+        topo_large(i)=(i/300+i%300)%2;
+    Mat2UI32 seed_large(topo_large.getDomain());
+    seed_large(10,10)=1;seed_large(200,150)=2;seed_large(390,290)=3;
+    Mat2UI8::IteratorENeighborhood itn_large(topo_large.getIteratorENeighborhood(1,0));
+    setNumberThreadParallel(4);
+    Mat2UI32 water_parallel = ProcessingAdvanced::watershed(seed_large,topo_large,itn_large);
+    Mat2UI32 boundary_parallel = ProcessingAdvanced::watershedBoundary(seed_large,topo_large,itn_large);
+    setNumberThreadParallel(0);
+    test.check(testMaxDifference(water_parallel,ProcessingAdvanced::watershed<Mat2UI32,Mat2UI8>(seed_large,topo_large,itn_large))==0,"parallel layers");
+    test.check(testMaxDifference(boundary_parallel,ProcessingAdvanced::watershedBoundary<Mat2UI8,Mat2UI32>(seed_large,topo_large,itn_large))==0,"parallel layers with boundary");
+    //the labels do not depend on the number of threads
+    Mat2UI8 topo_plateau = testRandomMatrix<2,UI8>(Vec2I32(512,384),4);
+    Mat2UI32 seed_plateau = Processing::minimaRegional(topo_plateau,0);
+    Mat2UI8::IteratorENeighborhood itn_plateau(topo_plateau.getIteratorENeighborhood(1,1));
+    Mat2UI8 mask_plateau(topo_plateau.getDomain());
+    for(unsigned int i=0;i<mask_plateau.size();i++)
+        mask_plateau(i)=(i%512<400)?255:0;
+    setNumberThreadParallel(1);
+    Mat2UI32 water_sequential = ProcessingAdvanced::watershed(seed_plateau,topo_plateau,itn_plateau);
+    Mat2UI32 boundary_sequential = ProcessingAdvanced::watershedBoundary(seed_plateau,topo_plateau,mask_plateau,itn_plateau);
+    test.check(testMaxDifference(boundary_sequential,ProcessingAdvanced::watershedBoundary<Mat2UI8,Mat2UI32,Mat2UI8>(seed_plateau,topo_plateau,mask_plateau,itn_plateau))==0,"sequential with boundary");
+    for(int nbr_thread=2;nbr_thread<=5;nbr_thread++){
+        setNumberThreadParallel(nbr_thread);
+        test.check(testMaxDifference(water_sequential,ProcessingAdvanced::watershed(seed_plateau,topo_plateau,itn_plateau))==0,"number of threads "+BasicUtility::Any2String(nbr_thread));
+        test.check(testMaxDifference(boundary_sequential,ProcessingAdvanced::watershedBoundary(seed_plateau,topo_plateau,mask_plateau,itn_plateau))==0,"number of threads with boundary "+BasicUtility::Any2String(nbr_thread));
+    }
+    setNumberThreadParallel(0);
+#ifndef HAVE_DEBUG
+    //more pixels than the int indexing of MatN: clean failure without any access to the data (assertion in debug)
+    UI8 topo_dummy=0;
+    UI32 seed_dummy=0;
+    Mat3UI8 topo_huge(Vec3I32(2048,2048,2048),&topo_dummy);
+    Mat3UI32 seed_huge(Vec3I32(2048,2048,2048),&seed_dummy);
+    test.check(ProcessingAdvanced::watershed(seed_huge,topo_huge,topo_huge.getIteratorENeighborhood(1,1)).getDomain()==Vec3I32(0,0,0),"size overflow");
+#endif
+    test.end();
+}
+
+//distance to the nearest seed and voronoi label (the label of a seed at distance equal to the minimum) by a direct scan of the seeds
+template<int DIM>
+bool testDistanceEuclidean(const MatN<DIM,UI32> & seed){
+    //position of the seed of each label
+    std::vector<VecN<DIM,I32> > v_seed;
+    std::map<UI32,VecN<DIM,I32> > m_label;
+    typename MatN<DIM,UI32>::IteratorEDomain it(seed.getIteratorEDomain());
+    while(it.next())
+        if(seed(it.x())!=0){
+            v_seed.push_back(it.x());
+            m_label[seed(it.x())]=it.x();
+        }
+    MatN<DIM,F32> dist = ProcessingAdvanced::distanceEuclidean(seed);
+    std::pair<MatN<DIM,UI32>,MatN<DIM,F32> > voronoi = ProcessingAdvanced::voronoiTesselationEuclidean(seed);
+    it.init();
+    while(it.next()){
+        F64 dist_min=NumericLimits<F64>::maximumRange();
+        for(unsigned int i=0;i<v_seed.size();i++)
+            dist_min=std::min(dist_min,std::sqrt(static_cast<F64>((it.x()-v_seed[i]).normPower())));
+        if(std::abs(dist(it.x())-dist_min)>1e-4||std::abs(voronoi.second(it.x())-dist_min)>1e-4)
+            return false;
+        if(m_label.find(voronoi.first(it.x()))==m_label.end())
+            return false;
+        VecN<DIM,I32> x_seed = m_label[voronoi.first(it.x())];
+        if(std::abs(std::sqrt(static_cast<F64>((it.x()-x_seed).normPower()))-dist_min)>1e-4)
+            return false;
+    }
+    return true;
+}
+void testDistanceEuclidean(){
+    pop::PopTest test;
+    test.start("distanceEuclidean");
+    Mat2UI32 seed2(Vec2I32(61,47));
+    Mat3UI32 seed3(Vec3I32(17,13,11));
+    unsigned int random=7;
+    for(UI32 label=1;label<=20;label++){
+        random = random*1103515245u+12345u;
+        seed2((random>>8)%seed2.size())=label;
+        if(label<=8)
+            seed3((random>>12)%seed3.size())=label;
+    }
+    test.check(testDistanceEuclidean(seed2),"2d");
+    test.check(testDistanceEuclidean(seed3),"3d");
+    Mat2UI32 seed_one(Vec2I32(33,1));
+    seed_one(32,0)=1;
+    test.check(testDistanceEuclidean(seed_one),"one line");
+    //squared distances above 2^24: (0,0,0) is at 16811602 from the first seed and 16811601 from the second one
+    Mat3UI32 seed_far(Vec3I32(4101,100,2));
+    seed_far(4099,99,0)=1;
+    seed_far(4100,40,1)=2;
+    std::pair<Mat3UI32,Mat3F32> voronoi_far = ProcessingAdvanced::voronoiTesselationEuclidean(seed_far);
+    test.check(voronoi_far.first(0,0,0)==2,"squared distance above 2^24");
+    test.end();
+}
+
+void testClusterToLabel(){
+    pop::PopTest test;
+    test.start("clusterToLabelUnionFind");
+    setNumberThreadParallel(4);
+    for(int norm=0;norm<=1;norm++){
+        Mat2UI8 bin2 = Processing::threshold(Processing::smoothGaussian(testRandomMatrix<2,UI8>(Vec2I32(301,257),256),1),128);
+        Mat2UI8::IteratorENeighborhood itn2(bin2.getIteratorENeighborhood(1,norm));
+        Mat2UI32 label_reference = ProcessingAdvanced::clusterToLabel<2,Mat2UI8::IteratorEDomain>(bin2,itn2,bin2.getIteratorEDomain());
+        test.check(testMaxDifference(ProcessingAdvanced::clusterToLabel(bin2,itn2,bin2.getIteratorEDomain()),label_reference)==0,"2d norm "+BasicUtility::Any2String(norm));
+        test.check(testMaxDifference(ProcessingAdvanced::clusterToLabel2D(bin2,norm),label_reference)==0,"clusterToLabel2D norm "+BasicUtility::Any2String(norm));
+        test.check(testMaxDifference(ProcessingAdvanced::holeFilling(bin2,itn2),ProcessingAdvanced::holeFilling<Mat2UI8>(bin2,itn2))==0,"holeFilling norm "+BasicUtility::Any2String(norm));
+        test.check(testMaxDifference(ProcessingAdvanced::clusterMax(bin2,itn2),ProcessingAdvanced::clusterMax<Mat2UI8>(bin2,itn2))==0,"clusterMax norm "+BasicUtility::Any2String(norm));
+        Mat3UI8 bin3 = Processing::threshold(testRandomMatrix<3,UI8>(Vec3I32(41,37,33),256),160);
+        Mat3UI8::IteratorENeighborhood itn3(bin3.getIteratorENeighborhood(1,norm));
+        test.check(testMaxDifference(ProcessingAdvanced::clusterToLabel(bin3,itn3,bin3.getIteratorEDomain()),ProcessingAdvanced::clusterToLabel<3,Mat3UI8::IteratorEDomain>(bin3,itn3,bin3.getIteratorEDomain()))==0,"3d norm "+BasicUtility::Any2String(norm));
+    }
+    //larger neighborhood
+    Mat2UI8 bin = Processing::threshold(testRandomMatrix<2,UI8>(Vec2I32(127,131),256),220);
+    Mat2UI8::IteratorENeighborhood itn(bin.getIteratorENeighborhood(2,2));
+    test.check(testMaxDifference(ProcessingAdvanced::clusterToLabel(bin,itn,bin.getIteratorEDomain()),ProcessingAdvanced::clusterToLabel<2,Mat2UI8::IteratorEDomain>(bin,itn,bin.getIteratorEDomain()))==0,"radius 2");
+    setNumberThreadParallel(0);
+    test.end();
+}
+
+template<int DIM,typename PixelType>
+bool testMedianHistogram(const MatN<DIM,PixelType> & f,F32 radius,int norm){
+    typedef typename MatN<DIM,PixelType>::IteratorEDomain IteratorGlobal;
+    typedef MatNIteratorENeighborhood<VecN<DIM,I32>,MatNBoundaryConditionBounded> IteratorLocal;
+    IteratorGlobal itg(f.getIteratorEDomain());
+    IteratorLocal itn(f.getIteratorENeighborhood(radius,norm));
+    MatN<DIM,PixelType> h_histogram = ProcessingAdvanced::median(f,itg,itn);
+    itg.init();
+    MatN<DIM,PixelType> h_reference = ProcessingAdvanced::median<MatN<DIM,PixelType>,IteratorGlobal,IteratorLocal>(f,itg,itn);
+    return testMaxDifference(h_histogram,h_reference)==0;
+}
+void testMedian(){
+    pop::PopTest test;
+    test.start("medianHistogram");
+    Mat2UI8 f8 = testRandomMatrix<2,UI8>(Vec2I32(83,71),256);
+    Mat2UI16 f16 = testRandomMatrix<2,UI16>(Vec2I32(83,71),65536);
+    Mat3UI16 f16_3d = testRandomMatrix<3,UI16>(Vec3I32(19,17,15),4000);
+    for(int norm=0;norm<=2;norm+=2){
+        for(int radius=1;radius<=5;radius+=4){
+            std::string param = "radius "+BasicUtility::Any2String(radius)+" norm "+BasicUtility::Any2String(norm);
+            test.check(testMedianHistogram(f8,radius,norm),"8 bits "+param);
+            test.check(testMedianHistogram(f16,radius,norm),"16 bits "+param);
+        }
+        test.check(testMedianHistogram(f16_3d,2,norm),"3d 16 bits norm "+BasicUtility::Any2String(norm));
+    }
+    //neighborhood larger than the domain
+    test.check(testMedianHistogram(f16,50,2),"radius larger than the domain");
+    test.end();
+}
+
+//sum of f and f^2 in the window [xmin,xmax] clipped to the domain by a direct scan
+template<int DIM,typename PixelType>
+void testBoxSumReference(const MatN<DIM,PixelType> & f,VecN<DIM,I32> xmin,VecN<DIM,I32> xmax,F64 & sum,F64 & sum_power2,int & count){
+    sum=0;sum_power2=0;count=0;
+    typename MatN<DIM,PixelType>::IteratorEDomain it(f.getIteratorEDomain());
+    while(it.next()){
+        bool inside=true;
+        for(int c=0;c<DIM;c++)
+            inside = inside&&it.x()(c)>=xmin(c)&&it.x()(c)<=xmax(c);
+        if(inside){
+            F64 v = static_cast<F64>(f(it.x()));
+            sum+=v;
+            sum_power2+=v*v;
+            count++;
+        }
+    }
+}
+template<int DIM,typename PixelType>
+bool testBoxStatistics(const MatN<DIM,PixelType> & f){
+    ProcessingAdvanced::BoxStatistics<DIM,PixelType> stat(f);
+    MatN<DIM,F64> f_integral(f.getDomain());
+    std::copy(f.begin(),f.end(),f_integral.begin());
+    f_integral = ProcessingAdvanced::integral(f_integral);
+    bool ok=true;
+    unsigned int seed=7;
+    for(int n=0;n<50;n++){
+        VecN<DIM,I32> xmin,xmax;
+        for(int c=0;c<DIM;c++){
+            seed = seed*1103515245u+12345u;
+            xmin(c)=static_cast<I32>((seed>>8)%(f.getDomain()(c)+4))-2;
+            seed = seed*1103515245u+12345u;
+            xmax(c)=xmin(c)+static_cast<I32>((seed>>8)%(f.getDomain()(c)));
+        }
+        F64 sum,sum_power2;
+        int count;
+        testBoxSumReference(f,xmin,xmax,sum,sum_power2,count);
+        ok = ok&&stat.count(xmin,xmax)==count;
+        ok = ok&&std::abs(static_cast<F64>(stat.sum(xmin,xmax))-sum)<=1e-6*(1+std::abs(sum));
+        ok = ok&&std::abs(static_cast<F64>(stat.sumPower2(xmin,xmax))-sum_power2)<=1e-6*(1+sum_power2);
+        if(count>0){
+            F64 mean=sum/count;
+            ok = ok&&std::abs(stat.mean(xmin,xmax)-mean)<=1e-6*(1+std::abs(mean));
+            ok = ok&&std::abs(stat.variance(xmin,xmax)-std::max(sum_power2/count-mean*mean,0.))<=1e-6*(1+sum_power2/count);
+        }
+        //the integral is the sum in the window [0,x]
+        VecN<DIM,I32> x = xmax;
+        for(int c=0;c<DIM;c++)
+            x(c)=std::min(std::max(x(c),0),f.getDomain()(c)-1);
+        testBoxSumReference(f,VecN<DIM,I32>(0),x,sum,sum_power2,count);
+        ok = ok&&std::abs(static_cast<F64>(f_integral(x))-sum)<=1e-4*(1+std::abs(sum));
+    }
+    return ok;
+}
+//the adaptative thresholds with the statistics of the window of the matrix with the mirror border computed by a direct scan
+void testThresholdReference(const Mat2UI8 & f,int radius,F32 k,int method,Mat2UI8 & h){
+    Mat2UI8 fborder(f);
+    Draw::addBorder(fborder,radius,UI8(0),MATN_BOUNDARY_CONDITION_MIRROR);
+    h.resize(f.getDomain());
+    Mat2UI8::IteratorEDomain it(f.getIteratorEDomain());
+    while(it.next()){
+        F64 sum,sum_power2;
+        int count;
+        testBoxSumReference(fborder,it.x(),it.x()+2*radius,sum,sum_power2,count);
+        F64 mean_window = sum/count;
+        F32 mean = static_cast<F32>(mean_window);
+        F32 standartdeviation = static_cast<F32>(std::max(sum_power2/count-mean_window*mean_window,0.));
+        standartdeviation = std::sqrt(standartdeviation);
+        F32 threshold;
+        if(method==0)
+            threshold = mean+k*standartdeviation;
+        else if(method==1)
+            threshold = mean*(1+k*(standartdeviation/128-1));
+        else
+            threshold = mean;
+        h(it.x()) = (f(it.x())>ArithmeticsSaturation<UI8,F32>::Range(threshold))?255:0;
+    }
+}
+struct TestFunctorCopy
+{
+    UI8 operator()(const Mat2UI8 & f,const Mat2UI8::E & x){
+        return f(x);
+    }
+};
+void testBoxStatistics(){
+    pop::PopTest test;
+    test.start("BoxStatistics");
+    test.check(testBoxStatistics(testRandomMatrix<2,UI8>(Vec2I32(37,29),256)),"2d 8 bits");
+    test.check(testBoxStatistics(testRandomMatrix<2,F32>(Vec2I32(23,41),1000)),"2d float");
+    test.check(testBoxStatistics(testRandomMatrix<3,UI16>(Vec3I32(11,9,13),65536)),"3d 16 bits");
+    test.check(testBoxStatistics(testRandomMatrix<1,UI32>(VecN<1,I32>(57),100000)),"1d 32 bits");
+    test.check(testBoxStatistics(testRandomMatrix<4,UI8>(VecN<4,I32>(5,6,4,7),256)),"4d 8 bits");
+    //the mean with a box neighborhood against the generic neighborhood scan
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(67,45),256);
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(13,17,11),1000);
+    for(int radius=1;radius<=6;radius+=5){
+        Mat2UI8::IteratorEDomain itg2(f2.getIteratorEDomain());
+        MatNIteratorENeighborhood<Vec2I32,MatNBoundaryConditionBounded> itn2(f2.getIteratorENeighborhood(radius,0));
+        Mat2UI8 mean_reference2 = ProcessingAdvanced::mean<Mat2UI8,Mat2UI8::IteratorEDomain,MatNIteratorENeighborhood<Vec2I32,MatNBoundaryConditionBounded> >(f2,itg2,itn2);
+        test.check(testMaxDifference(Processing::mean(f2,radius,0),mean_reference2)<=1,"2d mean radius "+BasicUtility::Any2String(radius));
+        Mat3F32::IteratorEDomain itg3(f3.getIteratorEDomain());
+        MatNIteratorENeighborhood<Vec3I32,MatNBoundaryConditionBounded> itn3(f3.getIteratorENeighborhood(radius,0));
+        Mat3F32 mean_reference3 = ProcessingAdvanced::mean<Mat3F32,Mat3F32::IteratorEDomain,MatNIteratorENeighborhood<Vec3I32,MatNBoundaryConditionBounded> >(f3,itg3,itn3);
+        test.check(testMaxDifference(Processing::mean(f3,radius,0),mean_reference3)<=1e-3,"3d mean radius "+BasicUtility::Any2String(radius));
+    }
+    //the adaptative thresholds, the last row and column included
+    Mat2UI8 h;
+    testThresholdReference(f2,4,0.2f,0,h);
+    test.check(testMaxDifference(Processing::thresholdNiblackMethod(f2,0.2f,4),h)==0,"Niblack");
+    testThresholdReference(f2,4,0.5f,1,h);
+    test.check(testMaxDifference(Processing::thresholdSauvolaMethod(f2,0.5f,4),h)==0,"Sauvola");
+    testThresholdReference(f2,4,0,2,h);
+    test.check(testMaxDifference(Processing::thresholdAdaptativeMean(f2,4),h)==0,"adaptative mean");
+    //the IteratorERectangle overload excludes the last row and column of the rectangle
+    Mat2UI8 copy(f2.getDomain());
+    TestFunctorCopy func_copy;
+    forEachFunctorBinaryFunctionE(f2,copy,func_copy,f2.getIteratorERectangle(Vec2I32(2),Vec2I32(10)));
+    test.check(copy(9,9)==f2(9,9)&&copy(10,5)==0&&copy(5,10)==0,"rectangle iterator with the last row and column excluded");
+    forEachFunctorBinaryFunctionE(f2,copy,func_copy,Vec2I32(2),Vec2I32(10));
+    test.check(copy(10,10)==f2(10,10)&&copy(11,5)==0,"rectangle with the last row and column included");
+    test.end();
+}
+
+//the line by line separable convolution against the generic scan of the taps
+template<int DIM,typename PixelType,typename BoundaryCondition>
+bool testConvolutionSeparable(const MatN<DIM,PixelType> & f,const Vec<F32> & kernel,BoundaryCondition condition){
+    bool ok=true;
+    for(int direction=0;direction<DIM;direction++){
+        MatN<DIM,PixelType> h_line = FunctorMatN::convolutionSeperable(f,kernel,direction,f.getIteratorEDomain(),condition);
+        MatN<DIM,PixelType> h_reference = FunctorMatN::convolutionSeperable<DIM,PixelType,F32,typename MatN<DIM,PixelType>::IteratorEDomain,BoundaryCondition>(f,kernel,direction,f.getIteratorEDomain(),condition);
+        ok = ok&&testMaxDifference(h_line,h_reference)==0;
+    }
+    return ok;
+}
+template<int DIM,typename PixelType>
+bool testConvolutionSeparable(const MatN<DIM,PixelType> & f,const Vec<F32> & kernel){
+    return testConvolutionSeparable(f,kernel,MatNBoundaryConditionMirror())
+            &&testConvolutionSeparable(f,kernel,MatNBoundaryConditionPeriodic());
+}
+void testConvolutionSeparable(){
+    pop::PopTest test;
+    test.start("convolutionSeperable");
+    Vec<F32> kernel_small(3);
+    kernel_small(0)=0.25f;kernel_small(1)=0.5f;kernel_small(2)=0.25f;
+    Vec<F32> kernel_derivate(3);
+    kernel_derivate(0)=-1;kernel_derivate(1)=0;kernel_derivate(2)=1;
+    //longer than the vector registers (the generic scan reflects the coordinates once, so the radius stays below the domain size)
+    Vec<F32> kernel_large(23);
+    for(unsigned int k=0;k<kernel_large.size();k++)
+        kernel_large(k)=1.f/(1+k*k);
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(67,45),256);
+    Mat2F32 f2_float = testRandomMatrix<2,F32>(Vec2I32(12,37),1000);
+    Mat3UI16 f3 = testRandomMatrix<3,UI16>(Vec3I32(19,9,21),65536);
+    Mat3F32 f3_float = testRandomMatrix<3,F32>(Vec3I32(12,16,13),1000);
+    test.check(testConvolutionSeparable(f2,kernel_small),"2d 8 bits small kernel");
+    test.check(testConvolutionSeparable(f2,kernel_derivate),"2d 8 bits derivate with the saturation");
+    test.check(testConvolutionSeparable(f2,kernel_large),"2d 8 bits large kernel");
+    test.check(testConvolutionSeparable(f2_float,kernel_derivate),"2d float");
+    test.check(testConvolutionSeparable(f2_float,kernel_large),"2d float large kernel");
+    test.check(testConvolutionSeparable(f3,kernel_small),"3d 16 bits");
+    test.check(testConvolutionSeparable(f3_float,kernel_large),"3d float large kernel");
+    //large enough to share the lines between the threads
+    Mat3UI8 f3_large = testRandomMatrix<3,UI8>(Vec3I32(41,37,29),256);
+    setNumberThreadParallel(1);
+    Mat3UI8 smooth_sequential = Processing::smoothGaussian(f3_large,2);
+    setNumberThreadParallel(4);
+    test.check(testMaxDifference(smooth_sequential,Processing::smoothGaussian(f3_large,2))==0,"smoothGaussian with 1 and 4 threads");
+    test.check(testConvolutionSeparable(f3_large,kernel_small),"3d 8 bits with 4 threads");
+    setNumberThreadParallel(0);
+    //Sobel's gradient of an impulse: the derivative along the direction, the smoothing (1,2,1) along the other one
+    Mat2F32 impulse(Vec2I32(9,9));
+    impulse(4,4)=1;
+    Mat2F32 sobel = Processing::gradientSobel(impulse,0);
+    test.check(sobel(4,3)==0&&sobel(4,5)==0&&sobel(3,4)!=0&&sobel(3,4)==-sobel(5,4),"Sobel derivative along the direction");
+    test.check(std::abs(sobel(3,4)-2*sobel(3,3))<1e-6&&std::abs(sobel(3,3)-sobel(3,5))<1e-6&&sobel(3,6)==0,"Sobel smoothing along the other direction");
+    test.end();
+}
+
+//discrete Fourier transform in F64 by the definition, direction by direction
+template<int DIM>
+MatN<DIM,ComplexF32> testDFTReference(const MatN<DIM,ComplexF32> & f,FFT_WAY way){
+    std::vector<F64> v_real(f.size()),v_img(f.size());
+    for(unsigned int i=0;i<f.size();i++){
+        v_real[i]=f(i).real();
+        v_img[i]=f(i).img();
+    }
+    //pop::PI is a F32
+    const F64 pi = std::acos(-1.);
+    for(int direction=0;direction<DIM;direction++){
+        const int n = f.getDomain()(direction);
+        const int stride = f.stride()(direction);
+        std::vector<F64> v_real_out(v_real.size()),v_img_out(v_img.size());
+        typename MatN<DIM,ComplexF32>::IteratorEDomain it(f.getIteratorEDomain());
+        while(it.next()){
+            int index = VecNIndice<DIM>::VecN2Indice(f.stride(),it.x());
+            int index_line = index-it.x()(direction)*stride;
+            F64 real=0,img=0;
+            for(int j=0;j<n;j++){
+                F64 angle = -way*2*pi*static_cast<F64>(j)*it.x()(direction)/n;
+                real+= v_real[index_line+j*stride]*std::cos(angle)-v_img[index_line+j*stride]*std::sin(angle);
+                img += v_real[index_line+j*stride]*std::sin(angle)+v_img[index_line+j*stride]*std::cos(angle);
+            }
+            v_real_out[index]=real;
+            v_img_out[index]=img;
+        }
+        v_real.swap(v_real_out);
+        v_img.swap(v_img_out);
+    }
+    MatN<DIM,ComplexF32> h(f.getDomain());
+    for(unsigned int i=0;i<h.size();i++)
+        h(i)=ComplexF32(static_cast<F32>(v_real[i]),static_cast<F32>(v_img[i]));
+    return h;
+}
+//maximum of the complex modulus of the difference relative to the maximum modulus of g
+template<int DIM>
+F64 testRelativeDifference(const MatN<DIM,ComplexF32> & f,const MatN<DIM,ComplexF32> & g){
+    if(!(f.getDomain()==g.getDomain()))
+        return NumericLimits<F64>::maximumRange();
+    F64 diff=0,norm=1e-30;
+    for(unsigned int i=0;i<f.size();i++){
+        F64 dr = f(i).real()-g(i).real(),di = f(i).img()-g(i).img();
+        diff = std::max(diff,std::sqrt(dr*dr+di*di));
+        norm = std::max(norm,std::sqrt(static_cast<F64>(g(i).real())*g(i).real()+static_cast<F64>(g(i).img())*g(i).img()));
+    }
+    return diff/norm;
+}
+template<int DIM>
+MatN<DIM,ComplexF32> testRandomComplex(const VecN<DIM,I32> & domain,unsigned int seed){
+    MatN<DIM,F32> real = testRandomMatrix<DIM,F32>(domain,1000,seed);
+    MatN<DIM,F32> img = testRandomMatrix<DIM,F32>(domain,1000,seed+1);
+    MatN<DIM,ComplexF32> f(domain);
+    for(unsigned int i=0;i<f.size();i++)
+        f(i)=ComplexF32(real(i)-500,img(i)-500);
+    return f;
+}
+void testFFT(){
+    pop::PopTest test;
+    test.start("FFT");
+    //powers of 2 and 4, the radices 3, 5 and 7, and the prime sizes done by Bluestein
+    int sizes[]={1,2,3,4,5,6,7,8,12,30,49,60,11,13,97,128,210};
+    for(unsigned int s=0;s<sizeof(sizes)/sizeof(int);s++){
+        MatN<1,ComplexF32> f = testRandomComplex<1>(VecN<1,I32>(sizes[s]),s);
+        MatN<1,ComplexF32> fft = Representation::FFT(f,FFT_FORWARD);
+        test.check(testRelativeDifference(fft,testDFTReference(f,FFT_FORWARD))<1e-5,"1d forward size "+BasicUtility::Any2String(sizes[s]));
+        test.check(testRelativeDifference(Representation::FFT(f,FFT_BACKWARD),testDFTReference(f,FFT_BACKWARD))<1e-5,"1d backward size "+BasicUtility::Any2String(sizes[s]));
+        MatN<1,ComplexF32> round_trip = Representation::FFT(fft,FFT_BACKWARD);
+        for(unsigned int i=0;i<round_trip.size();i++)
+            round_trip(i)=round_trip(i)*(1.f/sizes[s]);
+        test.check(testRelativeDifference(round_trip,f)<1e-5,"1d round trip size "+BasicUtility::Any2String(sizes[s]));
+    }
+    Mat2ComplexF32 f2 = testRandomComplex<2>(Vec2I32(12,35),7);
+    test.check(testRelativeDifference(Representation::FFT(f2,FFT_FORWARD),testDFTReference(f2,FFT_FORWARD))<1e-5,"2d forward");
+    //a domain with different sizes in each direction for the 3d indexing
+    Mat3ComplexF32 f3 = testRandomComplex<3>(Vec3I32(6,10,7),9);
+    test.check(testRelativeDifference(Representation::FFT(f3,FFT_FORWARD),testDFTReference(f3,FFT_FORWARD))<1e-5,"3d forward");
+    MatN<4,ComplexF32> f4 = testRandomComplex<4>(VecN<4,I32>(3,5,4,2),11);
+    test.check(testRelativeDifference(Representation::FFTMultiDimension(f4,FFT_FORWARD),testDFTReference(f4,FFT_FORWARD))<1e-5,"4d forward");
+    //the real transforms with an odd number of lines and odd sizes, against the complex transform
+    Mat3F32 real3 = testRandomMatrix<3,F32>(Vec3I32(5,9,3),1000);
+    Mat3ComplexF32 real3_complex(real3.getDomain());
+    for(unsigned int i=0;i<real3.size();i++)
+        real3_complex(i)=ComplexF32(real3(i),0);
+    Mat3ComplexF32 fft_real3 = Representation::FFTRealToComplex(real3);
+    test.check(testRelativeDifference(fft_real3,testDFTReference(real3_complex,FFT_FORWARD))<1e-5,"3d real to complex");
+    Mat3F32 real3_round_trip = Representation::FFTComplexToReal(fft_real3);
+    F64 diff=0;
+    for(unsigned int i=0;i<real3.size();i++)
+        diff = std::max(diff,std::abs(real3_round_trip(i)/real3.size()-static_cast<F64>(real3(i))));
+    test.check(diff<1e-2,"3d real round trip");
+    //large enough to share the lines between the threads
+    Mat2ComplexF32 f_large = testRandomComplex<2>(Vec2I32(150,105),13);
+    setNumberThreadParallel(1);
+    Mat2ComplexF32 fft_sequential = Representation::FFT(f_large,FFT_FORWARD);
+    setNumberThreadParallel(4);
+    test.check(testRelativeDifference(Representation::FFT(f_large,FFT_FORWARD),fft_sequential)==0,"2d with 1 and 4 threads");
+    setNumberThreadParallel(0);
+    test.end();
+}
+
+//maximum of the absolute difference relative to the maximum absolute value of g
+template<int DIM>
+F64 testRelativeDifference(const MatN<DIM,F32> & f,const MatN<DIM,F32> & g){
+    F64 norm=1e-30;
+    for(unsigned int i=0;i<g.size();i++)
+        norm = std::max(norm,std::abs(static_cast<F64>(g(i))));
+    return testMaxDifference(f,g)/norm;
+}
+template<int DIM,typename BoundaryCondition>
+bool testConvolutionByFFT(const MatN<DIM,F32> & f,const MatN<DIM,F32> & kernel,BoundaryCondition condition){
+    typename MatN<DIM,F32>::IteratorEDomain itg(f.getIteratorEDomain());
+    MatN<DIM,F32> h_direct = FunctorMatN::convolution(f,kernel,itg,condition);
+    //a single block, then small blocks to have many overlap-save tiles
+    return testRelativeDifference(Representation::convolutionByFFT(f,kernel,condition),h_direct)<1e-5
+            &&testRelativeDifference(Representation::convolutionByFFT(f,kernel,condition,1<<9),h_direct)<1e-5;
+}
+template<int DIM>
+bool testConvolutionByFFT(const MatN<DIM,F32> & f,const MatN<DIM,F32> & kernel){
+    return testConvolutionByFFT(f,kernel,MatNBoundaryConditionMirror())
+            &&testConvolutionByFFT(f,kernel,MatNBoundaryConditionPeriodic())
+            &&testConvolutionByFFT(f,kernel,MatNBoundaryConditionBounded());
+}
+//normalized cross-correlation by a direct scan of the window
+template<int DIM>
+MatN<DIM,F32> testNCCReference(const MatN<DIM,UI8> & f,const MatN<DIM,UI8> & pattern){
+    MatN<DIM,F32> h(f.getDomain());
+    const int nbr = pattern.getDomain().multCoordinate();
+    F64 mean_pattern=0;
+    for(int i=0;i<nbr;i++)
+        mean_pattern+=pattern(i);
+    mean_pattern/=nbr;
+    typename MatN<DIM,F32>::IteratorEDomain it(h.getIteratorEDomain());
+    while(it.next()){
+        VecN<DIM,I32> xmin = it.x()-pattern.getDomain()/2;
+        if(!(xmin.allSuperiorEqual(0)&&(xmin+pattern.getDomain()).allInferior(f.getDomain()+1)))
+            continue;
+        typename MatN<DIM,UI8>::IteratorEDomain itp(pattern.getIteratorEDomain());
+        F64 mean_window=0;
+        while(itp.next())
+            mean_window+=f(xmin+itp.x());
+        mean_window/=nbr;
+        F64 numerator=0,norm_window=0,norm_pattern=0;
+        itp.init();
+        while(itp.next()){
+            F64 a = f(xmin+itp.x())-mean_window,b = pattern(itp.x())-mean_pattern;
+            numerator+=a*b;
+            norm_window+=a*a;
+            norm_pattern+=b*b;
+        }
+        if(norm_window>0&&norm_pattern>0)
+            h(it.x())=static_cast<F32>(numerator/std::sqrt(norm_window*norm_pattern));
+    }
+    return h;
+}
+void testConvolutionFFT(){
+    pop::PopTest test;
+    test.start("convolutionByFFT");
+    Mat2F32 f2 = testRandomMatrix<2,F32>(Vec2I32(61,47),256);
+    //even and odd sizes for the center of the kernel
+    Mat2F32 kernel2 = testRandomMatrix<2,F32>(Vec2I32(7,4),100,3);
+    test.check(testConvolutionByFFT(f2,kernel2),"2d");
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(17,13,19),256);
+    Mat3F32 kernel3 = testRandomMatrix<3,F32>(Vec3I32(5,3,6),100,5);
+    test.check(testConvolutionByFFT(f3,kernel3),"3d");
+    //the dispatch of Processing::convolution to the FFT for a large kernel
+    Mat2UI8 f2_8bits = testRandomMatrix<2,UI8>(Vec2I32(97,83),256);
+    Mat2F32 kernel_large(Vec2I32(31,31));
+    kernel_large = 1.f/kernel_large.size();
+    Mat2UI8::IteratorEDomain itg(f2_8bits.getIteratorEDomain());
+    test.check(testMaxDifference(Processing::convolution(f2_8bits,kernel_large,MatNBoundaryConditionMirror()),FunctorMatN::convolution(f2_8bits,kernel_large,itg,MatNBoundaryConditionMirror()))<=1,"31x31 kernel");
+    //the normalized cross-correlation, the score 1 at the position of the pattern
+    Mat2UI8 image = testRandomMatrix<2,UI8>(Vec2I32(53,61),256);
+    Mat2UI8 pattern = image(Vec2I32(20,30),Vec2I32(29,37));
+    Mat2F32 score = Feature::templateMatchingNCC(image,pattern);
+    test.check(testMaxDifference(score,testNCCReference(image,pattern))<1e-4,"NCC against the direct scan");
+    test.check(std::abs(score(Vec2I32(20,30)+pattern.getDomain()/2)-1)<1e-4,"NCC score 1 at the pattern position");
+    test.end();
+}
+
+void testMatNMapped(){
+    pop::PopTest test;
+    test.start("openMapped");
+    std::string file_raw = "testmapped.raw";
+    std::string file_pgm = "testmapped.pgm";
+    Mat3UI16 f3 = testRandomMatrix<3,UI16>(Vec3I32(23,17,11),65536);
+    f3.saveRaw(file_raw.c_str());
+    {
+        Mat3UI16 mapped;
+        test.check(mapped.openMapped(file_raw.c_str(),f3.getDomain())&&mapped.isMapped(),"open raw");
+        test.check(testMaxDifference(mapped,f3)==0,"raw voxels");
+        //the copy is an usual matrix and the algorithms copying their input do not write in the file
+        Mat3UI16 copy(mapped);
+        test.check(copy.isMapped()==false&&testMaxDifference(copy,f3)==0,"copy of a mapped matrix");
+        test.check(testMaxDifference(Processing::erosion(mapped,1,0),Processing::erosion(f3,1,0))==0,"algorithm on a mapped matrix");
+        //the slab of the last 5 planes with the offset
+        Mat3UI16 slab;
+        test.check(slab.openMapped(file_raw.c_str(),Vec3I32(23,17,5),true,sizeof(UI16)*23*17*6),"open slab with an offset not aligned on the page size");
+        test.check(testMaxDifference(slab,f3(Vec3I32(0,0,6),Vec3I32(23,17,11)))==0,"slab voxels");
+        test.check(slab.openMapped(file_raw.c_str(),Vec3I32(23,17,12))==false,"refuse a domain larger than the file");
+    }
+    {
+        //the assignment to a writable mapped matrix writes in the file
+        Mat3UI16 mapped;
+        mapped.openMapped(file_raw.c_str(),f3.getDomain(),false);
+        Mat3UI16 f3_new = testRandomMatrix<3,UI16>(f3.getDomain(),65536,5);
+        mapped = f3_new;
+        test.check(mapped.isMapped(),"writable mapping kept by the assignment");
+        mapped.clear();
+        Mat3UI16 reload;
+        reload.loadRaw(file_raw.c_str(),f3.getDomain());
+        test.check(testMaxDifference(reload,f3_new)==0,"assignment written in the file");
+    }
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(37,29),256);
+    f2.save(file_pgm.c_str());
+    {
+        Mat2UI8 mapped;
+        test.check(mapped.openMapped(file_pgm.c_str())&&mapped.getDomain()==f2.getDomain(),"open binary pgm");
+        test.check(testMaxDifference(mapped,f2)==0,"pgm pixels");
+    }
+    std::remove(file_raw.c_str());
+    std::remove(file_pgm.c_str());
+    test.end();
+}
+
+//region [xmin,xmax) of f
+template<int DIM,typename PixelType>
+MatN<DIM,PixelType> testCrop(const MatN<DIM,PixelType> & f,const VecN<DIM,I32> & xmin,const VecN<DIM,I32> & xmax){
+    MatN<DIM,PixelType> h(xmax-xmin);
+    typename MatN<DIM,PixelType>::IteratorEDomain it(h.getIteratorEDomain());
+    while(it.next())
+        h(it.x())=f(it.x()+xmin);
+    return h;
+}
+template<int DIM,typename PixelType>
+bool testMatNChunked(const MatN<DIM,PixelType> & f,const VecN<DIM,I32> & brick,MatNChunkedCompression compression){
+    const char * file = "testchunked.chk";
+    bool ok = MatNChunked<DIM,PixelType>::save(file,f,brick,compression);
+    MatNChunked<DIM,PixelType> chunked;
+    ok = ok&&chunked.open(file,false);
+    ok = ok&&chunked.getCompression()==compression&&chunked.getDomain()==f.getDomain();
+    ok = ok&&testMaxDifference(chunked.load(),f)==0;
+    //regions across the bricks with a cache of 2 bricks
+    chunked.setCacheSize(2);
+    MatN<DIM,PixelType> g(f);
+    unsigned int seed=3;
+    for(int n=0;n<10;n++){
+        VecN<DIM,I32> xmin,xmax;
+        for(int c=0;c<DIM;c++){
+            seed = seed*1103515245u+12345u;
+            xmin(c)=static_cast<I32>((seed>>8)%f.getDomain()(c));
+            seed = seed*1103515245u+12345u;
+            xmax(c)=xmin(c)+1+static_cast<I32>((seed>>8)%(f.getDomain()(c)-xmin(c)));
+        }
+        ok = ok&&testMaxDifference(chunked.read(xmin,xmax),testCrop(g,xmin,xmax))==0;
+        MatN<DIM,PixelType> region = testRandomMatrix<DIM,PixelType>(xmax-xmin,NumericLimits<PixelType>::maximumRange(),seed);
+        chunked.write(region,xmin);
+        typename MatN<DIM,PixelType>::IteratorEDomain it(region.getIteratorEDomain());
+        while(it.next())
+            g(it.x()+xmin)=region(it.x());
+    }
+    chunked.close();
+    ok = ok&&chunked.open(file)&&testMaxDifference(chunked.load(),g)==0;
+    chunked.close();
+    std::remove(file);
+    return ok;
+}
+struct TestFunctorErosion
+{
+    Mat3UI8 operator()(const Mat3UI8 & f)const{
+        return Processing::erosion(f,2,2);
+    }
+};
+void testMatNChunked(){
+    pop::PopTest test;
+    test.start("MatNChunked");
+    //domains not multiple of the bricks
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(45,38),256);
+    Mat3UI16 f3 = testRandomMatrix<3,UI16>(Vec3I32(21,17,13),65536);
+    MatN<4,F32> f4 = testRandomMatrix<4,F32>(VecN<4,I32>(10,9,8,7),1000);
+    for(int compression=MATN_CHUNKED_RAW;compression<=MATN_CHUNKED_LZ;compression++){
+        std::string name = compression==MATN_CHUNKED_RAW?" raw":(compression==MATN_CHUNKED_DEFLATE?" deflate":" lz");
+        test.check(testMatNChunked(f2,Vec2I32(16,8),static_cast<MatNChunkedCompression>(compression)),"2d"+name);
+        test.check(testMatNChunked(f3,Vec3I32(8,5,4),static_cast<MatNChunkedCompression>(compression)),"3d"+name);
+        //a different number of bricks in each direction for the brick index
+        test.check(testMatNChunked(f4,VecN<4,I32>(4,4,3,2),static_cast<MatNChunkedCompression>(compression)),"4d"+name);
+    }
+    //the erosion tile by tile with a halo equal to the radius against the erosion in memory
+    Mat3UI8 f3_8bits = testRandomMatrix<3,UI8>(Vec3I32(30,27,25),256);
+    MatNChunked<3,UI8>::save("testchunked_in.chk",f3_8bits,Vec3I32(8));
+    MatNChunked<3,UI8> in,out;
+    in.open("testchunked_in.chk");
+    out.create("testchunked_out.chk",in.getDomain(),Vec3I32(7,9,10));
+    MatNChunked<3,UI8>::forEachTile(in,out,TestFunctorErosion(),2);
+    test.check(testMaxDifference(out.load(),Processing::erosion(f3_8bits,2,2))==0,"erosion tile by tile");
+    //a file opened in read-only mode refuses the writing
+    test.check(in.write(Mat3UI8(Vec3I32(2),255),Vec3I32(0))==false,"write refused in read-only mode");
+    test.check(MatNChunked<3,UI8>::forEachTile(out,in,TestFunctorErosion(),2)==false,"tiles refused in read-only mode");
+    test.check(testMaxDifference(in.load(),f3_8bits)==0,"read-only file unchanged");
+    in.close();
+    out.close();
+    std::remove("testchunked_in.chk");
+    std::remove("testchunked_out.chk");
+    test.end();
+}
+
+void testMatNDirectory(){
+    pop::PopTest test;
+    test.start("loadFromDirectory");
+    std::string dir = "testdirectory";
+    BasicUtility::makeDirectory(dir);
+    Mat3UI8 f = testRandomMatrix<3,UI8>(Vec3I32(37,29,23),256);
+    for(int nbr_thread=1;nbr_thread<=4;nbr_thread+=3){
+        setNumberThreadParallel(nbr_thread);
+        std::string thread = " with "+BasicUtility::Any2String(nbr_thread)+" threads";
+        f.saveFromDirectory(dir.c_str(),"slice",".pgm");
+        Mat3UI8 g;
+        test.check(MatNInOut::loadFromDirectory(g,dir.c_str(),"slice","pgm")&&testMaxDifference(g,f)==0,"pgm round trip"+thread);
+        f.saveFromDirectory(dir.c_str(),"slice",".png");
+        test.check(MatNInOut::loadFromDirectory(g,dir.c_str(),"slice",".png")&&testMaxDifference(g,f)==0,"png round trip"+thread);
+    }
+    setNumberThreadParallel(0);
+    //a slice with another domain
+    Mat2UI8 slice(Vec2I32(10,10));
+    slice.save((dir+"/slice9999.pgm").c_str());
+    Mat3UI8 g;
+    test.check(MatNInOut::loadFromDirectory(g,dir.c_str(),"slice","pgm")==false,"slices with different domains refused");
+    //the slice files, then the empty directory
+    std::vector<std::string> files = BasicUtility::getFilesInDirectory(dir);
+    for(unsigned int i=0;i<files.size();i++)
+        std::remove((dir+"/"+files[i]).c_str());
+    test.check(std::remove(dir.c_str())==0,"directory removed");
+    test.end();
+}
+
+bool testCompressionLZ(const std::vector<unsigned char> & data){
+    std::vector<unsigned char> compressed(Compression::boundLZ(data.size())+1);
+    std::size_t size = Compression::compressLZ(data.empty()?NULL:&data[0],data.size(),&compressed[0]);
+    if(size>Compression::boundLZ(data.size()))
+        return false;
+    std::vector<unsigned char> decompressed(data.size()+1);
+    if(Compression::decompressLZ(&compressed[0],size,&decompressed[0],data.size())==false)
+        return false;
+    if(std::equal(data.begin(),data.end(),decompressed.begin())==false)
+        return false;
+    //a wrong decompressed size or a truncated input is detected
+    if(data.size()>0&&Compression::decompressLZ(&compressed[0],size,&decompressed[0],data.size()+1)==true)
+        return false;
+    if(data.size()>0&&Compression::decompressLZ(&compressed[0],size-1,&decompressed[0],data.size())==true)
+        return false;
+    return true;
+}
+template<int DIM,typename PixelType>
+bool testPopFormat(const MatN<DIM,PixelType> & f){
+    const char * file = "testformat.pop";
+    f.save(file);
+    MatN<DIM,PixelType> g;
+    bool ok = g.load(file)&&testMaxDifference(g,f)==0;
+    std::remove(file);
+    return ok;
+}
+void testCompression(){
+    pop::PopTest test;
+    test.start("Compression");
+    //incompressible, constant, periodic with overlapping matches, and runs longer than the 64 KB window
+    std::vector<unsigned char> v_random(100000),v_zero(70000,0),v_period(30000),v_runs(200000);
+    unsigned int seed=1;
+    for(unsigned int i=0;i<v_random.size();i++){
+        seed = seed*1103515245u+12345u;
+        v_random[i]=static_cast<unsigned char>(seed>>16);
+    }
+    for(unsigned int i=0;i<v_period.size();i++)
+        v_period[i]=static_cast<unsigned char>("abcdefg"[i%((i/10000)*3+1)]);
+    for(unsigned int i=0;i<v_runs.size();i++)
+        v_runs[i]=static_cast<unsigned char>((i/90000)*7+((i%1000)==0));
+    test.check(testCompressionLZ(v_random),"random bytes");
+    test.check(testCompressionLZ(v_zero),"zeros");
+    test.check(testCompressionLZ(v_period),"periods 1, 4 and 7");
+    test.check(testCompressionLZ(v_runs),"long runs");
+    bool ok_small=true;
+    for(int size=0;size<=20;size++)
+        ok_small = ok_small&&testCompressionLZ(std::vector<unsigned char>(v_random.begin(),v_random.begin()+size));
+    test.check(ok_small,"sizes 0 to 20");
+    //the byte-plane filter with trailing bytes
+    bool ok_filter=true;
+    for(int element_size=1;element_size<=8;element_size*=2){
+        for(int delta=0;delta<=1;delta++){
+            std::vector<unsigned char> filtered(1003),unfiltered(1003);
+            Compression::filterShuffle(&v_random[0],1003,element_size,delta==1,&filtered[0]);
+            Compression::unfilterShuffle(&filtered[0],1003,element_size,delta==1,&unfiltered[0]);
+            ok_filter = ok_filter&&std::equal(unfiltered.begin(),unfiltered.end(),v_random.begin());
+        }
+    }
+    test.check(ok_filter,"shuffle filter round trip");
+    //the pop format with several blocks of 1 MB
+    test.check(testPopFormat(testRandomMatrix<2,UI8>(Vec2I32(45,38),256)),"pop 2d 8 bits");
+    test.check(testPopFormat(testRandomMatrix<3,UI16>(Vec3I32(21,17,13),65536)),"pop 3d 16 bits");
+    test.check(testPopFormat(testRandomMatrix<3,F32>(Vec3I32(71,67,65),1000)),"pop 3d float several blocks");
+    test.check(testPopFormat(testRandomMatrix<2,F64>(Vec2I32(11,9),1000)),"pop 2d double");
+    Mat3UI32 label = testRandomMatrix<3,UI32>(Vec3I32(80,75,70),10);
+    label = Processing::clusterToLabel(Processing::threshold(Processing::smoothGaussian(Mat3UI8(label*25),2),120),0);
+    test.check(testPopFormat(label),"pop labels");
+    Mat2RGBUI8 rgb(Vec2I32(31,27));
+    for(unsigned int i=0;i<rgb.size();i++)
+        rgb(i)=RGBUI8(i%256,(i*7)%256,(i*13)%256);
+    const char * file = "testformat.pop";
+    rgb.save(file);
+    Mat2RGBUI8 rgb_load;
+    test.check(rgb_load.load(file)&&rgb_load==rgb,"pop color");
+    //another pixel type and a truncated file are refused
+    Mat2UI16 other_type;
+    test.check(other_type.load(file)==false,"pixel type checked");
+    std::ifstream in(file,std::ios::binary);
+    std::vector<char> content((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(file,std::ios::binary);
+    out.write(&content[0],content.size()/2);
+    out.close();
+    test.check(rgb_load.load(file)==false,"truncated file");
+    std::remove(file);
+    test.end();
+}
+
+//sampling positions of GeometricalTransformation::scale for the nearest and bilinear interpolations
+std::vector<F32> testScalePositions(int size_out,F32 alpha){
+    std::vector<F32> x(size_out);
+    F32 x_f =-0.4999f;
+    for(int i=0;i<size_out;i++,x_f+=alpha)
+        x[i]=x_f;
+    return x;
+}
+void testResample(){
+    pop::PopTest test;
+    test.start("GeometricalTransformation::scale");
+    Mat2F32 f = testRandomMatrix<2,F32>(Vec2I32(37,29),1000);
+    Vec2F32 s(1.7f,0.6f);
+    Mat2F32 h_nearest = GeometricalTransformation::scale(f,s,MATN_INTERPOLATION_NEAREST);
+    Mat2F32 h_bilinear= GeometricalTransformation::scale(f,s,MATN_INTERPOLATION_BILINEAR);
+    std::vector<F32> x0 = testScalePositions(h_nearest.getDomain()(0),1.f/s(0));
+    std::vector<F32> x1 = testScalePositions(h_nearest.getDomain()(1),1.f/s(1));
+    Mat2F32 r_nearest(h_nearest.getDomain()),r_bilinear(h_nearest.getDomain());
+    for(int i=0;i<h_nearest.getDomain()(0);i++){
+        for(int j=0;j<h_nearest.getDomain()(1);j++){
+            Vec2F32 x(x0[i],x1[j]);
+            r_nearest(i,j)=f(Vec2I32(std::min(std::max(static_cast<int>(pop::round(x(0))),0),f.getDomain()(0)-1),std::min(std::max(static_cast<int>(pop::round(x(1))),0),f.getDomain()(1)-1)));
+            r_bilinear(i,j)=MatNInterpolationBiliniear::apply(f,x);
+        }
+    }
+    test.check(testMaxDifference(h_nearest,r_nearest)==0,"nearest vs the pointwise sampling");
+    test.check(testMaxDifference(h_bilinear,r_bilinear)<1e-3,"bilinear vs the pointwise interpolation");
+
+    //upsampling: the kernel is not stretched so the resampling is the pointwise interpolation at the pixel centres
+    Vec2F32 up(2.5f,1.5f);
+    for(int type=MATN_INTERPOLATION_BICUBIC;type<=MATN_INTERPOLATION_LANCZOS;type++){
+        MatNInterpolation interpolation(static_cast<MatNInterpolationType>(type));
+        Mat2F32 h = GeometricalTransformation::scale(f,up,static_cast<MatNInterpolationType>(type));
+        Mat2F32 r(h.getDomain());
+        for(int i=0;i<h.getDomain()(0);i++)
+            for(int j=0;j<h.getDomain()(1);j++)
+                r(i,j)=interpolation.apply(f,Vec2F32((i+0.5f)/up(0)-0.5f,(j+0.5f)/up(1)-0.5f));
+        std::string name = type==MATN_INTERPOLATION_BICUBIC?"bicubic":"lanczos";
+        test.check(testMaxDifference(h,r)<1e-2,name+" upsampling vs the pointwise interpolation");
+        test.check(testMaxDifference(GeometricalTransformation::scale(f,Vec2F32(1,1),static_cast<MatNInterpolationType>(type)),f)<1e-2,name+" identity at the scale 1");
+        test.check(std::abs(interpolation.apply(f,Vec2F32(12,7))-f(12,7))<1e-2,name+" pointwise interpolation at a pixel");
+    }
+
+    //area with an integer factor: mean of the blocks
+    Mat2F32 h_area = GeometricalTransformation::scale(f,Vec2F32(1.f/3,1.f/2),MATN_INTERPOLATION_AREA);
+    Mat2F32 r_area(Vec2I32(12,14));
+    for(int i=0;i<12;i++)
+        for(int j=0;j<14;j++){
+            F64 sum=0;
+            for(int a=0;a<3;a++)
+                for(int b=0;b<2;b++)
+                    sum+=f(3*i+a,2*j+b);
+            r_area(i,j)=static_cast<F32>(sum/6);
+        }
+    test.check(testMaxDifference(h_area,r_area)<1e-2,"area mean of the blocks");
+
+    //the threads split the output without changing the result
+    Mat3UI8 f3 = testRandomMatrix<3,UI8>(Vec3I32(41,33,27),256);
+    for(int type=MATN_INTERPOLATION_NEAREST;type<=MATN_INTERPOLATION_AREA;type++){
+        setNumberThreadParallel(1);
+        Mat3UI8 h_seq = GeometricalTransformation::scale(f3,Vec3F32(1.3f,0.7f,0.5f),static_cast<MatNInterpolationType>(type));
+        setNumberThreadParallel(4);
+        test.check(testMaxDifference(h_seq,GeometricalTransformation::scale(f3,Vec3F32(1.3f,0.7f,0.5f),static_cast<MatNInterpolationType>(type)))==0,"3d type "+BasicUtility::Any2String(type)+" 1 thread vs 4 threads");
+    }
+    setNumberThreadParallel(0);
+    test.end();
+}
+//pointwise warp: g(x) = f(m*(x+offset)) with the bilinear interpolation, 0 outside the domain of f
+//(MatN::isValid truncates the point, rotate tests the bounded condition on the real point)
+template<typename PixelType>
+MatN<2,PixelType> testWarpReference(const MatN<2,PixelType> & f,const Vec2I32 & domain,const Mat2x33F32 & m,const Vec2F32 & offset,bool projective,bool truncation=true){
+    MatN<2,PixelType> g(domain);
+    typename MatN<2,PixelType>::IteratorEDomain it(g.getIteratorEDomain());
+    while(it.next()){
+        Vec2F32 x = Vec2F32(it.x())+offset;
+        x = projective ? GeometricalTransformation::transformHomogeneous2D(m,x) : GeometricalTransformation::transformAffine2D(m,x);
+        if(truncation ? f.isValid(x) : MatNBoundaryConditionBounded::isValid(f.getDomain(),x))
+            g(it.x())=f.interpolationBilinear(x);
+    }
+    return g;
+}
+void testWarp(){
+    pop::PopTest test;
+    test.start("GeometricalTransformation::warp");
+    Mat2UI8 f = testRandomMatrix<2,UI8>(Vec2I32(173,131),256);
+    Mat2F32 f_float = testRandomMatrix<2,F32>(Vec2I32(173,131),1000);
+
+    Vec2F32 src[4],dst[4];
+    src[0]=Vec2F32(0,0);src[1]=Vec2F32(173,0);src[2]=Vec2F32(0,131);src[3]=Vec2F32(173,131);
+    dst[0]=Vec2F32(17,13);dst[1]=Vec2F32(138,39);dst[2]=Vec2F32(69,105);
+    Mat2x33F32 maffine = GeometricalTransformation::affine2D(src,dst);
+    Mat2UI8 h = GeometricalTransformation::transformAffine2D(maffine,f);
+    test.check(testMaxDifference(h,testWarpReference(f,f.getDomain(),maffine.inverse(),Vec2F32(0,0),false))==0,"affine UI8");
+    Mat2F32 h_float = GeometricalTransformation::transformAffine2D(maffine,f_float);
+    test.check(testMaxDifference(h_float,testWarpReference(f_float,f_float.getDomain(),maffine.inverse(),Vec2F32(0,0),false))<1e-3,"affine F32");
+
+    //automatic size: the output domain is the bounding box of the transformed domain
+    Mat2x33F32 mrotation = GeometricalTransformation::rotation2DHomogeneousCoordinate(0.7f);
+    Mat2UI8 h_auto = GeometricalTransformation::transformAffine2D(mrotation,f,true);
+    Vec2F32 xmin(NumericLimits<F32>::maximumRange());
+    for(int corner=0;corner<4;corner++){
+        Vec2F32 x((corner&1)?173.f:0.f,(corner&2)?131.f:0.f);
+        xmin = minimum(xmin,GeometricalTransformation::transformAffine2D(mrotation,x));
+    }
+    test.check(testMaxDifference(h_auto,testWarpReference(f,h_auto.getDomain(),mrotation.inverse(),Vec2F32(Vec2I32(xmin)),false))==0,"affine with the automatic size");
+
+    //projective matrix whose horizon line crosses the output
+    VecN<4,Vec2F32> src_proj,dst_proj;
+    for(int i=0;i<4;i++)
+        src_proj(i)=src[i];
+    dst_proj(0)=Vec2F32(17,13);dst_proj(1)=Vec2F32(156,13);dst_proj(2)=Vec2F32(17,118);dst_proj(3)=Vec2F32(60,50);
+    Mat2x33F32 mproj = GeometricalTransformation::projective2D(src_proj,dst_proj);
+    Mat2UI8 h_proj = GeometricalTransformation::transformHomogeneous2D(mproj,f);
+    test.check(testMaxDifference(h_proj,testWarpReference(f,f.getDomain(),mproj.inverse(),Vec2F32(0,0),true))==0,"projective UI8");
+    Mat2F32 h_proj_float = GeometricalTransformation::transformHomogeneous2D(mproj,f_float);
+    test.check(testMaxDifference(h_proj_float,testWarpReference(f_float,f_float.getDomain(),mproj.inverse(),Vec2F32(0,0),true))<1e-3,"projective F32");
+
+    //rotate about the center: y = rot*(x-c)+c
+    for(int i=0;i<4;i++){
+        F32 angle = -1.3f+0.9f*i;
+        Mat2x22F32 rot22 = GeometricalTransformation::rotation2D(angle);
+        Vec2F32 c(f.getDomain()/2);
+        Mat2x33F32 m;
+        m._dat[0]=rot22._dat[0];m._dat[1]=rot22._dat[1];m._dat[2]=c(0);
+        m._dat[3]=rot22._dat[2];m._dat[4]=rot22._dat[3];m._dat[5]=c(1);
+        m._dat[6]=0;m._dat[7]=0;m._dat[8]=1;
+        test.check(testMaxDifference(GeometricalTransformation::rotate(f,angle),testWarpReference(f,f.getDomain(),m,-c,false,false))==0,"rotate angle "+BasicUtility::Any2String(angle));
+    }
+
+    //the rows are split between the threads without changing the result
+    Mat2UI8 f_large = testRandomMatrix<2,UI8>(Vec2I32(311,257),256);
+    setNumberThreadParallel(1);
+    Mat2UI8 h_seq = GeometricalTransformation::transformHomogeneous2D(mproj,f_large);
+    Mat2UI8 r_seq = GeometricalTransformation::rotate(f_large,0.4f);
+    setNumberThreadParallel(4);
+    test.check(testMaxDifference(h_seq,GeometricalTransformation::transformHomogeneous2D(mproj,f_large))==0,"projective 1 thread vs 4 threads");
+    test.check(testMaxDifference(r_seq,GeometricalTransformation::rotate(f_large,0.4f))==0,"rotate 1 thread vs 4 threads");
+    setNumberThreadParallel(0);
+    test.end();
+}
+//pointwise affine transformation of a volume: g(x) = f(m^{-1}*(x+offset)), with the operations in the order of the slice engine
+template<typename PixelType>
+MatN<3,PixelType> testAffine3DReference(const MatN<3,PixelType> & f,const Vec3I32 & domain,const Mat2F32 & maffine,const Vec3F32 & offset,bool bilinear){
+    Mat2F32 m = maffine.inverse();
+    if(bilinear==false){
+        for(int c=0;c<3;c++)
+            m(c,3)+=0.5f;
+    }
+    MatN<3,PixelType> g(domain);
+    typename MatN<3,PixelType>::IteratorEDomain it(g.getIteratorEDomain());
+    while(it.next()){
+        Vec3F32 x = Vec3F32(it.x())+offset;
+        Vec3F32 y;
+        for(int c=0;c<3;c++){
+            F32 a = m(c,0)*x(0)+m(c,2)*x(2)+m(c,3);
+            y(c) = a+m(c,1)*x(1);
+        }
+        if(bilinear){
+            if(y.allSuperior(-1)&&y.allInferior(f.getDomain()))
+                g(it.x())=f.interpolationBilinear(y);
+        }else{
+            if(y.allSuperiorEqual(0)&&y.allInferior(f.getDomain()))
+                g(it.x())=f(Vec3I32(y));
+        }
+    }
+    return g;
+}
+void testAffine3D(){
+    pop::PopTest test;
+    test.start("GeometricalTransformation::transformAffine3D");
+    Mat3UI8 f = testRandomMatrix<3,UI8>(Vec3I32(29,23,19),256);
+    Mat3F32 f_float = testRandomMatrix<3,F32>(Vec3I32(29,23,19),1000);
+
+    //integer translation: exact shift of the voxels
+    Mat3UI8 h_trans = GeometricalTransformation::transformAffine3D(GeometricalTransformation::translation3DHomogeneousCoordinate(Vec3F32(3,-2,5)),f,false,MATN_INTERPOLATION_NEAREST);
+    bool shift=true;
+    ForEachDomain3D(x,h_trans){
+        Vec3I32 y = x-Vec3I32(3,-2,5);
+        if(h_trans(x)!=(f.isValid(y)?f(y):0))
+            shift=false;
+    }
+    test.check(shift,"integer translation");
+
+    //rotation about the center
+    Vec3F32 c(f.getDomain()/2);
+    Mat2F32 mrotation = GeometricalTransformation::translation3DHomogeneousCoordinate(c);
+    mrotation = mrotation*GeometricalTransformation::rotation3DHomogeneousCoordinate(0.6f,2);
+    mrotation = mrotation*GeometricalTransformation::rotation3DHomogeneousCoordinate(-0.4f,0);
+    mrotation = mrotation*GeometricalTransformation::translation3DHomogeneousCoordinate(-c);
+    test.check(testMaxDifference(GeometricalTransformation::transformAffine3D(mrotation,f,false,MATN_INTERPOLATION_NEAREST),testAffine3DReference(f,f.getDomain(),mrotation,Vec3F32(0,0,0),false))==0,"nearest UI8");
+    test.check(testMaxDifference(GeometricalTransformation::transformAffine3D(mrotation,f,false,MATN_INTERPOLATION_BILINEAR),testAffine3DReference(f,f.getDomain(),mrotation,Vec3F32(0,0,0),true))==0,"trilinear UI8");
+    test.check(testMaxDifference(GeometricalTransformation::transformAffine3D(mrotation,f_float,false,MATN_INTERPOLATION_BILINEAR),testAffine3DReference(f_float,f_float.getDomain(),mrotation,Vec3F32(0,0,0),true))<1e-3,"trilinear F32");
+
+    //automatic size: a quarter turn about the axis 2 swaps the sizes of the axes 0 and 1
+    Mat2F32 mquarter = GeometricalTransformation::rotation3DHomogeneousCoordinate(static_cast<F32>(std::acos(-1.)/2),2);
+    Mat3UI8 h_auto = GeometricalTransformation::transformAffine3D(mquarter,f,true,MATN_INTERPOLATION_BILINEAR);
+    test.check(h_auto.getDomain()(2)==19&&std::abs(h_auto.getDomain()(0)-23)<=1&&std::abs(h_auto.getDomain()(1)-29)<=1,"automatic size of a quarter turn");
+    Vec3F32 xmin(NumericLimits<F32>::maximumRange());
+    for(int corner=0;corner<8;corner++){
+        Vec3F32 x;
+        for(int i=0;i<3;i++)
+            x(i)= (corner&(1<<i)) ? static_cast<F32>(f.getDomain()(i)) : 0.f;
+        xmin = minimum(xmin,GeometricalTransformation::transformAffine3D(mquarter,x));
+    }
+    for(int i=0;i<3;i++)
+        xmin(i)=std::floor(xmin(i));
+    test.check(testMaxDifference(h_auto,testAffine3DReference(f,h_auto.getDomain(),mquarter,xmin,true))==0,"automatic size vs the pointwise transformation");
+
+    //the slices are split between the threads without changing the result
+    Mat3UI8 f_large = testRandomMatrix<3,UI8>(Vec3I32(47,41,37),256);
+    for(int type=MATN_INTERPOLATION_NEAREST;type<=MATN_INTERPOLATION_BILINEAR;type++){
+        setNumberThreadParallel(1);
+        Mat3UI8 h_seq = GeometricalTransformation::transformAffine3D(mrotation,f_large,true,static_cast<MatNInterpolationType>(type));
+        setNumberThreadParallel(4);
+        test.check(testMaxDifference(h_seq,GeometricalTransformation::transformAffine3D(mrotation,f_large,true,static_cast<MatNInterpolationType>(type)))==0,"type "+BasicUtility::Any2String(type)+" 1 thread vs 4 threads");
+    }
+    setNumberThreadParallel(0);
+    test.end();
+}
+//first random variable of each index, drawn with the engine of the thread
+struct TestRangeRandom
+{
+    std::vector<F32> _value;
+    void operator()(int begin,int end){
+        DistributionUniformReal d(0,1);
+        for(int i=begin;i<end;i++)
+            _value[i]=d.randomVariable();
+    }
+};
+template<typename Distribution1>
+void testMeanVariance(const Distribution1 & d,int n,F64 & mean,F64 & variance){
+    std::vector<F32> v(n);
+    RandomEngine engine(12345,0);
+    d.randomVariables(n,&v[0],engine);
+    mean=0;
+    variance=0;
+    for(int i=0;i<n;i++)
+        mean+=v[i];
+    mean/=n;
+    for(int i=0;i<n;i++)
+        variance+=(v[i]-mean)*(v[i]-mean);
+    variance/=n;
+}
+void testRandom(){
+    pop::PopTest test;
+    test.start("RandomEngine");
+    RandomEngine e1(42,3),e2(42,3),e3(42,4),e4(43,3),e5(42,5);
+    bool same=true,other_stream=false,other_seed=false,range=true;
+    for(int i=0;i<1000;i++){
+        UI32 x=e1();
+        same = same&&(x==e2());
+        other_stream = other_stream||(x!=e3());
+        other_seed = other_seed||(x!=e4());
+        F32 r = e5.randomReal();
+        range = range&&r>=0&&r<1;
+    }
+    test.check(same,"same sequence for the same seed and stream");
+    test.check(other_stream&&other_seed,"other sequence for another seed or stream");
+    test.check(range,"random real in [0,1)");
+
+    //moments of the batch sampling
+    F64 mean,variance;
+    testMeanVariance(DistributionUniformReal(2,4),200000,mean,variance);
+    test.check(std::abs(mean-3)<0.01&&std::abs(variance-1./3)<0.01,"uniform real moments");
+    testMeanVariance(DistributionNormal(1,2),200000,mean,variance);
+    test.check(std::abs(mean-1)<0.02&&std::abs(variance-4)<0.05,"normal moments");
+    testMeanVariance(DistributionExponential(2),200000,mean,variance);
+    test.check(std::abs(mean-0.5)<0.01&&std::abs(variance-0.25)<0.01,"exponential moments");
+    testMeanVariance(DistributionUniformInt(0,9),200000,mean,variance);
+    test.check(std::abs(mean-4.5)<0.03&&std::abs(variance-8.25)<0.1,"uniform int moments");
+    testMeanVariance(DistributionSign(),200000,mean,variance);
+    test.check(std::abs(mean)<0.01&&std::abs(variance-1)<0.01,"sign moments");
+
+    //the global seed and the seed of the twister both restart the engines
+    DistributionNormal d(0,1);
+    std::vector<F32> v1(100),v2(100),v3(100),v4(100),v5(100),b1(100),b2(100);
+    Distribution::setSeed(7);
+    for(int i=0;i<100;i++) v1[i]=d.randomVariable();
+    d.randomVariables(100,&b1[0]);
+    Distribution::setSeed(7);
+    for(int i=0;i<100;i++) v2[i]=d.randomVariable();
+    d.randomVariables(100,&b2[0]);
+    Distribution::irand().seed(7);
+    for(int i=0;i<100;i++) v3[i]=d.randomVariable();
+    Distribution::irand().seed(7);
+    for(int i=0;i<100;i++) v4[i]=d.randomVariable();
+    Distribution::irand().seed(8);
+    for(int i=0;i<100;i++) v5[i]=d.randomVariable();
+    test.check(v1==v2&&b1==b2,"setSeed reproducible");
+    test.check(v3==v4&&v4!=v5,"Distribution::irand().seed reproducible");
+
+    //random field independent of the number of threads
+    Mat2F32 field_seq,field_par;
+    DistributionUniformReal uniform(0,1);
+    setNumberThreadParallel(1);
+    Distribution::setSeed(11);
+    Processing::randomField(Vec2I32(301,297),uniform,field_seq);
+    setNumberThreadParallel(4);
+    Distribution::setSeed(11);
+    Processing::randomField(Vec2I32(301,297),uniform,field_par);
+    test.check(testMaxDifference(field_seq,field_par)==0,"random field 1 thread vs 4 threads");
+
+    //engine of the threads of forEachRangeParallel: reproducible for a seed, different between chunks and between calls
+    TestRangeRandom r1,r2,r3;
+    r1._value.resize(400);r2._value.resize(400);r3._value.resize(400);
+    Distribution::setSeed(5);
+    forEachRangeParallel(0,400,r1);
+    forEachRangeParallel(0,400,r3);
+    Distribution::setSeed(5);
+    forEachRangeParallel(0,400,r2);
+    test.check(r1._value==r2._value,"parallel sampling reproducible");
+    test.check(r1._value!=r3._value,"parallel sampling different between calls");
+    test.check(r1._value[100]!=r1._value[200]&&r1._value[200]!=r1._value[300]&&r1._value[0]!=r1._value[100],"parallel sampling different between chunks");
+    //the chunks do not advance the engine of the calling thread, so the next draws do not depend on the number of threads
+    Distribution::setSeed(42);
+    F32 next_without_loop = uniform.randomVariable();
+    std::vector<F32> next(2);
+    for(int nbr_thread=1;nbr_thread<=4;nbr_thread+=3){
+        setNumberThreadParallel(nbr_thread);
+        Distribution::setSeed(42);
+        TestRangeRandom r;
+        r._value.resize(400);
+        forEachRangeParallel(0,400,r);
+        next[nbr_thread/4]=uniform.randomVariable();
+    }
+    test.check(next[0]==next_without_loop&&next[1]==next_without_loop,"draw after a parallel loop independent of the number of threads");
+    setNumberThreadParallel(0);
+    test.end();
+}
+//mini-batch of random inputs, one sample per row, and one-hot expected outputs
+void testNeuralNetSamples(int nbr_sample,int nbr_input,int nbr_output,Mat2F32 & X_batch,Mat2F32 & Y_expected){
+    DistributionUniformReal d(-1,1);
+    RandomEngine engine(3,0);
+    X_batch.resize(nbr_sample,nbr_input);
+    d.randomVariables(static_cast<int>(X_batch.size()),X_batch.data(),engine);
+    Y_expected.resize(nbr_sample,nbr_output);
+    for(int i=0;i<nbr_sample;i++)
+        Y_expected(i,i%nbr_output)=1;
+}
+//relative difference of the summed weight errors of the fully connected and convolution layers
+F64 testNeuralNetErrorDifference(const NeuralLayer * layer,const Mat2F32 & d_E_W,const Vec<Mat2F32> & d_E_W_kernels,const Vec<F32> & d_E_W_biais){
+    F64 diff=0,norm=0;
+    if(const NeuralLayerLinearFullyConnected * fc = dynamic_cast<const NeuralLayerLinearFullyConnected *>(layer)){
+        for(unsigned int i=0;i<d_E_W.size();i++){
+            diff=std::max(diff,std::abs(static_cast<F64>(fc->_d_E_W(i))-d_E_W(i)));
+            norm=std::max(norm,std::abs(static_cast<F64>(d_E_W(i))));
+        }
+    }else if(const NeuralLayerMatrixConvolutionSubScaling * conv = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(layer)){
+        for(unsigned int k=0;k<d_E_W_kernels.size();k++){
+            for(unsigned int i=0;i<d_E_W_kernels(k).size();i++){
+                diff=std::max(diff,std::abs(static_cast<F64>(conv->_d_E_W_kernels(k)(i))-d_E_W_kernels(k)(i)));
+                norm=std::max(norm,std::abs(static_cast<F64>(d_E_W_kernels(k)(i))));
+            }
+            diff=std::max(diff,std::abs(static_cast<F64>(conv->_d_E_W_biais(k))-d_E_W_biais(k)));
+        }
+    }
+    return norm>0?diff/norm:diff;
+}
+//the batch forward/backward gives the outputs and the summed weight errors of the samples propagated one by one
+bool testNeuralNetBatchVsSample(NeuralNet & net,int nbr_sample,F64 tolerance){
+    const int nbr_input = net.layers()(0)->X().size();
+    const int nbr_output= net.layers()(net.layers().size()-1)->X().size();
+    Mat2F32 X_batch,Y_expected;
+    testNeuralNetSamples(nbr_sample,nbr_input,nbr_output,X_batch,Y_expected);
+    net.setTrainable(true);
+    NeuralNet net_batch(net);
+    net_batch.setTrainable(true);
+
+    //per sample, the errors of the fully connected layers are summed here, the convolution layers sum them
+    const int nbr_layer = net.layers().size();
+    std::vector<Mat2F32> d_E_W(nbr_layer);
+    std::vector<VecF32> Y_sample(nbr_sample);
+    for(int s=0;s<nbr_sample;s++){
+        VecF32 X_in(nbr_input),X_expected(nbr_output);
+        std::copy(X_batch.data()+s*nbr_input,X_batch.data()+(s+1)*nbr_input,X_in.begin());
+        std::copy(Y_expected.data()+s*nbr_output,Y_expected.data()+(s+1)*nbr_output,X_expected.begin());
+        net.forwardCPU(X_in,Y_sample[s]);
+        net.backwardCPU(X_expected);
+        for(int l=0;l<nbr_layer;l++){
+            if(const NeuralLayerLinearFullyConnected * fc = dynamic_cast<const NeuralLayerLinearFullyConnected *>(net.layers()(l))){
+                if(s==0)
+                    d_E_W[l]=fc->_d_E_W;
+                else
+                    d_E_W[l]+=fc->_d_E_W;
+            }
+        }
+    }
+    Mat2F32 Y_batch;
+    net_batch.forwardCPU(X_batch,Y_batch);
+    net_batch.backwardCPU(Y_expected);
+    F64 diff=0;
+    for(int s=0;s<nbr_sample;s++)
+        for(int j=0;j<nbr_output;j++)
+            diff=std::max(diff,std::abs(static_cast<F64>(Y_batch(s,j))-Y_sample[s](j)));
+    bool ok = diff<tolerance;
+    for(int l=0;l<nbr_layer;l++){
+        const NeuralLayerMatrixConvolutionSubScaling * conv = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(net.layers()(l));
+        if(conv!=NULL)
+            ok = ok&&testNeuralNetErrorDifference(net_batch.layers()(l),d_E_W[l],conv->_d_E_W_kernels,conv->_d_E_W_biais)<tolerance;
+        else
+            ok = ok&&testNeuralNetErrorDifference(net_batch.layers()(l),d_E_W[l],Vec<Mat2F32>(),Vec<F32>())<tolerance;
+    }
+    return ok;
+}
+void testNeuralNetBatch(){
+    pop::PopTest test;
+    test.start("NeuralNet batch");
+    Distribution::setSeed(1);
+    NeuralNet mlp;
+    mlp.addLayerLinearInput(37);
+    mlp.addLayerLinearFullyConnected(29);
+    mlp.addLayerLinearFullyConnected(11);
+    test.check(testNeuralNetBatchVsSample(mlp,13,1e-4),"fully connected vs per sample");
+    NeuralNet mlp_softmax;
+    mlp_softmax.addLayerLinearInput(37);
+    mlp_softmax.addLayerLinearFullyConnected(29);
+    mlp_softmax.addLayerLinearFullyConnectedSoftmax(7);
+    test.check(testNeuralNetBatchVsSample(mlp_softmax,13,1e-4),"softmax vs per sample");
+    //the convolution and max pool layers of a mixed network
+    NeuralNet net;
+    net.addLayerMatrixInput(14,14,2);
+    net.addLayerMatrixConvolutionSubScaling(3,1,1);
+    net.addLayerMatrixMaxPool(2);
+    net.addLayerMatrixConvolutionSubScaling(4,2,1);
+    net.addLayerLinearFullyConnected(9);
+    net.addLayerLinearFullyConnectedSoftmax(5);
+    test.check(testNeuralNetBatchVsSample(net,9,1e-4),"convolution and max pool vs per sample");
+
+    //learn updates once per batch with the summed error
+    NeuralNet net_learn(mlp);
+    net_learn.setTrainable(true);
+    net_learn.setLearnableParameter(0.01f);
+    Mat2F32 X_batch,Y_expected,Y_batch;
+    testNeuralNetSamples(13,37,11,X_batch,Y_expected);
+    net_learn.forwardCPU(X_batch,Y_batch);
+    net_learn.backwardCPU(Y_expected);
+    NeuralLayerLinearFullyConnected * fc = dynamic_cast<NeuralLayerLinearFullyConnected *>(net_learn.layers()(2));
+    Mat2F32 W_expected = fc->_W-fc->_d_E_W*0.01f;
+    net_learn.learn();
+    test.check(testMaxDifference(fc->_W,W_expected)<1e-6,"learn with the summed error");
+    test.end();
+}
+//direct convolution of a layer (one kernel and one biais by pair of maps): forward outputs, then the errors for the error d_E_X of the layer
+void testConvolutionLayerReference(const NeuralLayerMatrixConvolutionSubScaling & layer,const NeuralLayerMatrix & previous,const VecF32 & d_E_X,
+                                   VecF32 & X,Vec<Mat2F32> & d_E_W_kernels,Vec<F32> & d_E_W_biais,VecF32 & d_E_X_previous){
+    const int nbr_map = layer.X_map().size(),nbr_map_previous = previous.X_map().size();
+    const int sizei = layer.X_map()(0).sizeI(),sizej = layer.X_map()(0).sizeJ();
+    const int sizei_previous = previous.X_map()(0).sizeI(),sizej_previous = previous.X_map()(0).sizeJ();
+    const int size_kernel = 2*layer._radius_kernel+1,sub = layer._sub_resolution_factor;
+    const VecF32 & X_previous = previous.X();
+    NeuronSigmoid neuron;
+    X.resize(nbr_map*sizei*sizej);
+    d_E_W_kernels = layer._W_kernels;
+    d_E_W_biais = layer._W_biais;
+    for(unsigned int k=0;k<d_E_W_kernels.size();k++){
+        d_E_W_kernels(k)=0;
+        d_E_W_biais(k)=0;
+    }
+    d_E_X_previous.clear();
+    d_E_X_previous.resize(X_previous.size(),0);
+    for(int m=0;m<nbr_map;m++){
+        for(int i=0;i<sizei;i++){
+            for(int j=0;j<sizej;j++){
+                F64 sum=0;
+                for(int m_p=0;m_p<nbr_map_previous;m_p++){
+                    const int kernel = m_p+m*nbr_map_previous;
+                    sum+=layer._W_biais(kernel);
+                    for(int i_k=0;i_k<size_kernel;i_k++)
+                        for(int j_k=0;j_k<size_kernel;j_k++)
+                            sum+=layer._W_kernels(kernel)(i_k,j_k)*X_previous(m_p*sizei_previous*sizej_previous+(i*sub+i_k)*sizej_previous+j*sub+j_k);
+                }
+                const int index = (m*sizei+i)*sizej+j;
+                X(index)=neuron.activation(static_cast<F32>(sum));
+                const F32 d_E_Y = d_E_X(index)*neuron.derivedActivation(X(index));
+                for(int m_p=0;m_p<nbr_map_previous;m_p++){
+                    const int kernel = m_p+m*nbr_map_previous;
+                    d_E_W_biais(kernel)+=d_E_Y;
+                    for(int i_k=0;i_k<size_kernel;i_k++){
+                        for(int j_k=0;j_k<size_kernel;j_k++){
+                            const int index_previous = m_p*sizei_previous*sizej_previous+(i*sub+i_k)*sizej_previous+j*sub+j_k;
+                            d_E_W_kernels(kernel)(i_k,j_k)+=X_previous(index_previous)*d_E_Y;
+                            d_E_X_previous(index_previous)+=layer._W_kernels(kernel)(i_k,j_k)*d_E_Y;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+F64 testRelativeDifference(const VecF32 & a,const VecF32 & b){
+    F64 diff=0,norm=0;
+    for(unsigned int i=0;i<a.size();i++){
+        diff=std::max(diff,std::abs(static_cast<F64>(a(i))-b(i)));
+        norm=std::max(norm,std::abs(static_cast<F64>(b(i))));
+    }
+    return a.size()==b.size()?(norm>0?diff/norm:diff):NumericLimits<F64>::maximumRange();
+}
+//im2col forward/backward of the convolution layers of the network vs the direct convolution
+bool testConvolutionLayers(NeuralNet & net,F64 tolerance){
+    const int nbr_input = net.layers()(0)->X().size();
+    const int nbr_output= net.layers()(net.layers().size()-1)->X().size();
+    Mat2F32 X_batch,Y_expected;
+    testNeuralNetSamples(1,nbr_input,nbr_output,X_batch,Y_expected);
+    VecF32 X_in(X_batch.begin(),X_batch.end()),X_expected(Y_expected.begin(),Y_expected.end()),X_out;
+    net.setTrainable(true);
+    net.forwardCPU(X_in,X_out);
+    net.backwardCPU(X_expected);
+    bool ok=true;
+    for(unsigned int l=1;l<net.layers().size();l++){
+        const NeuralLayerMatrixConvolutionSubScaling * conv = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(net.layers()(l));
+        if(conv==NULL)
+            continue;
+        const NeuralLayerMatrix * previous = dynamic_cast<const NeuralLayerMatrix *>(net.layers()(l-1));
+        VecF32 X,d_E_X_previous;
+        Vec<Mat2F32> d_E_W_kernels;
+        Vec<F32> d_E_W_biais;
+        testConvolutionLayerReference(*conv,*previous,const_cast<NeuralLayerMatrixConvolutionSubScaling *>(conv)->d_E_X(),X,d_E_W_kernels,d_E_W_biais,d_E_X_previous);
+        ok = ok&&testRelativeDifference(conv->X(),X)<tolerance;
+        ok = ok&&testNeuralNetErrorDifference(conv,Mat2F32(),d_E_W_kernels,d_E_W_biais)<tolerance;
+        //the error of the input layer is not computed
+        if(l>1)
+            ok = ok&&testRelativeDifference(net.layers()(l-1)->d_E_X(),d_E_X_previous)<tolerance;
+    }
+    return ok;
+}
+void testNeuralNetConvolution(){
+    pop::PopTest test;
+    test.start("NeuralNet convolution im2col");
+    Distribution::setSeed(2);
+    NeuralNet net;
+    net.addLayerMatrixInput(13,12,3);
+    net.addLayerMatrixConvolutionSubScaling(4,2,1);
+    net.addLayerMatrixConvolutionSubScaling(2,1,2);
+    net.addLayerLinearFullyConnected(5);
+    test.check(testConvolutionLayers(net,1e-5),"sub-scaling 2 radius 1, sub-scaling 1 radius 2");
+    //large enough to be distributed on the threads
+    NeuralNet net_large;
+    net_large.addLayerMatrixInput(41,37,2);
+    net_large.addLayerMatrixConvolutionSubScaling(6,1,2);
+    net_large.addLayerMatrixConvolutionSubScaling(5,2,1);
+    net_large.addLayerLinearFullyConnected(3);
+    setNumberThreadParallel(4);
+    test.check(testConvolutionLayers(net_large,1e-5),"4 threads");
+    setNumberThreadParallel(0);
+    test.end();
+}
+//C = alpha*op(A)*op(B) + beta*C by the definition, row-major with leading dimensions
+template<typename T>
+void testGEMMReference(char transA,char transB,int m,int n,int k,T alpha,const std::vector<T> & A,int lda,const std::vector<T> & B,int ldb,T beta,std::vector<T> & C,int ldc){
+    for(int i=0;i<m;i++){
+        for(int j=0;j<n;j++){
+            F64 sum=0;
+            for(int l=0;l<k;l++){
+                F64 a = transA=='N' ? A[i*lda+l] : A[l*lda+i];
+                F64 b = transB=='N' ? B[l*ldb+j] : B[j*ldb+l];
+                sum+=a*b;
+            }
+            C[i*ldc+j] = static_cast<T>(alpha*sum+(beta==0?0:beta*C[i*ldc+j]));
+        }
+    }
+}
+template<typename T>
+std::vector<T> testGEMMRandom(int size,unsigned int seed){
+    std::vector<T> v(size);
+    for(int i=0;i<size;i++){
+        seed = seed*1103515245u+12345u;
+        v[i]=static_cast<T>(static_cast<int>((seed>>8)%2001)-1000)/1000;
+    }
+    return v;
+}
+//maximum difference with the reference, relative to the maximum absolute value of the reference
+template<typename T>
+F64 testGEMMCase(char transA,char transB,int m,int n,int k,T alpha,T beta){
+    //leading dimensions larger than the stored rows
+    const int lda = (transA=='N'?k:m)+3,ldb = (transB=='N'?n:k)+2,ldc = n+1;
+    std::vector<T> A = testGEMMRandom<T>((transA=='N'?m:k)*lda,1);
+    std::vector<T> B = testGEMMRandom<T>((transB=='N'?k:n)*ldb,2);
+    std::vector<T> C = testGEMMRandom<T>(m*ldc,3),C_ref(C);
+    if(sizeof(T)==sizeof(F32))
+        GEMM::sgemm(transA,transB,m,n,k,alpha,reinterpret_cast<const F32*>(&A[0]),lda,reinterpret_cast<const F32*>(&B[0]),ldb,beta,reinterpret_cast<F32*>(&C[0]),ldc);
+    else
+        GEMM::dgemm(transA,transB,m,n,k,alpha,reinterpret_cast<const F64*>(&A[0]),lda,reinterpret_cast<const F64*>(&B[0]),ldb,beta,reinterpret_cast<F64*>(&C[0]),ldc);
+    testGEMMReference(transA,transB,m,n,k,alpha,A,lda,B,ldb,beta,C_ref,ldc);
+    F64 diff=0,norm=0;
+    for(int i=0;i<m;i++){
+        for(int j=0;j<ldc;j++){
+            //the padding of C is not modified
+            if(j>=n&&C[i*ldc+j]!=C_ref[i*ldc+j])
+                return NumericLimits<F64>::maximumRange();
+            diff=std::max(diff,std::abs(static_cast<F64>(C[i*ldc+j])-C_ref[i*ldc+j]));
+            norm=std::max(norm,std::abs(static_cast<F64>(C_ref[i*ldc+j])));
+        }
+    }
+    return norm>0?diff/norm:diff;
+}
+void testGEMM(){
+    pop::PopTest test;
+    test.start("GEMM");
+    //sizes around the micro-kernel (MR,NR) and the cache blocks (MC,KC)
+    const int nbr_case=8;
+    const int size[nbr_case][3]={{1,1,1},{7,5,3},{13,17,300},{150,20,17},{5,300,9},{97,61,263},{2,3,0},{5,4200,3}};
+    const char trans[2]={'N','T'};
+    for(int c=0;c<nbr_case;c++){
+        for(int ta=0;ta<2;ta++){
+            for(int tb=0;tb<2;tb++){
+                std::string name = std::string(1,trans[ta])+std::string(1,trans[tb])+" "+BasicUtility::Any2String(size[c][0])+"x"+BasicUtility::Any2String(size[c][1])+"x"+BasicUtility::Any2String(size[c][2]);
+                test.check(testGEMMCase<F32>(trans[ta],trans[tb],size[c][0],size[c][1],size[c][2],1.f,0.f)<1e-5,"sgemm "+name);
+                test.check(testGEMMCase<F32>(trans[ta],trans[tb],size[c][0],size[c][1],size[c][2],-0.5f,1.f)<1e-5,"sgemm alpha beta "+name);
+                test.check(testGEMMCase<F64>(trans[ta],trans[tb],size[c][0],size[c][1],size[c][2],2.,0.25)<1e-12,"dgemm "+name);
+            }
+        }
+    }
+    //matrix-vector product
+    for(int ta=0;ta<2;ta++){
+        const int m=37,n=291;
+        std::vector<F32> A = testGEMMRandom<F32>(m*(n+1),4);
+        std::vector<F32> x = testGEMMRandom<F32>(std::max(m,n),5),y = testGEMMRandom<F32>(std::max(m,n),6),y_ref(y);
+        GEMM::sgemv(trans[ta],m,n,0.5f,&A[0],n+1,&x[0],2.f,&y[0]);
+        const int size_y = trans[ta]=='N'?m:n,size_x = trans[ta]=='N'?n:m;
+        testGEMMReference<F32>(trans[ta],'N',trans[ta]=='N'?m:n,1,size_x,0.5f,A,n+1,x,1,2.f,y_ref,1);
+        F64 diff=0;
+        for(int i=0;i<size_y;i++)
+            diff=std::max(diff,std::abs(static_cast<F64>(y[i])-y_ref[i]));
+        test.check(diff<1e-4,std::string("sgemv ")+trans[ta]);
+    }
+    //MatN products through GEMM
+    Mat2F32 a(67,45),b(45,53);
+    std::vector<F32> va = testGEMMRandom<F32>(a.size(),7),vb = testGEMMRandom<F32>(b.size(),8);
+    std::copy(va.begin(),va.end(),a.begin());
+    std::copy(vb.begin(),vb.end(),b.begin());
+    std::vector<F32> vc(67*53);
+    testGEMMReference<F32>('N','N',67,53,45,1,va,45,vb,53,0,vc,53);
+    Mat2F32 c = a*b;
+    F64 diff=0;
+    for(unsigned int i=0;i<c.size();i++)
+        diff=std::max(diff,std::abs(static_cast<F64>(c(i))-vc[i]));
+    test.check(c.sizeI()==67&&c.sizeJ()==53&&diff<1e-4,"Mat2F32 product");
+    //the row blocks are split between the threads without changing the result
+    std::vector<F32> A = testGEMMRandom<F32>(300*260,9),B = testGEMMRandom<F32>(260*200,10),C_seq(300*200),C_par(300*200);
+    setNumberThreadParallel(1);
+    GEMM::sgemm('N','N',300,200,260,1,&A[0],260,&B[0],200,0,&C_seq[0],200);
+    setNumberThreadParallel(4);
+    GEMM::sgemm('N','N',300,200,260,1,&A[0],260,&B[0],200,0,&C_par[0],200);
+    setNumberThreadParallel(0);
+    test.check(C_seq==C_par,"1 thread vs 4 threads");
+    //least squares through GEMM: y=2+3x, and the empty inputs refused with beta=0
+    Mat2F32 X(4,2);
+    VecF32 Y(4);
+    for(int i=0;i<4;i++){
+        X(i,0)=1;X(i,1)=static_cast<F32>(i);
+        Y(i)=2+3.f*i;
+    }
+    Vec2F32 beta = LinearAlgebra::linearLeastSquares(X,Y);
+    test.check(std::abs(beta(0)-2)<1e-3&&std::abs(beta(1)-3)<1e-3,"linear least squares");
+    test.check(LinearAlgebra::linearLeastSquares(X,VecF32())==Vec2F32(0,0),"linear least squares with empty Y");
+    test.check(LinearAlgebra::linearLeastSquares(Mat2F32(),VecF32())==Vec2F32(0,0),"linear least squares with empty X");
+    test.end();
+}
+VecF32 testNeuralNetRandomInput(int size){
+    VecF32 v(size);
+    DistributionUniformReal d(-1,1);
+    for(int i=0;i<size;i++)
+        v(i)=d.randomVariable();
+    return v;
+}
+void testNeuralNetQuantized(){
+    pop::PopTest test;
+    test.start("NeuralNet int8");
+    Distribution::setSeed(3);
+    NeuralNet net;
+    net.addLayerMatrixInput(16,16,1);
+    net.addLayerMatrixConvolutionSubScaling(6,2,2);
+    net.addLayerMatrixConvolutionSubScaling(8,1,1);
+    net.addLayerMatrixMaxPool(2);
+    net.addLayerLinearFullyConnected(20);
+    net.addLayerLinearFullyConnectedSoftmax(10);
+    Vec<VecF32> v_calibration(100);
+    for(unsigned int i=0;i<v_calibration.size();i++)
+        v_calibration(i)=testNeuralNetRandomInput(16*16);
+    NeuralNetQuantized net_quantized(net,v_calibration);
+    test.check(net_quantized.isQuantizationOf(net),"quantization of the network");
+    //agreement of the outputs and of the labels on samples different from the calibration ones
+    F64 diff_max=0;
+    int nbr_label=0,nbr_label_equal=0;
+    VecF32 vout,vout_quantized;
+    for(int i=0;i<300;i++){
+        VecF32 vin = testNeuralNetRandomInput(16*16);
+        net.forwardCPU(vin,vout);
+        net_quantized.forwardCPU(vin,vout_quantized);
+        for(unsigned int j=0;j<vout.size();j++)
+            diff_max=std::max(diff_max,static_cast<F64>(std::abs(vout(j)-vout_quantized(j))));
+        //the labels are compared when the float network is not undecided
+        VecF32 vsort(vout);
+        std::sort(vsort.begin(),vsort.end());
+        if(vsort(vsort.size()-1)-vsort(vsort.size()-2)>0.02f){
+            nbr_label++;
+            if(std::max_element(vout.begin(),vout.end())-vout.begin()==std::max_element(vout_quantized.begin(),vout_quantized.end())-vout_quantized.begin())
+                nbr_label_equal++;
+        }
+    }
+    test.check(diff_max<0.02,"softmax outputs");
+    test.check(nbr_label>100&&nbr_label_equal==nbr_label,"labels");
+    //the file keeps the network and the checksum of the float weights
+    const char * file = "testneuralnet.q8";
+    NeuralNetQuantized net_load;
+    test.check(net_quantized.save(file)&&net_load.load(file),"save and load");
+    VecF32 vin = testNeuralNetRandomInput(16*16);
+    net_quantized.forwardCPU(vin,vout);
+    net_load.forwardCPU(vin,vout_quantized);
+    test.check(vout==vout_quantized&&net_load.isQuantizationOf(net),"loaded network");
+    NeuralLayerLinearFullyConnected * layer_fully = dynamic_cast<NeuralLayerLinearFullyConnected *>(net.layers()(4));
+    layer_fully->_W(3,7)+=0.001f;
+    test.check(net_load.isQuantizationOf(net)==false,"modified weight");
+    layer_fully->_W(3,7)-=0.001f;
+    NeuralNet net_other;
+    net_other.addLayerMatrixInput(16,16,1);
+    net_other.addLayerMatrixConvolutionSubScaling(6,2,2);
+    net_other.addLayerMatrixConvolutionSubScaling(8,1,1);
+    net_other.addLayerMatrixMaxPool(2);
+    net_other.addLayerLinearFullyConnected(21);
+    net_other.addLayerLinearFullyConnectedSoftmax(10);
+    test.check(net_load.isQuantizationOf(net_other)==false,"other geometry");
+    std::remove(file);
+    //the OCR uses the .q8 file only if it belongs to the xml file
+    Vec<std::string> label;
+    for(int i=0;i<10;i++)
+        label.push_back(BasicUtility::Any2String(i));
+    net.label2String() = label;
+    const char * file_xml = "testneuralnet.xml";
+    net.save(file_xml);
+    OCRNeuralNetwork ocr;
+    ocr.setDictionnary(file_xml);
+    Vec<Mat2UI8> v_calibration_ocr(20);
+    for(unsigned int i=0;i<v_calibration_ocr.size();i++)
+        v_calibration_ocr(i) = testRandomMatrix<2,UI8>(Vec2I32(20,14),255,i+1);
+    ocr.quantize(v_calibration_ocr);
+    ocr.neuralNetworkQuantized().save(OCRNeuralNetwork::quantizedFile(file_xml).c_str());
+    OCRNeuralNetwork ocr_load;
+    test.check(ocr_load.setDictionnary(file_xml)&&ocr_load.neuralNetworkQuantized().empty()==false,"OCR loads the quantized network");
+    net_other.label2String() = label;
+    net_other.save(file_xml);
+    test.check(ocr_load.setDictionnary(file_xml)&&ocr_load.neuralNetworkQuantized().empty(),"OCR rejects the quantized network of another network");
+    std::remove(OCRNeuralNetwork::quantizedFile(file_xml).c_str());
+    std::remove(file_xml);
+    test.end();
+}
+//copy of the file with the byte i replaced by value (i<0 for no replacement) and truncated to size bytes (size<0 for the full file)
+void testNeuralNetCorruptFile(const char * file,const char * file_corrupted,int i,char value,int size){
+    std::ifstream in(file,std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+    if(i>=0)
+        data[i]=value;
+    if(size>=0)
+        data.resize(size);
+    std::ofstream out(file_corrupted,std::ios::binary);
+    out.write(data.data(),data.size());
+}
+//the network is empty and can be used again
+bool testNeuralNetDefaultState(NeuralNet & net){
+    if(net.layers().size()!=0||net.label2String().size()!=0)
+        return false;
+    net.addLayerMatrixInput(4,5,1);
+    const bool ok = net.inputMatrixToInputNeuron(testRandomMatrix<2,UI8>(Vec2I32(8,10),255)).size()==20;
+    net.clear();
+    net.setNormalizationMatrixInput(new NormalizationMatrixInputMass());
+    return ok;
+}
+void testNeuralNetBinary(){
+    pop::PopTest test;
+    test.start("NeuralNet binary");
+    Distribution::setSeed(4);
+    const char * file = "testneuralnet.popnn",* file_xml = "testneuralnet.xml",* file_corrupted = "testneuralnet_corrupted.popnn";
+    {
+        NeuralNet net;
+        net.addLayerMatrixInput(12,10,1);
+        net.addLayerMatrixConvolutionSubScaling(4,1,1);
+        net.addLayerMatrixMaxPool(2);
+        net.addLayerLinearFullyConnected(7);
+        net.addLayerLinearFullyConnectedSoftmax(3);
+        net.setNormalizationMatrixInput(new NormalizationMatrixInputCentering(NormalizationMatrixInput::ZeroToOne));
+        Vec<std::string> label;
+        label.push_back("a");label.push_back("b");label.push_back("c");
+        net.label2String() = label;
+        test.check(net.saveBinary(file),"save");
+        Mat2UI8 m = testRandomMatrix<2,UI8>(Vec2I32(24,17),255);
+        VecF32 vin = net.inputMatrixToInputNeuron(m),vout,vout_load;
+        net.forwardCPU(vin,vout);
+        NeuralNet net_load;
+        test.check(net_load.loadBinary(file),"load");
+        net_load.forwardCPU(net_load.inputMatrixToInputNeuron(m),vout_load);
+        test.check(net_load.layers().size()==5&&net_load.label2String()==label&&vout==vout_load,"round trip");
+        //load recognizes the binary and the xml files
+        NeuralNet net_auto,net_auto_xml;
+        net_auto.load(file);
+        net_auto.forwardCPU(net_auto.inputMatrixToInputNeuron(m),vout_load);
+        test.check(net_auto.layers().size()==5&&vout==vout_load,"load binary file");
+        net.save(file_xml);
+        net_auto_xml.load(file_xml);
+        test.check(net_auto_xml.layers().size()==5&&net_auto_xml.label2String()==label,"load xml file");
+        //header: magic (8 bytes), version, byte order, number of layers, number of labels, normalization type, normalization value (I32),
+        //then the labels (length and characters) and the layer descriptors
+        const int offset_normalization = 8+4*sizeof(I32),offset_layer = 8+6*sizeof(I32)+3*(sizeof(I32)+1);
+        NeuralNet net_corrupted;
+        net_corrupted.load(file);
+        testNeuralNetCorruptFile(file,file_corrupted,offset_normalization,7,-1);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&net_corrupted.layers().size()==5,"unknown normalization type");
+        testNeuralNetCorruptFile(file,file_corrupted,offset_normalization+sizeof(I32),2,-1);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&net_corrupted.layers().size()==5,"unknown normalization value");
+        testNeuralNetCorruptFile(file,file_corrupted,0,'X',-1);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&net_corrupted.layers().size()==5,"not a binary file");
+        testNeuralNetCorruptFile(file,file_corrupted,-1,0,offset_layer+10);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&testNeuralNetDefaultState(net_corrupted),"truncated header");
+        net_corrupted.load(file);
+        testNeuralNetCorruptFile(file,file_corrupted,offset_layer+2*(8*sizeof(I32)+2*sizeof(UI64)),99,-1);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&testNeuralNetDefaultState(net_corrupted),"corrupted layer");
+        net_corrupted.load(file);
+        std::ifstream in(file,std::ios::binary|std::ios::ate);
+        const int size = static_cast<int>(in.tellg());
+        in.close();
+        testNeuralNetCorruptFile(file,file_corrupted,-1,0,size-4);
+        test.check(net_corrupted.loadBinary(file_corrupted)==false&&testNeuralNetDefaultState(net_corrupted),"truncated weights");
+    }
+    std::remove(file);
+    std::remove(file_xml);
+    std::remove(file_corrupted);
+    test.end();
+}
+//erosion or dilation by the structural element by a direct scan of the neighborhood
+template<int DIM,typename PixelType>
+MatN<DIM,PixelType> testMorphologyStructuralElementReference(const MatN<DIM,PixelType> & f,const MatN<DIM,UI8> & structural_element,int dilate,bool erosion){
+    MatN<DIM,PixelType> h(f.getDomain());
+    typename MatN<DIM,PixelType>::IteratorEDomain itg(f.getIteratorEDomain());
+    typename MatN<DIM,PixelType>::IteratorENeighborhood itn(f.getIteratorENeighborhood(structural_element,dilate));
+    while(itg.next()){
+        itn.init(itg.x());
+        PixelType value = erosion?NumericLimits<PixelType>::maximumRange():NumericLimits<PixelType>::minimumRange();
+        while(itn.next())
+            value = erosion?std::min(value,f(itn.x())):std::max(value,f(itn.x()));
+        h(itg.x())=value;
+    }
+    return h;
+}
+template<int DIM,typename PixelType>
+bool testMorphologyStructuralElement(const MatN<DIM,PixelType> & f,const MatN<DIM,UI8> & structural_element,int dilate){
+    return testMaxDifference(Processing::erosionStructuralElement(f,structural_element,dilate),testMorphologyStructuralElementReference(f,structural_element,dilate,true))==0
+            &&testMaxDifference(Processing::dilationStructuralElement(f,structural_element,dilate),testMorphologyStructuralElementReference(f,structural_element,dilate,false))==0;
+}
+void testMorphologyDiamond(){
+    pop::PopTest test;
+    test.start("erosion diamond");
+    Mat2UI8 f2 = testRandomMatrix<2,UI8>(Vec2I32(67,45),256);
+    Mat3F32 f3 = testRandomMatrix<3,F32>(Vec3I32(13,17,11),1000);
+    //unit cross: balls of radius 1
+    test.check(testMaxDifference(Processing::erosion(f2,1,1),testMorphologyReference(f2,1,1,true))==0,"2d cross");
+    test.check(testMaxDifference(Processing::dilation(f3,1,2),testMorphologyReference(f3,1,2,false))==0,"3d cross");
+    //diamond: the cross dilated by itself
+    Mat2UI8 cross2(3,3);
+    cross2(0,1)=1;cross2(1,0)=1;cross2(1,1)=1;cross2(1,2)=1;cross2(2,1)=1;
+    for(int dilate=2;dilate<=8;dilate+=3)
+        test.check(testMorphologyStructuralElement(f2,cross2,dilate),"2d diamond radius "+BasicUtility::Any2String(dilate));
+    test.check(testMorphologyStructuralElement(testRandomMatrix<2,UI8>(Vec2I32(20,15),256),cross2,25),"diamond larger than the domain");
+    Mat3UI8 cross3(3,3,3);
+    cross3(1,1,1)=1;
+    for(int i=0;i<3;i++){
+        Vec3I32 x(1);
+        x(i)=0;cross3(x)=1;
+        x(i)=2;cross3(x)=1;
+    }
+    test.check(testMorphologyStructuralElement(f3,cross3,3),"3d diamond");
+    //octagon: the 3x3 box dilated by the cross, dilated by itself
+    Mat2UI8 octagon(5,5);
+    octagon = 1;
+    octagon(0,0)=0;octagon(0,4)=0;octagon(4,0)=0;octagon(4,4)=0;
+    test.check(testMorphologyStructuralElement(f2,octagon,1),"octagon");
+    test.check(testMorphologyStructuralElement(f2,octagon,3),"octagon dilated");
+    //diamond around a box without the origin and disk: generic scan
+    Mat2UI8 shifted(5,5);
+    shifted(2,3)=1;shifted(3,2)=1;shifted(3,3)=1;shifted(3,4)=1;shifted(4,3)=1;
+    test.check(testMorphologyStructuralElement(f2,shifted,2),"shifted");
+    test.check(testMaxDifference(Processing::erosion(f2,3,2),testMorphologyReference(f2,3,2,true))==0,"disk");
+    test.end();
+}
 void testMatN(){
 
     pop::PopTest test;
@@ -305,6 +2126,31 @@ void processingTest()
 
 int main(){
     testMatN();
+    testMorphologyBox();
+    testMorphologyDiamond();
+    testParallelGlobalToLocal();
+    testNeighborhoodIterator();
+    testWatershed();
+    testDistanceEuclidean();
+    testClusterToLabel();
+    testMedian();
+    testBoxStatistics();
+    testConvolutionSeparable();
+    testFFT();
+    testConvolutionFFT();
+    testMatNMapped();
+    testMatNChunked();
+    testMatNDirectory();
+    testCompression();
+    testResample();
+    testWarp();
+    testAffine3D();
+    testRandom();
+    testNeuralNetBatch();
+    testNeuralNetConvolution();
+    testGEMM();
+    testNeuralNetQuantized();
+    testNeuralNetBinary();
     processingTest();
     testAnamysis();
     return 1;
@@ -52,12 +52,15 @@ HEADERS += $${PWD}/include/Population.h \
            $${PWD}/include/data/germgrain/Germ.h \
            $${PWD}/include/data/germgrain/GermGrain.h \
            $${PWD}/include/data/mat/Mat2x.h \
+           $${PWD}/include/data/mat/GEMM.h \
            $${PWD}/include/data/mat/MatN.h \
            $${PWD}/include/data/mat/MatNBoundaryCondition.h \
            $${PWD}/include/data/mat/MatNDisplay.h \
            $${PWD}/include/data/mat/MatNInOut.h \
+           $${PWD}/include/data/mat/MatNChunked.h \
            $${PWD}/include/data/mat/MatNIteratorE.h \
            $${PWD}/include/data/neuralnetwork/NeuralNetwork.h \
+           $${PWD}/include/data/neuralnetwork/NeuralNetworkQuantized.h \
            $${PWD}/include/data/notstable/CharacteristicCluster.h \
            $${PWD}/include/data/notstable/Classifer.h \
            $${PWD}/include/data/notstable/Descriptor.h \
@@ -75,8 +78,10 @@ HEADERS += $${PWD}/include/Population.h \
            $${PWD}/include/data/typeF/TypeF.h \
            $${PWD}/include/data/typeF/TypeTraitsF.h \
            $${PWD}/include/data/utility/BasicUtility.h \
+           $${PWD}/include/data/utility/Compression.h \
            $${PWD}/include/data/utility/Cryptography.h \
            $${PWD}/include/data/utility/BSPTree.h \
+           $${PWD}/include/data/utility/MemoryMappedFile.h \
            $${PWD}/include/data/utility/XML.h \
            $${PWD}/include/data/vec/Vec.h \
            $${PWD}/include/data/vec/VecN.h \
@@ -111,12 +116,16 @@ SOURCES += $${PWD}/src/algorithm/GeometricalTransformation.cpp \
            $${PWD}/src/data/distribution/DistributionMultiVariateArithmetic.cpp \
            $${PWD}/src/data/distribution/DistributionMultiVariateFromDataStructure.cpp \
            $${PWD}/src/data/germgrain/GermGrain.cpp \
+           $${PWD}/src/data/mat/GEMM.cpp \
            $${PWD}/src/data/mat/MatNDisplay.cpp \
            $${PWD}/src/data/mat/MatNInOut.cpp \
            $${PWD}/src/data/neuralnetwork/NeuralNetwork.cpp \
+           $${PWD}/src/data/neuralnetwork/NeuralNetworkQuantized.cpp \
            $${PWD}/src/data/notstable/Ransac.cpp \
            $${PWD}/src/data/ocr/OCR.cpp \
            $${PWD}/src/data/utility/BasicUtility.cpp \
+           $${PWD}/src/data/utility/Compression.cpp \
            $${PWD}/src/data/utility/Cryptography.cpp \
+           $${PWD}/src/data/utility/MemoryMappedFile.cpp \
            $${PWD}/src/data/utility/XML.cpp \
            $${PWD}/src/data/video/Video.cpp
@@ -15,6 +15,8 @@
 unsigned long MTRand_int32::state[624] = {0x0UL};
 int MTRand_int32::p(0);
 bool MTRand_int32::init = false;
+int MTRand_int32::_seed_generation = 0;
+unsigned long MTRand_int32::_seed_value = 0;
  #if defined(HAVE_THREAD)
 tthread::mutex MTRand_int32::_mutex;
 #endif
@@ -23,6 +25,12 @@ pop::F32 MTRand_int32::_max = 4294967296.;
 pop::F32 MTRand_int32::maxValue(){
     return _max;
 }
+int MTRand_int32::seedGeneration(){
+    return _seed_generation;
+}
+unsigned long MTRand_int32::seedValue(){
+    return _seed_value;
+}
 // inline for speed, must therefore reside in header file
  unsigned long MTRand_int32::twiddle(unsigned long u, unsigned long v) {
   return (((u & 0x80000000UL) | (v & 0x7FFFFFFFUL)) >> 1)
@@ -74,6 +82,8 @@ void MTRand_int32::seed(unsigned long s) {  // init by 32 bit seed
     state[i] &= 0xFFFFFFFFUL; // for > 32 bit machines
   }
   p = NMAX; // force gen_state() to be called for next random number
+  _seed_generation++;
+  _seed_value = s & 0xFFFFFFFFUL;
 }
 
 void MTRand_int32::seed(const unsigned long* array, int size) { // init by array
@@ -93,6 +103,9 @@ void MTRand_int32::seed(const unsigned long* array, int size) { // init by array
   }
   state[0] = 0x80000000UL; // MSB is 1; assuring non-zero initial array
   p = NMAX; // force gen_state() to be called for next random number
+  _seed_value = 0;
+  for (int k = 0; k < size; ++k)
+    _seed_value = (_seed_value * 1664525UL + array[k]) & 0xFFFFFFFFUL;
 }
 MTRand::MTRand() : MTRand_int32() {}
 MTRand::MTRand(unsigned long seed_value) : MTRand_int32(seed_value) {}
@@ -295,9 +295,16 @@ Mat2F32 LinearAlgebra::AATransposeEqualMDecomposition(const Mat2F32 &M){
     return A;
 }
 Vec2F32  LinearAlgebra::linearLeastSquares(const Mat2F32 &X,const VecF32& Y){
-    Mat2F32 Xtranspose=X.transpose();
-    Mat2F32 M(Xtranspose*X);
-    return M.inverse()*(Xtranspose*Y);
+    if(X.sizeI()==0||X.sizeJ()==0||Y.size()!=X.sizeI()){
+        std::cerr<<"In LinearAlgebra::linearLeastSquares, X must be non-empty and Y must have one element by row of X"<<std::endl;
+        return Vec2F32(0,0);
+    }
+    //X^t*X and X^t*Y without the copy of the transposed matrix
+    Mat2F32 M(X.sizeJ(),X.sizeJ());
+    GEMM::sgemm('T','N',X.sizeJ(),X.sizeJ(),X.sizeI(),1,X.data(),X.sizeJ(),X.data(),X.sizeJ(),0,M.data(),M.sizeJ());
+    VecF32 XtransposeY(X.sizeJ());
+    GEMM::sgemv('T',X.sizeI(),X.sizeJ(),1,X.data(),X.sizeJ(),&Y[0],0,&XtransposeY[0]);
+    return M.inverse()*XtransposeY;
 }
 
 }
@@ -6,6 +6,7 @@
 #include"data/mat/MatNDisplay.h"
 #include"algorithm/Draw.h"
 #include"algorithm/Statistics.h"
+#include<new>
 namespace pop
 {
 unsigned long Distribution::_init[] = {static_cast<unsigned long>(time(NULL)), 0x234, 0x345, 0x456};
@@ -16,6 +17,142 @@ MTRand_int32 &Distribution::irand(){
     return _irand;
 }
 
+//thread local storage is limited to trivial types before C++11
+#if (__cplusplus > 199711L)
+#define POP_THREAD_LOCAL thread_local
+#elif defined(_MSC_VER)
+#define POP_THREAD_LOCAL __declspec(thread)
+#else
+#define POP_THREAD_LOCAL __thread
+#endif
+namespace{
+UI64 splitMix64(UI64 & x){
+    UI64 z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+UI64 _seed_global = static_cast<UI64>(time(NULL));
+//incremented by setSeed, so that the thread engines are reseeded at their next use
+int _seed_generation = 1;
+//seed generation of the twister at the last setSeed
+int _twister_generation = 0;
+
+POP_THREAD_LOCAL RandomEngine * _engine_current = NULL;
+POP_THREAD_LOCAL int _engine_generation = 0;
+//storage of the engine of the thread (RandomEngine is trivially destructible)
+POP_THREAD_LOCAL UI64 _engine_storage[2];
+
+//seed and number of calls of Distribution::parallelSeed in the calling thread, set by RandomEngineChunk inside a chunk
+POP_THREAD_LOCAL UI64 _parallel_seed = 0;
+POP_THREAD_LOCAL UI64 _parallel_counter = 0;
+POP_THREAD_LOCAL int _parallel_generation = 0;
+POP_THREAD_LOCAL bool _parallel_chunk = false;
+
+//the chunks of forEachRangeParallel get their own engine (RandomEngineChunk)
+int threadIndex(){
+#if defined(HAVE_OPENMP)
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+//the last seed, given by setSeed or by Distribution::irand().seed(), and a generation incremented by both
+int seedGeneration(){
+    return _seed_generation+MTRand_int32::seedGeneration();
+}
+UI64 seedGlobal(){
+    if(MTRand_int32::seedGeneration()!=_twister_generation)
+        return static_cast<UI64>(MTRand_int32::seedValue());
+    return _seed_global;
+}
+}
+RandomEngine::RandomEngine(){
+    seed(0,0);
+}
+RandomEngine::RandomEngine(UI64 seed_value,UI64 stream){
+    seed(seed_value,stream);
+}
+void RandomEngine::seed(UI64 seed_value,UI64 stream){
+    //the hash of (seed,stream) is the starting point of the splitmix64 sequence filling the state
+    UI64 x = seed_value;
+    x = splitMix64(x)^stream;
+    x = splitMix64(x);
+    UI64 a = splitMix64(x);
+    UI64 b = splitMix64(x);
+    _s[0]=static_cast<UI32>(a);_s[1]=static_cast<UI32>(a>>32);
+    _s[2]=static_cast<UI32>(b);_s[3]=static_cast<UI32>(b>>32);
+    if(_s[0]==0&&_s[1]==0&&_s[2]==0&&_s[3]==0)
+        _s[0]=1;
+}
+UI32 RandomEngine::maxValue(){
+    return 0xFFFFFFFF;
+}
+
+RandomEngine & Distribution::engine(){
+    if(_engine_current!=NULL)
+        return *_engine_current;
+    RandomEngine * engine = reinterpret_cast<RandomEngine *>(_engine_storage);
+    const int generation = seedGeneration();
+    if(_engine_generation!=generation){
+        new(engine) RandomEngine(seedGlobal(),static_cast<UI64>(threadIndex()));
+        _engine_generation = generation;
+    }
+    return *engine;
+}
+void Distribution::setSeed(UI64 seed){
+    _seed_global = seed;
+    _seed_generation++;
+    _twister_generation = MTRand_int32::seedGeneration();
+}
+UI64 Distribution::parallelSeed(){
+    if(_parallel_chunk==false){
+        const int generation = seedGeneration();
+        if(_parallel_generation!=generation){
+            UI64 x = seedGlobal();
+            _parallel_seed = splitMix64(x)^static_cast<UI64>(threadIndex());
+            _parallel_counter = 0;
+            _parallel_generation = generation;
+        }
+    }
+    UI64 x = _parallel_seed^_parallel_counter;
+    _parallel_counter++;
+    return splitMix64(x);
+}
+RandomEngineChunk::RandomEngineChunk(UI64 seed,UI64 chunk)
+    :_engine(seed,chunk),_seed_previous(_parallel_seed),_counter_previous(_parallel_counter),_chunk_previous(_parallel_chunk)
+{
+    _engine_previous = Distribution::_setEngine(&_engine);
+    UI64 x = seed;
+    x = splitMix64(x)^chunk;
+    _parallel_seed = splitMix64(x);
+    _parallel_counter = 0;
+    _parallel_chunk = true;
+}
+RandomEngineChunk::~RandomEngineChunk(){
+    Distribution::_setEngine(_engine_previous);
+    _parallel_seed = _seed_previous;
+    _parallel_counter = _counter_previous;
+    _parallel_chunk = _chunk_previous;
+}
+RandomEngine * Distribution::_setEngine(RandomEngine * engine){
+    RandomEngine * previous = _engine_current;
+    _engine_current = engine;
+    return previous;
+}
+void Distribution::randomVariables(int n,F32 * out)const{
+    _randomVariables(n,out,engine());
+}
+void Distribution::randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    _randomVariables(n,out,engine);
+}
+void Distribution::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    RandomEngine * previous = _setEngine(&engine);
+    for(int i=0;i<n;i++)
+        out[i]=randomVariable();
+    _setEngine(previous);
+}
+
 void DistributionDisplay::display( const Distribution & d,F32 xmin,F32 xmax,F32 ymin,F32 ymax,int sizex,int sizey){
     Vec<const Distribution*> v_d;
     v_d.push_back(&d);
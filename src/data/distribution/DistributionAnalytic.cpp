@@ -52,11 +52,15 @@ F32 DistributionSign::operator()(F32 value)const {
 }
 
 F32 DistributionSign::randomVariable()const {
-    if(Distribution::irand()()%2==1)
+    if(Distribution::engine()()&1)
         return 1;
     else
         return -1;
 }
+void DistributionSign::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    for(int i=0;i<n;i++)
+        out[i]=(engine()&1) ? 1.f : -1.f;
+}
 
 DistributionUniformReal * DistributionUniformReal::clone()const 
 {
@@ -76,9 +80,14 @@ F32 DistributionUniformReal::operator()(F32 value)const
 }
 F32 DistributionUniformReal::randomVariable()const 
 {
-    F32 value = (_xmax-_xmin)* static_cast<F32>(irand()())/ static_cast<F32>(MTRand_int32::maxValue());
+    F32 value = (_xmax-_xmin)* Distribution::engine().randomReal();
     return _xmin + value;
 }
+void DistributionUniformReal::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    const F32 range = _xmax-_xmin;
+    for(int i=0;i<n;i++)
+        out[i]=_xmin + range*engine.randomReal();
+}
 
 //Uniform Distribution
 
@@ -96,7 +105,12 @@ DistributionUniformInt::DistributionUniformInt(int min, int max)
 }
 F32 DistributionUniformInt::randomVariable()const 
 {
-    return _xmin + static_cast<F32>(Distribution::irand().operator ()()%(1+_xmax-_xmin));
+    return _xmin + static_cast<F32>(Distribution::engine()(static_cast<UI32>(1+_xmax-_xmin)));
+}
+void DistributionUniformInt::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    const UI32 range = static_cast<UI32>(1+_xmax-_xmin);
+    for(int i=0;i<n;i++)
+        out[i]=_xmin + static_cast<F32>(engine(range));
 }
 F32 DistributionUniformInt::operator()(F32 value)const 
 {
@@ -130,11 +144,26 @@ F32 DistributionNormal::randomVariable()const
         x2 = 2.f * _real.randomVariable() - 1.f;
         w = x1 * x1 + x2 * x2;
 
-    } while ( w >= 1.0 );
+    } while ( w >= 1.0 || w == 0 );
 
     w = std::sqrt( (-2.f * std::log ( w ) ) / w );
     return (x1 * w)*_standard_deviation + _mean;
 }
+void DistributionNormal::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    //the polar method gives two independent variables by draw
+    for(int i=0;i<n;i+=2){
+        F32 x1, x2, w;
+        do {
+            x1 = 2.f * engine.randomReal() - 1.f;
+            x2 = 2.f * engine.randomReal() - 1.f;
+            w = x1 * x1 + x2 * x2;
+        } while ( w >= 1.0 || w == 0 );
+        w = std::sqrt( (-2.f * std::log ( w ) ) / w );
+        out[i] = (x1 * w)*_standard_deviation + _mean;
+        if(i+1<n)
+            out[i+1] = (x2 * w)*_standard_deviation + _mean;
+    }
+}
 F32 DistributionNormal::operator()(F32 value)const 
 {
 
@@ -181,7 +210,11 @@ DistributionExponential::DistributionExponential(F32 lambda)
 
 F32 DistributionExponential::randomVariable()const 
 {
-    return -std::log(distreal01.randomVariable())/_lambda;
+    return -std::log(1-distreal01.randomVariable())/_lambda;
+}
+void DistributionExponential::_randomVariables(int n,F32 * out,RandomEngine & engine)const{
+    for(int i=0;i<n;i++)
+        out[i]=-std::log(1-engine.randomReal())/_lambda;
 }
 F32 DistributionExponential::operator()(F32 value)const 
 {
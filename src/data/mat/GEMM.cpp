@@ -0,0 +1,411 @@
+#include"PopulationConfig.h"
+#include<algorithm>
+#include<vector>
+#include"data/mat/GEMM.h"
+#include"algorithm/ForEachFunctor.h"
+//the AVX kernels are used directly if the compilation enables AVX and FMA, otherwise compiled with a target attribute and chosen at run time
+#if defined(__AVX__)&&defined(__FMA__)
+#define POP_GEMM_AVX
+#define POP_GEMM_AVX_TARGET
+#elif (defined(__GNUC__)||defined(__clang__))&&(defined(__x86_64__)||defined(__i386__))
+#define POP_GEMM_AVX
+#define POP_GEMM_AVX_DISPATCH
+#define POP_GEMM_AVX_TARGET __attribute__((target("avx,fma")))
+#endif
+#if defined(POP_GEMM_AVX)
+#include<immintrin.h>
+#elif defined(__SSE2__)
+#include<emmintrin.h>
+#endif
+
+namespace pop
+{
+namespace{
+/*
+ * micro-kernels: ab(MR,NR) = sum_p a(p,0..MR-1)^t * b(p,0..NR-1) with a packed MR by MR and b packed NR by NR.
+ * MC (multiple of MR) and KC size the packed block of A for L2, NC (multiple of NR) the columns of B used for a packed block of A.
+ * GEMMKernel is the kernel of the compilation target (SSE2 or scalar), GEMMKernelAVX the AVX with FMA one.
+ */
+template<typename T>
+struct GEMMKernel
+{
+    enum{MR=4,NR=4,MC=128,KC=256,NC=4096};
+    static void micro(int kc,const T * a,const T * b,T * ab){
+        T c[MR*NR];
+        std::fill(c,c+MR*NR,T(0));
+        for(int p=0;p<kc;p++,a+=MR,b+=NR){
+            for(int i=0;i<MR;i++){
+                const T a_i=a[i];
+                for(int j=0;j<NR;j++)
+                    c[i*NR+j]+=a_i*b[j];
+            }
+        }
+        std::copy(c,c+MR*NR,ab);
+    }
+};
+#if defined(__SSE2__)
+template<>
+struct GEMMKernel<F32>
+{
+    enum{MR=4,NR=8,MC=128,KC=256,NC=4096};
+    static void micro(int kc,const F32 * a,const F32 * b,F32 * ab){
+        __m128 c00=_mm_setzero_ps(),c01=_mm_setzero_ps(),c10=_mm_setzero_ps(),c11=_mm_setzero_ps();
+        __m128 c20=_mm_setzero_ps(),c21=_mm_setzero_ps(),c30=_mm_setzero_ps(),c31=_mm_setzero_ps();
+        for(int p=0;p<kc;p++,a+=MR,b+=NR){
+            const __m128 b0=_mm_loadu_ps(b),b1=_mm_loadu_ps(b+4);
+            __m128 a_i=_mm_set1_ps(a[0]);
+            c00=_mm_add_ps(c00,_mm_mul_ps(a_i,b0));c01=_mm_add_ps(c01,_mm_mul_ps(a_i,b1));
+            a_i=_mm_set1_ps(a[1]);
+            c10=_mm_add_ps(c10,_mm_mul_ps(a_i,b0));c11=_mm_add_ps(c11,_mm_mul_ps(a_i,b1));
+            a_i=_mm_set1_ps(a[2]);
+            c20=_mm_add_ps(c20,_mm_mul_ps(a_i,b0));c21=_mm_add_ps(c21,_mm_mul_ps(a_i,b1));
+            a_i=_mm_set1_ps(a[3]);
+            c30=_mm_add_ps(c30,_mm_mul_ps(a_i,b0));c31=_mm_add_ps(c31,_mm_mul_ps(a_i,b1));
+        }
+        _mm_storeu_ps(ab   ,c00);_mm_storeu_ps(ab+4 ,c01);
+        _mm_storeu_ps(ab+8 ,c10);_mm_storeu_ps(ab+12,c11);
+        _mm_storeu_ps(ab+16,c20);_mm_storeu_ps(ab+20,c21);
+        _mm_storeu_ps(ab+24,c30);_mm_storeu_ps(ab+28,c31);
+    }
+};
+template<>
+struct GEMMKernel<F64>
+{
+    enum{MR=4,NR=4,MC=128,KC=256,NC=4096};
+    static void micro(int kc,const F64 * a,const F64 * b,F64 * ab){
+        __m128d c00=_mm_setzero_pd(),c01=_mm_setzero_pd(),c10=_mm_setzero_pd(),c11=_mm_setzero_pd();
+        __m128d c20=_mm_setzero_pd(),c21=_mm_setzero_pd(),c30=_mm_setzero_pd(),c31=_mm_setzero_pd();
+        for(int p=0;p<kc;p++,a+=MR,b+=NR){
+            const __m128d b0=_mm_loadu_pd(b),b1=_mm_loadu_pd(b+2);
+            __m128d a_i=_mm_set1_pd(a[0]);
+            c00=_mm_add_pd(c00,_mm_mul_pd(a_i,b0));c01=_mm_add_pd(c01,_mm_mul_pd(a_i,b1));
+            a_i=_mm_set1_pd(a[1]);
+            c10=_mm_add_pd(c10,_mm_mul_pd(a_i,b0));c11=_mm_add_pd(c11,_mm_mul_pd(a_i,b1));
+            a_i=_mm_set1_pd(a[2]);
+            c20=_mm_add_pd(c20,_mm_mul_pd(a_i,b0));c21=_mm_add_pd(c21,_mm_mul_pd(a_i,b1));
+            a_i=_mm_set1_pd(a[3]);
+            c30=_mm_add_pd(c30,_mm_mul_pd(a_i,b0));c31=_mm_add_pd(c31,_mm_mul_pd(a_i,b1));
+        }
+        _mm_storeu_pd(ab   ,c00);_mm_storeu_pd(ab+2 ,c01);
+        _mm_storeu_pd(ab+4 ,c10);_mm_storeu_pd(ab+6 ,c11);
+        _mm_storeu_pd(ab+8 ,c20);_mm_storeu_pd(ab+10,c21);
+        _mm_storeu_pd(ab+12,c30);_mm_storeu_pd(ab+14,c31);
+    }
+};
+#endif
+#if defined(POP_GEMM_AVX)
+template<typename T>
+struct GEMMKernelAVX;
+template<>
+struct GEMMKernelAVX<F32>
+{
+    enum{MR=6,NR=16,MC=144,KC=256,NC=4096};
+    POP_GEMM_AVX_TARGET static void micro(int kc,const F32 * a,const F32 * b,F32 * ab){
+        __m256 c00=_mm256_setzero_ps(),c01=_mm256_setzero_ps(),c10=_mm256_setzero_ps(),c11=_mm256_setzero_ps();
+        __m256 c20=_mm256_setzero_ps(),c21=_mm256_setzero_ps(),c30=_mm256_setzero_ps(),c31=_mm256_setzero_ps();
+        __m256 c40=_mm256_setzero_ps(),c41=_mm256_setzero_ps(),c50=_mm256_setzero_ps(),c51=_mm256_setzero_ps();
+        for(int p=0;p<kc;p++,a+=MR,b+=NR){
+            const __m256 b0=_mm256_loadu_ps(b),b1=_mm256_loadu_ps(b+8);
+            __m256 a_i=_mm256_broadcast_ss(a);
+            c00=_mm256_fmadd_ps(a_i,b0,c00);c01=_mm256_fmadd_ps(a_i,b1,c01);
+            a_i=_mm256_broadcast_ss(a+1);
+            c10=_mm256_fmadd_ps(a_i,b0,c10);c11=_mm256_fmadd_ps(a_i,b1,c11);
+            a_i=_mm256_broadcast_ss(a+2);
+            c20=_mm256_fmadd_ps(a_i,b0,c20);c21=_mm256_fmadd_ps(a_i,b1,c21);
+            a_i=_mm256_broadcast_ss(a+3);
+            c30=_mm256_fmadd_ps(a_i,b0,c30);c31=_mm256_fmadd_ps(a_i,b1,c31);
+            a_i=_mm256_broadcast_ss(a+4);
+            c40=_mm256_fmadd_ps(a_i,b0,c40);c41=_mm256_fmadd_ps(a_i,b1,c41);
+            a_i=_mm256_broadcast_ss(a+5);
+            c50=_mm256_fmadd_ps(a_i,b0,c50);c51=_mm256_fmadd_ps(a_i,b1,c51);
+        }
+        _mm256_storeu_ps(ab   ,c00);_mm256_storeu_ps(ab+8  ,c01);
+        _mm256_storeu_ps(ab+16,c10);_mm256_storeu_ps(ab+24 ,c11);
+        _mm256_storeu_ps(ab+32,c20);_mm256_storeu_ps(ab+40 ,c21);
+        _mm256_storeu_ps(ab+48,c30);_mm256_storeu_ps(ab+56 ,c31);
+        _mm256_storeu_ps(ab+64,c40);_mm256_storeu_ps(ab+72 ,c41);
+        _mm256_storeu_ps(ab+80,c50);_mm256_storeu_ps(ab+88 ,c51);
+    }
+};
+template<>
+struct GEMMKernelAVX<F64>
+{
+    enum{MR=6,NR=8,MC=96,KC=256,NC=4096};
+    POP_GEMM_AVX_TARGET static void micro(int kc,const F64 * a,const F64 * b,F64 * ab){
+        __m256d c00=_mm256_setzero_pd(),c01=_mm256_setzero_pd(),c10=_mm256_setzero_pd(),c11=_mm256_setzero_pd();
+        __m256d c20=_mm256_setzero_pd(),c21=_mm256_setzero_pd(),c30=_mm256_setzero_pd(),c31=_mm256_setzero_pd();
+        __m256d c40=_mm256_setzero_pd(),c41=_mm256_setzero_pd(),c50=_mm256_setzero_pd(),c51=_mm256_setzero_pd();
+        for(int p=0;p<kc;p++,a+=MR,b+=NR){
+            const __m256d b0=_mm256_loadu_pd(b),b1=_mm256_loadu_pd(b+4);
+            __m256d a_i=_mm256_broadcast_sd(a);
+            c00=_mm256_fmadd_pd(a_i,b0,c00);c01=_mm256_fmadd_pd(a_i,b1,c01);
+            a_i=_mm256_broadcast_sd(a+1);
+            c10=_mm256_fmadd_pd(a_i,b0,c10);c11=_mm256_fmadd_pd(a_i,b1,c11);
+            a_i=_mm256_broadcast_sd(a+2);
+            c20=_mm256_fmadd_pd(a_i,b0,c20);c21=_mm256_fmadd_pd(a_i,b1,c21);
+            a_i=_mm256_broadcast_sd(a+3);
+            c30=_mm256_fmadd_pd(a_i,b0,c30);c31=_mm256_fmadd_pd(a_i,b1,c31);
+            a_i=_mm256_broadcast_sd(a+4);
+            c40=_mm256_fmadd_pd(a_i,b0,c40);c41=_mm256_fmadd_pd(a_i,b1,c41);
+            a_i=_mm256_broadcast_sd(a+5);
+            c50=_mm256_fmadd_pd(a_i,b0,c50);c51=_mm256_fmadd_pd(a_i,b1,c51);
+        }
+        _mm256_storeu_pd(ab   ,c00);_mm256_storeu_pd(ab+4 ,c01);
+        _mm256_storeu_pd(ab+8 ,c10);_mm256_storeu_pd(ab+12,c11);
+        _mm256_storeu_pd(ab+16,c20);_mm256_storeu_pd(ab+20,c21);
+        _mm256_storeu_pd(ab+24,c30);_mm256_storeu_pd(ab+28,c31);
+        _mm256_storeu_pd(ab+32,c40);_mm256_storeu_pd(ab+36,c41);
+        _mm256_storeu_pd(ab+40,c50);_mm256_storeu_pd(ab+44,c51);
+    }
+};
+//true if the processor executes the AVX with FMA kernels
+bool hasKernelAVX(){
+#if defined(POP_GEMM_AVX_DISPATCH)
+    static const bool has = __builtin_cpu_supports("avx")&&__builtin_cpu_supports("fma");
+    return has;
+#else
+    return true;
+#endif
+}
+#endif
+
+template<typename T,typename Kernel>
+struct GEMMEngine
+{
+    enum{MR=Kernel::MR,NR=Kernel::NR,KC=Kernel::KC,NC=Kernel::NC};
+    bool _transA,_transB;
+    int _m,_n,_k;
+    T _alpha;
+    const T * _A;
+    int _lda;
+    const T * _B;
+    int _ldb;
+    T * _C;
+    int _ldc;
+    int _mc;
+    //op(B) packed once: the rows [pc,pc+kc) start at pc*_n_pack, in panels of NR columns
+    int _n_pack;
+    std::vector<T> _B_packed;
+
+    //op(A)(i,p) in slivers of MR rows, padded with 0
+    void packA(int ic,int mc,int pc,int kc,T * packed)const{
+        for(int ir=0;ir<mc;ir+=MR){
+            const int mr=std::min(static_cast<int>(MR),mc-ir);
+            for(int i=0;i<MR;i++){
+                T * out = packed+i;
+                if(i>=mr){
+                    for(int p=0;p<kc;p++,out+=MR)
+                        *out=0;
+                }else if(_transA==false){
+                    const T * in = _A+static_cast<std::size_t>(ic+ir+i)*_lda+pc;
+                    for(int p=0;p<kc;p++,out+=MR)
+                        *out=in[p];
+                }else{
+                    const T * in = _A+static_cast<std::size_t>(pc)*_lda+ic+ir+i;
+                    for(int p=0;p<kc;p++,out+=MR,in+=_lda)
+                        *out=*in;
+                }
+            }
+            packed+=MR*kc;
+        }
+    }
+    //op(B)(p,j) in panels of NR columns, padded with 0
+    void packB(){
+        for(int pc=0;pc<_k;pc+=KC){
+            const int kc=std::min(static_cast<int>(KC),_k-pc);
+            T * packed = &_B_packed[0]+static_cast<std::size_t>(pc)*_n_pack;
+            for(int jr=0;jr<_n;jr+=NR){
+                const int nr=std::min(static_cast<int>(NR),_n-jr);
+                for(int p=0;p<kc;p++){
+                    T * out = packed+p*NR;
+                    if(_transB==false){
+                        const T * in = _B+static_cast<std::size_t>(pc+p)*_ldb+jr;
+                        for(int j=0;j<nr;j++)
+                            out[j]=in[j];
+                    }else{
+                        const T * in = _B+static_cast<std::size_t>(jr)*_ldb+pc+p;
+                        for(int j=0;j<nr;j++)
+                            out[j]=in[static_cast<std::size_t>(j)*_ldb];
+                    }
+                    for(int j=nr;j<NR;j++)
+                        out[j]=0;
+                }
+                packed+=NR*kc;
+            }
+        }
+    }
+    //row blocks [block_begin,block_end) of mc rows, multiplied by all the panels of op(B)
+    void operator()(int block_begin,int block_end){
+        std::vector<T> A_packed(static_cast<std::size_t>((_mc+MR-1)/MR)*MR*KC);
+        T ab[MR*NR];
+        for(int block=block_begin;block<block_end;block++){
+            const int ic=block*_mc;
+            const int mc=std::min(_mc,_m-ic);
+            for(int jc=0;jc<_n;jc+=NC){
+                const int nc=std::min(static_cast<int>(NC),_n-jc);
+                for(int pc=0;pc<_k;pc+=KC){
+                    const int kc=std::min(static_cast<int>(KC),_k-pc);
+                    packA(ic,mc,pc,kc,&A_packed[0]);
+                    const T * B_packed = &_B_packed[0]+static_cast<std::size_t>(pc)*_n_pack;
+                    for(int jr=jc;jr<jc+nc;jr+=NR){
+                        const int nr=std::min(static_cast<int>(NR),_n-jr);
+                        const T * b = B_packed+static_cast<std::size_t>(jr/NR)*NR*kc;
+                        for(int ir=0;ir<mc;ir+=MR){
+                            const int mr=std::min(static_cast<int>(MR),mc-ir);
+                            Kernel::micro(kc,&A_packed[0]+static_cast<std::size_t>(ir/MR)*MR*kc,b,ab);
+                            T * c = _C+static_cast<std::size_t>(ic+ir)*_ldc+jr;
+                            for(int i=0;i<mr;i++,c+=_ldc){
+                                for(int j=0;j<nr;j++)
+                                    c[j]+=_alpha*ab[i*NR+j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    void run(){
+        const int nbr_thread = (static_cast<F64>(_m)*_n*_k<64.*64*64) ? 1 : getNumberThreadParallel();
+        //row blocks small enough to feed all the threads
+        _mc = std::min(static_cast<int>(Kernel::MC),((_m+nbr_thread-1)/nbr_thread+MR-1)/MR*MR);
+        const int nbr_block = (_m+_mc-1)/_mc;
+        _n_pack = (_n+NR-1)/NR*NR;
+        _B_packed.resize(static_cast<std::size_t>(_k)*_n_pack);
+        packB();
+        //a single parallel loop on the row blocks, the sums on p are in the same order for any number of threads
+        if(nbr_thread<=1)
+            (*this)(0,nbr_block);
+        else
+            forEachRangeParallel(0,nbr_block,*this);
+    }
+};
+
+template<typename T,typename Kernel>
+void gemmKernel(bool transA,bool transB,int m,int n,int k,T alpha,const T * A,int lda,const T * B,int ldb,T * C,int ldc){
+    GEMMEngine<T,Kernel> engine;
+    engine._transA = transA;
+    engine._transB = transB;
+    engine._m=m;engine._n=n;engine._k=k;
+    engine._alpha=alpha;
+    engine._A=A;engine._lda=lda;
+    engine._B=B;engine._ldb=ldb;
+    engine._C=C;engine._ldc=ldc;
+    engine.run();
+}
+template<typename T>
+void gemm(char transA,char transB,int m,int n,int k,T alpha,const T * A,int lda,const T * B,int ldb,T beta,T * C,int ldc){
+    if(m<=0||n<=0)
+        return;
+    for(int i=0;i<m;i++){
+        T * c = C+static_cast<std::size_t>(i)*ldc;
+        if(beta==0)
+            std::fill(c,c+n,T(0));
+        else if(beta!=1)
+            for(int j=0;j<n;j++)
+                c[j]*=beta;
+    }
+    if(alpha==0||k<=0)
+        return;
+    const bool trans_A = (transA=='T'||transA=='t');
+    const bool trans_B = (transB=='T'||transB=='t');
+#if defined(POP_GEMM_AVX)
+    if(hasKernelAVX()){
+        gemmKernel<T,GEMMKernelAVX<T> >(trans_A,trans_B,m,n,k,alpha,A,lda,B,ldb,C,ldc);
+        return;
+    }
+#endif
+    gemmKernel<T,GEMMKernel<T> >(trans_A,trans_B,m,n,k,alpha,A,lda,B,ldb,C,ldc);
+}
+
+template<typename T>
+struct GEMVEngine
+{
+    int _n;
+    T _alpha;
+    const T * _A;
+    int _lda;
+    const T * _x;
+    T * _y;
+    //y(i) += alpha*<A(i,.),x> for the rows [begin,end), with eight independent partial sums the compiler vectorizes
+    void operator()(int begin,int end){
+        for(int i=begin;i<end;i++){
+            const T * a = _A+static_cast<std::size_t>(i)*_lda;
+            T s[8]={0,0,0,0,0,0,0,0};
+            int j=0;
+            for(;j+8<=_n;j+=8){
+                for(int l=0;l<8;l++)
+                    s[l]+=a[j+l]*_x[j+l];
+            }
+            T sum=((s[0]+s[1])+(s[2]+s[3]))+((s[4]+s[5])+(s[6]+s[7]));
+            for(;j<_n;j++)
+                sum+=a[j]*_x[j];
+            _y[i]+=_alpha*sum;
+        }
+    }
+};
+template<typename T>
+struct GEMVTransposeEngine
+{
+    int _m,_n;
+    T _alpha;
+    const T * _A;
+    int _lda;
+    const T * _x;
+    T * _y;
+    //y(j) += alpha*sum_i A(i,j) x(i) for the columns [begin,end), one axpy per row
+    void operator()(int begin,int end){
+        for(int i=0;i<_m;i++){
+            const T weight = _alpha*_x[i];
+            const T * a = _A+static_cast<std::size_t>(i)*_lda;
+            for(int j=begin;j<end;j++)
+                _y[j]+=weight*a[j];
+        }
+    }
+};
+
+template<typename T>
+void gemv(char transA,int m,int n,T alpha,const T * A,int lda,const T * x,T beta,T * y){
+    const bool trans = (transA=='T'||transA=='t');
+    const int size_y = trans ? n : m;
+    if(size_y<=0)
+        return;
+    if(beta==0)
+        std::fill(y,y+size_y,T(0));
+    else if(beta!=1)
+        for(int i=0;i<size_y;i++)
+            y[i]*=beta;
+    if(alpha==0||m<=0||n<=0)
+        return;
+    //a product of less than 100000 multiply-adds is faster on a single thread
+    const bool parallel = static_cast<F64>(m)*n>=100000;
+    if(trans==false){
+        GEMVEngine<T> engine;
+        engine._n=n;engine._alpha=alpha;engine._A=A;engine._lda=lda;engine._x=x;engine._y=y;
+        if(parallel)
+            forEachRangeParallel(0,m,engine);
+        else
+            engine(0,m);
+    }else{
+        GEMVTransposeEngine<T> engine;
+        engine._m=m;engine._n=n;engine._alpha=alpha;engine._A=A;engine._lda=lda;engine._x=x;engine._y=y;
+        if(parallel)
+            forEachRangeParallel(0,n,engine);
+        else
+            engine(0,n);
+    }
+}
+}
+
+void GEMM::sgemm(char transA,char transB,int m,int n,int k,F32 alpha,const F32 * A,int lda,const F32 * B,int ldb,F32 beta,F32 * C,int ldc){
+    gemm(transA,transB,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc);
+}
+void GEMM::dgemm(char transA,char transB,int m,int n,int k,F64 alpha,const F64 * A,int lda,const F64 * B,int ldb,F64 beta,F64 * C,int ldc){
+    gemm(transA,transB,m,n,k,alpha,A,lda,B,ldb,beta,C,ldc);
+}
+void GEMM::sgemv(char transA,int m,int n,F32 alpha,const F32 * A,int lda,const F32 * x,F32 beta,F32 * y){
+    gemv(transA,m,n,alpha,A,lda,x,beta,y);
+}
+void GEMM::dgemv(char transA,int m,int n,F64 alpha,const F64 * A,int lda,const F64 * x,F64 beta,F64 * y){
+    gemv(transA,m,n,alpha,A,lda,x,beta,y);
+}
+}
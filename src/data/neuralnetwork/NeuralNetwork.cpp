@@ -5,9 +5,30 @@
 #include "data/mat/MatNDisplay.h"
 #include "PopulationConfig.h"
 #include "algorithm/Arithmetic.h"
+#include "algorithm/ForEachFunctor.h"
+#include "data/mat/GEMM.h"
 #include <cmath>
+#include <cstring>
+#include <fstream>
 namespace pop {
 
+//    \cond HIDDEN_SYMBOLS
+/*
+ * scatter-add of the im2col matrix in the previous maps, the maps being independent are distributed on the threads
+ */
+struct __FunctorCol2Im
+{
+    const NeuralLayerMatrixConvolutionSubScaling::Geometry & _geometry;
+    const F32 * _col;
+    F32 * _d_E_X_previous;
+    __FunctorCol2Im(const NeuralLayerMatrixConvolutionSubScaling::Geometry & geometry,const F32 * col,F32 * d_E_X_previous)
+        :_geometry(geometry),_col(col),_d_E_X_previous(d_E_X_previous){}
+    void operator()(int map_begin,int map_end){
+        _geometry.col2im(_col,_d_E_X_previous,map_begin,map_end);
+    }
+};
+//    \endcond
+
 Mat2UI8 MNISTNeuralNetLeCun5::elasticDeformation(const Mat2UI8 &m, F32 sigma,F32 alpha){
     return GeometricalTransformation::elasticDeformation(m,sigma,alpha);
 }
@@ -308,6 +329,9 @@ NeuralLayerLinear&  NeuralLayerLinear::operator=(const NeuralLayerLinear & net){
 VecF32& NeuralLayerLinear::X(){return __X;}
 const VecF32& NeuralLayerLinear::X()const{return __X;}
 VecF32& NeuralLayerLinear::d_E_X(){return _d_E_X;}
+const Mat2F32& NeuralLayerLinear::X_batch()const{return _X_batch;}
+Mat2F32& NeuralLayerLinear::X_batch(){return _X_batch;}
+Mat2F32& NeuralLayerLinear::d_E_X_batch(){return _d_E_X_batch;}
 void NeuralLayerLinear::setTrainable(bool istrainable){
     if(istrainable==true){
         this->_d_E_Y = this->__X;
@@ -316,6 +340,44 @@ void NeuralLayerLinear::setTrainable(bool istrainable){
         this->_d_E_Y.clear();
         this->_d_E_X.clear();
     }
+    if(_X_batch.sizeI()!=0)
+        this->setBatchSize(_X_batch.sizeI());
+}
+void NeuralLayerLinear::setBatchSize(unsigned int nbr_sample){
+    _X_batch.resize(nbr_sample,__X.size());
+    _Y_batch.resize(nbr_sample,__X.size());
+    if(_d_E_X.size()!=0){
+        _d_E_X_batch.resize(nbr_sample,__X.size());
+        _d_E_Y_batch.resize(nbr_sample,__X.size());
+    }else{
+        _d_E_X_batch.clear();
+        _d_E_Y_batch.clear();
+    }
+}
+void NeuralLayerLinear::forwardBatchCPU(NeuralLayer& layer_previous){
+    const Mat2F32 & X_previous = layer_previous.X_batch();
+    VecF32 & X_previous_sample = layer_previous.X();
+    for(unsigned int index_sample=0;index_sample<_X_batch.sizeI();index_sample++){
+        std::copy(X_previous.begin()+index_sample*X_previous.sizeJ(),X_previous.begin()+(index_sample+1)*X_previous.sizeJ(),X_previous_sample.begin());
+        this->forwardCPU(layer_previous);
+        std::copy(__X.begin(),__X.end(),_X_batch.begin()+index_sample*_X_batch.sizeJ());
+        std::copy(__Y.begin(),__Y.end(),_Y_batch.begin()+index_sample*_Y_batch.sizeJ());
+    }
+}
+void NeuralLayerLinear::backwardBatchCPU(NeuralLayer& layer_previous){
+    const Mat2F32 & X_previous = layer_previous.X_batch();
+    VecF32 & X_previous_sample = layer_previous.X();
+    Mat2F32 & d_E_X_previous = layer_previous.d_E_X_batch();
+    for(unsigned int index_sample=0;index_sample<_X_batch.sizeI();index_sample++){
+        //restore the state of the forward propagation of this sample (the max pool layer stores its arg max in __Y)
+        std::copy(X_previous.begin()+index_sample*X_previous.sizeJ(),X_previous.begin()+(index_sample+1)*X_previous.sizeJ(),X_previous_sample.begin());
+        std::copy(_X_batch.begin()+index_sample*_X_batch.sizeJ(),_X_batch.begin()+(index_sample+1)*_X_batch.sizeJ(),__X.begin());
+        std::copy(_Y_batch.begin()+index_sample*_Y_batch.sizeJ(),_Y_batch.begin()+(index_sample+1)*_Y_batch.sizeJ(),__Y.begin());
+        std::copy(_d_E_X_batch.begin()+index_sample*_d_E_X_batch.sizeJ(),_d_E_X_batch.begin()+(index_sample+1)*_d_E_X_batch.sizeJ(),_d_E_X.begin());
+        this->backwardCPU(layer_previous);
+        if(d_E_X_previous.sizeI()!=0)
+            std::copy(layer_previous.d_E_X().begin(),layer_previous.d_E_X().end(),d_E_X_previous.begin()+index_sample*d_E_X_previous.sizeJ());
+    }
 }
 
 void NeuralLayerLinear::print(){
@@ -366,19 +428,21 @@ Vec<MatN<2,F32> >& NeuralLayerMatrix::d_E_X_map(){return _d_E_X_reference;}
 
 void NeuralLayerMatrix::setTrainable(bool istrainable){
     NeuralLayerLinear::setTrainable(istrainable);
+    //the error maps reference the error vectors just allocated (also for a copied layer)
+    this->_d_E_Y_reference.clear();
+    this->_d_E_X_reference.clear();
     if(istrainable==true){
         for(unsigned int i=0;i<_X_reference.size();i++){
             _d_E_Y_reference.push_back(MatN<2,F32>(_X_reference(0).getDomain(),_d_E_Y.data()+_X_reference(0).getDomain().multCoordinate()*i));
             _d_E_X_reference.push_back(MatN<2,F32>(_X_reference(0).getDomain(),_d_E_X.data()+_X_reference(0).getDomain().multCoordinate()*i));
         }
-    }else{
-        this->_d_E_Y_reference.clear();
-        this->_d_E_X_reference.clear();
     }
 }
-NeuralLayerLinearFullyConnected::NeuralLayerLinearFullyConnected(unsigned int nbr_neurons_previous,unsigned int nbr_neurons)
+NeuralLayerLinearFullyConnected::NeuralLayerLinearFullyConnected(unsigned int nbr_neurons_previous,unsigned int nbr_neurons,bool random_weight)
     :NeuralLayerLinear(nbr_neurons),_W(nbr_neurons,nbr_neurons_previous+1),_X_biais(nbr_neurons_previous+1,1)
 {
+    if(random_weight==false)
+        return;
     //normalize tbe number inverse square root of the connection feeding into the nodes)
     DistributionNormal n(0,1.f/std::sqrt(nbr_neurons_previous+1.f));
     for(unsigned int i=0;i<_W.size();i++){
@@ -386,8 +450,8 @@ NeuralLayerLinearFullyConnected::NeuralLayerLinearFullyConnected(unsigned int nb
     }
 }
 
-NeuralLayerLinearFullyConnectedSoftmax::NeuralLayerLinearFullyConnectedSoftmax(unsigned int nbr_neurons_previous, unsigned int nbr_neurons)
-    : NeuralLayerLinearFullyConnected(nbr_neurons_previous, nbr_neurons)
+NeuralLayerLinearFullyConnectedSoftmax::NeuralLayerLinearFullyConnectedSoftmax(unsigned int nbr_neurons_previous, unsigned int nbr_neurons,bool random_weight)
+    : NeuralLayerLinearFullyConnected(nbr_neurons_previous, nbr_neurons,random_weight)
 {
 
 }
@@ -395,15 +459,31 @@ NeuralLayerLinearFullyConnectedSoftmax::NeuralLayerLinearFullyConnectedSoftmax(u
 void NeuralLayerLinearFullyConnected::setTrainable(bool istrainable){
     NeuralLayerLinear::setTrainable(istrainable);
     if(istrainable==true){
+        if(this->_W.isMapped()){
+            //the weights mapped from a binary model are read-only, the learning works on a copy in memory
+            Mat2F32 W(this->_W);
+            this->_W = W;
+        }
         this->_d_E_W = this->_W;
     }else{
         this->_d_E_W.clear();
     }
 }
 
-void NeuralLayerLinearFullyConnected::forwardCPU(const NeuralLayer& layer_previous){
+void NeuralLayerLinearFullyConnected::_forwardLinear(const NeuralLayer& layer_previous){
     std::copy(layer_previous.X().begin(),layer_previous.X().end(),this->_X_biais.begin());
-    this->__Y = this->_W * this->_X_biais;
+    //in place matrix-vector product (no allocation per sample)
+    Mat2F32::const_iterator it_w = this->_W.begin();
+    for(unsigned int i=0;i<__Y.size();i++){
+        F32 sum=0;
+        for(VecF32::const_iterator it_x=this->_X_biais.begin();it_x!=this->_X_biais.end();it_x++,it_w++)
+            sum+=(*it_w) * (*it_x);
+        this->__Y(i)=sum;
+    }
+}
+
+void NeuralLayerLinearFullyConnected::forwardCPU(const NeuralLayer& layer_previous){
+    _forwardLinear(layer_previous);
     for(unsigned int i=0;i<__Y.size();i++){
         this->__X(i) = NeuronSigmoid::activation(this->__Y(i));
     }
@@ -411,8 +491,7 @@ void NeuralLayerLinearFullyConnected::forwardCPU(const NeuralLayer& layer_previo
 }
 
 void NeuralLayerLinearFullyConnectedSoftmax::forwardCPU(const NeuralLayer &layer_previous) {
-    std::copy(layer_previous.X().begin(),layer_previous.X().end(),this->_X_biais.begin());
-    this->__Y = this->_W * this->_X_biais;
+    _forwardLinear(layer_previous);
     for(unsigned int i=0;i<__Y.size();i++){
         //this->__X(i) = NeuronSigmoid::activation(this->__Y(i));
         // ignore non-linearity
@@ -465,6 +544,71 @@ void NeuralLayerLinearFullyConnectedSoftmax::backwardCPU(NeuralLayer &layer_prev
     }
 }
 
+void NeuralLayerLinearFullyConnected::_forwardBatchLinear(const NeuralLayer& layer_previous){
+    const Mat2F32 & X_previous = layer_previous.X_batch();
+    const int nbr_sample = _X_batch.sizeI();
+    const int nbr_in  = _W.sizeJ()-1;
+    const int nbr_out = _W.sizeI();
+    //Y_batch = biais + X_batch_previous * W^t (the biais column is skipped with the leading dimension)
+    for(int index_sample=0;index_sample<nbr_sample;index_sample++){
+        for(int i=0;i<nbr_out;i++){
+            _Y_batch(index_sample,i)=_W(i,nbr_in);
+        }
+    }
+    GEMM::sgemm('N','T',nbr_sample,nbr_out,nbr_in,1,X_previous.data(),nbr_in,_W.data(),nbr_in+1,1,_Y_batch.data(),nbr_out);
+}
+
+void NeuralLayerLinearFullyConnected::_backwardBatchLinear(NeuralLayer& layer_previous){
+    const Mat2F32 & X_previous = layer_previous.X_batch();
+    Mat2F32 & d_E_X_previous = layer_previous.d_E_X_batch();
+    const int nbr_sample = _X_batch.sizeI();
+    const int nbr_in  = _W.sizeJ()-1;
+    const int nbr_out = _W.sizeI();
+    //d_E_W = d_E_Y_batch^t * (X_batch_previous,1), summed over the samples
+    _d_E_W.fill(0);
+    GEMM::sgemm('T','N',nbr_out,nbr_in,nbr_sample,1,_d_E_Y_batch.data(),nbr_out,X_previous.data(),nbr_in,1,_d_E_W.data(),nbr_in+1);
+    for(int index_sample=0;index_sample<nbr_sample;index_sample++){
+        for(int i=0;i<nbr_out;i++){
+            _d_E_W(i,nbr_in)+=_d_E_Y_batch(index_sample,i);
+        }
+    }
+    //d_E_X_batch_previous = d_E_Y_batch * W (the biais column is skipped with the leading dimension)
+    if(d_E_X_previous.sizeI()!=0){
+        GEMM::sgemm('N','N',nbr_sample,nbr_in,nbr_out,1,_d_E_Y_batch.data(),nbr_out,_W.data(),nbr_in+1,0,d_E_X_previous.data(),nbr_in);
+    }
+}
+
+void NeuralLayerLinearFullyConnected::forwardBatchCPU(NeuralLayer& layer_previous){
+    _forwardBatchLinear(layer_previous);
+    Mat2F32::const_iterator it_y = _Y_batch.begin();
+    for(Mat2F32::iterator it_x = _X_batch.begin();it_x!=_X_batch.end();it_x++,it_y++){
+        *it_x = NeuronSigmoid::activation(*it_y);
+    }
+}
+
+void NeuralLayerLinearFullyConnected::backwardBatchCPU(NeuralLayer& layer_previous){
+    Mat2F32::const_iterator it_x = _X_batch.begin();
+    Mat2F32::const_iterator it_d_e_x = _d_E_X_batch.begin();
+    for(Mat2F32::iterator it_d_e_y = _d_E_Y_batch.begin();it_d_e_y!=_d_E_Y_batch.end();it_d_e_y++,it_x++,it_d_e_x++){
+        *it_d_e_y = (*it_d_e_x)*NeuronSigmoid::derivedActivation(*it_x);
+    }
+    _backwardBatchLinear(layer_previous);
+}
+
+void NeuralLayerLinearFullyConnectedSoftmax::forwardBatchCPU(NeuralLayer& layer_previous){
+    _forwardBatchLinear(layer_previous);
+    std::copy(_Y_batch.begin(),_Y_batch.end(),_X_batch.begin());
+    for(unsigned int index_sample=0;index_sample<_X_batch.sizeI();index_sample++){
+        _sm.softmax(_X_batch.data()+index_sample*_X_batch.sizeJ(),_X_batch.sizeJ());
+    }
+}
+
+void NeuralLayerLinearFullyConnectedSoftmax::backwardBatchCPU(NeuralLayer& layer_previous){
+    // ignore the non-linearity
+    std::copy(_d_E_X_batch.begin(),_d_E_X_batch.end(),_d_E_Y_batch.begin());
+    _backwardBatchLinear(layer_previous);
+}
+
 void NeuralLayerLinearFullyConnected::learn(){
     for(unsigned int i=0;i<this->_W.sizeI();i++){
         for(unsigned int j=0;j<this->_W.sizeJ();j++){
@@ -510,6 +654,9 @@ void NeuralLayerLinearFullyConnectedSoftmax::save(XMLNode &nodechild) {
 NeuralLayer * NeuralLayerLinearFullyConnected::clone(){
     return new NeuralLayerLinearFullyConnected(*this);
 }
+NeuralLayer * NeuralLayerLinearFullyConnectedSoftmax::clone(){
+    return new NeuralLayerLinearFullyConnectedSoftmax(*this);
+}
 
 NeuralLayerMatrixMaxPool::NeuralLayerMatrixMaxPool(unsigned int sub_scaling_factor,unsigned int sizei_map_previous,unsigned int sizej_map_previous,unsigned int nbr_map_previous)
     :NeuralLayerMatrix(static_cast<unsigned int>(std::floor (  sizei_map_previous/(1.f*sub_scaling_factor))),
@@ -671,76 +818,163 @@ void NeuralLayerMatrixConvolutionSubScaling::setTrainable(bool istrainable){
         this->_d_E_W_biais(i)=0;
     }
 }
-void NeuralLayerMatrixConvolutionSubScaling::forwardCPU(const NeuralLayer& layer_previous){
-
-    if(const NeuralLayerMatrix * neural_matrix = dynamic_cast<const NeuralLayerMatrix *>(&layer_previous)){
-
-#if defined(HAVE_OPENMP)
-#pragma omp parallel for
-#endif
-        for( int index_map=0;index_map<static_cast<int>(this->_Y_reference.size());index_map++){
-            MatN<2,F32> &map_out =  this->_Y_reference[index_map];
-            int index_start_kernel = index_map*neural_matrix->X_map().size();
-            for(unsigned int i_map_next=0,i_map_previous=_radius_kernel;i_map_next<map_out.sizeI();i_map_next++,i_map_previous+=_sub_resolution_factor){
-                for(unsigned int j_map_next=0,j_map_previous=_radius_kernel;j_map_next<map_out.sizeJ();j_map_next++,j_map_previous+=_sub_resolution_factor){
-                    F32 sum=0;
-                    //convolution
-                    for(unsigned int index_map_previous=0;index_map_previous<neural_matrix->X_map().size();index_map_previous++){
-                        sum+=_W_biais[ index_map_previous + index_start_kernel];
-                        for(unsigned int i=0,index_kernel_ij=0,index_map = (i_map_previous-_radius_kernel)*neural_matrix->X_map()(0).sizeJ()+(j_map_previous-_radius_kernel);i<_W_kernels(0).sizeI();i++,index_map+=(neural_matrix->X_map()(0).sizeJ()-_W_kernels(0).sizeJ())){
-                            for(unsigned int j=0;j<_W_kernels(0).sizeJ();j++,index_map++,index_kernel_ij++){
-                                sum+=_W_kernels(index_map_previous + index_start_kernel)(index_kernel_ij)*neural_matrix->X_map()(index_map_previous)(index_map);
-                            }
-                        }
+void NeuralLayerMatrixConvolutionSubScaling::Geometry::im2col(const F32 * X_previous,F32 * col,int stride_k,int stride_p)const{
+    int k=0;
+    for(int index_map=0;index_map<_nbr_map_previous;index_map++){
+        const F32 * map = X_previous+index_map*sizePrevious();
+        for(int i_kernel=0;i_kernel<_size_kernel;i_kernel++){
+            for(int j_kernel=0;j_kernel<_size_kernel;j_kernel++,k++){
+                F32 * col_k = col+k*stride_k;
+                for(int i=0,p=0;i<_sizei;i++){
+                    const F32 * row = map+(i*_sub+i_kernel)*_sizej_previous+j_kernel;
+                    for(int j=0;j<_sizej;j++,p++){
+                        col_k[p*stride_p]=row[j*_sub];
                     }
-                    map_out(i_map_next,j_map_next)=sum;
                 }
             }
         }
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::Geometry::col2im(const F32 * col,F32 * X_previous,int map_begin,int map_end)const{
+    for(int index_map=map_begin;index_map<map_end;index_map++){
+        F32 * map = X_previous+index_map*sizePrevious();
+        std::fill(map,map+sizePrevious(),0.f);
+        const F32 * col_k = col+index_map*_size_kernel*_size_kernel*sizeP();
+        for(int i_kernel=0;i_kernel<_size_kernel;i_kernel++){
+            for(int j_kernel=0;j_kernel<_size_kernel;j_kernel++){
+                for(int i=0;i<_sizei;i++){
+                    F32 * row = map+(i*_sub+i_kernel)*_sizej_previous+j_kernel;
+                    for(int j=0;j<_sizej;j++){
+                        row[j*_sub]+=*col_k++;
+                    }
+                }
+            }
+        }
     }
-    for(unsigned int i=0;i<__Y.size();i++){
-        this->__X(i) = NeuronSigmoid::activation(this->__Y(i));
+}
+
+void NeuralLayerMatrixConvolutionSubScaling::_initGeometry(const NeuralLayerMatrix & layer_previous){
+    _geometry._nbr_map_previous = layer_previous.X_map().size();
+    _geometry._sizei_previous   = layer_previous.X_map()(0).sizeI();
+    _geometry._sizej_previous   = layer_previous.X_map()(0).sizeJ();
+    _geometry._sizei = this->X_map()(0).sizeI();
+    _geometry._sizej = this->X_map()(0).sizeJ();
+    _geometry._size_kernel = _W_kernels(0).sizeI();
+    _geometry._sub = _sub_resolution_factor;
+    const unsigned int nbr_map = this->X_map().size();
+    //the kernels feeding the map index_map are the row index_map of the kernel matrix
+    if(_W_matrix.sizeI()!=nbr_map||_W_matrix.sizeJ()!=static_cast<unsigned int>(_geometry.sizeK()))
+        _W_matrix.resize(nbr_map,_geometry.sizeK());
+    for(unsigned int index_kernel=0;index_kernel<_W_kernels.size();index_kernel++){
+        std::copy(_W_kernels(index_kernel).begin(),_W_kernels(index_kernel).end(),_W_matrix.begin()+index_kernel*_W_kernels(index_kernel).size());
     }
+    if(_im2col.sizeI()!=static_cast<unsigned int>(_geometry.sizeK())||_im2col.sizeJ()!=static_cast<unsigned int>(_geometry.sizeP()))
+        _im2col.resize(_geometry.sizeK(),_geometry.sizeP());
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::_forwardIm2Col(const F32 * X_previous,F32 * Y,F32 * X){
+    const int nbr_map = _W_matrix.sizeI();
+    const int size_p = _geometry.sizeP();
+    const int size_k = _geometry.sizeK();
+    _geometry.im2col(X_previous,_im2col.data(),size_p,1);
+    //Y = biais + W_matrix * im2col
+    for(int index_map=0;index_map<nbr_map;index_map++){
+        F32 biais=0;
+        for(int index_map_previous=0;index_map_previous<_geometry._nbr_map_previous;index_map_previous++)
+            biais+=_W_biais[index_map_previous+index_map*_geometry._nbr_map_previous];
+        std::fill(Y+index_map*size_p,Y+(index_map+1)*size_p,biais);
+    }
+    GEMM::sgemm('N','N',nbr_map,size_p,size_k,1,_W_matrix.data(),size_k,_im2col.data(),size_p,1,Y,size_p);
+    for(int i=0;i<nbr_map*size_p;i++){
+        X[i] = NeuronSigmoid::activation(Y[i]);
+    }
 }
-void NeuralLayerMatrixConvolutionSubScaling::backwardCPU(NeuralLayer& layer_previous){
-    for(unsigned int i=0;i<this->__Y.size();i++){
-        this->_d_E_Y(i) = this->_d_E_X(i)*NeuronSigmoid::derivedActivation(this->__X(i));
+
+void NeuralLayerMatrixConvolutionSubScaling::_backwardIm2Col(const F32 * X_previous,const F32 * X,const F32 * d_E_X,F32 * d_E_Y,F32 * d_E_X_previous){
+    const int nbr_map = _W_matrix.sizeI();
+    const int size_p = _geometry.sizeP();
+    const int size_k = _geometry.sizeK();
+    for(int i=0;i<nbr_map*size_p;i++){
+        d_E_Y[i] = d_E_X[i]*NeuronSigmoid::derivedActivation(X[i]);
     }
+    //biais error: every biais of the map index_map receives the sum of its errors
+    for(int index_map=0;index_map<nbr_map;index_map++){
+        F32 sum=0;
+        for(int p=0;p<size_p;p++)
+            sum+=d_E_Y[index_map*size_p+p];
+        for(int index_map_previous=0;index_map_previous<_geometry._nbr_map_previous;index_map_previous++)
+            _d_E_W_biais(index_map_previous+index_map*_geometry._nbr_map_previous)+=sum;
+    }
+    //kernel error d_E_W_matrix += d_E_Y * im2col^t, with the transposed im2col built directly
+    _geometry.im2col(X_previous,_im2col.data(),1,size_k);
+    GEMM::sgemm('N','N',nbr_map,size_k,size_p,1,d_E_Y,size_p,_im2col.data(),size_k,1,_d_E_W_matrix.data(),size_k);
+    //previous error: col2im(W_matrix^t * d_E_Y)
+    if(d_E_X_previous!=NULL){
+        GEMM::sgemm('T','N',size_k,size_p,nbr_map,1,_W_matrix.data(),size_k,d_E_Y,size_p,0,_im2col.data(),size_p);
+        __FunctorCol2Im func(_geometry,_im2col.data(),d_E_X_previous);
+        if(static_cast<F32>(size_k)*size_p<PARALLEL_MINIMUM_SIZE)
+            func(0,_geometry._nbr_map_previous);
+        else
+            forEachRangeParallel(0,_geometry._nbr_map_previous,func);
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::_beginAccumulationError(){
+    if(_d_E_W_matrix.getDomain()!=_W_matrix.getDomain())
+        _d_E_W_matrix.resize(_W_matrix.getDomain());
+    for(unsigned int index_kernel=0;index_kernel<_d_E_W_kernels.size();index_kernel++){
+        std::copy(_d_E_W_kernels(index_kernel).begin(),_d_E_W_kernels(index_kernel).end(),_d_E_W_matrix.begin()+index_kernel*_d_E_W_kernels(index_kernel).size());
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::_endAccumulationError(){
+    for(unsigned int index_kernel=0;index_kernel<_d_E_W_kernels.size();index_kernel++){
+        Mat2F32::const_iterator it = _d_E_W_matrix.begin()+index_kernel*_d_E_W_kernels(index_kernel).size();
+        std::copy(it,it+_d_E_W_kernels(index_kernel).size(),_d_E_W_kernels(index_kernel).begin());
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::forwardCPU(const NeuralLayer& layer_previous){
+    if(const NeuralLayerMatrix * neural_matrix = dynamic_cast<const NeuralLayerMatrix *>(&layer_previous)){
+        _initGeometry(*neural_matrix);
+        _forwardIm2Col(neural_matrix->X().data(),this->__Y.data(),this->__X.data());
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::backwardCPU(NeuralLayer& layer_previous){
     if( NeuralLayerMatrix * neural_matrix = dynamic_cast< NeuralLayerMatrix *>(&layer_previous)){
-        for(unsigned int i=0;i<neural_matrix->d_E_X_map().size();i++){
-            for(unsigned int j=0;j<neural_matrix->d_E_X_map()(i).size();j++){
-                neural_matrix->d_E_X_map()(i)(j)=0;
-            }
-        }
-        for(unsigned int index_map=0;index_map<this->_d_E_Y_reference.size();index_map++){
-            MatN<2,F32> &map_error_out =  this->_d_E_Y_reference[index_map];
-
-            int index_start_kernel = index_map*neural_matrix->X_map().size();
-            for(unsigned int i_map_next=0,i_map_previous=_radius_kernel;i_map_next<map_error_out.sizeI();i_map_next++,i_map_previous+=_sub_resolution_factor){
-                for(unsigned int j_map_next=0,j_map_previous=_radius_kernel;j_map_next<map_error_out.sizeJ();j_map_next++,j_map_previous+=_sub_resolution_factor){
-                    F32 d_error_y_value = map_error_out(i_map_next,j_map_next);
-
-                    //convolution
-                    for(unsigned int index_map_previous=0;index_map_previous<neural_matrix->X_map().size();index_map_previous++){
-                        this->_d_E_W_biais(index_map_previous + index_start_kernel)+=d_error_y_value;
-                        for(unsigned int i=0,index_kernel_ij=0,index_map = (i_map_previous-_radius_kernel)*neural_matrix->X_map()(0).sizeJ()+(j_map_previous-_radius_kernel);i<_W_kernels(0).sizeI();i++,index_map+=(neural_matrix->X_map()(0).sizeJ()-_W_kernels(0).sizeJ())){
-                            for(unsigned int j=0;j<_W_kernels(0).sizeJ();j++,index_map++,index_kernel_ij++){
-
-                                this->_d_E_W_kernels(index_map_previous + index_start_kernel)(index_kernel_ij)+=neural_matrix->X_map()(index_map_previous)(index_map)*d_error_y_value;
-                                neural_matrix->d_E_X_map()(index_map_previous)(index_map)+=  this->_W_kernels(index_map_previous + index_start_kernel)(index_kernel_ij)  *d_error_y_value;
-                            }
-                        }
-                    }
-                }
-            }
+        _initGeometry(*neural_matrix);
+        _beginAccumulationError();
+        _backwardIm2Col(neural_matrix->X().data(),this->__X.data(),this->_d_E_X.data(),this->_d_E_Y.data(),neural_matrix->d_E_X().data());
+        _endAccumulationError();
+    }
+}
+
+void NeuralLayerMatrixConvolutionSubScaling::forwardBatchCPU(NeuralLayer& layer_previous){
+    if(const NeuralLayerMatrix * neural_matrix = dynamic_cast<const NeuralLayerMatrix *>(&layer_previous)){
+        _initGeometry(*neural_matrix);
+        const Mat2F32 & X_previous = neural_matrix->X_batch();
+        for(unsigned int index_sample=0;index_sample<_X_batch.sizeI();index_sample++){
+            _forwardIm2Col(X_previous.data()+index_sample*X_previous.sizeJ(),_Y_batch.data()+index_sample*_Y_batch.sizeJ(),_X_batch.data()+index_sample*_X_batch.sizeJ());
         }
+    }
+}
 
+void NeuralLayerMatrixConvolutionSubScaling::backwardBatchCPU(NeuralLayer& layer_previous){
+    if( NeuralLayerMatrix * neural_matrix = dynamic_cast< NeuralLayerMatrix *>(&layer_previous)){
+        _initGeometry(*neural_matrix);
+        _beginAccumulationError();
+        const Mat2F32 & X_previous = neural_matrix->X_batch();
+        Mat2F32 & d_E_X_previous = neural_matrix->d_E_X_batch();
+        for(unsigned int index_sample=0;index_sample<_X_batch.sizeI();index_sample++){
+            _backwardIm2Col(X_previous.data()+index_sample*X_previous.sizeJ(),
+                            _X_batch.data()+index_sample*_X_batch.sizeJ(),
+                            _d_E_X_batch.data()+index_sample*_d_E_X_batch.sizeJ(),
+                            _d_E_Y_batch.data()+index_sample*_d_E_Y_batch.sizeJ(),
+                            d_E_X_previous.sizeI()!=0 ? d_E_X_previous.data()+index_sample*d_E_X_previous.sizeJ() : NULL);
+        }
+        _endAccumulationError();
     }
 }
 void NeuralLayerMatrixConvolutionSubScaling::learn(){
@@ -781,6 +1015,12 @@ NeuralLayerLinearInput::NeuralLayerLinearInput(unsigned int nbr_neurons)
     :NeuralLayerLinear(nbr_neurons){}
 void NeuralLayerLinearInput::forwardCPU(const NeuralLayer& ) {}
 void NeuralLayerLinearInput::backwardCPU(NeuralLayer& ) {}
+void NeuralLayerLinearInput::forwardBatchCPU(NeuralLayer& ) {}
+void NeuralLayerLinearInput::backwardBatchCPU(NeuralLayer& ) {}
+void NeuralLayerLinearInput::setBatchSize(unsigned int nbr_sample){
+    //the input layer does not back-propagate the batch error
+    _X_batch.resize(nbr_sample,__X.size());
+}
 void NeuralLayerLinearInput::learn( ){}
 void NeuralLayerLinearInput::setTrainable(bool istrainable){NeuralLayerLinear::setTrainable(istrainable);}
 NeuralLayer * NeuralLayerLinearInput::clone(){
@@ -801,6 +1041,11 @@ NeuralLayerMatrixInput::NeuralLayerMatrixInput(unsigned int sizei,unsigned int s
     :NeuralLayerMatrix(sizei,  sizej,  nbr_map){}
 void NeuralLayerMatrixInput::forwardCPU(const NeuralLayer& ) {}
 void NeuralLayerMatrixInput::backwardCPU(NeuralLayer& ) {}
+void NeuralLayerMatrixInput::forwardBatchCPU(NeuralLayer& ) {}
+void NeuralLayerMatrixInput::backwardBatchCPU(NeuralLayer& ) {}
+void NeuralLayerMatrixInput::setBatchSize(unsigned int nbr_sample){
+    _X_batch.resize(nbr_sample,__X.size());
+}
 void NeuralLayerMatrixInput::learn( ){}
 void NeuralLayerMatrixInput::setTrainable(bool istrainable){NeuralLayerMatrix::setTrainable(istrainable);}
 NeuralLayer * NeuralLayerMatrixInput::clone(){
@@ -826,7 +1071,9 @@ NeuralNet::NeuralNet()
 {}
 
 
-NeuralNet::NeuralNet(const NeuralNet & neural){
+NeuralNet::NeuralNet(const NeuralNet & neural)
+    :_normalizationmatrixinput(NULL)
+{
 
     this->_label2string = neural._label2string;
 
@@ -950,6 +1197,56 @@ void NeuralNet::backwardCPU(const VecF32& X_expected){
         layer->backwardCPU(* layer_previous);
     }
 }
+void NeuralNet::forwardCPU(const Mat2F32& X_batch, Mat2F32& Y_batch){
+    if(X_batch.sizeJ()!=(*(_v_layer.begin()))->X().size()){
+        std::cerr<<"In NeuralNet::forwardCPU, the number of columns of the batch is not equal to the number of input neurons"<<std::endl;
+        return;
+    }
+    for(unsigned int i=0;i<_v_layer.size();i++){
+        if(_v_layer(i)->X_batch().sizeI()!=X_batch.sizeI())
+            _v_layer(i)->setBatchSize(X_batch.sizeI());
+    }
+    std::copy(X_batch.begin(),X_batch.end(), (*(_v_layer.begin()))->X_batch().begin());
+    for(unsigned int i=1;i<_v_layer.size();i++){
+        _v_layer(i)->forwardBatchCPU(*_v_layer(i-1));
+    }
+    const Mat2F32 & X_last = (*(_v_layer.rbegin()))->X_batch();
+    if(Y_batch.getDomain()!=X_last.getDomain()){
+        Y_batch.resize(X_last.getDomain());
+    }
+    std::copy(X_last.begin(),X_last.end(),Y_batch.begin());
+}
+
+void NeuralNet::backwardCPU(const Mat2F32& X_expected_batch){
+    NeuralLayer* layer_last = _v_layer[_v_layer.size()-1];
+    Mat2F32 & d_E_X_last = layer_last->d_E_X_batch();
+    const Mat2F32 & X_last = layer_last->X_batch();
+    if(d_E_X_last.sizeI()==0){
+        std::cerr<<"In NeuralNet::backwardCPU, the network is not trainable (call setTrainable(true)) or no batch has been propagated"<<std::endl;
+        return;
+    }
+    if(X_expected_batch.getDomain()!=X_last.getDomain()){
+        std::cerr<<"In NeuralNet::backwardCPU, the expected batch size is not equal to the propagated batch size"<<std::endl;
+        return;
+    }
+    if (dynamic_cast<NeuralLayerLinearFullyConnectedSoftmax*>(layer_last)) {
+        // the error function of softmax is different from square error
+        for(unsigned int j=0;j<X_expected_batch.size();j++){
+            d_E_X_last(j) = X_last(j);
+            if (X_expected_batch(j) == 1) {
+                d_E_X_last(j) -= 1;
+            }
+        }
+    } else {
+        for(unsigned int j=0;j<X_expected_batch.size();j++){
+            d_E_X_last(j) = X_last(j)-X_expected_batch(j);
+        }
+    }
+    for( int index_layer=_v_layer.size()-1;index_layer>0;index_layer--){
+        _v_layer[index_layer]->backwardBatchCPU(*_v_layer[index_layer-1]);
+    }
+}
+
 NeuralLayer::~NeuralLayer(){
 
 }
@@ -965,6 +1262,15 @@ void NeuralNet::clear(){
 }
 void NeuralNet::load(const char * file)
 {
+    std::ifstream is(file,std::ios::binary);
+    char magic[8]={0};
+    is.read(magic,8);
+    if(is&&std::memcmp(magic,"POPNNB01",8)==0){
+        is.close();
+        loadBinary(file);
+        return;
+    }
+    is.close();
     XMLDocument doc;
     doc.load(file);
     load(doc);
@@ -1187,6 +1493,221 @@ void NeuralNet::save(XMLDocument& doc) const {
     }
 }
 
+//    \cond HIDDEN_SYMBOLS
+/*
+ * binary model: "POPNNB01", I32 info[6]={version,0x01020304 (byte order),nbr_layer,nbr_label,normalization method,normalization value},
+ * the labels (I32 length + characters), one descriptor per layer (I32 type, I32 parameter[7], UI64 offset, UI64 nbr_weight) and
+ * the F32 weight blocks starting at a multiple of 64 bytes (fully connected: W row by row, convolutionnal: biais then kernels)
+ */
+namespace{
+const I32 NEURALNET_BINARY_VERSION = 1;
+const I32 NEURALNET_BINARY_BYTE_ORDER = 0x01020304;
+const UI64 NEURALNET_BINARY_ALIGN = 64;
+enum NeuralNetBinaryType{
+    BINARY_LINEAR_INPUT=0,
+    BINARY_MATRIX_INPUT=1,
+    BINARY_FULLY_CONNECTED=2,
+    BINARY_FULLY_CONNECTED_SOFTMAX=3,
+    BINARY_MATRIX_CONVOLUTION=4,
+    BINARY_MATRIX_MAX_POOL=5
+};
+struct NeuralNetBinaryLayer
+{
+    I32 _type;
+    I32 _parameter[7];
+    UI64 _offset;
+    UI64 _nbr_weight;
+};
+UI64 alignBinary(UI64 offset){
+    return (offset+NEURALNET_BINARY_ALIGN-1)/NEURALNET_BINARY_ALIGN*NEURALNET_BINARY_ALIGN;
+}
+}
+//    \endcond
+
+bool NeuralNet::saveBinary(const char * file)const{
+    std::vector<NeuralNetBinaryLayer> v_binary(_v_layer.size());
+    std::vector<std::vector<F32> > v_weight(_v_layer.size());
+    for(unsigned int i=0;i<_v_layer.size();i++){
+        NeuralNetBinaryLayer & binary = v_binary[i];
+        std::fill(binary._parameter,binary._parameter+7,0);
+        std::vector<F32> & weight = v_weight[i];
+        if(const NeuralLayerMatrixInput *layer_matrix = dynamic_cast<const NeuralLayerMatrixInput *>(_v_layer[i])){
+            binary._type = BINARY_MATRIX_INPUT;
+            binary._parameter[0] = layer_matrix->X_map()(0).sizeI();
+            binary._parameter[1] = layer_matrix->X_map()(0).sizeJ();
+            binary._parameter[2] = layer_matrix->X_map().size();
+        }else if(const NeuralLayerLinearInput *layer_linear = dynamic_cast<const NeuralLayerLinearInput *>(_v_layer[i])){
+            binary._type = BINARY_LINEAR_INPUT;
+            binary._parameter[0] = layer_linear->X().size();
+        }else if(const NeuralLayerMatrixConvolutionSubScaling *layer_conv = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(_v_layer[i])){
+            binary._type = BINARY_MATRIX_CONVOLUTION;
+            binary._parameter[0] = layer_conv->X_map().size();
+            binary._parameter[1] = layer_conv->_radius_kernel;
+            binary._parameter[2] = layer_conv->_sub_resolution_factor;
+            weight.insert(weight.end(),layer_conv->_W_biais.begin(),layer_conv->_W_biais.end());
+            for(unsigned int index_kernel=0;index_kernel<layer_conv->_W_kernels.size();index_kernel++)
+                weight.insert(weight.end(),layer_conv->_W_kernels(index_kernel).begin(),layer_conv->_W_kernels(index_kernel).end());
+        }else if(const NeuralLayerLinearFullyConnected *layer_fully = dynamic_cast<const NeuralLayerLinearFullyConnected *>(_v_layer[i])){
+            binary._type = dynamic_cast<const NeuralLayerLinearFullyConnectedSoftmax *>(layer_fully)?BINARY_FULLY_CONNECTED_SOFTMAX:BINARY_FULLY_CONNECTED;
+            binary._parameter[0] = layer_fully->X().size();
+        }else if(const NeuralLayerMatrixMaxPool *layer_max_pool = dynamic_cast<const NeuralLayerMatrixMaxPool *>(_v_layer[i])){
+            binary._type = BINARY_MATRIX_MAX_POOL;
+            binary._parameter[0] = layer_max_pool->_sub_resolution_factor;
+        }else{
+            std::cerr<<"In NeuralNet::saveBinary, unknown layer type"<<std::endl;
+            return false;
+        }
+        if(const NeuralLayerLinearFullyConnected *layer_fully = dynamic_cast<const NeuralLayerLinearFullyConnected *>(_v_layer[i]))
+            binary._nbr_weight = layer_fully->_W.size();
+        else
+            binary._nbr_weight = weight.size();
+    }
+    //offsets of the weight blocks after the header
+    UI64 offset = 8+6*sizeof(I32)+_v_layer.size()*(8*sizeof(I32)+2*sizeof(UI64));
+    for(unsigned int i=0;i<_label2string.size();i++)
+        offset += sizeof(I32)+_label2string(i).size();
+    for(unsigned int i=0;i<v_binary.size();i++){
+        offset = alignBinary(offset);
+        v_binary[i]._offset = offset;
+        offset += v_binary[i]._nbr_weight*sizeof(F32);
+    }
+    std::ofstream  out(file,std::ios::binary);
+    if (out.fail()){
+        std::cerr<<"In NeuralNet::saveBinary, cannot open file: "+std::string(file) << std::endl;
+        return false;
+    }
+    I32 info[6]={NEURALNET_BINARY_VERSION,NEURALNET_BINARY_BYTE_ORDER,static_cast<I32>(_v_layer.size()),static_cast<I32>(_label2string.size()),0,0};
+    if(const NormalizationMatrixInputMass * mass= dynamic_cast<const NormalizationMatrixInputMass *>(_normalizationmatrixinput)){
+        info[4]=0;
+        info[5]=mass->_normalization_value;
+    }else if(const NormalizationMatrixInputCentering * centering= dynamic_cast<const NormalizationMatrixInputCentering *>(_normalizationmatrixinput)){
+        info[4]=1;
+        info[5]=centering->_normalization_value;
+    }
+    out.write("POPNNB01",8);
+    out.write(reinterpret_cast<const char *>(info),sizeof(info));
+    for(unsigned int i=0;i<_label2string.size();i++){
+        const I32 length = static_cast<I32>(_label2string(i).size());
+        out.write(reinterpret_cast<const char *>(&length),sizeof(length));
+        out.write(_label2string(i).data(),length);
+    }
+    for(unsigned int i=0;i<v_binary.size();i++){
+        out.write(reinterpret_cast<const char *>(&v_binary[i]._type),sizeof(I32));
+        out.write(reinterpret_cast<const char *>(v_binary[i]._parameter),sizeof(v_binary[i]._parameter));
+        out.write(reinterpret_cast<const char *>(&v_binary[i]._offset),sizeof(UI64));
+        out.write(reinterpret_cast<const char *>(&v_binary[i]._nbr_weight),sizeof(UI64));
+    }
+    const char zero[NEURALNET_BINARY_ALIGN]={0};
+    for(unsigned int i=0;i<v_binary.size();i++){
+        if(v_binary[i]._nbr_weight==0)
+            continue;
+        out.write(zero,static_cast<std::streamsize>(v_binary[i]._offset-static_cast<UI64>(out.tellp())));
+        if(const NeuralLayerLinearFullyConnected *layer_fully = dynamic_cast<const NeuralLayerLinearFullyConnected *>(_v_layer[i]))
+            out.write(reinterpret_cast<const char *>(layer_fully->_W.data()),layer_fully->_W.size()*sizeof(F32));
+        else
+            out.write(reinterpret_cast<const char *>(&v_weight[i][0]),v_weight[i].size()*sizeof(F32));
+    }
+    if(out.fail()){
+        std::cerr<<"In NeuralNet::saveBinary, cannot write file: "+std::string(file) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool NeuralNet::loadBinary(const char * file){
+    std::ifstream  is(file,std::ios::binary);
+    char magic[8];
+    I32 info[6];
+    is.read(magic,8);
+    is.read(reinterpret_cast<char *>(info),sizeof(info));
+    if(!is||std::memcmp(magic,"POPNNB01",8)!=0){
+        std::cerr<<"In NeuralNet::loadBinary, the file is not a binary neural network: "+std::string(file) << std::endl;
+        return false;
+    }
+    if(info[0]!=NEURALNET_BINARY_VERSION||info[1]!=NEURALNET_BINARY_BYTE_ORDER||info[2]<=0||info[3]<0){
+        std::cerr<<"In NeuralNet::loadBinary, unknown version or byte order of the binary neural network: "+std::string(file) << std::endl;
+        return false;
+    }
+    //0 for NormalizationMatrixInputMass, 1 for NormalizationMatrixInputCentering
+    if((info[4]!=0&&info[4]!=1)||(info[5]!=NormalizationMatrixInput::MinusOneToOne&&info[5]!=NormalizationMatrixInput::ZeroToOne)){
+        std::cerr<<"In NeuralNet::loadBinary, unknown normalization of the binary neural network: "+std::string(file) << std::endl;
+        return false;
+    }
+    this->clear();
+    this->setNormalizationMatrixInput(info[4]==0?static_cast<NormalizationMatrixInput*>(new NormalizationMatrixInputMass(static_cast<NormalizationMatrixInput::NormalizationValue>(info[5])))
+                                                :static_cast<NormalizationMatrixInput*>(new NormalizationMatrixInputCentering(static_cast<NormalizationMatrixInput::NormalizationValue>(info[5]))));
+    _label2string.clear();
+    for(I32 i=0;i<info[3]&&is;i++){
+        I32 length=0;
+        is.read(reinterpret_cast<char *>(&length),sizeof(length));
+        std::string label(length>0&&length<(1<<16)?length:0,' ');
+        if(label.empty()==false)
+            is.read(&label[0],length);
+        _label2string.push_back(label);
+    }
+    std::vector<NeuralNetBinaryLayer> v_binary(info[2]);
+    for(unsigned int i=0;i<v_binary.size();i++){
+        is.read(reinterpret_cast<char *>(&v_binary[i]._type),sizeof(I32));
+        is.read(reinterpret_cast<char *>(v_binary[i]._parameter),sizeof(v_binary[i]._parameter));
+        is.read(reinterpret_cast<char *>(&v_binary[i]._offset),sizeof(UI64));
+        is.read(reinterpret_cast<char *>(&v_binary[i]._nbr_weight),sizeof(UI64));
+    }
+    if(!is){
+        std::cerr<<"In NeuralNet::loadBinary, truncated header: "+std::string(file) << std::endl;
+        this->clear();
+        _label2string.clear();
+        _normalizationmatrixinput = new NormalizationMatrixInputMass();
+        return false;
+    }
+    for(unsigned int i=0;i<v_binary.size();i++){
+        const NeuralNetBinaryLayer & binary = v_binary[i];
+        const unsigned int nbr_layer = _v_layer.size();
+        bool valid = (i==0)==(binary._type==BINARY_LINEAR_INPUT||binary._type==BINARY_MATRIX_INPUT);
+        if(valid==true){
+            if(binary._type==BINARY_LINEAR_INPUT&&binary._parameter[0]>0){
+                this->addLayerLinearInput(binary._parameter[0]);
+            }else if(binary._type==BINARY_MATRIX_INPUT&&binary._parameter[0]>0&&binary._parameter[1]>0&&binary._parameter[2]>0){
+                this->addLayerMatrixInput(binary._parameter[0],binary._parameter[1],binary._parameter[2]);
+            }else if((binary._type==BINARY_FULLY_CONNECTED||binary._type==BINARY_FULLY_CONNECTED_SOFTMAX)&&binary._parameter[0]>0){
+                //no random initialization, the weights are replaced by the file
+                const unsigned int nbr_neurons_previous = (*(_v_layer.rbegin()))->X().size();
+                if(binary._type==BINARY_FULLY_CONNECTED)
+                    this->_v_layer.push_back(new NeuralLayerLinearFullyConnected(nbr_neurons_previous,binary._parameter[0],false));
+                else
+                    this->_v_layer.push_back(new NeuralLayerLinearFullyConnectedSoftmax(nbr_neurons_previous,binary._parameter[0],false));
+                //zero copy: the weight matrix is the block of the file mapped in memory
+                NeuralLayerLinearFullyConnected * layer_fully = dynamic_cast<NeuralLayerLinearFullyConnected *>(*(_v_layer.rbegin()));
+                valid = binary._nbr_weight==layer_fully->_W.size()&&binary._offset%NEURALNET_BINARY_ALIGN==0
+                        &&layer_fully->_W.openMapped(file,layer_fully->_W.getDomain(),true,static_cast<std::size_t>(binary._offset));
+            }else if(binary._type==BINARY_MATRIX_CONVOLUTION&&binary._parameter[0]>0&&binary._parameter[1]>=0&&binary._parameter[2]>0
+                     &&dynamic_cast<NeuralLayerMatrix *>(*(_v_layer.rbegin()))!=NULL){
+                this->addLayerMatrixConvolutionSubScaling(binary._parameter[0],binary._parameter[2],binary._parameter[1]);
+                //the kernels are small, they are read in the layer
+                NeuralLayerMatrixConvolutionSubScaling * layer_conv = dynamic_cast<NeuralLayerMatrixConvolutionSubScaling *>(*(_v_layer.rbegin()));
+                valid = layer_conv!=NULL&&binary._nbr_weight==layer_conv->_W_biais.size()+layer_conv->_W_kernels.size()*layer_conv->_W_kernels(0).size();
+                if(valid==true){
+                    is.seekg(static_cast<std::streamoff>(binary._offset));
+                    is.read(reinterpret_cast<char *>(&layer_conv->_W_biais[0]),layer_conv->_W_biais.size()*sizeof(F32));
+                    for(unsigned int index_kernel=0;index_kernel<layer_conv->_W_kernels.size();index_kernel++)
+                        is.read(reinterpret_cast<char *>(layer_conv->_W_kernels(index_kernel).data()),layer_conv->_W_kernels(index_kernel).size()*sizeof(F32));
+                    valid = !is.fail();
+                }
+            }else if(binary._type==BINARY_MATRIX_MAX_POOL&&binary._parameter[0]>0&&dynamic_cast<NeuralLayerMatrix *>(*(_v_layer.rbegin()))!=NULL){
+                this->addLayerMatrixMaxPool(binary._parameter[0]);
+            }
+            valid = valid&&_v_layer.size()==nbr_layer+1;
+        }
+        if(valid==false){
+            std::cerr<<"In NeuralNet::loadBinary, corrupted layer "<<i<<" in the binary neural network: "+std::string(file) << std::endl;
+            this->clear();
+            _label2string.clear();
+            _normalizationmatrixinput = new NormalizationMatrixInputMass();
+            return false;
+        }
+    }
+    return true;
+}
+
 void NeuralNet::setNormalizationMatrixInput(NormalizationMatrixInput * input){
     if(_normalizationmatrixinput!=NULL)
         delete _normalizationmatrixinput;
@@ -1418,12 +1939,16 @@ NormalizationMatrixInputCentering *NormalizationMatrixInputCentering::clone(){
 }
 
 void Softmax::softmax(Vec<F32>& x) {
+    softmax(x.data(),x.size());
+}
+
+void Softmax::softmax(F32* x,unsigned int size) {
     F32 sum = 0;
-    for (Vec<F32>::iterator it = x.begin() ; it != x.end() ; it ++) {
+    for (F32* it = x ; it != x+size ; it ++) {
         *it = std::exp(*it);
         sum += *it;
     }
-    for (Vec<F32>::iterator it = x.begin() ; it != x.end() ; it ++) {
+    for (F32* it = x ; it != x+size ; it ++) {
         *it /= sum;
     }
 }
@@ -0,0 +1,565 @@
+#include "PopulationConfig.h"
+#include "data/neuralnetwork/NeuralNetworkQuantized.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+namespace pop {
+
+//    \cond HIDDEN_SYMBOLS
+namespace {
+const int NBR_BYTE_ALIGN = 16;
+const I32 CODE_ZERO = 128;
+
+int alignSize(int size){
+    return (size+NBR_BYTE_ALIGN-1)/NBR_BYTE_ALIGN*NBR_BYTE_ALIGN;
+}
+#if defined(__SSE2__)
+//(sum a,sum b,sum c,sum d) of the int32 lanes of four accumulators
+inline __m128i reduce4(__m128i a,__m128i b,__m128i c,__m128i d){
+    const __m128i ab = _mm_add_epi32(_mm_unpacklo_epi32(a,b),_mm_unpackhi_epi32(a,b));
+    const __m128i cd = _mm_add_epi32(_mm_unpacklo_epi32(c,d),_mm_unpackhi_epi32(c,d));
+    return _mm_add_epi32(_mm_unpacklo_epi64(ab,cd),_mm_unpackhi_epi64(ab,cd));
+}
+#endif
+#if defined(__AVX2__)&&!(defined(__AVX512VNNI__)&&defined(__AVX512VL__))
+inline __m256i maddU8I8(const UI8 * u,const I8 * w){
+    return _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u))),
+                             _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w))));
+}
+inline __m128i fold(__m256i a){
+    return _mm_add_epi32(_mm256_castsi256_si128(a),_mm256_extracti128_si256(a,1));
+}
+#elif defined(__SSE2__)&&!defined(__AVX2__)
+//zero extension of u, sign extension of w (byte duplicated in the 16 bits then arithmetic shift)
+inline __m128i maddU8I8(__m128i u_lo,__m128i u_hi,const I8 * w){
+    const __m128i w8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+    const __m128i w_lo = _mm_srai_epi16(_mm_unpacklo_epi8(w8,w8),8),w_hi = _mm_srai_epi16(_mm_unpackhi_epi8(w8,w8),8);
+    return _mm_add_epi32(_mm_madd_epi16(u_lo,w_lo),_mm_madd_epi16(u_hi,w_hi));
+}
+#endif
+/*
+ * sum(i) = sum_k u(k)*w(i)(k) for four weight rows, u in [0,255], w in [-127,127] and size a multiple of 16. The bytes are widened to
+ * 16 bits before the multiply-add (pmaddwd) since the pairwise sum of pmaddubsw saturates at 32767 for 8 bits codes, VNNI having no
+ * intermediate saturation. All the paths give the same integers. The four rows share the loads of u and the horizontal reduction.
+ */
+void dot4U8I8(const UI8 * u,const I8 * const * w,int size,I32 * sum){
+    const I8 * w0 = w[0],* w1 = w[1],* w2 = w[2],* w3 = w[3];
+#if defined(__AVX512VNNI__)&&defined(__AVX512VL__)
+    __m128i a0 = _mm_setzero_si128(),a1 = _mm_setzero_si128(),a2 = _mm_setzero_si128(),a3 = _mm_setzero_si128();
+    for(int k=0;k<size;k+=16){
+        const __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u+k));
+        a0 = _mm_dpbusd_epi32(a0,u8,_mm_loadu_si128(reinterpret_cast<const __m128i*>(w0+k)));
+        a1 = _mm_dpbusd_epi32(a1,u8,_mm_loadu_si128(reinterpret_cast<const __m128i*>(w1+k)));
+        a2 = _mm_dpbusd_epi32(a2,u8,_mm_loadu_si128(reinterpret_cast<const __m128i*>(w2+k)));
+        a3 = _mm_dpbusd_epi32(a3,u8,_mm_loadu_si128(reinterpret_cast<const __m128i*>(w3+k)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sum),reduce4(a0,a1,a2,a3));
+#elif defined(__AVX2__)
+    __m256i a0 = _mm256_setzero_si256(),a1 = _mm256_setzero_si256(),a2 = _mm256_setzero_si256(),a3 = _mm256_setzero_si256();
+    for(int k=0;k<size;k+=16){
+        a0 = _mm256_add_epi32(a0,maddU8I8(u+k,w0+k));
+        a1 = _mm256_add_epi32(a1,maddU8I8(u+k,w1+k));
+        a2 = _mm256_add_epi32(a2,maddU8I8(u+k,w2+k));
+        a3 = _mm256_add_epi32(a3,maddU8I8(u+k,w3+k));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sum),reduce4(fold(a0),fold(a1),fold(a2),fold(a3)));
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a0 = _mm_setzero_si128(),a1 = _mm_setzero_si128(),a2 = _mm_setzero_si128(),a3 = _mm_setzero_si128();
+    for(int k=0;k<size;k+=16){
+        const __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u+k));
+        const __m128i u_lo = _mm_unpacklo_epi8(u8,zero),u_hi = _mm_unpackhi_epi8(u8,zero);
+        a0 = _mm_add_epi32(a0,maddU8I8(u_lo,u_hi,w0+k));
+        a1 = _mm_add_epi32(a1,maddU8I8(u_lo,u_hi,w1+k));
+        a2 = _mm_add_epi32(a2,maddU8I8(u_lo,u_hi,w2+k));
+        a3 = _mm_add_epi32(a3,maddU8I8(u_lo,u_hi,w3+k));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sum),reduce4(a0,a1,a2,a3));
+#else
+    sum[0]=sum[1]=sum[2]=sum[3]=0;
+    for(int k=0;k<size;k++){
+        const I32 u_k = u[k];
+        sum[0]+=u_k*w0[k];sum[1]+=u_k*w1[k];sum[2]+=u_k*w2[k];sum[3]+=u_k*w3[k];
+    }
+#endif
+}
+//tanh with the Pade approximant of Lambert's continued fraction, absolute error lower than 1e-4 (branchless so the loops are vectorized)
+inline F32 fastTanh(F32 x){
+    x = (std::max)(-4.97f,(std::min)(4.97f,x));
+    const F32 x2 = x*x;
+    const F32 p = x*(135135.f+x2*(17325.f+x2*(378.f+x2)));
+    const F32 q = 135135.f+x2*(62370.f+x2*(3150.f+x2*28.f));
+    return p/q;
+}
+inline F32 fastActivation(F32 y){
+    return 1.7159f*fastTanh(0.66666667f*y);
+}
+//exp(x)=2^n*2^f with 2^f evaluated by a polynomial on [0,1[ (relative error lower than 1e-5) and 2^n written in the exponent bits
+inline F32 fastExp(F32 x){
+    x = (std::max)(-87.f,(std::min)(88.f,x));
+    const F32 t = x*1.44269504f;
+    const F32 t_floor = std::floor(t);
+    const F32 f = t-t_floor;
+    const F32 p = 1.f+f*(0.693147182f+f*(0.240226507f+f*(0.0555041087f+f*(0.00961812911f+f*(0.00133335581f+f*0.000154035304f)))));
+    const I32 bits = (static_cast<I32>(t_floor)+127)<<23;
+    F32 power;
+    std::memcpy(&power,&bits,sizeof(F32));
+    return p*power;
+}
+void fastSoftmax(F32 * x,int size){
+    const F32 value_max = *std::max_element(x,x+size);
+    F32 sum=0;
+    for(int i=0;i<size;i++){
+        x[i] = fastExp(x[i]-value_max);
+        sum+=x[i];
+    }
+    const F32 sum_inverse = 1.f/sum;
+    for(int i=0;i<size;i++)
+        x[i]*=sum_inverse;
+}
+inline UI8 quantizeCode(F32 x,F32 scale_inverse){
+    const F32 v = (std::max)(-127.f,(std::min)(127.f,x*scale_inverse));
+    return static_cast<UI8>(static_cast<I32>(v+CODE_ZERO+0.5f));
+}
+F32 scaleFromRange(F32 value_max,F32 range){
+    return (value_max>0?value_max:1.f)/range;
+}
+void quantizeRow(const F32 * w,int size,NeuralNetQuantized::Layer & layer,int index_row){
+    F32 value_max=0;
+    for(int i=0;i<size;i++)
+        value_max = (std::max)(value_max,std::abs(w[i]));
+    const F32 scale = scaleFromRange(value_max,127.f);
+    I8 * w_q = &layer._W[index_row*layer._size_row];
+    for(int i=0;i<size;i++){
+        const F32 v = (std::max)(-127.f,(std::min)(127.f,w[i]/scale));
+        w_q[i] = static_cast<I8>(v<0?v-0.5f:v+0.5f);
+    }
+    layer._scale_W[index_row]=scale;
+}
+//type and geometry of the output neurons of the layer, false for an unknown layer type
+bool layerGeometry(const NeuralLayer * neural_layer,NeuralNetQuantized::Layer & layer){
+    layer._nbr_map=1;layer._sizei=1;layer._sizej=static_cast<I32>(neural_layer->X().size());
+    layer._size_kernel=0;layer._sub=0;
+    layer._nbr_row=0;layer._size_row=0;
+    if(const NeuralLayerMatrix * neural_matrix = dynamic_cast<const NeuralLayerMatrix *>(neural_layer)){
+        layer._nbr_map = neural_matrix->X_map().size();
+        layer._sizei = neural_matrix->X_map()(0).sizeI();
+        layer._sizej = neural_matrix->X_map()(0).sizeJ();
+    }
+    if(dynamic_cast<const NeuralLayerLinearInput *>(neural_layer)){
+        layer._type = NeuralNetQuantized::LINEAR_INPUT;
+    }else if(dynamic_cast<const NeuralLayerMatrixInput *>(neural_layer)){
+        layer._type = NeuralNetQuantized::MATRIX_INPUT;
+    }else if(dynamic_cast<const NeuralLayerLinearFullyConnected *>(neural_layer)){
+        layer._type = dynamic_cast<const NeuralLayerLinearFullyConnectedSoftmax *>(neural_layer)?NeuralNetQuantized::FULLY_CONNECTED_SOFTMAX:NeuralNetQuantized::FULLY_CONNECTED;
+    }else if(const NeuralLayerMatrixConvolutionSubScaling * neural_convolution = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(neural_layer)){
+        layer._type = NeuralNetQuantized::MATRIX_CONVOLUTION;
+        layer._size_kernel = neural_convolution->_W_kernels(0).sizeI();
+        layer._sub = neural_convolution->_sub_resolution_factor;
+    }else if(const NeuralLayerMatrixMaxPool * neural_max_pool = dynamic_cast<const NeuralLayerMatrixMaxPool *>(neural_layer)){
+        layer._type = NeuralNetQuantized::MATRIX_MAX_POOL;
+        layer._sub = neural_max_pool->_sub_resolution_factor;
+    }else{
+        return false;
+    }
+    return true;
+}
+//FNV-1a hash of the bytes
+void hashByte(UI32 & hash,const void * data,std::size_t size){
+    const UI8 * byte = static_cast<const UI8 *>(data);
+    for(std::size_t i=0;i<size;i++){
+        hash^=byte[i];
+        hash*=16777619u;
+    }
+}
+}
+//    \endcond
+
+NeuralNetQuantized::NeuralNetQuantized()
+    :_checksum(0)
+{}
+
+NeuralNetQuantized::NeuralNetQuantized(NeuralNet & net,const Vec<VecF32> & v_calibration)
+    :_checksum(0)
+{
+    quantize(net,v_calibration);
+}
+
+const std::vector<NeuralNetQuantized::Layer> & NeuralNetQuantized::layers()const{
+    return _v_layer;
+}
+
+bool NeuralNetQuantized::empty()const{
+    return _v_layer.empty();
+}
+
+void NeuralNetQuantized::clear(){
+    _checksum=0;
+    _v_layer.clear();
+    _v_code.clear();
+    _im2col.clear();
+    _Y.clear();
+}
+
+void NeuralNetQuantized::_initSumWeight(Layer & layer){
+    //the codes are the int8 values plus 128 so the dot product is corrected by 128*sum(w)
+    layer._sum_W.assign(layer._nbr_row,0);
+    for(int index_row=0;index_row<layer._nbr_row;index_row++){
+        const I8 * w = &layer._W[index_row*layer._size_row];
+        for(int i=0;i<layer._size_row;i++)
+            layer._sum_W[index_row]+=w[i];
+    }
+}
+
+void NeuralNetQuantized::quantize(NeuralNet & net,const Vec<VecF32> & v_calibration){
+    clear();
+    const Vec<NeuralLayer*> & v_layer = net.layers();
+    for(unsigned int index_layer=0;index_layer<v_layer.size();index_layer++){
+        Layer layer;
+        if(layerGeometry(v_layer(index_layer),layer)==false){
+            std::cerr<<"In NeuralNetQuantized::quantize, unknown layer type"<<std::endl;
+            clear();
+            return;
+        }
+        //range of the neuron values without calibration: the inputs and the softmax in [-1,1], the sigmoid in [-1.7159,1.7159]
+        layer._scale_X = scaleFromRange(1.7159f,127.f);
+        if(layer._type==LINEAR_INPUT||layer._type==MATRIX_INPUT||layer._type==FULLY_CONNECTED_SOFTMAX)
+            layer._scale_X = scaleFromRange(1.f,127.f);
+        const Layer * layer_previous = index_layer>0?&_v_layer[index_layer-1]:NULL;
+        if(const NeuralLayerLinearFullyConnected * neural_linear = dynamic_cast<const NeuralLayerLinearFullyConnected *>(v_layer(index_layer))){
+            //the last column of W is the biais
+            const int size_previous = static_cast<int>(neural_linear->_W.sizeJ())-1;
+            layer._nbr_row = neural_linear->_W.sizeI();
+            layer._size_row = alignSize(size_previous);
+            layer._W.assign(layer._nbr_row*layer._size_row,0);
+            layer._scale_W.resize(layer._nbr_row);
+            layer._biais.resize(layer._nbr_row);
+            for(int index_row=0;index_row<layer._nbr_row;index_row++){
+                const F32 * w = neural_linear->_W.data()+index_row*neural_linear->_W.sizeJ();
+                quantizeRow(w,size_previous,layer,index_row);
+                layer._biais[index_row] = w[size_previous];
+            }
+        }else if(const NeuralLayerMatrixConvolutionSubScaling * neural_convolution = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(v_layer(index_layer))){
+            //the kernels feeding the map index_map are the row index_map (as in the im2col lowering of the layer)
+            const int nbr_map_previous = layer_previous->_nbr_map;
+            const int size_k = nbr_map_previous*layer._size_kernel*layer._size_kernel;
+            layer._nbr_row = layer._nbr_map;
+            layer._size_row = alignSize(size_k);
+            layer._W.assign(layer._nbr_row*layer._size_row,0);
+            layer._scale_W.resize(layer._nbr_row);
+            layer._biais.assign(layer._nbr_row,0);
+            std::vector<F32> w(size_k);
+            for(int index_map=0;index_map<layer._nbr_map;index_map++){
+                for(int index_map_previous=0;index_map_previous<nbr_map_previous;index_map_previous++){
+                    const Mat2F32 & kernel = neural_convolution->_W_kernels(index_map_previous+index_map*nbr_map_previous);
+                    std::copy(kernel.begin(),kernel.end(),w.begin()+index_map_previous*kernel.size());
+                    layer._biais[index_map]+=neural_convolution->_W_biais(index_map_previous+index_map*nbr_map_previous);
+                }
+                quantizeRow(&w[0],size_k,layer,index_map);
+            }
+        }
+        if(layer._nbr_row>0)
+            _initSumWeight(layer);
+        _v_layer.push_back(layer);
+    }
+    _checksum = checksum(net);
+    //calibration of the scales of the neuron values on the maximum absolute value reached by each layer
+    if(v_calibration.size()>0&&_v_layer.size()>0){
+        std::vector<F32> v_value_max(_v_layer.size(),0);
+        VecF32 X_out;
+        for(unsigned int index_sample=0;index_sample<v_calibration.size();index_sample++){
+            net.forwardCPU(v_calibration(index_sample),X_out);
+            for(unsigned int index_layer=0;index_layer<_v_layer.size();index_layer++){
+                const VecF32 & X = v_layer(index_layer)->X();
+                for(unsigned int i=0;i<X.size();i++)
+                    v_value_max[index_layer] = (std::max)(v_value_max[index_layer],std::abs(X(i)));
+            }
+        }
+        for(unsigned int index_layer=0;index_layer<_v_layer.size();index_layer++){
+            _v_layer[index_layer]._scale_X = scaleFromRange(v_value_max[index_layer],127.f);
+        }
+    }
+    //the max pool keeps the codes of the previous layer
+    for(unsigned int index_layer=1;index_layer<_v_layer.size();index_layer++){
+        if(_v_layer[index_layer]._type==MATRIX_MAX_POOL)
+            _v_layer[index_layer]._scale_X = _v_layer[index_layer-1]._scale_X;
+    }
+}
+
+UI32 NeuralNetQuantized::checksum(const NeuralNet & net){
+    UI32 hash = 2166136261u;
+    const Vec<NeuralLayer*> & v_layer = net.layers();
+    for(unsigned int index_layer=0;index_layer<v_layer.size();index_layer++){
+        if(const NeuralLayerLinearFullyConnected * neural_linear = dynamic_cast<const NeuralLayerLinearFullyConnected *>(v_layer(index_layer))){
+            hashByte(hash,neural_linear->_W.data(),neural_linear->_W.size()*sizeof(F32));
+        }else if(const NeuralLayerMatrixConvolutionSubScaling * neural_convolution = dynamic_cast<const NeuralLayerMatrixConvolutionSubScaling *>(v_layer(index_layer))){
+            for(unsigned int index_kernel=0;index_kernel<neural_convolution->_W_kernels.size();index_kernel++)
+                hashByte(hash,neural_convolution->_W_kernels(index_kernel).data(),neural_convolution->_W_kernels(index_kernel).size()*sizeof(F32));
+            hashByte(hash,&neural_convolution->_W_biais[0],neural_convolution->_W_biais.size()*sizeof(F32));
+        }
+    }
+    return hash;
+}
+
+bool NeuralNetQuantized::isQuantizationOf(const NeuralNet & net)const{
+    const Vec<NeuralLayer*> & v_layer = net.layers();
+    if(_v_layer.empty()||_v_layer.size()!=v_layer.size())
+        return false;
+    for(unsigned int index_layer=0;index_layer<v_layer.size();index_layer++){
+        const Layer & layer_quantized = _v_layer[index_layer];
+        Layer layer;
+        if(layerGeometry(v_layer(index_layer),layer)==false)
+            return false;
+        if(layer._type!=layer_quantized._type||layer._nbr_map!=layer_quantized._nbr_map||layer._sizei!=layer_quantized._sizei||layer._sizej!=layer_quantized._sizej
+                ||layer._size_kernel!=layer_quantized._size_kernel||layer._sub!=layer_quantized._sub)
+            return false;
+    }
+    return _checksum==checksum(net);
+}
+
+bool NeuralNetQuantized::_checkLayer(const Layer & layer,const Layer & layer_previous){
+    if(layer._type==FULLY_CONNECTED||layer._type==FULLY_CONNECTED_SOFTMAX){
+        return layer._nbr_map==1&&layer._sizei==1&&layer._nbr_row==layer._sizej&&layer._size_row==alignSize(layer_previous.sizeX());
+    }else if(layer._type==MATRIX_CONVOLUTION){
+        return layer._size_kernel>0&&layer._sub>0&&layer._nbr_row==layer._nbr_map
+                &&layer._size_row==alignSize(layer_previous._nbr_map*layer._size_kernel*layer._size_kernel)
+                &&(layer._sizei-1)*layer._sub+layer._size_kernel<=layer_previous._sizei
+                &&(layer._sizej-1)*layer._sub+layer._size_kernel<=layer_previous._sizej;
+    }else if(layer._type==MATRIX_MAX_POOL){
+        return layer._sub>0&&layer._nbr_row==0&&layer._nbr_map==layer_previous._nbr_map
+                &&layer._sizei*layer._sub<=layer_previous._sizei&&layer._sizej*layer._sub<=layer_previous._sizej;
+    }
+    return false;
+}
+
+void NeuralNetQuantized::_rowGroup(const Layer & layer,int index_row,const I8 ** w){
+    //the rows after the last one are replaced by the last one
+    for(int r=0;r<4;r++)
+        w[r] = &layer._W[(std::min)(index_row+r,layer._nbr_row-1)*layer._size_row];
+}
+
+void NeuralNetQuantized::_forwardFullyConnected(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,F32 * Y){
+    I32 sum[4];
+    const I8 * w[4];
+    for(int index_row=0;index_row<layer._nbr_row;index_row+=4){
+        const int nbr = (std::min)(4,layer._nbr_row-index_row);
+        _rowGroup(layer,index_row,w);
+        dot4U8I8(code_previous,w,layer._size_row,sum);
+        for(int r=0;r<nbr;r++){
+            const int index = index_row+r;
+            Y[index] = layer_previous._scale_X*layer._scale_W[index]*(sum[r]-CODE_ZERO*layer._sum_W[index])+layer._biais[index];
+        }
+    }
+}
+
+void NeuralNetQuantized::_forwardConvolution(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,F32 * Y){
+    const int size_p = layer._sizei*layer._sizej;
+    const int size_previous = layer_previous._sizei*layer_previous._sizej;
+    if(_im2col.size()<static_cast<std::size_t>(size_p*layer._size_row))
+        _im2col.resize(size_p*layer._size_row);
+    //transposed im2col: the row p contains the receptive field of the neuron p, a kernel line being contiguous in the previous map
+    for(int i=0,p=0;i<layer._sizei;i++){
+        for(int j=0;j<layer._sizej;j++,p++){
+            UI8 * col = &_im2col[p*layer._size_row];
+            UI8 * col_end = col+layer._size_row;
+            for(int index_map_previous=0;index_map_previous<layer_previous._nbr_map;index_map_previous++){
+                const UI8 * map = code_previous+index_map_previous*size_previous;
+                for(int i_kernel=0;i_kernel<layer._size_kernel;i_kernel++){
+                    const UI8 * row = map+(i*layer._sub+i_kernel)*layer_previous._sizej+j*layer._sub;
+                    for(int j_kernel=0;j_kernel<layer._size_kernel;j_kernel++)
+                        *col++ = row[j_kernel];
+                }
+            }
+            std::fill(col,col_end,static_cast<UI8>(CODE_ZERO));
+        }
+    }
+    I32 sum[4];
+    const I8 * w[4];
+    for(int index_map=0;index_map<layer._nbr_map;index_map+=4){
+        const int nbr = (std::min)(4,layer._nbr_map-index_map);
+        _rowGroup(layer,index_map,w);
+        for(int p=0;p<size_p;p++){
+            dot4U8I8(&_im2col[p*layer._size_row],w,layer._size_row,sum);
+            for(int r=0;r<nbr;r++){
+                const int index = index_map+r;
+                Y[index*size_p+p] = layer_previous._scale_X*layer._scale_W[index]*(sum[r]-CODE_ZERO*layer._sum_W[index])+layer._biais[index];
+            }
+        }
+    }
+}
+
+void NeuralNetQuantized::_forwardMaxPool(const Layer & layer,const Layer & layer_previous,const UI8 * code_previous,UI8 * code){
+    const int size_previous = layer_previous._sizei*layer_previous._sizej;
+    for(int index_map=0;index_map<layer._nbr_map;index_map++){
+        const UI8 * map = code_previous+index_map*size_previous;
+        for(int i=0;i<layer._sizei;i++){
+            for(int j=0;j<layer._sizej;j++){
+                UI8 value=0;
+                for(int i_r=0;i_r<layer._sub;i_r++){
+                    const UI8 * row = map+(i*layer._sub+i_r)*layer_previous._sizej+j*layer._sub;
+                    for(int j_r=0;j_r<layer._sub;j_r++)
+                        value = (std::max)(value,row[j_r]);
+                }
+                *code++ = value;
+            }
+        }
+    }
+}
+
+void NeuralNetQuantized::forwardCPU(const VecF32& X_in,VecF32 & X_out){
+    if(_v_layer.empty()){
+        std::cerr<<"In NeuralNetQuantized::forwardCPU, the network is empty"<<std::endl;
+        return;
+    }
+    if(X_in.size()!=_v_layer[0].sizeX()){
+        std::cerr<<"In NeuralNetQuantized::forwardCPU, the number of input values is not equal to the number of input neurons"<<std::endl;
+        return;
+    }
+    //the codes are padded with the code of 0 so that the dot products run on multiples of 16
+    if(_v_code.size()!=_v_layer.size()){
+        _v_code.resize(_v_layer.size());
+        for(unsigned int index_layer=0;index_layer<_v_layer.size();index_layer++)
+            _v_code[index_layer].assign(alignSize(_v_layer[index_layer].sizeX()),static_cast<UI8>(CODE_ZERO));
+    }
+    const F32 scale_inverse_input = 1.f/_v_layer[0]._scale_X;
+    for(unsigned int i=0;i<X_in.size();i++)
+        _v_code[0][i] = quantizeCode(X_in(i),scale_inverse_input);
+    const unsigned int index_last = _v_layer.size()-1;
+    X_out.resize(_v_layer[index_last].sizeX());
+    if(index_last==0){
+        std::copy(X_in.begin(),X_in.end(),X_out.begin());
+        return;
+    }
+    for(unsigned int index_layer=1;index_layer<_v_layer.size();index_layer++){
+        const Layer & layer = _v_layer[index_layer];
+        const Layer & layer_previous = _v_layer[index_layer-1];
+        const UI8 * code_previous = &_v_code[index_layer-1][0];
+        UI8 * code = &_v_code[index_layer][0];
+        const int size = static_cast<int>(layer.sizeX());
+        if(layer._type==MATRIX_MAX_POOL){
+            _forwardMaxPool(layer,layer_previous,code_previous,code);
+            if(index_layer==index_last){
+                for(int i=0;i<size;i++)
+                    X_out(i) = layer._scale_X*(static_cast<I32>(code[i])-CODE_ZERO);
+            }
+            continue;
+        }
+        if(_Y.size()<static_cast<std::size_t>(size))
+            _Y.resize(size);
+        F32 * Y = &_Y[0];
+        if(layer._type==MATRIX_CONVOLUTION)
+            _forwardConvolution(layer,layer_previous,code_previous,Y);
+        else
+            _forwardFullyConnected(layer,layer_previous,code_previous,Y);
+        if(layer._type==FULLY_CONNECTED_SOFTMAX){
+            fastSoftmax(Y,size);
+        }else{
+            for(int i=0;i<size;i++)
+                Y[i] = fastActivation(Y[i]);
+        }
+        if(index_layer==index_last){
+            std::copy(Y,Y+size,X_out.begin());
+        }else{
+            const F32 scale_inverse = 1.f/layer._scale_X;
+            for(int i=0;i<size;i++)
+                code[i] = quantizeCode(Y[i],scale_inverse);
+        }
+    }
+}
+
+bool NeuralNetQuantized::save(const char * file)const{
+    std::ofstream  out(file,std::ios::binary);
+    if (out.fail()){
+        std::cerr<<"In NeuralNetQuantized::save, cannot open file: "+std::string(file) << std::endl;
+        return false;
+    }
+    const I32 nbr_layer = static_cast<I32>(_v_layer.size());
+    out.write("POPNNQ82",8);
+    out.write(reinterpret_cast<const char *>(&nbr_layer),sizeof(nbr_layer));
+    out.write(reinterpret_cast<const char *>(&_checksum),sizeof(_checksum));
+    for(unsigned int index_layer=0;index_layer<_v_layer.size();index_layer++){
+        const Layer & layer = _v_layer[index_layer];
+        I32 info[8]={layer._type,layer._nbr_map,layer._sizei,layer._sizej,layer._size_kernel,layer._sub,layer._nbr_row,layer._size_row};
+        out.write(reinterpret_cast<const char *>(info),sizeof(info));
+        out.write(reinterpret_cast<const char *>(&layer._scale_X),sizeof(F32));
+        if(layer._nbr_row>0){
+            out.write(reinterpret_cast<const char *>(&layer._biais[0]),layer._biais.size()*sizeof(F32));
+            out.write(reinterpret_cast<const char *>(&layer._scale_W[0]),layer._scale_W.size()*sizeof(F32));
+            out.write(reinterpret_cast<const char *>(&layer._W[0]),layer._W.size()*sizeof(I8));
+        }
+    }
+    if(out.fail()){
+        std::cerr<<"In NeuralNetQuantized::save, cannot write file: "+std::string(file) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool NeuralNetQuantized::load(const char * file){
+    clear();
+    std::ifstream  is(file,std::ios::binary);
+    char magic[8];
+    I32 nbr_layer=0;
+    UI32 checksum_weight=0;
+    is.read(magic,8);
+    is.read(reinterpret_cast<char *>(&nbr_layer),sizeof(nbr_layer));
+    is.read(reinterpret_cast<char *>(&checksum_weight),sizeof(checksum_weight));
+    if(!is||std::memcmp(magic,"POPNNQ82",8)!=0||nbr_layer<=0){
+        std::cerr<<"In NeuralNetQuantized::load, the file is not a quantized neural network: "+std::string(file) << std::endl;
+        return false;
+    }
+    for(I32 index_layer=0;index_layer<nbr_layer;index_layer++){
+        Layer layer;
+        I32 info[8];
+        is.read(reinterpret_cast<char *>(info),sizeof(info));
+        is.read(reinterpret_cast<char *>(&layer._scale_X),sizeof(F32));
+        layer._type=info[0];layer._nbr_map=info[1];layer._sizei=info[2];layer._sizej=info[3];
+        layer._size_kernel=info[4];layer._sub=info[5];layer._nbr_row=info[6];layer._size_row=info[7];
+        if(!is||layer._type<LINEAR_INPUT||layer._type>MATRIX_MAX_POOL||layer._nbr_map<=0||layer._sizei<=0||layer._sizej<=0
+                ||layer._nbr_row<0||layer._size_row<0||layer._size_row%NBR_BYTE_ALIGN!=0||(index_layer==0)!=(layer._type<=MATRIX_INPUT)||(layer._type<=MATRIX_INPUT&&layer._nbr_row!=0)){
+            std::cerr<<"In NeuralNetQuantized::load, corrupted layer in the file: "+std::string(file) << std::endl;
+            clear();
+            return false;
+        }
+        if(index_layer>0&&_checkLayer(layer,_v_layer[index_layer-1])==false){
+            std::cerr<<"In NeuralNetQuantized::load, the layer "<<index_layer<<" does not match the previous layer in the file: "+std::string(file) << std::endl;
+            clear();
+            return false;
+        }
+        if(layer._nbr_row>0){
+            layer._biais.resize(layer._nbr_row);
+            layer._scale_W.resize(layer._nbr_row);
+            layer._W.resize(static_cast<std::size_t>(layer._nbr_row)*layer._size_row);
+            is.read(reinterpret_cast<char *>(&layer._biais[0]),layer._biais.size()*sizeof(F32));
+            is.read(reinterpret_cast<char *>(&layer._scale_W[0]),layer._scale_W.size()*sizeof(F32));
+            is.read(reinterpret_cast<char *>(&layer._W[0]),layer._W.size()*sizeof(I8));
+            _initSumWeight(layer);
+        }
+        _v_layer.push_back(layer);
+    }
+    if(!is){
+        std::cerr<<"In NeuralNetQuantized::load, truncated file: "+std::string(file) << std::endl;
+        clear();
+        return false;
+    }
+    _checksum = checksum_weight;
+    return true;
+}
+
+void NeuralNetQuantized::print()const{
+    std::cout<<"QUANTIZED NET STRUCTURE"<<std::endl;
+    const char * name[]={"Linear input layer","Matrix input layer","Fully connected layer","Fully connected softmax layer","Convolution layer","Max pool layer"};
+    for(unsigned int index_layer=0;index_layer<_v_layer.size();index_layer++){
+        const Layer & layer = _v_layer[index_layer];
+        std::cout<<std::endl<<"LAYER "<<index_layer<<std::endl;
+        std::cout<<name[layer._type]<<std::endl;
+        std::cout<<"nbr_map="<<layer._nbr_map<<" size i="<<layer._sizei<<" size j="<<layer._sizej<<std::endl;
+        std::cout<<"scale="<<layer._scale_X<<" int8 weights="<<layer._W.size()<<std::endl;
+    }
+}
+}
@@ -1,8 +1,9 @@
 
 #include"data/notstable/blas.h"
+#include<chrono>
+#include<cmath>
 #ifdef HAVE_ACML
 void popblas::blas::ger(float alpha, pop::MatN<2, pop::F32> &vecX, pop::MatN<2, pop::F32> &vecY, pop::MatN<2, pop::F32> &matA) {
-    std::cout << "use BLAS ger" << std::endl;
     POP_DbgAssertMessage((vecX.sizeI() == 1 || vecX.sizeJ() == 1) && (vecY.sizeI() == 1 || vecY.sizeJ() == 1) && (matA.sizeI() == vecX.size()) && (matA.sizeJ() == vecY.size()), "[ERROR] blas::ger, vector and matrix sizes are not compatible");
     int sizeY = vecY.getDomain().multCoordinate(), sizeX = vecX.getDomain().multCoordinate();
     ger_(&sizeY, &sizeX, &alpha, &vecY[0], &otherMatN::getStrideVector(vecY), &vecX[0],
@@ -17,7 +18,6 @@ void popblas::blas::gemv(float alpha, pop::MatN<2, pop::F32> &matA, pop::MatN<2,
 }
 
 void popblas::blas::gemv(float alpha, pop::MatN<2, pop::F32> &matA, char transA, pop::MatN<2, pop::F32> &vecX, float beta, pop::MatN<2, pop::F32> &vecY) {
-    std::cout << "use BLAS gemv" << std::endl;
     POP_DbgAssertMessage((vecX.sizeI() == 1 || vecX.sizeJ() == 1) && (vecY.sizeI() == 1 || vecY.sizeJ() == 1), "[ERROR] blas::gemv, vector and matrix sizes are not compatible");
     char opTransA = 'T';
     if (transA == 'T') {
@@ -42,7 +42,6 @@ void popblas::blas::gemm(float alpha, pop::MatN<2, pop::F32> &matA, pop::MatN<2,
 }
 
 void popblas::blas::gemm(float alpha, pop::MatN<2, pop::F32> &matA, char transA, pop::MatN<2, pop::F32> &matB, char transB, float beta, pop::MatN<2, pop::F32> &matC) {
-    std::cout << "use BLAS gemm" << std::endl;
     int m, n, k;
     int lda, ldb, ldc;
     m = matC.getDomain()(1);
@@ -169,3 +168,33 @@ void popblas::testBlas::test_dot() {
 //    pop::MatN<2, pop::F32> vecB = matB.selectColumn(0);
 //    std::cout << blas::dot(vecA, vecB) << std::endl;
 }
+
+void popblas::testBlas::bench_gemm() {
+    std::cout << "size\tnaive (ms)\tgemm (ms)\tgemm GFLOP/s\tmax error" << std::endl;
+    for (int size = 64; size <= 1024; size *= 2) {
+        pop::MatN<2, pop::F32> matA(size, size), matB(size, size), matC(size, size), matC_naive(size, size);
+        for (unsigned int i = 0; i < matA.size(); i++) {
+            matA(i) = static_cast<pop::F32>((i * 7) % 13) / 13 - 0.5f;
+            matB(i) = static_cast<pop::F32>((i * 5) % 11) / 11 - 0.5f;
+        }
+        // naive triple loop of the former MatN::operator*
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        pop::MatN<2, pop::F32> matB_trans = matB.transpose();
+        for (int i = 0; i < size; i++) {
+            for (int j = 0; j < size; j++) {
+                pop::F32 sum = 0;
+                for (int k = 0; k < size; k++)
+                    sum += matA(i, k) * matB_trans(j, k);
+                matC_naive(i, j) = sum;
+            }
+        }
+        double time_naive = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        start = std::chrono::high_resolution_clock::now();
+        blas::gemm(1, matA, matB, 0, matC);
+        double time_gemm = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        pop::F32 error = 0;
+        for (unsigned int i = 0; i < matC.size(); i++)
+            error = std::max(error, std::abs(matC(i) - matC_naive(i)));
+        std::cout << size << "\t" << time_naive << "\t" << time_gemm << "\t" << 2. * size * size * size / (time_gemm * 1e6) << "\t" << error << std::endl;
+    }
+}
@@ -41,7 +41,10 @@ char OCRNeuralNetwork::parseMatrix(const Mat2UI8 & m){
 
         VecF32 vin= _n.inputMatrixToInputNeuron(m);
         VecF32 vout;
-        _n.forwardCPU(vin,vout);
+        if(_n_quantized.empty()==false)
+            _n_quantized.forwardCPU(vin,vout);
+        else
+            _n.forwardCPU(vin,vout);
         //std::cout << "vout of neural network : " << vout << std::endl;
         //                _n.propagateFront(vin,vout);
         VecF32::iterator itt = std::max_element(vout.begin(),vout.end());
@@ -69,6 +72,13 @@ int OCRNeuralNetwork::characterConfidence(){
 bool OCRNeuralNetwork::setDictionnary(std::string xmlfile){
     if(BasicUtility::isFile(xmlfile)){
         _n.load(xmlfile.c_str());
+        _n_quantized.clear();
+        if(BasicUtility::isFile(quantizedFile(xmlfile))&&_n_quantized.load(quantizedFile(xmlfile).c_str())){
+            if(_n_quantized.isQuantizationOf(_n)==false){
+                std::cerr<<"In OCRNeuralNetwork::setDictionnary, the quantized network "+quantizedFile(xmlfile)+" does not match the neural network "+xmlfile+", the float network is used"<<std::endl;
+                _n_quantized.clear();
+            }
+        }
         return true;
     }else{
         return false;
@@ -78,9 +88,33 @@ bool OCRNeuralNetwork::setDictionnary(std::string xmlfile){
 
 bool OCRNeuralNetwork::setDictionnaryByteArray(const char * byte_array){
     _n.loadByteArray(byte_array);
+    _n_quantized.clear();
     return true;
 }
 
+void OCRNeuralNetwork::quantize(const Vec<Mat2UI8> & v_calibration){
+    Vec<VecF32> v_input(v_calibration.size());
+    for(unsigned int i=0;i<v_calibration.size();i++)
+        v_input(i)=_n.inputMatrixToInputNeuron(v_calibration(i));
+    _n_quantized.quantize(_n,v_input);
+}
+
+NeuralNetQuantized &   OCRNeuralNetwork::neuralNetworkQuantized(){
+    return _n_quantized;
+}
+
+const NeuralNetQuantized &   OCRNeuralNetwork::neuralNetworkQuantized()const{
+    return _n_quantized;
+}
+
+std::string OCRNeuralNetwork::quantizedFile(std::string xmlfile){
+    std::string::size_type dot = xmlfile.find_last_of('.');
+    std::string::size_type slash = xmlfile.find_last_of("/\\");
+    if(dot==std::string::npos||(slash!=std::string::npos&&dot<slash))
+        return xmlfile+".q8";
+    return xmlfile.substr(0,dot)+".q8";
+}
+
 bool OCRNeuralNetwork::isRecognitionCharacter(){
     return _isrecognized;
 }
@@ -0,0 +1,172 @@
+#include"PopulationConfig.h"
+#include<algorithm>
+#include<cstring>
+#include<vector>
+#include"data/utility/Compression.h"
+
+namespace pop
+{
+namespace{
+const std::size_t LZ_MIN_MATCH    = 4;
+const std::size_t LZ_LAST_LITERAL = 5;
+const std::size_t LZ_MF_LIMIT     = 12;
+const std::size_t LZ_MAX_OFFSET   = 65535;
+const int LZ_HASH_LOG             = 16;
+
+inline unsigned int read32(const unsigned char * p){
+    unsigned int v;
+    std::memcpy(&v,p,4);
+    return v;
+}
+inline unsigned int hash32(unsigned int v){
+    return (v*2654435761U)>>(32-LZ_HASH_LOG);
+}
+inline unsigned char * writeLength(unsigned char * op,std::size_t length){
+    while(length>=255){
+        *op++=255;
+        length-=255;
+    }
+    *op++=static_cast<unsigned char>(length);
+    return op;
+}
+inline unsigned char * writeSequence(unsigned char * op,const unsigned char * literal,std::size_t nbr_literal,std::size_t offset,std::size_t match){
+    unsigned char * token = op++;
+    if(nbr_literal>=15){
+        *token = 15<<4;
+        op = writeLength(op,nbr_literal-15);
+    }else{
+        *token = static_cast<unsigned char>(nbr_literal<<4);
+    }
+    std::memcpy(op,literal,nbr_literal);
+    op+=nbr_literal;
+    if(match==0)
+        return op;
+    *op++=static_cast<unsigned char>(offset&0xFF);
+    *op++=static_cast<unsigned char>(offset>>8);
+    match-=LZ_MIN_MATCH;
+    if(match>=15){
+        *token |= 15;
+        op = writeLength(op,match-15);
+    }else{
+        *token |= static_cast<unsigned char>(match);
+    }
+    return op;
+}
+inline bool readLength(const unsigned char * in,std::size_t size,std::size_t & ip,std::size_t & length){
+    unsigned char b;
+    do{
+        if(ip>=size)
+            return false;
+        b = in[ip++];
+        length+=b;
+    }while(b==255);
+    return true;
+}
+}
+
+std::size_t Compression::boundLZ(std::size_t size){
+    return size+size/255+16;
+}
+std::size_t Compression::compressLZ(const unsigned char * in,std::size_t size,unsigned char * out){
+    unsigned char * op = out;
+    std::size_t anchor = 0;
+    if(size>LZ_MF_LIMIT){
+        std::vector<int> table(1<<LZ_HASH_LOG,-1);
+        const std::size_t limit = size-LZ_MF_LIMIT;
+        const std::size_t match_limit = size-LZ_LAST_LITERAL;
+        std::size_t ip = 0;
+        while(ip<limit){
+            unsigned int v = read32(in+ip);
+            unsigned int h = hash32(v);
+            int ref = table[h];
+            table[h] = static_cast<int>(ip);
+            if(ref<0||ip-ref>LZ_MAX_OFFSET||read32(in+ref)!=v){
+                //skip faster in the incompressible regions
+                ip += 1+((ip-anchor)>>6);
+                continue;
+            }
+            std::size_t r = ref;
+            while(ip>anchor&&r>0&&in[ip-1]==in[r-1]){
+                ip--;
+                r--;
+            }
+            std::size_t match = LZ_MIN_MATCH;
+            while(ip+match<match_limit&&in[r+match]==in[ip+match])
+                match++;
+            op = writeSequence(op,in+anchor,ip-anchor,ip-r,match);
+            ip += match;
+            anchor = ip;
+            if(ip<limit)
+                table[hash32(read32(in+ip-2))] = static_cast<int>(ip-2);
+        }
+    }
+    return writeSequence(op,in+anchor,size-anchor,0,0)-out;
+}
+bool Compression::decompressLZ(const unsigned char * in,std::size_t size,unsigned char * out,std::size_t size_out){
+    std::size_t ip = 0;
+    std::size_t op = 0;
+    while(ip<size){
+        unsigned char token = in[ip++];
+        std::size_t nbr_literal = token>>4;
+        if(nbr_literal==15&&readLength(in,size,ip,nbr_literal)==false)
+            return false;
+        if(nbr_literal>size-ip||nbr_literal>size_out-op)
+            return false;
+        std::memcpy(out+op,in+ip,nbr_literal);
+        ip+=nbr_literal;
+        op+=nbr_literal;
+        if(ip==size)
+            break;
+        if(ip+2>size)
+            return false;
+        std::size_t offset = in[ip]|(in[ip+1]<<8);
+        ip+=2;
+        if(offset==0||offset>op)
+            return false;
+        std::size_t match = token&15;
+        if(match==15&&readLength(in,size,ip,match)==false)
+            return false;
+        match+=LZ_MIN_MATCH;
+        if(match>size_out-op)
+            return false;
+        //the copied region can overlap the destination (offset<match), so the pattern is duplicated by doubling blocks
+        unsigned char * src = out+op-offset;
+        unsigned char * dst = out+op;
+        std::size_t remaining = match;
+        while(remaining>0){
+            std::size_t n = std::min<std::size_t>(dst-src,remaining);
+            std::memcpy(dst,src,n);
+            dst+=n;
+            remaining-=n;
+        }
+        op+=match;
+    }
+    return op==size_out;
+}
+void Compression::filterShuffle(const unsigned char * in,std::size_t size,int element_size,bool delta,unsigned char * out){
+    std::size_t nbr = size/element_size;
+    for(int b=0;b<element_size;b++){
+        unsigned char * plane = out+b*nbr;
+        const unsigned char * p = in+b;
+        unsigned char previous = 0;
+        for(std::size_t i=0;i<nbr;i++,p+=element_size){
+            plane[i] = delta ? static_cast<unsigned char>(*p-previous) : *p;
+            previous = *p;
+        }
+    }
+    std::memcpy(out+nbr*element_size,in+nbr*element_size,size-nbr*element_size);
+}
+void Compression::unfilterShuffle(const unsigned char * in,std::size_t size,int element_size,bool delta,unsigned char * out){
+    std::size_t nbr = size/element_size;
+    for(int b=0;b<element_size;b++){
+        const unsigned char * plane = in+b*nbr;
+        unsigned char * p = out+b;
+        unsigned char previous = 0;
+        for(std::size_t i=0;i<nbr;i++,p+=element_size){
+            previous = delta ? static_cast<unsigned char>(plane[i]+previous) : plane[i];
+            *p = previous;
+        }
+    }
+    std::memcpy(out+nbr*element_size,in+nbr*element_size,size-nbr*element_size);
+}
+}
@@ -0,0 +1,131 @@
+#include"PopulationConfig.h"
+#include<iostream>
+#include<string>
+#if Pop_OS==2
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include"data/utility/MemoryMappedFile.h"
+
+namespace pop
+{
+MemoryMappedFile::MemoryMappedFile()
+    :_base(NULL),_length_base(0),_data(NULL),_length(0),_read_only(true)
+#if Pop_OS==2
+    ,_handle_file(NULL),_handle_mapping(NULL)
+#endif
+{
+}
+#if Pop_OS==2
+MemoryMappedFile * MemoryMappedFile::open(const char * file,std::size_t offset,std::size_t length,bool read_only){
+    HANDLE handle_file = CreateFileA(file,read_only ? GENERIC_READ : GENERIC_READ|GENERIC_WRITE,FILE_SHARE_READ|(read_only ? 0 : FILE_SHARE_WRITE),NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(handle_file==INVALID_HANDLE_VALUE){
+        std::cerr<<"In MemoryMappedFile::open, cannot open file: "+std::string(file)<<std::endl;
+        return NULL;
+    }
+    LARGE_INTEGER size_file;
+    if(GetFileSizeEx(handle_file,&size_file)==0||static_cast<unsigned long long>(size_file.QuadPart)<offset+length){
+        std::cerr<<"In MemoryMappedFile::open, the file is smaller than the mapped region: "+std::string(file)<<std::endl;
+        CloseHandle(handle_file);
+        return NULL;
+    }
+    HANDLE handle_mapping = CreateFileMappingA(handle_file,NULL,read_only ? PAGE_READONLY : PAGE_READWRITE,0,0,NULL);
+    if(handle_mapping==NULL){
+        std::cerr<<"In MemoryMappedFile::open, cannot map file: "+std::string(file)<<std::endl;
+        CloseHandle(handle_file);
+        return NULL;
+    }
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    unsigned long long offset_base = (offset/info.dwAllocationGranularity)*info.dwAllocationGranularity;
+    std::size_t length_base = length+static_cast<std::size_t>(offset-offset_base);
+    void * base = MapViewOfFile(handle_mapping,read_only ? FILE_MAP_READ : FILE_MAP_WRITE,static_cast<DWORD>(offset_base>>32),static_cast<DWORD>(offset_base&0xFFFFFFFF),length_base);
+    if(base==NULL){
+        std::cerr<<"In MemoryMappedFile::open, cannot map file: "+std::string(file)<<std::endl;
+        CloseHandle(handle_mapping);
+        CloseHandle(handle_file);
+        return NULL;
+    }
+    MemoryMappedFile * map = new MemoryMappedFile;
+    map->_handle_file = handle_file;
+    map->_handle_mapping = handle_mapping;
+    map->_base = base;
+    map->_length_base = length_base;
+    map->_data = static_cast<char *>(base)+(offset-offset_base);
+    map->_length = length;
+    map->_read_only = read_only;
+    return map;
+}
+MemoryMappedFile::~MemoryMappedFile(){
+    if(_base!=NULL)
+        UnmapViewOfFile(_base);
+    if(_handle_mapping!=NULL)
+        CloseHandle(_handle_mapping);
+    if(_handle_file!=NULL)
+        CloseHandle(_handle_file);
+}
+bool MemoryMappedFile::flush(){
+    if(_base==NULL||_read_only==true)
+        return true;
+    return FlushViewOfFile(_base,_length_base)!=0;
+}
+#else
+MemoryMappedFile * MemoryMappedFile::open(const char * file,std::size_t offset,std::size_t length,bool read_only){
+    int fd = ::open(file,read_only ? O_RDONLY : O_RDWR);
+    if(fd<0){
+        std::cerr<<"In MemoryMappedFile::open, cannot open file: "+std::string(file)<<std::endl;
+        return NULL;
+    }
+    struct stat info;
+    if(fstat(fd,&info)!=0||static_cast<unsigned long long>(info.st_size)<static_cast<unsigned long long>(offset)+length){
+        std::cerr<<"In MemoryMappedFile::open, the file is smaller than the mapped region: "+std::string(file)<<std::endl;
+        ::close(fd);
+        return NULL;
+    }
+    std::size_t size_page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t offset_base = (offset/size_page)*size_page;
+    std::size_t length_base = length+(offset-offset_base);
+    void * base = NULL;
+    if(length_base>0){
+        base = mmap(NULL,length_base,read_only ? PROT_READ : PROT_READ|PROT_WRITE,MAP_SHARED,fd,static_cast<off_t>(offset_base));
+        if(base==MAP_FAILED){
+            std::cerr<<"In MemoryMappedFile::open, cannot map file: "+std::string(file)<<std::endl;
+            ::close(fd);
+            return NULL;
+        }
+    }
+    //the mapping stays valid after the closing of the file descriptor
+    ::close(fd);
+    MemoryMappedFile * map = new MemoryMappedFile;
+    map->_base = base;
+    map->_length_base = length_base;
+    map->_data = (base!=NULL) ? static_cast<char *>(base)+(offset-offset_base) : NULL;
+    map->_length = length;
+    map->_read_only = read_only;
+    return map;
+}
+MemoryMappedFile::~MemoryMappedFile(){
+    if(_base!=NULL)
+        munmap(_base,_length_base);
+}
+bool MemoryMappedFile::flush(){
+    if(_base==NULL||_read_only==true)
+        return true;
+    return msync(_base,_length_base,MS_SYNC)==0;
+}
+#endif
+void * MemoryMappedFile::data()const{
+    return _data;
+}
+std::size_t MemoryMappedFile::size()const{
+    return _length;
+}
+bool MemoryMappedFile::isReadOnly()const{
+    return _read_only;
+}
+}
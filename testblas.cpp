@@ -8,5 +8,6 @@ int main (int argc, char* argv[]) {
     popblas::testBlas::test_gemv();
     popblas::testBlas::test_gemm();
     popblas::testBlas::test_dot();
+    popblas::testBlas::bench_gemm();
     return 0;
 }